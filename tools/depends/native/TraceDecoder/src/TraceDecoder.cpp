@@ -0,0 +1,169 @@
+/*
+ *      Copyright (C) 2017 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/*
+ * Prints the events of a trace file written by CTrace (xbmc/utils/Trace.h),
+ * oldest first, one line per event:
+ *   TraceDecoder kodi.trace
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "utils/TraceFormat.h"
+
+namespace
+{
+  std::string FormatTime(int64_t wallTime)
+  {
+    time_t seconds = static_cast<time_t>(wallTime / 1000000);
+    struct tm* localTime = localtime(&seconds);
+    char buffer[32];
+    snprintf(buffer, sizeof(buffer), "%02d:%02d:%02d.%06d",
+             localTime ? localTime->tm_hour : 0, localTime ? localTime->tm_min : 0, localTime ? localTime->tm_sec : 0,
+             static_cast<int>(wallTime % 1000000));
+    return buffer;
+  }
+
+  std::string FormatArguments(uint16_t event, const uint8_t* data, size_t size)
+  {
+    std::istringstream names(GetTraceEventArguments(event));
+    std::ostringstream result;
+    size_t position = 0;
+    while (position < size && data[position] != 0)
+    {
+      std::string name;
+      if (!(names >> name))
+        name = "arg";
+      result << " " << name << "=";
+
+      const uint8_t type = data[position++];
+      if (type == TRACE_ARGUMENT_INT && position + sizeof(int64_t) <= size)
+      {
+        int64_t value;
+        memcpy(&value, data + position, sizeof(value));
+        position += sizeof(value);
+        result << value;
+      }
+      else if (type == TRACE_ARGUMENT_DOUBLE && position + sizeof(double) <= size)
+      {
+        double value;
+        memcpy(&value, data + position, sizeof(value));
+        position += sizeof(value);
+        result << value;
+      }
+      else if (type == TRACE_ARGUMENT_STRING && position < size && position + 1 + data[position] <= size)
+      {
+        const size_t length = data[position++];
+        result << "\"" << std::string(reinterpret_cast<const char*>(data + position), length) << "\"";
+        position += length;
+      }
+      else
+      {
+        result << "<invalid>";
+        break;
+      }
+    }
+    return result.str();
+  }
+}
+
+int main(int argc, char* argv[])
+{
+  if (argc != 2)
+  {
+    std::cerr << "Usage: " << argv[0] << " <trace file>" << std::endl;
+    return 1;
+  }
+
+  std::ifstream input(argv[1], std::ios::binary);
+  std::vector<uint8_t> file((std::istreambuf_iterator<char>(input)), std::istreambuf_iterator<char>());
+
+  TraceFileHeader header;
+  if (file.size() < TRACE_FILE_HEADER_SIZE)
+  {
+    std::cerr << "Can't read " << argv[1] << std::endl;
+    return 1;
+  }
+  memcpy(&header, file.data(), sizeof(header));
+  if (memcmp(header.magic, TRACE_FILE_MAGIC, sizeof(header.magic)) != 0 ||
+      header.version != TRACE_FILE_VERSION ||
+      file.size() < TRACE_FILE_HEADER_SIZE + header.capacity)
+  {
+    std::cerr << argv[1] << " is not a trace file of version " << TRACE_FILE_VERSION << std::endl;
+    return 1;
+  }
+
+  // records are found by their position matching the offset in the ring buffer
+  const uint8_t* data = file.data() + TRACE_FILE_HEADER_SIZE;
+  const uint64_t capacity = header.capacity;
+  std::vector<std::pair<uint64_t, uint64_t>> records; // position, offset
+  for (uint64_t offset = 0; offset + sizeof(TraceRecordHeader) <= capacity; offset += 8)
+  {
+    TraceRecordHeader record;
+    memcpy(&record, data + offset, sizeof(record));
+    if (record.position != UINT64_MAX &&
+        record.position % capacity == offset &&
+        record.size >= sizeof(record) && record.size % 8 == 0 && offset + record.size <= capacity &&
+        record.event > static_cast<uint16_t>(TraceEvent::None) && record.event < static_cast<uint16_t>(TraceEvent::Count))
+      records.push_back(std::make_pair(record.position, offset));
+  }
+
+  std::sort(records.begin(), records.end());
+
+  // only the last capacity bytes of the stream are intact
+  uint64_t end = 0;
+  if (!records.empty())
+  {
+    TraceRecordHeader last;
+    memcpy(&last, data + records.back().second, sizeof(last));
+    end = last.position + last.size;
+  }
+
+  uint64_t nextPosition = end > capacity ? end - capacity : 0;
+  for (const auto& positionAndOffset : records)
+  {
+    // skips overwritten records and ones that were found inside the arguments of another
+    if (positionAndOffset.first < nextPosition)
+      continue;
+
+    TraceRecordHeader record;
+    memcpy(&record, data + positionAndOffset.second, sizeof(record));
+    nextPosition = record.position + record.size;
+
+    std::cout << FormatTime(header.startWallTime + static_cast<int64_t>(record.time - header.startTime))
+              << " T:" << record.thread
+              << " " << GetTraceComponentName(record.component)
+              << " " << GetTraceEventName(record.event) << ":"
+              << FormatArguments(record.event, data + positionAndOffset.second + sizeof(record), record.size - sizeof(record))
+              << std::endl;
+  }
+
+  return 0;
+}
@@ -4342,6 +4342,11 @@ const infomap playlist[] =       {{ "length",           PLAYLIST_LENGTH },
 ///                  _string (integer)_,
 ///     Number of deleted recording present on the backend
 ///   }
+///   \table_row3{   <b>`Pvr.BackendResponseTime`</b>,
+///                  \anchor Pvr_BackendResponseTime
+///                  _string_,
+///     Time the backend took to answer the last call from Kodi
+///   }
 ///   \table_row3{   <b>`Pvr.BackendNumber`</b>,
 ///                  \anchor Pvr_BackendNumber
 ///                  _string_,
@@ -4629,6 +4634,7 @@ const infomap pvr[] =            {{ "isrecording",              PVR_IS_RECORDING
                                   { "backendrecordings",        PVR_BACKEND_RECORDINGS },
                                   { "backenddeletedrecordings", PVR_BACKEND_DELETED_RECORDINGS },
                                   { "backendnumber",            PVR_BACKEND_NUMBER },
+                                  { "backendresponsetime",      PVR_BACKEND_RESPONSE_TIME },
                                   { "totaldiscspace",           PVR_TOTAL_DISKSPACE },
                                   { "nexttimer",                PVR_NEXT_TIMER },
                                   { "isplayingtv",              PVR_IS_PLAYING_TV },
@@ -5971,6 +5977,7 @@ std::string CGUIInfoManager::GetLabel(int info, int contextWindow, std::string *
   case PVR_BACKEND_RECORDINGS:
   case PVR_BACKEND_DELETED_RECORDINGS:
   case PVR_BACKEND_NUMBER:
+  case PVR_BACKEND_RESPONSE_TIME:
   case PVR_TOTAL_DISKSPACE:
   case PVR_NEXT_TIMER:
   case PVR_PLAYING_DURATION:
@@ -162,6 +162,8 @@ void CPVRClient::ResetProperties(int iClientId /* = PVR_INVALID_CLIENT_ID */)
   m_struct.toKodi.ConnectionStateChange = cb_connection_state_change;
   m_struct.toKodi.EpgEventStateChange = cb_epg_event_state_change;
   m_struct.toKodi.GetCodecByName = cb_get_codec_by_name;
+  m_struct.toKodi.RecordingStateChange = cb_recording_state_change;
+  m_struct.toKodi.TimerStateChange = cb_timer_state_change;
 }
 
 ADDON_STATUS CPVRClient::Create(int iClientId)
@@ -2032,6 +2034,77 @@ void CPVRClient::cb_epg_event_state_change(void* kodiInstance, EPG_TAG* tag, EPG
   CServiceBroker::GetPVRManager().EpgContainer().UpdateFromClient(std::make_shared<CPVREpgInfoTag>(*tag, client->GetID()), newState);
 }
 
+void CPVRClient::cb_recording_state_change(void* kodiInstance, const PVR_RECORDING* recording, PVR_ENTRY_STATE newState)
+{
+  CPVRClient *client = static_cast<CPVRClient*>(kodiInstance);
+  if (!client || !recording)
+  {
+    CLog::Log(LOGERROR, "PVR - %s - invalid handler data", __FUNCTION__);
+    return;
+  }
+
+  // null while the pvr manager is (re)starting
+  const CPVRRecordingsPtr recordings = CServiceBroker::GetPVRManager().Recordings();
+  if (!recordings)
+  {
+    CLog::Log(LOGERROR, "PVR - %s - recordings not available", __FUNCTION__);
+    return;
+  }
+
+  CPVRRecordingPtr tag;
+  if (newState == PVR_ENTRY_DELETED)
+  {
+    tag.reset(new CPVRRecording);
+    tag->m_strRecordingId = recording->strRecordingId;
+    tag->m_iClientId = client->GetID();
+  }
+  else
+  {
+    tag.reset(new CPVRRecording(*recording, client->GetID()));
+  }
+
+  /* apply the change in the next iteration of the pvrmanager's main loop */
+  recordings->QueueEntryChange(tag, newState);
+  CServiceBroker::GetPVRManager().TriggerRecordingEntriesUpdate();
+}
+
+void CPVRClient::cb_timer_state_change(void* kodiInstance, const PVR_TIMER* timer, PVR_ENTRY_STATE newState)
+{
+  CPVRClient *client = static_cast<CPVRClient*>(kodiInstance);
+  if (!client || !timer)
+  {
+    CLog::Log(LOGERROR, "PVR - %s - invalid handler data", __FUNCTION__);
+    return;
+  }
+
+  // null while the pvr manager is (re)starting
+  const CPVRTimersPtr timers = CServiceBroker::GetPVRManager().Timers();
+  const CPVRChannelGroupsContainerPtr channelGroups = CServiceBroker::GetPVRManager().ChannelGroups();
+  if (!timers || !channelGroups)
+  {
+    CLog::Log(LOGERROR, "PVR - %s - timers not available", __FUNCTION__);
+    return;
+  }
+
+  CPVRTimerInfoTagPtr tag;
+  if (newState == PVR_ENTRY_DELETED)
+  {
+    tag.reset(new CPVRTimerInfoTag);
+    tag->m_iClientIndex = timer->iClientIndex;
+    tag->m_iClientId = client->GetID();
+  }
+  else
+  {
+    /* Note: channel can be NULL here, for instance for epg-based timer rules ("record on any channel" condition). */
+    CPVRChannelPtr channel = channelGroups->GetByUniqueID(timer->iClientChannelUid, client->GetID());
+    tag.reset(new CPVRTimerInfoTag(*timer, channel, client->GetID()));
+  }
+
+  /* apply the change in the next iteration of the pvrmanager's main loop */
+  timers->QueueEntryChange(tag, newState);
+  CServiceBroker::GetPVRManager().TriggerTimerEntriesUpdate();
+}
+
 class CCodecIds
 {
 public:
@@ -1061,6 +1061,24 @@ namespace PVR
      */
     static void cb_epg_event_state_change(void* kodiInstance, EPG_TAG* tag, EPG_EVENT_STATE newState);
 
+    /*!
+     * @brief Notify a state change for a recording
+     * @param kodiInstance Pointer to Kodi's CPVRClient class
+     * @param recording The recording.
+     * @param newState The new state. For PVR_ENTRY_CREATED and PVR_ENTRY_UPDATED, recording must be filled with all available
+     *        data, not just a delta. For PVR_ENTRY_DELETED, it is sufficient to fill PVR_RECORDING.strRecordingId
+     */
+    static void cb_recording_state_change(void* kodiInstance, const PVR_RECORDING* recording, PVR_ENTRY_STATE newState);
+
+    /*!
+     * @brief Notify a state change for a timer
+     * @param kodiInstance Pointer to Kodi's CPVRClient class
+     * @param timer The timer.
+     * @param newState The new state. For PVR_ENTRY_CREATED and PVR_ENTRY_UPDATED, timer must be filled with all available
+     *        data, not just a delta. For PVR_ENTRY_DELETED, it is sufficient to fill PVR_TIMER.iClientIndex
+     */
+    static void cb_timer_state_change(void* kodiInstance, const PVR_TIMER* timer, PVR_ENTRY_STATE newState);
+
     /*! @todo remove the use complete from them, or add as generl function?!
      * Returns the ffmpeg codec id from given ffmpeg codec string name
      */
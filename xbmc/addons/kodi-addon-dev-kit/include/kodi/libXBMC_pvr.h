@@ -230,6 +230,30 @@ public:
     return m_Callbacks->toKodi.EpgEventStateChange(m_Callbacks->toKodi.kodiInstance, tag, newState);
   }
 
+  /*!
+   * @brief Notify a state change for a recording. Cheaper than TriggerRecordingUpdate for single changes,
+   *        as Kodi does not request the complete list of recordings.
+   * @param recording The recording.
+   * @param newState The new state. For PVR_ENTRY_CREATED and PVR_ENTRY_UPDATED, recording must be filled with all available
+   *        data, not just a delta. For PVR_ENTRY_DELETED, it is sufficient to fill PVR_RECORDING.strRecordingId
+   */
+  void RecordingStateChange(const PVR_RECORDING *recording, PVR_ENTRY_STATE newState)
+  {
+    return m_Callbacks->toKodi.RecordingStateChange(m_Callbacks->toKodi.kodiInstance, recording, newState);
+  }
+
+  /*!
+   * @brief Notify a state change for a timer. Cheaper than TriggerTimerUpdate for single changes,
+   *        as Kodi does not request the complete list of timers.
+   * @param timer The timer.
+   * @param newState The new state. For PVR_ENTRY_CREATED and PVR_ENTRY_UPDATED, timer must be filled with all available
+   *        data, not just a delta. For PVR_ENTRY_DELETED, it is sufficient to fill PVR_TIMER.iClientIndex
+   */
+  void TimerStateChange(const PVR_TIMER *timer, PVR_ENTRY_STATE newState)
+  {
+    return m_Callbacks->toKodi.TimerStateChange(m_Callbacks->toKodi.kodiInstance, timer, newState);
+  }
+
   /*!
    * @brief Get the codec id used by XBMC
    * @param strCodecName The name of the codec
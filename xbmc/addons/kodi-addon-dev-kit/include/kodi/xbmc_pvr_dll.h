@@ -240,7 +240,8 @@ extern "C"
   /** @name PVR recording methods
    *  @remarks Only used by XBMC is bSupportsRecordings is set to true.
    *           If a recording changes after the initial import, or if a new one was added,
-   *           then the add-on should call TriggerRecordingUpdate()
+   *           then the add-on should call TriggerRecordingUpdate(), or RecordingStateChange() for
+   *           every recording that was added, changed or deleted.
    */
   //@{
   /*!
@@ -347,7 +348,8 @@ extern "C"
   /** @name PVR timer methods
    *  @remarks Only used by XBMC is bSupportsTimers is set to true.
    *           If a timer changes after the initial import, or if a new one was added,
-   *           then the add-on should call TriggerTimerUpdate()
+   *           then the add-on should call TriggerTimerUpdate(), or TimerStateChange() for
+   *           every timer that was added, changed or deleted.
    */
   //@{
   /*!
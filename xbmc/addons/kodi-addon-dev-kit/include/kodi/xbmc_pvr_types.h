@@ -261,6 +261,16 @@ extern "C" {
     PVR_CONNECTION_STATE_CONNECTING         = 7,  /*!< @brief connecting to backend */
   } PVR_CONNECTION_STATE;
 
+  /*!
+   * @brief PVR recording and timer entry states. Used with RecordingStateChange and TimerStateChange callbacks.
+   */
+  typedef enum
+  {
+    PVR_ENTRY_CREATED = 0,  /*!< @brief entry created */
+    PVR_ENTRY_UPDATED = 1,  /*!< @brief entry updated */
+    PVR_ENTRY_DELETED = 2,  /*!< @brief entry deleted */
+  } PVR_ENTRY_STATE;
+
   /*!
    * @brief PVR recording channel types
    */
@@ -625,6 +635,9 @@ extern "C" {
     void (*EpgEventStateChange)(void* kodiInstance, EPG_TAG* tag, EPG_EVENT_STATE newState);
 
     xbmc_codec_t (*GetCodecByName)(const void* kodiInstance, const char* strCodecName);
+
+    void (*RecordingStateChange)(void* kodiInstance, const PVR_RECORDING* recording, PVR_ENTRY_STATE newState);
+    void (*TimerStateChange)(void* kodiInstance, const PVR_TIMER* timer, PVR_ENTRY_STATE newState);
   } AddonToKodiFuncTable_PVR;
 
   /*!
@@ -26,6 +26,7 @@
 #include "threads/SingleLock.h"
 #include "utils/log.h"
 #include "utils/TimeUtils.h"
+#include "utils/Trace.h"
 
 #include <inttypes.h>
 
@@ -167,6 +168,7 @@ void CDVDClock::SetSpeed(int iSpeed)
 void CDVDClock::SetSpeedAdjust(double adjust)
 {
   CLog::Log(LOGDEBUG, "CDVDClock::SetSpeedAdjust - adjusted:%f", adjust);
+  KODI_TRACE(LOGAVTIMING, TraceEvent::ClockSpeedAdjust, adjust);
 
   CSingleLock lock(m_critSection);
   m_speedAdjust = adjust;
@@ -213,6 +215,7 @@ double CDVDClock::ErrorAdjust(double error, const char* log)
 
   Discontinuity(clock+adjustment, absolute);
 
+  KODI_TRACE(LOGAVTIMING, TraceEvent::ClockErrorAdjust, error, adjustment, log);
   CLog::Log(LOGDEBUG, "CDVDClock::ErrorAdjust - %s - error:%f, adjusted:%f",
                       log, error, adjustment);
   return adjustment;
@@ -220,6 +223,8 @@ double CDVDClock::ErrorAdjust(double error, const char* log)
 
 void CDVDClock::Discontinuity(double clock, double absolute)
 {
+  KODI_TRACE(LOGAVTIMING, TraceEvent::ClockDiscontinuity, clock, absolute);
+
   CSingleLock lock(m_critSection);
   m_startClock = AbsoluteToSystem(absolute);
   if(m_pauseClock)
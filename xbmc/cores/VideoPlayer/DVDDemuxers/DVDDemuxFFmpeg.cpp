@@ -80,6 +80,10 @@ static const struct StereoModeConversionMap WmvToInternalStereoModeMap[] =
 };
 
 #define FF_MAX_EXTRADATA_SIZE ((1 << 28) - AV_INPUT_BUFFER_PADDING_SIZE)
+// packets checked against cached stream info before it is trusted
+#define PROBE_CACHE_VERIFY_PACKETS 1000
+// larger extradata, e.g. subtitle headers, is not worth keeping in the probe cache
+#define PROBE_CACHE_MAX_EXTRADATA_SIZE (64 * 1024)
 
 std::string CDemuxStreamAudioFFmpeg::GetStreamName()
 {
@@ -214,6 +218,9 @@ bool CDVDDemuxFFmpeg::Open(CDVDInputStream* pInput, bool streaminfo, bool filein
   m_speed = DVD_PLAYSPEED_NORMAL;
   m_program = UINT_MAX;
   m_seekToKeyFrame = false;
+  m_probeCacheKey.clear();
+  m_probeCacheVerifyPackets = 0;
+  m_probeCacheStartTimePending = false;
 
   const AVIOInterruptCB int_cb = { interrupt_cb, this };
 
@@ -465,26 +472,42 @@ bool CDVDDemuxFFmpeg::Open(CDVDInputStream* pInput, bool streaminfo, bool filein
     if(m_pInput->IsStreamType(DVDSTREAM_TYPE_DVD))
       av_opt_set_int(m_pFormatContext, "analyzeduration", 500000, 0);
 
-    CLog::Log(LOGDEBUG, "%s - avformat_find_stream_info starting", __FUNCTION__);
-    int iErr = avformat_find_stream_info(m_pFormatContext, NULL);
-    if (iErr < 0)
+    // streams opened before only need the results of probing, verify them while reading
+    m_probeCacheKey = GetProbeCacheKey();
+    if (!m_probeCacheKey.empty() &&
+        CDVDDemuxProbeCache::GetInstance().Get(m_probeCacheKey, m_probeCacheEntry) &&
+        ApplyProbeCache(m_probeCacheEntry))
     {
-      CLog::Log(LOGWARNING,"could not find codec parameters for %s", CURL::GetRedacted(strFile).c_str());
-      if (m_pInput->IsStreamType(DVDSTREAM_TYPE_DVD) ||
-          m_pInput->IsStreamType(DVDSTREAM_TYPE_BLURAY) ||
-          (m_pFormatContext->nb_streams == 1 &&
-           m_pFormatContext->streams[0]->codecpar->codec_id == AV_CODEC_ID_AC3) ||
-          m_checkvideo)
-      {
-        // special case, our codecs can still handle it.
-      }
-      else
+      CLog::Log(LOGDEBUG, "%s - using cached stream info instead of avformat_find_stream_info", __FUNCTION__);
+      m_probeCacheVerifyPackets = PROBE_CACHE_VERIFY_PACKETS;
+      m_probeCacheStartTimePending = m_pFormatContext->start_time == (int64_t)AV_NOPTS_VALUE;
+    }
+    else
+    {
+      CLog::Log(LOGDEBUG, "%s - avformat_find_stream_info starting", __FUNCTION__);
+      unsigned int iStartTime = XbmcThreads::SystemClockMillis();
+      int iErr = avformat_find_stream_info(m_pFormatContext, NULL);
+      if (iErr < 0)
       {
-        Dispose();
-        return false;
+        CLog::Log(LOGWARNING,"could not find codec parameters for %s", CURL::GetRedacted(strFile).c_str());
+        if (m_pInput->IsStreamType(DVDSTREAM_TYPE_DVD) ||
+            m_pInput->IsStreamType(DVDSTREAM_TYPE_BLURAY) ||
+            (m_pFormatContext->nb_streams == 1 &&
+             m_pFormatContext->streams[0]->codecpar->codec_id == AV_CODEC_ID_AC3) ||
+            m_checkvideo)
+        {
+          // special case, our codecs can still handle it.
+        }
+        else
+        {
+          Dispose();
+          return false;
+        }
       }
+      else if (!m_probeCacheKey.empty())
+        StoreProbeCache();
+      CLog::Log(LOGDEBUG, "%s - av_find_stream_info finished after %u ms", __FUNCTION__, XbmcThreads::SystemClockMillis() - iStartTime);
     }
-    CLog::Log(LOGDEBUG, "%s - av_find_stream_info finished", __FUNCTION__);
 
     if (m_checkvideo)
     {
@@ -935,6 +958,23 @@ DemuxPacket* CDVDDemuxFFmpeg::Read()
     {
       ParsePacket(&m_pkt.pkt);
 
+      if (m_probeCacheStartTimePending)
+        UpdateStartTimeFromPacket(m_pkt.pkt);
+
+      if (m_probeCacheVerifyPackets > 0 && !VerifyProbeCache(m_pkt.pkt.stream_index))
+      {
+        // the streams were opened with wrong parameters, probe them now and let the player open them again.
+        // the packet that was read stays saved and is returned by the next read
+        ProbeStreamInfo();
+        CreateStreams(m_program);
+
+        pPacket = CDVDDemuxUtils::AllocateDemuxPacket(0);
+        pPacket->iStreamId = DMX_SPECIALID_STREAMCHANGE;
+        pPacket->demuxerId = m_demuxerId;
+
+        return pPacket;
+      }
+
       if (IsProgramChange())
       {
         // update streams
@@ -2086,3 +2126,266 @@ void CDVDDemuxFFmpeg::GetL16Parameters(int &channels, int &samplerate)
     }
   }
 }
+
+std::string CDVDDemuxFFmpeg::GetProbeCacheKey()
+{
+  // the streams of discs and adaptive streams depend on what is played
+  if (m_pInput->IsStreamType(DVDSTREAM_TYPE_DVD) ||
+      m_pInput->IsStreamType(DVDSTREAM_TYPE_BLURAY) ||
+      m_pInput->IsStreamType(DVDSTREAM_TYPE_MULTIFILES) ||
+      strcmp(m_pFormatContext->iformat->name, "hls,applehttp") == 0)
+    return "";
+
+  std::string strFile = m_pInput->GetFileName();
+  std::string key;
+  if (m_pInput->IsStreamType(DVDSTREAM_TYPE_PVRMANAGER) || m_pInput->IsRealtime())
+  {
+    // live streams are identified by the channel
+    key = strFile;
+  }
+  else
+  {
+    // files are identified by size and modification time, so that changed files are probed again
+    if (URIUtils::IsInternetStream(strFile))
+      return "";
+
+    struct __stat64 st;
+    if (XFILE::CFile::Stat(strFile, &st) != 0 || st.st_size <= 0 || st.st_mtime == 0)
+      return "";
+
+    key = StringUtils::Format("%s|%" PRId64 "|%" PRId64, strFile.c_str(),
+                              static_cast<int64_t>(st.st_size), static_cast<int64_t>(st.st_mtime));
+  }
+
+  // the program selects the service of a transport stream
+  CVariant programProp(m_pInput->GetProperty("program"));
+  if (!programProp.isNull())
+    key += StringUtils::Format("|%" PRId64, programProp.asInteger());
+
+  return key;
+}
+
+bool CDVDDemuxFFmpeg::ApplyProbeCache(const CDVDDemuxProbeCache::Entry& entry)
+{
+  // the header has to describe the same streams as the cached ones
+  if (entry.format != m_pFormatContext->iformat->name ||
+      entry.streams.size() != m_pFormatContext->nb_streams ||
+      m_pFormatContext->nb_programs > 1)
+    return false;
+
+  for (unsigned int i = 0; i < m_pFormatContext->nb_streams; i++)
+  {
+    const AVCodecParameters* par = m_pFormatContext->streams[i]->codecpar;
+    const CDVDDemuxProbeCache::Stream& cached = entry.streams[i];
+    if (par->codec_type != cached.iCodecType ||
+        par->codec_id != cached.iCodecId ||
+        (par->width && par->width != cached.iWidth) ||
+        (par->height && par->height != cached.iHeight) ||
+        (par->sample_rate && par->sample_rate != cached.iSampleRate) ||
+        (par->channels && par->channels != cached.iChannels))
+      return false;
+  }
+
+  if (m_pFormatContext->start_time == (int64_t)AV_NOPTS_VALUE)
+    m_pFormatContext->start_time = entry.iStartTime;
+  if (m_pFormatContext->duration == (int64_t)AV_NOPTS_VALUE)
+    m_pFormatContext->duration = entry.iDuration;
+
+  // only fill in what the header did not tell
+  for (unsigned int i = 0; i < m_pFormatContext->nb_streams; i++)
+  {
+    AVStream* st = m_pFormatContext->streams[i];
+    AVCodecParameters* par = st->codecpar;
+    const CDVDDemuxProbeCache::Stream& cached = entry.streams[i];
+
+    if (par->extradata_size == 0 && !cached.extraData.empty())
+    {
+      par->extradata = static_cast<uint8_t*>(av_mallocz(cached.extraData.size() + AV_INPUT_BUFFER_PADDING_SIZE));
+      if (par->extradata)
+      {
+        memcpy(par->extradata, cached.extraData.data(), cached.extraData.size());
+        par->extradata_size = cached.extraData.size();
+      }
+    }
+
+    if (!par->codec_tag)
+      par->codec_tag = cached.iCodecTag;
+    if (par->format < 0)
+      par->format = cached.iFormat;
+    if (par->profile == FF_PROFILE_UNKNOWN)
+      par->profile = cached.iProfile;
+    if (par->level == FF_LEVEL_UNKNOWN)
+      par->level = cached.iLevel;
+    if (!par->bits_per_coded_sample)
+      par->bits_per_coded_sample = cached.iBitsPerCodedSample;
+    if (!par->bit_rate)
+      par->bit_rate = cached.iBitRate;
+
+    if (!par->width && !par->height)
+    {
+      par->width = cached.iWidth;
+      par->height = cached.iHeight;
+    }
+    if (!par->sample_aspect_ratio.num)
+      par->sample_aspect_ratio = av_make_q(cached.iSampleAspectNum, cached.iSampleAspectDen);
+    if (par->field_order == AV_FIELD_UNKNOWN)
+      par->field_order = static_cast<AVFieldOrder>(cached.iFieldOrder);
+    if (par->color_range == AVCOL_RANGE_UNSPECIFIED)
+      par->color_range = static_cast<AVColorRange>(cached.iColorRange);
+    if (par->color_primaries == AVCOL_PRI_UNSPECIFIED)
+      par->color_primaries = static_cast<AVColorPrimaries>(cached.iColorPrimaries);
+    if (par->color_trc == AVCOL_TRC_UNSPECIFIED)
+      par->color_trc = static_cast<AVColorTransferCharacteristic>(cached.iColorTrc);
+    if (par->color_space == AVCOL_SPC_UNSPECIFIED)
+      par->color_space = static_cast<AVColorSpace>(cached.iColorSpace);
+    if (par->chroma_location == AVCHROMA_LOC_UNSPECIFIED)
+      par->chroma_location = static_cast<AVChromaLocation>(cached.iChromaLocation);
+
+    if (!par->sample_rate)
+      par->sample_rate = cached.iSampleRate;
+    if (!par->channels)
+      par->channels = cached.iChannels;
+    if (!par->channel_layout)
+      par->channel_layout = cached.iChannelLayout;
+    if (!par->block_align)
+      par->block_align = cached.iBlockAlign;
+    if (!par->frame_size)
+      par->frame_size = cached.iFrameSize;
+
+    if (!st->r_frame_rate.num)
+      st->r_frame_rate = av_make_q(cached.iFrameRateNum, cached.iFrameRateDen);
+    if (!st->avg_frame_rate.num)
+      st->avg_frame_rate = av_make_q(cached.iAvgFrameRateNum, cached.iAvgFrameRateDen);
+    if (st->start_time == (int64_t)AV_NOPTS_VALUE)
+      st->start_time = cached.iStartTime;
+    if (st->duration == (int64_t)AV_NOPTS_VALUE)
+      st->duration = cached.iDuration;
+  }
+
+  return true;
+}
+
+void CDVDDemuxFFmpeg::StoreProbeCache()
+{
+  // timestamps of live streams differ every time they are opened
+  bool bLive = m_pInput->IsStreamType(DVDSTREAM_TYPE_PVRMANAGER) || m_pInput->IsRealtime();
+
+  CDVDDemuxProbeCache::Entry entry;
+  entry.format = m_pFormatContext->iformat->name;
+  entry.iStartTime = bLive ? (int64_t)AV_NOPTS_VALUE : m_pFormatContext->start_time;
+  entry.iDuration = bLive ? (int64_t)AV_NOPTS_VALUE : m_pFormatContext->duration;
+
+  for (unsigned int i = 0; i < m_pFormatContext->nb_streams; i++)
+  {
+    const AVStream* st = m_pFormatContext->streams[i];
+    const AVCodecParameters* par = st->codecpar;
+
+    // streams that were not identified are probed again next time
+    if ((par->codec_type == AVMEDIA_TYPE_VIDEO || par->codec_type == AVMEDIA_TYPE_AUDIO) &&
+        par->codec_id == AV_CODEC_ID_NONE)
+      return;
+
+    if (par->extradata_size > PROBE_CACHE_MAX_EXTRADATA_SIZE)
+      return;
+
+    CDVDDemuxProbeCache::Stream stream;
+    stream.iCodecType = par->codec_type;
+    stream.iCodecId = par->codec_id;
+    stream.iCodecTag = par->codec_tag;
+    stream.iFormat = par->format;
+    stream.iProfile = par->profile;
+    stream.iLevel = par->level;
+    stream.iBitsPerCodedSample = par->bits_per_coded_sample;
+    stream.iBitRate = par->bit_rate;
+    stream.iWidth = par->width;
+    stream.iHeight = par->height;
+    stream.iSampleAspectNum = par->sample_aspect_ratio.num;
+    stream.iSampleAspectDen = par->sample_aspect_ratio.den;
+    stream.iFieldOrder = par->field_order;
+    stream.iColorRange = par->color_range;
+    stream.iColorPrimaries = par->color_primaries;
+    stream.iColorTrc = par->color_trc;
+    stream.iColorSpace = par->color_space;
+    stream.iChromaLocation = par->chroma_location;
+    stream.iSampleRate = par->sample_rate;
+    stream.iChannels = par->channels;
+    stream.iChannelLayout = par->channel_layout;
+    stream.iBlockAlign = par->block_align;
+    stream.iFrameSize = par->frame_size;
+    stream.iFrameRateNum = st->r_frame_rate.num;
+    stream.iFrameRateDen = st->r_frame_rate.den;
+    stream.iAvgFrameRateNum = st->avg_frame_rate.num;
+    stream.iAvgFrameRateDen = st->avg_frame_rate.den;
+    stream.iStartTime = bLive ? (int64_t)AV_NOPTS_VALUE : st->start_time;
+    stream.iDuration = bLive ? (int64_t)AV_NOPTS_VALUE : st->duration;
+    if (par->extradata)
+      stream.extraData.assign(reinterpret_cast<const char*>(par->extradata), par->extradata_size);
+
+    entry.streams.push_back(std::move(stream));
+  }
+
+  CDVDDemuxProbeCache::GetInstance().Set(m_probeCacheKey, entry);
+}
+
+bool CDVDDemuxFFmpeg::VerifyProbeCache(int streamIdx)
+{
+  bool bMatches = m_pFormatContext->nb_streams == m_probeCacheEntry.streams.size();
+  if (bMatches)
+  {
+    // parameters found while reading, e.g. by the parser, have to agree with the cached ones
+    const AVCodecParameters* par = m_pFormatContext->streams[streamIdx]->codecpar;
+    const CDVDDemuxProbeCache::Stream& cached = m_probeCacheEntry.streams[streamIdx];
+    bMatches = par->codec_id == cached.iCodecId &&
+               (par->codec_type != AVMEDIA_TYPE_VIDEO || !cached.iWidth ||
+                (par->width == cached.iWidth && par->height == cached.iHeight)) &&
+               (par->codec_type != AVMEDIA_TYPE_AUDIO || !cached.iSampleRate ||
+                (par->sample_rate == cached.iSampleRate && par->channels == cached.iChannels));
+  }
+
+  if (!bMatches)
+  {
+    CLog::Log(LOGDEBUG, "%s - cached stream info does not match %s, dropping it", __FUNCTION__, CURL::GetRedacted(m_pInput->GetFileName()).c_str());
+    CDVDDemuxProbeCache::GetInstance().Remove(m_probeCacheKey);
+    m_probeCacheVerifyPackets = 0;
+  }
+  else
+    m_probeCacheVerifyPackets--;
+
+  return bMatches;
+}
+
+void CDVDDemuxFFmpeg::UpdateStartTimeFromPacket(const AVPacket& pkt)
+{
+  // like avformat_find_stream_info, start at the first timestamp of the stream
+  int64_t ts = pkt.pts != (int64_t)AV_NOPTS_VALUE ? pkt.pts : pkt.dts;
+  if (ts == (int64_t)AV_NOPTS_VALUE)
+    return;
+
+  AVStream* st = m_pFormatContext->streams[pkt.stream_index];
+  if (st->start_time == (int64_t)AV_NOPTS_VALUE)
+    st->start_time = ts;
+
+  m_pFormatContext->start_time = av_rescale_q(ts, st->time_base, AV_TIME_BASE_Q);
+  m_probeCacheStartTimePending = false;
+}
+
+void CDVDDemuxFFmpeg::ProbeStreamInfo()
+{
+  CLog::Log(LOGDEBUG, "%s - avformat_find_stream_info starting", __FUNCTION__);
+  unsigned int iStartTime = XbmcThreads::SystemClockMillis();
+
+  // probing has to read until it has seen enough of every stream
+  m_pFormatContext->flags &= ~AVFMT_FLAG_NONBLOCK;
+  m_timeout.Set(30000);
+  int iErr = avformat_find_stream_info(m_pFormatContext, NULL);
+  m_timeout.SetInfinite();
+  m_pFormatContext->flags |= AVFMT_FLAG_NONBLOCK;
+
+  if (iErr < 0)
+    CLog::Log(LOGWARNING, "%s - could not find codec parameters for %s", __FUNCTION__, CURL::GetRedacted(m_pInput->GetFileName()).c_str());
+  else if (!m_probeCacheKey.empty())
+    StoreProbeCache();
+
+  m_probeCacheStartTimePending = false;
+  CLog::Log(LOGDEBUG, "%s - av_find_stream_info finished after %u ms", __FUNCTION__, XbmcThreads::SystemClockMillis() - iStartTime);
+}
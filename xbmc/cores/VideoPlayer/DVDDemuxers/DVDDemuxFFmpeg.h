@@ -21,6 +21,7 @@
  */
 
 #include "DVDDemux.h"
+#include "DVDDemuxProbeCache.h"
 #include "threads/CriticalSection.h"
 #include "threads/SystemClock.h"
 #include <map>
@@ -135,6 +136,13 @@ protected:
   bool IsProgramChange();
   unsigned int HLSSelectProgram();
 
+  std::string GetProbeCacheKey();
+  bool ApplyProbeCache(const CDVDDemuxProbeCache::Entry& entry);
+  void StoreProbeCache();
+  bool VerifyProbeCache(int streamIdx);
+  void UpdateStartTimeFromPacket(const AVPacket& pkt);
+  void ProbeStreamInfo();
+
   std::string GetStereoModeFromMetadata(AVDictionary *pMetadata);
   std::string ConvertCodecToInternalStereoMode(const std::string &mode, const StereoModeConversionMap *conversionMap);
 
@@ -169,5 +177,10 @@ protected:
   int m_displayTime = 0;
   double m_dtsAtDisplayTime;
   bool m_seekToKeyFrame = false;
+
+  std::string m_probeCacheKey;               // key of the stream info in the probe cache, empty if not cacheable
+  CDVDDemuxProbeCache::Entry m_probeCacheEntry; // cached stream info used instead of probing
+  int m_probeCacheVerifyPackets = 0;         // packets left to check against the cached stream info
+  bool m_probeCacheStartTimePending = false; // start time is taken from the first packet, as the cache has none for live streams
 };
 
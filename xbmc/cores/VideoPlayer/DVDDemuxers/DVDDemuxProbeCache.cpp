@@ -0,0 +1,327 @@
+/*
+ *      Copyright (C) 2017 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "DVDDemuxProbeCache.h"
+
+#include <cstring>
+#include <iterator>
+
+#include "filesystem/File.h"
+#include "threads/SingleLock.h"
+#include "utils/JobManager.h"
+#include "utils/auto_buffer.h"
+#include "utils/log.h"
+
+namespace
+{
+  const char CACHE_MAGIC[4] = { 'K', 'P', 'C', 'F' };
+  const uint32_t CACHE_VERSION = 1;
+
+  /* the cache file is local to this machine, values are stored in host byte order */
+  class CWriter
+  {
+  public:
+    explicit CWriter(std::string& data) : m_data(data) {}
+
+    template<typename T>
+    void operator()(const T& value)
+    {
+      m_data.append(reinterpret_cast<const char*>(&value), sizeof(value));
+    }
+
+    void operator()(const std::string& value)
+    {
+      (*this)(static_cast<uint32_t>(value.size()));
+      m_data.append(value);
+    }
+
+  private:
+    std::string& m_data;
+  };
+
+  class CReader
+  {
+  public:
+    explicit CReader(const std::string& data) : m_data(data) {}
+
+    template<typename T>
+    void operator()(T& value)
+    {
+      if (m_bError || m_data.size() - m_position < sizeof(value))
+      {
+        m_bError = true;
+        return;
+      }
+      memcpy(&value, m_data.data() + m_position, sizeof(value));
+      m_position += sizeof(value);
+    }
+
+    void operator()(std::string& value)
+    {
+      uint32_t size = 0;
+      (*this)(size);
+      if (m_bError || m_data.size() - m_position < size)
+      {
+        m_bError = true;
+        return;
+      }
+      value.assign(m_data, m_position, size);
+      m_position += size;
+    }
+
+    bool IsError() const { return m_bError; }
+    bool IsEnd() const { return m_position == m_data.size(); }
+
+  private:
+    const std::string& m_data;
+    size_t m_position = 0;
+    bool m_bError = false;
+  };
+
+  template<typename Archive, typename StreamType>
+  void SerializeStream(Archive& ar, StreamType& stream)
+  {
+    ar(stream.iCodecType);
+    ar(stream.iCodecId);
+    ar(stream.iCodecTag);
+    ar(stream.iFormat);
+    ar(stream.iProfile);
+    ar(stream.iLevel);
+    ar(stream.iBitsPerCodedSample);
+    ar(stream.iBitRate);
+    ar(stream.iWidth);
+    ar(stream.iHeight);
+    ar(stream.iSampleAspectNum);
+    ar(stream.iSampleAspectDen);
+    ar(stream.iFieldOrder);
+    ar(stream.iColorRange);
+    ar(stream.iColorPrimaries);
+    ar(stream.iColorTrc);
+    ar(stream.iColorSpace);
+    ar(stream.iChromaLocation);
+    ar(stream.iSampleRate);
+    ar(stream.iChannels);
+    ar(stream.iChannelLayout);
+    ar(stream.iBlockAlign);
+    ar(stream.iFrameSize);
+    ar(stream.iFrameRateNum);
+    ar(stream.iFrameRateDen);
+    ar(stream.iAvgFrameRateNum);
+    ar(stream.iAvgFrameRateDen);
+    ar(stream.iStartTime);
+    ar(stream.iDuration);
+    ar(stream.extraData);
+  }
+}
+
+CDVDDemuxProbeCache& CDVDDemuxProbeCache::GetInstance()
+{
+  static CDVDDemuxProbeCache probeCache("special://temp/streamprobecache.dat", 500);
+  return probeCache;
+}
+
+CDVDDemuxProbeCache::CDVDDemuxProbeCache(const std::string& file, size_t maxEntries)
+  : m_file(file),
+    m_maxEntries(maxEntries),
+    m_bLoaded(false),
+    m_bSavePending(false)
+{
+}
+
+bool CDVDDemuxProbeCache::Get(const std::string& key, Entry& entry)
+{
+  CSingleLock lock(m_critSection);
+  if (!m_bLoaded)
+    Load();
+
+  auto it = m_index.find(key);
+  if (it == m_index.end())
+    return false;
+
+  m_entries.splice(m_entries.begin(), m_entries, it->second);
+  entry = it->second->second;
+  return true;
+}
+
+void CDVDDemuxProbeCache::Set(const std::string& key, const Entry& entry)
+{
+  CSingleLock lock(m_critSection);
+  if (!m_bLoaded)
+    Load();
+
+  auto it = m_index.find(key);
+  if (it != m_index.end())
+  {
+    it->second->second = entry;
+    m_entries.splice(m_entries.begin(), m_entries, it->second);
+  }
+  else
+  {
+    m_entries.emplace_front(key, entry);
+    m_index[key] = m_entries.begin();
+
+    while (m_entries.size() > m_maxEntries)
+    {
+      m_index.erase(m_entries.back().first);
+      m_entries.pop_back();
+    }
+  }
+
+  ScheduleSave();
+}
+
+void CDVDDemuxProbeCache::Remove(const std::string& key)
+{
+  CSingleLock lock(m_critSection);
+  if (!m_bLoaded)
+    Load();
+
+  auto it = m_index.find(key);
+  if (it == m_index.end())
+    return;
+
+  m_entries.erase(it->second);
+  m_index.erase(it);
+
+  ScheduleSave();
+}
+
+std::string CDVDDemuxProbeCache::Serialize() const
+{
+  std::string data;
+  CWriter writer(data);
+
+  data.append(CACHE_MAGIC, sizeof(CACHE_MAGIC));
+  writer(CACHE_VERSION);
+
+  CSingleLock lock(m_critSection);
+  writer(static_cast<uint32_t>(m_entries.size()));
+  for (const auto& keyAndEntry : m_entries)
+  {
+    const Entry& entry = keyAndEntry.second;
+    writer(keyAndEntry.first);
+    writer(entry.format);
+    writer(entry.iStartTime);
+    writer(entry.iDuration);
+    writer(static_cast<uint32_t>(entry.streams.size()));
+    for (const auto& stream : entry.streams)
+      SerializeStream(writer, stream);
+  }
+
+  return data;
+}
+
+bool CDVDDemuxProbeCache::Deserialize(const std::string& data)
+{
+  CSingleLock lock(m_critSection);
+  m_entries.clear();
+  m_index.clear();
+
+  if (data.size() < sizeof(CACHE_MAGIC) || memcmp(data.data(), CACHE_MAGIC, sizeof(CACHE_MAGIC)) != 0)
+    return false;
+
+  CReader reader(data);
+  char magic[sizeof(CACHE_MAGIC)];
+  reader(magic);
+
+  uint32_t version = 0;
+  uint32_t entryCount = 0;
+  reader(version);
+  reader(entryCount);
+  if (reader.IsError() || version != CACHE_VERSION)
+    return false;
+
+  EntryList entries;
+  for (uint32_t i = 0; i < entryCount && !reader.IsError(); ++i)
+  {
+    std::string key;
+    Entry entry;
+    uint32_t streamCount = 0;
+    reader(key);
+    reader(entry.format);
+    reader(entry.iStartTime);
+    reader(entry.iDuration);
+    reader(streamCount);
+    for (uint32_t j = 0; j < streamCount && !reader.IsError(); ++j)
+    {
+      Stream stream;
+      SerializeStream(reader, stream);
+      entry.streams.push_back(std::move(stream));
+    }
+    entries.emplace_back(std::move(key), std::move(entry));
+  }
+
+  if (reader.IsError() || !reader.IsEnd())
+    return false;
+
+  for (auto it = entries.begin(); it != entries.end() && m_entries.size() < m_maxEntries; ++it)
+  {
+    if (m_index.find(it->first) != m_index.end())
+      continue;
+
+    m_entries.push_back(std::move(*it));
+    m_index[m_entries.back().first] = std::prev(m_entries.end());
+  }
+
+  return true;
+}
+
+void CDVDDemuxProbeCache::Load()
+{
+  m_bLoaded = true;
+  if (m_file.empty() || !XFILE::CFile::Exists(m_file))
+    return;
+
+  XFILE::CFile file;
+  XUTILS::auto_buffer buffer;
+  if (file.LoadFile(m_file, buffer) <= 0)
+    return;
+
+  if (!Deserialize(std::string(buffer.get(), buffer.size())))
+    CLog::Log(LOGWARNING, "CDVDDemuxProbeCache::%s - ignoring invalid cache file %s", __FUNCTION__, m_file.c_str());
+}
+
+void CDVDDemuxProbeCache::ScheduleSave()
+{
+  if (m_file.empty() || m_bSavePending)
+    return;
+
+  m_bSavePending = true;
+  CJobManager::GetInstance().Submit([this]() {
+    Save();
+  });
+}
+
+void CDVDDemuxProbeCache::Save()
+{
+  CSingleLock saveLock(m_saveSection);
+
+  std::string data;
+  {
+    CSingleLock lock(m_critSection);
+    m_bSavePending = false;
+    data = Serialize();
+  }
+
+  XFILE::CFile file;
+  if (!file.OpenForWrite(m_file, true) ||
+      file.Write(data.data(), data.size()) != static_cast<ssize_t>(data.size()))
+    CLog::Log(LOGERROR, "CDVDDemuxProbeCache::%s - failed to write %s", __FUNCTION__, m_file.c_str());
+}
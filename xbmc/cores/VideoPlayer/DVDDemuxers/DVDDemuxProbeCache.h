@@ -0,0 +1,141 @@
+#pragma once
+
+/*
+ *      Copyright (C) 2017 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <list>
+#include <stdint.h>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "threads/CriticalSection.h"
+
+/*!
+ * @brief Cache of the stream parameters found by probing a file or channel.
+ *
+ * Probing a stream with avformat_find_stream_info reads and decodes data until
+ * the parameters of all streams are known, which takes seconds for transport
+ * streams and network sources. The results are kept per key, the most recently
+ * used entries first, and persisted to a file so they survive a restart.
+ *
+ * The values mirror the AVCodecParameters and AVStream fields of the same
+ * name, so that this class does not depend on ffmpeg.
+ */
+class CDVDDemuxProbeCache
+{
+public:
+  struct Stream
+  {
+    int iCodecType = -1;
+    int iCodecId = 0;
+    uint32_t iCodecTag = 0;
+    int iFormat = -1;
+    int iProfile = 0;
+    int iLevel = 0;
+    int iBitsPerCodedSample = 0;
+    int64_t iBitRate = 0;
+    int iWidth = 0;
+    int iHeight = 0;
+    int iSampleAspectNum = 0;
+    int iSampleAspectDen = 0;
+    int iFieldOrder = 0;
+    int iColorRange = 0;
+    int iColorPrimaries = 0;
+    int iColorTrc = 0;
+    int iColorSpace = 0;
+    int iChromaLocation = 0;
+    int iSampleRate = 0;
+    int iChannels = 0;
+    uint64_t iChannelLayout = 0;
+    int iBlockAlign = 0;
+    int iFrameSize = 0;
+    int iFrameRateNum = 0;
+    int iFrameRateDen = 0;
+    int iAvgFrameRateNum = 0;
+    int iAvgFrameRateDen = 0;
+    int64_t iStartTime = 0;
+    int64_t iDuration = 0;
+    std::string extraData;
+  };
+
+  struct Entry
+  {
+    std::string format;     /*!< name of the input format that was probed */
+    int64_t iStartTime = 0; /*!< start time of the format context */
+    int64_t iDuration = 0;  /*!< duration of the format context */
+    std::vector<Stream> streams;
+  };
+
+  /*!
+   * @brief The cache shared by all demuxers, persisted to special://temp.
+   */
+  static CDVDDemuxProbeCache& GetInstance();
+
+  /*!
+   * @param file The file to persist the cache to, empty to keep it in memory only.
+   * @param maxEntries The number of entries to keep.
+   */
+  CDVDDemuxProbeCache(const std::string& file, size_t maxEntries);
+
+  /*!
+   * @brief Look up the probe results for a key and mark them as recently used.
+   * @return True if an entry was found, false otherwise.
+   */
+  bool Get(const std::string& key, Entry& entry);
+
+  /*!
+   * @brief Store the probe results for a key, dropping the least recently used entry if the cache is full.
+   */
+  void Set(const std::string& key, const Entry& entry);
+
+  /*!
+   * @brief Drop the probe results for a key, e.g. because they no longer match the stream.
+   */
+  void Remove(const std::string& key);
+
+  /*!
+   * @brief Serialize all entries into the format of the cache file.
+   */
+  std::string Serialize() const;
+
+  /*!
+   * @brief Replace all entries with the ones from the given cache file data.
+   * @return True on success, false if the data is not a valid cache file. The cache is empty then.
+   */
+  bool Deserialize(const std::string& data);
+
+private:
+  typedef std::list<std::pair<std::string, Entry>> EntryList;
+
+  void Load();
+  void ScheduleSave();
+  void Save();
+
+  const std::string m_file;
+  const size_t m_maxEntries;
+  EntryList m_entries; /*!< most recently used first */
+  std::unordered_map<std::string, EntryList::iterator> m_index;
+  bool m_bLoaded;
+  bool m_bSavePending;
+  mutable CCriticalSection m_critSection;
+  CCriticalSection m_saveSection;
+};
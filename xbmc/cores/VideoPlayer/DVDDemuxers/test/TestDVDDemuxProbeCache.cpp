@@ -0,0 +1,141 @@
+/*
+ *      Copyright (C) 2017 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "cores/VideoPlayer/DVDDemuxers/DVDDemuxProbeCache.h"
+
+#include "gtest/gtest.h"
+
+namespace
+{
+  CDVDDemuxProbeCache::Entry MakeEntry(const std::string& format, int width)
+  {
+    CDVDDemuxProbeCache::Entry entry;
+    entry.format = format;
+    entry.iStartTime = 1400000;
+    entry.iDuration = 5400000000LL;
+
+    CDVDDemuxProbeCache::Stream video;
+    video.iCodecType = 0;
+    video.iCodecId = 28;
+    video.iWidth = width;
+    video.iHeight = width * 9 / 16;
+    video.iFrameRateNum = 25;
+    video.iFrameRateDen = 1;
+    video.extraData = std::string("\x01\x64\x00\x28\xff\x00", 6);
+    entry.streams.push_back(video);
+
+    CDVDDemuxProbeCache::Stream audio;
+    audio.iCodecType = 1;
+    audio.iCodecId = 86019;
+    audio.iSampleRate = 48000;
+    audio.iChannels = 6;
+    audio.iChannelLayout = 0x60f;
+    entry.streams.push_back(audio);
+
+    return entry;
+  }
+}
+
+TEST(TestDVDDemuxProbeCache, SetAndGet)
+{
+  CDVDDemuxProbeCache cache("", 10);
+  CDVDDemuxProbeCache::Entry entry;
+  EXPECT_FALSE(cache.Get("movie.mkv|1000|1", entry));
+
+  cache.Set("movie.mkv|1000|1", MakeEntry("matroska,webm", 1920));
+  ASSERT_TRUE(cache.Get("movie.mkv|1000|1", entry));
+  EXPECT_EQ("matroska,webm", entry.format);
+  ASSERT_EQ(2u, entry.streams.size());
+  EXPECT_EQ(1920, entry.streams[0].iWidth);
+  EXPECT_EQ(6u, entry.streams[0].extraData.size());
+  EXPECT_EQ(48000, entry.streams[1].iSampleRate);
+
+  /* a changed file has a different key */
+  EXPECT_FALSE(cache.Get("movie.mkv|1000|2", entry));
+
+  cache.Set("movie.mkv|1000|1", MakeEntry("matroska,webm", 1280));
+  ASSERT_TRUE(cache.Get("movie.mkv|1000|1", entry));
+  EXPECT_EQ(1280, entry.streams[0].iWidth);
+
+  cache.Remove("movie.mkv|1000|1");
+  EXPECT_FALSE(cache.Get("movie.mkv|1000|1", entry));
+}
+
+TEST(TestDVDDemuxProbeCache, DropsLeastRecentlyUsed)
+{
+  CDVDDemuxProbeCache cache("", 2);
+  CDVDDemuxProbeCache::Entry entry;
+
+  cache.Set("a", MakeEntry("mpegts", 720));
+  cache.Set("b", MakeEntry("mpegts", 720));
+  ASSERT_TRUE(cache.Get("a", entry));
+
+  /* b is the least recently used entry now */
+  cache.Set("c", MakeEntry("mpegts", 720));
+  EXPECT_TRUE(cache.Get("a", entry));
+  EXPECT_FALSE(cache.Get("b", entry));
+  EXPECT_TRUE(cache.Get("c", entry));
+}
+
+TEST(TestDVDDemuxProbeCache, SerializeRoundTrip)
+{
+  CDVDDemuxProbeCache cache("", 10);
+  cache.Set("pvr://channels/tv/All channels/pvr.demo_1.pvr", MakeEntry("mpegts", 720));
+  cache.Set("movie.mkv|1000|1", MakeEntry("matroska,webm", 1920));
+
+  CDVDDemuxProbeCache restored("", 10);
+  ASSERT_TRUE(restored.Deserialize(cache.Serialize()));
+
+  CDVDDemuxProbeCache::Entry entry;
+  ASSERT_TRUE(restored.Get("pvr://channels/tv/All channels/pvr.demo_1.pvr", entry));
+  EXPECT_EQ("mpegts", entry.format);
+  ASSERT_TRUE(restored.Get("movie.mkv|1000|1", entry));
+
+  CDVDDemuxProbeCache::Entry expected = MakeEntry("matroska,webm", 1920);
+  EXPECT_EQ(expected.iStartTime, entry.iStartTime);
+  EXPECT_EQ(expected.iDuration, entry.iDuration);
+  ASSERT_EQ(expected.streams.size(), entry.streams.size());
+  EXPECT_EQ(expected.streams[0].extraData, entry.streams[0].extraData);
+  EXPECT_EQ(expected.streams[0].iHeight, entry.streams[0].iHeight);
+  EXPECT_EQ(expected.streams[0].iFrameRateNum, entry.streams[0].iFrameRateNum);
+  EXPECT_EQ(expected.streams[1].iChannelLayout, entry.streams[1].iChannelLayout);
+
+  /* the order of use survives, the most recently used entry is kept first */
+  CDVDDemuxProbeCache small("", 1);
+  ASSERT_TRUE(small.Deserialize(cache.Serialize()));
+  EXPECT_TRUE(small.Get("movie.mkv|1000|1", entry));
+  EXPECT_FALSE(small.Get("pvr://channels/tv/All channels/pvr.demo_1.pvr", entry));
+}
+
+TEST(TestDVDDemuxProbeCache, RejectsInvalidData)
+{
+  CDVDDemuxProbeCache cache("", 10);
+  cache.Set("movie.mkv|1000|1", MakeEntry("matroska,webm", 1920));
+  std::string data = cache.Serialize();
+
+  CDVDDemuxProbeCache restored("", 10);
+  CDVDDemuxProbeCache::Entry entry;
+  EXPECT_FALSE(restored.Deserialize(data.substr(0, data.size() - 1)));
+  EXPECT_FALSE(restored.Get("movie.mkv|1000|1", entry));
+  EXPECT_FALSE(restored.Deserialize(data + "x"));
+  EXPECT_FALSE(restored.Deserialize("not a cache file"));
+  EXPECT_FALSE(restored.Deserialize(""));
+  EXPECT_TRUE(restored.Deserialize(data));
+}
@@ -20,6 +20,7 @@
 
 #include "DVDFactoryInputStream.h"
 #include "DVDInputStreamPVRManager.h"
+#include "DVDTimeshiftBuffer.h"
 #include "cores/VideoPlayer/Interface/Addon/DemuxPacket.h"
 #include "ServiceBroker.h"
 #include "URL.h"
@@ -32,6 +33,7 @@
 #include "pvr/channels/PVRChannelGroupsContainer.h"
 #include "pvr/recordings/PVRRecordingsPath.h"
 #include "pvr/recordings/PVRRecordings.h"
+#include "settings/AdvancedSettings.h"
 #include "settings/Settings.h"
 #include "cores/VideoPlayer/DVDDemuxers/DVDDemux.h"
 
@@ -51,6 +53,7 @@ CDVDInputStreamPVRManager::CDVDInputStreamPVRManager(IVideoPlayer* pPlayer, cons
   m_eof = true;
   m_ScanTimeout.Set(0);
   m_demuxActive = false;
+  m_timeshiftStartTime = 0;
 
   m_StreamProps = new PVR_STREAM_PROPERTIES;
 }
@@ -140,6 +143,26 @@ bool CDVDInputStreamPVRManager::Open()
       m_demuxActive = true;
   }
 
+  /* buffer live streams locally if the client can neither pause nor seek them */
+  if (!m_isRecording && !m_demuxActive && g_advancedSettings.m_iPVRTimeshiftMemorySize > 0 &&
+      !CServiceBroker::GetPVRManager().Clients()->CanPauseStream() &&
+      !CServiceBroker::GetPVRManager().Clients()->CanSeekStream())
+  {
+    m_timeshiftBuffer.reset(new CDVDTimeshiftBuffer(static_cast<size_t>(g_advancedSettings.m_iPVRTimeshiftMemorySize) * 1024 * 1024,
+                                                    static_cast<int64_t>(g_advancedSettings.m_iPVRTimeshiftDiskSize) * 1024 * 1024));
+    if (m_timeshiftBuffer->Open([](uint8_t* buf, int buf_size) {
+          return CServiceBroker::GetPVRManager().Clients()->ReadStream(buf, buf_size);
+        }))
+    {
+      m_timeshiftStartTime = time(nullptr);
+    }
+    else
+    {
+      CLog::Log(LOGERROR, "CDVDInputStreamPVRManager - %s - failed to open timeshift buffer, using the client stream", __FUNCTION__);
+      m_timeshiftBuffer.reset();
+    }
+  }
+
   CLog::Log(LOGDEBUG, "CDVDInputStreamPVRManager::Open - stream opened: %s", CURL::GetRedacted(m_item.GetDynPath()).c_str());
 
   m_StreamProps->iStreamCount = 0;
@@ -149,8 +172,15 @@ bool CDVDInputStreamPVRManager::Open()
 // close file and reset everything
 void CDVDInputStreamPVRManager::Close()
 {
+  /* the buffer thread may be blocked in a read from the client. stop it from reading again, close the
+     client stream to interrupt the pending read and only then wait for the thread */
+  if (m_timeshiftBuffer)
+    m_timeshiftBuffer->Abort();
+
   CServiceBroker::GetPVRManager().CloseStream();
 
+  m_timeshiftBuffer.reset();
+
   CDVDInputStream::Close();
 
   m_eof = true;
@@ -160,7 +190,9 @@ void CDVDInputStreamPVRManager::Close()
 
 int CDVDInputStreamPVRManager::Read(uint8_t* buf, int buf_size)
 {
-  int ret = CServiceBroker::GetPVRManager().Clients()->ReadStream((BYTE*)buf, buf_size);
+  int ret = m_timeshiftBuffer ?
+    m_timeshiftBuffer->Read(buf, buf_size) :
+    CServiceBroker::GetPVRManager().Clients()->ReadStream((BYTE*)buf, buf_size);
   if (ret < 0)
     ret = -1;
 
@@ -175,13 +207,15 @@ int64_t CDVDInputStreamPVRManager::Seek(int64_t offset, int whence)
 {
   if (whence == SEEK_POSSIBLE)
   {
-    if (CServiceBroker::GetPVRManager().Clients()->CanSeekStream())
+    if (m_timeshiftBuffer || CServiceBroker::GetPVRManager().Clients()->CanSeekStream())
       return 1;
     else
       return 0;
   }
 
-  int64_t ret = CServiceBroker::GetPVRManager().Clients()->SeekStream(offset, whence);
+  int64_t ret = m_timeshiftBuffer ?
+    m_timeshiftBuffer->Seek(offset, whence) :
+    CServiceBroker::GetPVRManager().Clients()->SeekStream(offset, whence);
 
   // if we succeed, we are not eof anymore
   if( ret >= 0 )
@@ -192,6 +226,9 @@ int64_t CDVDInputStreamPVRManager::Seek(int64_t offset, int whence)
 
 int64_t CDVDInputStreamPVRManager::GetLength()
 {
+  if (m_timeshiftBuffer)
+    return m_timeshiftBuffer->GetLength();
+
   return CServiceBroker::GetPVRManager().Clients()->GetStreamLength();
 }
 
@@ -211,6 +248,20 @@ int CDVDInputStreamPVRManager::GetTime()
 
 bool CDVDInputStreamPVRManager::GetTimes(Times &times)
 {
+  if (m_timeshiftBuffer)
+  {
+    /* times of the timeshift buffer are relative to the first PCR of the stream */
+    int iBeginMs, iEndMs;
+    if (!m_timeshiftBuffer->GetTimes(iBeginMs, iEndMs))
+      return false;
+
+    times.startTime = m_timeshiftStartTime;
+    times.ptsStart = 0;
+    times.ptsBegin = DVD_MSEC_TO_TIME(iBeginMs);
+    times.ptsEnd = DVD_MSEC_TO_TIME(iEndMs);
+    return true;
+  }
+
   PVR_STREAM_TIMES streamTimes;
   bool ret = CServiceBroker::GetPVRManager().Clients()->GetStreamTimes(&streamTimes);
   if (ret)
@@ -224,6 +275,23 @@ bool CDVDInputStreamPVRManager::GetTimes(Times &times)
   return ret;
 }
 
+CDVDInputStream::IPosTime* CDVDInputStreamPVRManager::GetIPosTime()
+{
+  if (m_timeshiftBuffer)
+    return this;
+  else
+    return nullptr;
+}
+
+bool CDVDInputStreamPVRManager::PosTime(int ms)
+{
+  if (!m_timeshiftBuffer || !m_timeshiftBuffer->SeekTime(ms))
+    return false;
+
+  m_eof = false;
+  return true;
+}
+
 CPVRChannelPtr CDVDInputStreamPVRManager::GetSelectedChannel()
 {
   return CServiceBroker::GetPVRManager().GetCurrentChannel();
@@ -262,16 +330,26 @@ void CDVDInputStreamPVRManager::Record(bool bOnOff)
 
 bool CDVDInputStreamPVRManager::CanPause()
 {
+  if (m_timeshiftBuffer)
+    return true;
+
   return CServiceBroker::GetPVRManager().Clients()->CanPauseStream();
 }
 
 bool CDVDInputStreamPVRManager::CanSeek()
 {
+  if (m_timeshiftBuffer)
+    return true;
+
   return CServiceBroker::GetPVRManager().Clients()->CanSeekStream();
 }
 
 void CDVDInputStreamPVRManager::Pause(bool bPaused)
 {
+  /* the timeshift buffer keeps receiving the live stream while paused */
+  if (m_timeshiftBuffer)
+    return;
+
   CServiceBroker::GetPVRManager().Clients()->PauseStream(bPaused);
 }
 
@@ -24,6 +24,7 @@
 * for DESCRIPTION see 'DVDInputStreamPVRManager.cpp'
 */
 
+#include <memory>
 #include <vector>
 #include "DVDInputStream.h"
 #include "FileItem.h"
@@ -37,11 +38,13 @@ class CDemuxStreamSubtitle;
 class CDemuxStreamTeletext;
 class CDemuxStreamRadioRDS;
 class IDemux;
+class CDVDTimeshiftBuffer;
 
 class CDVDInputStreamPVRManager
   : public CDVDInputStream
   , public CDVDInputStream::ITimes
   , public CDVDInputStream::IDisplayTime
+  , public CDVDInputStream::IPosTime
   , public CDVDInputStream::IDemux
 {
 public:
@@ -63,6 +66,10 @@ public:
   CDVDInputStream::ITimes* GetITimes() override { return this; }
   bool GetTimes(Times &times) override;
 
+  /* seeking by time is only supported by the local timeshift buffer */
+  CDVDInputStream::IPosTime* GetIPosTime() override;
+  bool PosTime(int ms) override;
+
   // deprecated
   CDVDInputStream::IDisplayTime* GetIDisplayTime() override { return this; }
   int GetTotalTime() override;
@@ -109,6 +116,8 @@ protected:
   PVR_STREAM_PROPERTIES *m_StreamProps;
   std::map<int, std::shared_ptr<CDemuxStream>> m_streamMap;
   bool m_isRecording;
+  std::unique_ptr<CDVDTimeshiftBuffer> m_timeshiftBuffer; /*!< local timeshift buffer for live tv, nullptr if reads are passed to the client */
+  time_t m_timeshiftStartTime;
 };
 
 
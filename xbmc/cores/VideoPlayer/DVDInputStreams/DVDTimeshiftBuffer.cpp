@@ -0,0 +1,470 @@
+/*
+ *      Copyright (C) 2017 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "DVDTimeshiftBuffer.h"
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstring>
+
+#include "URL.h"
+#include "Util.h"
+#include "filesystem/IFile.h"
+#include "filesystem/SpecialProtocol.h"
+#include "threads/SingleLock.h"
+#include "threads/SystemClock.h"
+#include "utils/log.h"
+
+#if defined(TARGET_POSIX)
+#include "filesystem/posix/PosixFile.h"
+#define TimeshiftLocalFile XFILE::CPosixFile
+#elif defined(TARGET_WINDOWS)
+#include "filesystem/win32/Win32File.h"
+#define TimeshiftLocalFile XFILE::CWin32File
+#endif
+
+namespace
+{
+  const size_t TS_PACKET_SIZE = 188;
+  const uint8_t TS_SYNC_BYTE = 0x47;
+  const size_t SOURCE_READ_SIZE = 64 * 1024;
+  const unsigned int READ_TIMEOUT = 10000;   // ms the reader waits for live data before reporting the end of the stream
+  const int64_t PCR_WRAP = 1LL << 33;         // PCR base is a 33 bit counter running at 90 kHz
+  const int PUSI_INDEX_INTERVAL = 1000;      // ms between index entries for streams without random access indicators
+}
+
+CDVDTimeshiftBuffer::CDVDTimeshiftBuffer(size_t memorySize, int64_t diskSize)
+  : CThread("TimeshiftBuffer")
+  , m_memorySize(std::max(memorySize, TS_PACKET_SIZE))
+  , m_diskSize(std::max(diskSize, static_cast<int64_t>(0)))
+  , m_iStart(0)
+  , m_iEnd(0)
+  , m_iReadPosition(0)
+  , m_bEndOfInput(false)
+  , m_bAbort(false)
+  , m_iParsePosition(0)
+  , m_iPcrPid(-1)
+  , m_iFirstPcr(-1)
+  , m_iLastPcr(-1)
+  , m_iLastPcrTimeMs(0)
+  , m_bHasRandomAccessIndicator(false)
+{
+}
+
+CDVDTimeshiftBuffer::~CDVDTimeshiftBuffer()
+{
+  Close();
+}
+
+bool CDVDTimeshiftBuffer::Open(SourceFunction source)
+{
+  Close();
+
+  m_source = source;
+  m_memory.resize(m_memorySize);
+  m_iStart = m_iEnd = m_iReadPosition = 0;
+  m_bEndOfInput = false;
+  m_bAbort = false;
+  m_parseBuffer.clear();
+  m_iParsePosition = 0;
+  m_iPcrPid = -1;
+  m_iFirstPcr = m_iLastPcr = -1;
+  m_iLastPcrTimeMs = 0;
+  m_bHasRandomAccessIndicator = false;
+  m_keyFrames.clear();
+
+  if (m_diskSize > 0)
+  {
+    m_spillFileName = CSpecialProtocol::TranslatePath(CUtil::GetNextFilename("special://temp/timeshift%03d.ts", 999));
+    m_spillFileWrite.reset(new TimeshiftLocalFile());
+    m_spillFileRead.reset(new TimeshiftLocalFile());
+
+    CURL fileURL(m_spillFileName);
+    if (m_spillFileName.empty() ||
+        !m_spillFileWrite->OpenForWrite(fileURL, true) ||
+        !m_spillFileRead->Open(fileURL))
+    {
+      CLog::Log(LOGWARNING, "CDVDTimeshiftBuffer - %s - failed to create spill file '%s', buffering in memory only", __FUNCTION__, m_spillFileName.c_str());
+      m_spillFileWrite.reset();
+      m_spillFileRead.reset();
+      m_diskSize = 0;
+    }
+  }
+
+  CLog::Log(LOGDEBUG, "CDVDTimeshiftBuffer - %s - buffering %zu bytes in memory and %" PRId64" bytes on disk", __FUNCTION__, m_memorySize, m_diskSize);
+
+  Create();
+  return true;
+}
+
+void CDVDTimeshiftBuffer::Abort()
+{
+  {
+    CSingleLock lock(m_critSection);
+    m_bAbort = true;
+  }
+  m_dataAvailable.Set();
+  StopThread(false);
+}
+
+void CDVDTimeshiftBuffer::Close()
+{
+  Abort();
+  StopThread(true);
+
+  CSingleLock lock(m_critSection);
+  m_memory.clear();
+  m_memory.shrink_to_fit();
+  m_keyFrames.clear();
+
+  if (m_spillFileWrite)
+  {
+    m_spillFileWrite->Close();
+    m_spillFileRead->Close();
+    if (!m_spillFileRead->Delete(CURL(m_spillFileName)))
+      CLog::Log(LOGWARNING, "CDVDTimeshiftBuffer - %s - failed to delete spill file '%s'", __FUNCTION__, m_spillFileName.c_str());
+
+    m_spillFileWrite.reset();
+    m_spillFileRead.reset();
+  }
+  m_spillFileName.clear();
+}
+
+void CDVDTimeshiftBuffer::Process()
+{
+  std::vector<uint8_t> buffer(SOURCE_READ_SIZE);
+
+  while (!m_bStop)
+  {
+    int iRead = m_source(buffer.data(), static_cast<int>(buffer.size()));
+    if (iRead <= 0)
+    {
+      if (iRead < 0)
+        CLog::Log(LOGERROR, "CDVDTimeshiftBuffer - %s - failed to read from the live stream", __FUNCTION__);
+      break;
+    }
+
+    Write(buffer.data(), static_cast<size_t>(iRead));
+  }
+
+  CSingleLock lock(m_critSection);
+  m_bEndOfInput = true;
+  m_dataAvailable.Set();
+}
+
+void CDVDTimeshiftBuffer::Write(const uint8_t* buf, size_t size)
+{
+  CSingleLock lock(m_critSection);
+
+  ParseTransportStream(buf, size);
+
+  while (size > 0)
+  {
+    size_t chunk = std::min(size, m_memorySize);
+
+    /* the oldest bytes in memory are overwritten by this chunk, move them to disk first */
+    int64_t iSpillStart = std::max(m_iEnd - static_cast<int64_t>(m_memorySize), m_iStart);
+    int64_t iSpillEnd = std::max(m_iEnd + static_cast<int64_t>(chunk) - static_cast<int64_t>(m_memorySize), m_iStart);
+    if (m_diskSize > 0 && iSpillEnd > iSpillStart &&
+        !SpillToDisk(iSpillStart, static_cast<size_t>(iSpillEnd - iSpillStart)))
+    {
+      CLog::Log(LOGERROR, "CDVDTimeshiftBuffer - %s - failed to write spill file, buffering in memory only", __FUNCTION__);
+      m_diskSize = 0;
+    }
+
+    size_t iOffset = static_cast<size_t>(m_iEnd % m_memorySize);
+    size_t iFirst = std::min(chunk, m_memorySize - iOffset);
+    memcpy(m_memory.data() + iOffset, buf, iFirst);
+    if (chunk > iFirst)
+      memcpy(m_memory.data(), buf + iFirst, chunk - iFirst);
+
+    m_iEnd += chunk;
+    buf += chunk;
+    size -= chunk;
+  }
+
+  TrimToWindow();
+  m_dataAvailable.Set();
+}
+
+bool CDVDTimeshiftBuffer::SpillToDisk(int64_t iPosition, size_t size)
+{
+  while (size > 0)
+  {
+    int64_t iFileOffset = iPosition % m_diskSize;
+    size_t chunk = static_cast<size_t>(std::min(static_cast<int64_t>(size), m_diskSize - iFileOffset));
+    size_t iMemoryOffset = static_cast<size_t>(iPosition % m_memorySize);
+    chunk = std::min(chunk, m_memorySize - iMemoryOffset);
+
+    if (m_spillFileWrite->Seek(iFileOffset, SEEK_SET) != iFileOffset ||
+        m_spillFileWrite->Write(m_memory.data() + iMemoryOffset, chunk) != static_cast<ssize_t>(chunk))
+      return false;
+
+    iPosition += chunk;
+    size -= chunk;
+  }
+
+  return true;
+}
+
+void CDVDTimeshiftBuffer::TrimToWindow()
+{
+  m_iStart = std::max(m_iStart, m_iEnd - static_cast<int64_t>(m_memorySize) - m_diskSize);
+
+  while (!m_keyFrames.empty() && m_keyFrames.front().iPosition < m_iStart)
+    m_keyFrames.pop_front();
+
+  /* the reader fell out of the buffer, continue at the oldest random access point */
+  if (m_iReadPosition < m_iStart)
+    m_iReadPosition = m_keyFrames.empty() ? m_iStart : m_keyFrames.front().iPosition;
+}
+
+void CDVDTimeshiftBuffer::ReadFromMemory(int64_t iPosition, uint8_t* buf, size_t size) const
+{
+  size_t iOffset = static_cast<size_t>(iPosition % m_memorySize);
+  size_t iFirst = std::min(size, m_memorySize - iOffset);
+  memcpy(buf, m_memory.data() + iOffset, iFirst);
+  if (size > iFirst)
+    memcpy(buf + iFirst, m_memory.data(), size - iFirst);
+}
+
+int CDVDTimeshiftBuffer::ReadFromDisk(int64_t iPosition, int64_t diskSize, uint8_t* buf, size_t size)
+{
+  int64_t iFileOffset = iPosition % diskSize;
+  size = static_cast<size_t>(std::min(static_cast<int64_t>(size), diskSize - iFileOffset));
+
+  if (m_spillFileRead->Seek(iFileOffset, SEEK_SET) != iFileOffset)
+    return -1;
+
+  ssize_t iRead = m_spillFileRead->Read(buf, size);
+  return iRead > 0 ? static_cast<int>(iRead) : -1;
+}
+
+int CDVDTimeshiftBuffer::Read(uint8_t* buf, int buf_size)
+{
+  if (buf_size <= 0)
+    return 0;
+
+  XbmcThreads::EndTime timeout(READ_TIMEOUT);
+
+  CSingleLock lock(m_critSection);
+  while (true)
+  {
+    while (!m_bAbort && m_iReadPosition >= m_iEnd)
+    {
+      if (m_bEndOfInput)
+        return 0;
+
+      if (timeout.IsTimePast())
+      {
+        CLog::Log(LOGERROR, "CDVDTimeshiftBuffer - %s - no data received within %u ms", __FUNCTION__, READ_TIMEOUT);
+        return 0;
+      }
+
+      CSingleExit exit(m_critSection);
+      m_dataAvailable.WaitMSec(timeout.MillisLeft());
+    }
+
+    if (m_bAbort)
+      return -1;
+
+    size_t size = static_cast<size_t>(std::min(static_cast<int64_t>(buf_size), m_iEnd - m_iReadPosition));
+    int64_t iMemoryStart = std::max(m_iEnd - static_cast<int64_t>(m_memorySize), m_iStart);
+
+    if (m_iReadPosition >= iMemoryStart)
+    {
+      ReadFromMemory(m_iReadPosition, buf, size);
+      m_iReadPosition += size;
+      return static_cast<int>(size);
+    }
+
+    /* the disk part ends where the memory part starts, the remainder is returned by the next read */
+    size = static_cast<size_t>(std::min(static_cast<int64_t>(size), iMemoryStart - m_iReadPosition));
+    int64_t iPosition = m_iReadPosition;
+    int64_t diskSize = m_diskSize;
+
+    /* don't block the buffer thread while waiting for the disk, it writes through its own file handle */
+    int iRead;
+    {
+      CSingleExit exit(m_critSection);
+      iRead = ReadFromDisk(iPosition, diskSize, buf, size);
+    }
+
+    if (m_bAbort)
+      return -1;
+
+    if (iRead < 0)
+    {
+      CLog::Log(LOGERROR, "CDVDTimeshiftBuffer - %s - failed to read spill file at position %" PRId64, __FUNCTION__, iPosition);
+      return -1;
+    }
+
+    /* the spill file wrapped around the position while reading, the data is stale */
+    if (iPosition < m_iStart || iPosition != m_iReadPosition)
+      continue;
+
+    m_iReadPosition += iRead;
+    return iRead;
+  }
+}
+
+int64_t CDVDTimeshiftBuffer::Seek(int64_t offset, int whence)
+{
+  CSingleLock lock(m_critSection);
+
+  int64_t iPosition;
+  switch (whence)
+  {
+    case SEEK_SET:
+      iPosition = offset;
+      break;
+    case SEEK_CUR:
+      iPosition = m_iReadPosition + offset;
+      break;
+    case SEEK_END:
+      iPosition = m_iEnd + offset;
+      break;
+    default:
+      return -1;
+  }
+
+  if (iPosition < m_iStart || iPosition > m_iEnd)
+    return -1;
+
+  m_iReadPosition = iPosition;
+  return m_iReadPosition;
+}
+
+int64_t CDVDTimeshiftBuffer::GetLength() const
+{
+  CSingleLock lock(m_critSection);
+  return m_iEnd;
+}
+
+int64_t CDVDTimeshiftBuffer::GetStartPosition() const
+{
+  CSingleLock lock(m_critSection);
+  return m_iStart;
+}
+
+bool CDVDTimeshiftBuffer::SeekTime(int iTimeMs)
+{
+  CSingleLock lock(m_critSection);
+  if (m_keyFrames.empty())
+    return false;
+
+  /* last random access point at or before the requested time, or the oldest one if the time is no longer buffered */
+  auto it = std::upper_bound(m_keyFrames.begin(), m_keyFrames.end(), iTimeMs, [](int iTime, const KeyFrame& keyFrame) {
+    return iTime < keyFrame.iTimeMs;
+  });
+  if (it != m_keyFrames.begin())
+    --it;
+
+  m_iReadPosition = it->iPosition;
+  return true;
+}
+
+bool CDVDTimeshiftBuffer::GetTimes(int &iBeginMs, int &iEndMs) const
+{
+  CSingleLock lock(m_critSection);
+  if (m_iFirstPcr < 0)
+    return false;
+
+  iBeginMs = m_keyFrames.empty() ? m_iLastPcrTimeMs : m_keyFrames.front().iTimeMs;
+  iEndMs = m_iLastPcrTimeMs;
+  return true;
+}
+
+void CDVDTimeshiftBuffer::ParseTransportStream(const uint8_t* buf, size_t size)
+{
+  m_parseBuffer.insert(m_parseBuffer.end(), buf, buf + size);
+
+  size_t iOffset = 0;
+  while (m_parseBuffer.size() - iOffset >= TS_PACKET_SIZE)
+  {
+    if (m_parseBuffer[iOffset] != TS_SYNC_BYTE)
+    {
+      /* lost sync, skip to the next sync byte */
+      ++iOffset;
+      continue;
+    }
+
+    ParsePacket(m_parseBuffer.data() + iOffset, m_iParsePosition + iOffset);
+    iOffset += TS_PACKET_SIZE;
+  }
+
+  m_parseBuffer.erase(m_parseBuffer.begin(), m_parseBuffer.begin() + iOffset);
+  m_iParsePosition += iOffset;
+}
+
+void CDVDTimeshiftBuffer::ParsePacket(const uint8_t* packet, int64_t iPosition)
+{
+  int iPid = ((packet[1] & 0x1f) << 8) | packet[2];
+  bool bPayloadUnitStart = (packet[1] & 0x40) != 0;
+  bool bHasAdaptationField = (packet[3] & 0x20) != 0;
+  bool bRandomAccess = false;
+
+  if (bHasAdaptationField && packet[4] > 0)
+  {
+    uint8_t iFlags = packet[5];
+    bRandomAccess = (iFlags & 0x40) != 0;
+
+    /* the first pid carrying a PCR is used as the time base */
+    if ((iFlags & 0x10) && packet[4] >= 7 && (m_iPcrPid < 0 || m_iPcrPid == iPid))
+    {
+      int64_t iPcr = (static_cast<int64_t>(packet[6]) << 25) |
+                     (static_cast<int64_t>(packet[7]) << 17) |
+                     (static_cast<int64_t>(packet[8]) << 9) |
+                     (static_cast<int64_t>(packet[9]) << 1) |
+                     (static_cast<int64_t>(packet[10]) >> 7);
+
+      if (m_iFirstPcr < 0)
+      {
+        m_iPcrPid = iPid;
+        m_iFirstPcr = iPcr;
+      }
+      else
+      {
+        /* unwrap the 33 bit counter */
+        iPcr += m_iLastPcr - (m_iLastPcr % PCR_WRAP);
+        if (iPcr < m_iLastPcr - PCR_WRAP / 2)
+          iPcr += PCR_WRAP;
+      }
+
+      m_iLastPcr = iPcr;
+      m_iLastPcrTimeMs = static_cast<int>((iPcr - m_iFirstPcr) / 90);
+    }
+  }
+
+  if (m_iFirstPcr < 0)
+    return;
+
+  if (bRandomAccess)
+  {
+    m_bHasRandomAccessIndicator = true;
+    m_keyFrames.push_back({ iPosition, m_iLastPcrTimeMs });
+  }
+  else if (!m_bHasRandomAccessIndicator && bPayloadUnitStart && iPid == m_iPcrPid &&
+           (m_keyFrames.empty() || m_iLastPcrTimeMs - m_keyFrames.back().iTimeMs >= PUSI_INDEX_INTERVAL))
+  {
+    /* the stream doesn't flag random access points, index the start of a PES packet on the PCR pid once in a while */
+    m_keyFrames.push_back({ iPosition, m_iLastPcrTimeMs });
+  }
+}
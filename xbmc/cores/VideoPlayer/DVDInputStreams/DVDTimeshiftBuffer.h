@@ -0,0 +1,164 @@
+#pragma once
+
+/*
+ *      Copyright (C) 2017 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <deque>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "threads/CriticalSection.h"
+#include "threads/Event.h"
+#include "threads/Thread.h"
+
+namespace XFILE
+{
+  class IFile;
+}
+
+/*!
+ * @brief Local timeshift buffer for live MPEG-TS streams.
+ *
+ * A background thread reads the live stream from a source function into a ring
+ * buffer in memory. Data that falls out of the memory ring is spilled to a ring
+ * file on disk, so that the buffer covers the last memory size + disk size bytes
+ * of the stream. Positions are absolute byte offsets in the received stream.
+ *
+ * While receiving, the transport stream is scanned for random access points and
+ * PCRs. The resulting keyframe index is used to seek by time and to report the
+ * time range covered by the buffer.
+ */
+class CDVDTimeshiftBuffer : private CThread
+{
+public:
+  /*!
+   * @brief Reads the next chunk of the live stream.
+   * @return The number of bytes read, 0 at the end of the stream or a negative value on error.
+   */
+  typedef std::function<int(uint8_t* buf, int buf_size)> SourceFunction;
+
+  /*!
+   * @param memorySize The size of the ring buffer in memory in bytes.
+   * @param diskSize The maximum size of the spill file on disk in bytes, 0 to keep the buffer in memory only.
+   */
+  CDVDTimeshiftBuffer(size_t memorySize, int64_t diskSize);
+  ~CDVDTimeshiftBuffer() override;
+
+  /*!
+   * @brief Start buffering the given source.
+   * @param source The function to read the live stream from. Called from the buffer thread only.
+   * @return True on success, false otherwise.
+   */
+  bool Open(SourceFunction source);
+
+  /*!
+   * @brief Stop buffering and release the memory and the spill file.
+   */
+  void Close();
+
+  /*!
+   * @brief Interrupt pending and further reads and tell the buffer thread to stop, without waiting for it.
+   * The thread exits once its current read from the source returns.
+   */
+  void Abort();
+
+  /*!
+   * @brief Read from the current position, waiting for the live stream if the position is at its end.
+   * @return The number of bytes read, 0 at the end of the stream or -1 on error.
+   */
+  int Read(uint8_t* buf, int buf_size);
+
+  /*!
+   * @brief Seek within the buffered part of the stream.
+   * @return The new position or -1 if the position is not buffered.
+   */
+  int64_t Seek(int64_t offset, int whence);
+
+  /*!
+   * @return The number of bytes received so far, which is the end of the buffered range.
+   */
+  int64_t GetLength() const;
+
+  /*!
+   * @return The first position that is still buffered.
+   */
+  int64_t GetStartPosition() const;
+
+  /*!
+   * @brief Seek to the last random access point at or before the given time.
+   * @param iTimeMs The time in milliseconds relative to the first PCR of the stream.
+   * @return True on success, false if no random access point was indexed yet.
+   */
+  bool SeekTime(int iTimeMs);
+
+  /*!
+   * @brief Get the time range covered by the buffer.
+   * @param iBeginMs The time of the first indexed random access point, relative to the first PCR.
+   * @param iEndMs The time of the last received PCR, relative to the first PCR.
+   * @return True if the stream contained a PCR, false otherwise.
+   */
+  bool GetTimes(int &iBeginMs, int &iEndMs) const;
+
+protected:
+  void Process() override;
+
+private:
+  struct KeyFrame
+  {
+    int64_t iPosition; /*!< the absolute position of the transport stream packet */
+    int iTimeMs;       /*!< the time of the packet relative to the first PCR */
+  };
+
+  void Write(const uint8_t* buf, size_t size);
+  bool SpillToDisk(int64_t iPosition, size_t size);
+  int ReadFromDisk(int64_t iPosition, int64_t diskSize, uint8_t* buf, size_t size);
+  void ReadFromMemory(int64_t iPosition, uint8_t* buf, size_t size) const;
+  void TrimToWindow();
+  void ParseTransportStream(const uint8_t* buf, size_t size);
+  void ParsePacket(const uint8_t* packet, int64_t iPosition);
+
+  SourceFunction m_source;
+  size_t m_memorySize;
+  int64_t m_diskSize;
+  std::vector<uint8_t> m_memory;            /*!< ring buffer holding the most recent bytes */
+  std::unique_ptr<XFILE::IFile> m_spillFileWrite;
+  std::unique_ptr<XFILE::IFile> m_spillFileRead;
+  std::string m_spillFileName;
+
+  int64_t m_iStart;                         /*!< first position that is still buffered */
+  int64_t m_iEnd;                           /*!< position after the last received byte */
+  int64_t m_iReadPosition;
+  bool m_bEndOfInput;
+  bool m_bAbort;
+
+  std::vector<uint8_t> m_parseBuffer;       /*!< incomplete transport stream packet of the last write */
+  int64_t m_iParsePosition;                 /*!< absolute position of the first byte in m_parseBuffer */
+  int m_iPcrPid;
+  int64_t m_iFirstPcr;
+  int64_t m_iLastPcr;
+  int m_iLastPcrTimeMs;
+  bool m_bHasRandomAccessIndicator;
+  std::deque<KeyFrame> m_keyFrames;
+
+  mutable CCriticalSection m_critSection;
+  CEvent m_dataAvailable;
+};
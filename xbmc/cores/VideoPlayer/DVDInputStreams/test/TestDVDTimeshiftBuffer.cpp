@@ -0,0 +1,204 @@
+/*
+ *      Copyright (C) 2017 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "cores/VideoPlayer/DVDInputStreams/DVDTimeshiftBuffer.h"
+#include "threads/SystemClock.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace
+{
+  const int PACKET_SIZE = 188;
+  const int PACKET_DURATION_MS = 4;  // time between two generated packets
+  const int PCR_INTERVAL = 10;       // every 10th packet carries a PCR
+  const int KEYFRAME_INTERVAL = 50;  // every 50th packet is a random access point
+
+  /* stand-in for a live tv backend, generating a transport stream with one pid */
+  class CTsGenerator
+  {
+  public:
+    CTsGenerator(int packets, int chunkSize, bool randomAccessIndicator = true)
+      : m_chunkSize(chunkSize)
+    {
+      for (int i = 0; i < packets; ++i)
+        AppendPacket(i, randomAccessIndicator);
+    }
+
+    int Read(uint8_t* buf, int buf_size)
+    {
+      int size = std::min(std::min(buf_size, m_chunkSize), static_cast<int>(m_stream.size() - m_position));
+      memcpy(buf, m_stream.data() + m_position, size);
+      m_position += size;
+      return size;
+    }
+
+    const std::vector<uint8_t>& Stream() const { return m_stream; }
+
+  private:
+    void AppendPacket(int index, bool randomAccessIndicator)
+    {
+      bool keyFrame = index % KEYFRAME_INTERVAL == 0;
+      bool pcr = index % PCR_INTERVAL == 0;
+
+      uint8_t packet[PACKET_SIZE];
+      memset(packet, index & 0xff, sizeof(packet));
+      packet[0] = 0x47;
+      packet[1] = (keyFrame ? 0x40 : 0x00) | 0x01;
+      packet[2] = 0x00;
+      packet[3] = (pcr ? 0x30 : 0x10) | (index & 0x0f);
+
+      if (pcr)
+      {
+        int64_t base = static_cast<int64_t>(index) * PACKET_DURATION_MS * 90;
+        packet[4] = 7;
+        packet[5] = 0x10 | (keyFrame && randomAccessIndicator ? 0x40 : 0x00);
+        packet[6] = static_cast<uint8_t>(base >> 25);
+        packet[7] = static_cast<uint8_t>(base >> 17);
+        packet[8] = static_cast<uint8_t>(base >> 9);
+        packet[9] = static_cast<uint8_t>(base >> 1);
+        packet[10] = static_cast<uint8_t>(((base & 1) << 7) | 0x7e);
+        packet[11] = 0;
+      }
+
+      m_stream.insert(m_stream.end(), packet, packet + sizeof(packet));
+    }
+
+    std::vector<uint8_t> m_stream;
+    size_t m_position = 0;
+    int m_chunkSize;
+  };
+
+  bool WaitForLength(const CDVDTimeshiftBuffer& buffer, int64_t length)
+  {
+    XbmcThreads::EndTime timeout(5000);
+    while (buffer.GetLength() < length && !timeout.IsTimePast())
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    return buffer.GetLength() == length;
+  }
+
+  std::vector<uint8_t> ReadToEnd(CDVDTimeshiftBuffer& buffer)
+  {
+    std::vector<uint8_t> data;
+    uint8_t buf[1000];
+    int read;
+    while ((read = buffer.Read(buf, sizeof(buf))) > 0)
+      data.insert(data.end(), buf, buf + read);
+    return data;
+  }
+}
+
+TEST(TestDVDTimeshiftBuffer, ReadFromMemory)
+{
+  CTsGenerator generator(1000, 1000);
+  CDVDTimeshiftBuffer buffer(1024 * 1024, 0);
+  ASSERT_TRUE(buffer.Open([&generator](uint8_t* buf, int buf_size) { return generator.Read(buf, buf_size); }));
+
+  EXPECT_TRUE(ReadToEnd(buffer) == generator.Stream());
+  EXPECT_EQ(0, buffer.GetStartPosition());
+}
+
+TEST(TestDVDTimeshiftBuffer, SpillToDisk)
+{
+  const int64_t memorySize = 64 * PACKET_SIZE;
+  const int64_t diskSize = 256 * PACKET_SIZE;
+
+  CTsGenerator generator(1000, 1000);
+  const std::vector<uint8_t>& stream = generator.Stream();
+  CDVDTimeshiftBuffer buffer(memorySize, diskSize);
+  ASSERT_TRUE(buffer.Open([&generator](uint8_t* buf, int buf_size) { return generator.Read(buf, buf_size); }));
+  ASSERT_TRUE(WaitForLength(buffer, stream.size()));
+
+  /* only the last memory + disk size bytes are kept */
+  int64_t start = stream.size() - memorySize - diskSize;
+  EXPECT_EQ(start, buffer.GetStartPosition());
+  EXPECT_EQ(-1, buffer.Seek(start - 1, SEEK_SET));
+  EXPECT_EQ(start, buffer.Seek(start, SEEK_SET));
+
+  /* read across the spill file into memory */
+  std::vector<uint8_t> expected(stream.begin() + start, stream.end());
+  EXPECT_TRUE(ReadToEnd(buffer) == expected);
+}
+
+TEST(TestDVDTimeshiftBuffer, SeekTime)
+{
+  CTsGenerator generator(1000, 1000);
+  CDVDTimeshiftBuffer buffer(1024 * 1024, 0);
+  ASSERT_TRUE(buffer.Open([&generator](uint8_t* buf, int buf_size) { return generator.Read(buf, buf_size); }));
+  ASSERT_TRUE(WaitForLength(buffer, generator.Stream().size()));
+
+  int beginMs, endMs;
+  ASSERT_TRUE(buffer.GetTimes(beginMs, endMs));
+  EXPECT_EQ(0, beginMs);
+  EXPECT_EQ(990 * PACKET_DURATION_MS, endMs);
+
+  /* packet 250 is the last random access point before 1099 ms */
+  ASSERT_TRUE(buffer.SeekTime(1099));
+  uint8_t packet[PACKET_SIZE];
+  ASSERT_EQ(PACKET_SIZE, buffer.Read(packet, sizeof(packet)));
+  EXPECT_EQ(0x47, packet[0]);
+  EXPECT_EQ(250 & 0xff, packet[PACKET_SIZE - 1]);
+  EXPECT_EQ(0x40, packet[5] & 0x40);
+
+  /* times before the buffer start at the oldest random access point */
+  ASSERT_TRUE(buffer.SeekTime(-1000));
+  ASSERT_EQ(PACKET_SIZE, buffer.Read(packet, sizeof(packet)));
+  EXPECT_EQ(0, packet[PACKET_SIZE - 1]);
+}
+
+TEST(TestDVDTimeshiftBuffer, SeekTimeAfterSpill)
+{
+  const int64_t memorySize = 64 * PACKET_SIZE;
+  const int64_t diskSize = 256 * PACKET_SIZE;
+
+  CTsGenerator generator(1000, 1000);
+  CDVDTimeshiftBuffer buffer(memorySize, diskSize);
+  ASSERT_TRUE(buffer.Open([&generator](uint8_t* buf, int buf_size) { return generator.Read(buf, buf_size); }));
+  ASSERT_TRUE(WaitForLength(buffer, generator.Stream().size()));
+
+  /* packets 680 to 999 are buffered, 700 is the oldest random access point */
+  int beginMs, endMs;
+  ASSERT_TRUE(buffer.GetTimes(beginMs, endMs));
+  EXPECT_EQ(700 * PACKET_DURATION_MS, beginMs);
+
+  ASSERT_TRUE(buffer.SeekTime(0));
+  uint8_t packet[PACKET_SIZE];
+  ASSERT_EQ(PACKET_SIZE, buffer.Read(packet, sizeof(packet)));
+  EXPECT_EQ(700 & 0xff, packet[PACKET_SIZE - 1]);
+}
+
+TEST(TestDVDTimeshiftBuffer, IndexWithoutRandomAccessIndicator)
+{
+  CTsGenerator generator(1000, 1000, false);
+  CDVDTimeshiftBuffer buffer(1024 * 1024, 0);
+  ASSERT_TRUE(buffer.Open([&generator](uint8_t* buf, int buf_size) { return generator.Read(buf, buf_size); }));
+  ASSERT_TRUE(WaitForLength(buffer, generator.Stream().size()));
+
+  /* payload unit starts are indexed once per second, the start of packet 250 is 1000 ms */
+  ASSERT_TRUE(buffer.SeekTime(1999));
+  uint8_t packet[PACKET_SIZE];
+  ASSERT_EQ(PACKET_SIZE, buffer.Read(packet, sizeof(packet)));
+  EXPECT_EQ(250 & 0xff, packet[PACKET_SIZE - 1]);
+}
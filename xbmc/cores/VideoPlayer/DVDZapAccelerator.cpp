@@ -0,0 +1,354 @@
+/*
+ *      Copyright (C) 2017 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "DVDZapAccelerator.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "DVDDemuxers/DVDDemux.h"
+#include "DVDDemuxers/DVDFactoryDemuxer.h"
+#include "DVDInputStreams/DVDFactoryInputStream.h"
+#include "DVDInputStreams/DVDInputStream.h"
+#include "FileItem.h"
+#include "ServiceBroker.h"
+#include "pvr/PVRManager.h"
+#include "pvr/channels/PVRChannel.h"
+#include "pvr/channels/PVRChannelGroup.h"
+#include "settings/AdvancedSettings.h"
+#include "threads/CriticalSection.h"
+#include "threads/SingleLock.h"
+#include "utils/JobManager.h"
+#include "utils/URIUtils.h"
+#include "utils/log.h"
+
+using namespace PVR;
+
+namespace
+{
+  // time after which a prepared stream is reopened. the input stream stops reading once its
+  // cache is full, so a switch starts up to this far behind the live position. a shorter time
+  // brings it closer to live but makes the backend retune the adjacent channels more often
+  const unsigned int PREPARED_STREAM_MAX_AGE = 5000;
+  const unsigned int REFRESH_INTERVAL = 1000;
+
+  CDVDInputStream* CreateInputStream(const CPVRChannelPtr& channel)
+  {
+    CFileItem item(channel);
+    if (!CServiceBroker::GetPVRManager().FillStreamFileItem(item) ||
+        URIUtils::IsPVRChannel(item.GetDynPath()))
+    {
+      CLog::Log(LOGDEBUG, "CDVDZapAccelerator::%s - channel '%s' has no stream url, not preparing it", __FUNCTION__, channel->ChannelName().c_str());
+      return nullptr;
+    }
+
+    CDVDInputStream* inputStream = CDVDFactoryInputStream::CreateInputStream(nullptr, item);
+    if (!inputStream)
+      return nullptr;
+
+    // streams that need a player or a pvr client can not be opened next to the playing one
+    if (inputStream->IsStreamType(DVDSTREAM_TYPE_PVRMANAGER) ||
+        inputStream->IsStreamType(DVDSTREAM_TYPE_ADDON) ||
+        inputStream->IsStreamType(DVDSTREAM_TYPE_DVD) ||
+        inputStream->IsStreamType(DVDSTREAM_TYPE_BLURAY))
+    {
+      delete inputStream;
+      return nullptr;
+    }
+
+    return inputStream;
+  }
+
+  CDVDDemux* OpenDemuxer(CDVDInputStream* inputStream)
+  {
+    if (!inputStream->Open())
+      return nullptr;
+
+    return CDVDFactoryDemuxer::CreateDemuxer(inputStream);
+  }
+}
+
+class CDVDZapAccelerator::CPreparedStream
+{
+public:
+  CPreparedStream(const CPVRChannelPtr& channel, unsigned int iMaxAge)
+    : m_channel(channel),
+      m_iMaxAge(iMaxAge)
+  {
+  }
+
+  ~CPreparedStream()
+  {
+    delete m_demuxer;
+    delete m_inputStream;
+  }
+
+  const CPVRChannelPtr& GetChannel() const { return m_channel; }
+
+  bool IsChannel(const CPVRChannelPtr& channel) const
+  {
+    return channel && m_channel->StorageId() == channel->StorageId();
+  }
+
+  /*!
+   * @brief Open the input stream and probe the demuxer. Runs in a job.
+   */
+  void Open(const InputStreamFactory& inputStreamFactory, const DemuxerFactory& demuxerFactory)
+  {
+    CDVDInputStream* inputStream = inputStreamFactory(m_channel);
+    if (!inputStream)
+      return;
+
+    {
+      CSingleLock lock(m_critSection);
+      if (m_bAborted)
+      {
+        delete inputStream;
+        return;
+      }
+      // set before opening, so that an abort interrupts a stalling open
+      m_inputStream = inputStream;
+    }
+
+    unsigned int iStartTime = XbmcThreads::SystemClockMillis();
+    CDVDDemux* demuxer = demuxerFactory(inputStream);
+
+    CSingleLock lock(m_critSection);
+    if (!demuxer || m_bAborted)
+    {
+      if (!m_bAborted)
+        CLog::Log(LOGERROR, "CDVDZapAccelerator::%s - failed to prepare channel '%s'", __FUNCTION__, m_channel->ChannelName().c_str());
+      delete demuxer;
+      return;
+    }
+
+    m_demuxer = demuxer;
+    m_iReadyTime = XbmcThreads::SystemClockMillis();
+    m_bReady = true;
+    CLog::Log(LOGDEBUG, "CDVDZapAccelerator::%s - prepared channel '%s' in %u ms", __FUNCTION__, m_channel->ChannelName().c_str(), m_iReadyTime - iStartTime);
+  }
+
+  void Abort()
+  {
+    CSingleLock lock(m_critSection);
+    m_bAborted = true;
+    if (m_demuxer)
+      m_demuxer->Abort();
+    if (m_inputStream)
+      m_inputStream->Abort();
+  }
+
+  bool IsReady() const
+  {
+    CSingleLock lock(m_critSection);
+    return m_bReady && !m_bAborted && !IsTooOld();
+  }
+
+  bool IsExpired() const
+  {
+    CSingleLock lock(m_critSection);
+    return m_bReady && !m_bAborted && IsTooOld();
+  }
+
+  bool Take(CDVDInputStream*& inputStream, CDVDDemux*& demuxer)
+  {
+    CSingleLock lock(m_critSection);
+    // the player may switch between two runs of Process, don't hand over a stream that expired since
+    if (!m_bReady || m_bAborted || IsTooOld())
+      return false;
+
+    inputStream = m_inputStream;
+    demuxer = m_demuxer;
+    m_inputStream = nullptr;
+    m_demuxer = nullptr;
+    m_bAborted = true;
+    return true;
+  }
+
+private:
+  bool IsTooOld() const
+  {
+    return XbmcThreads::SystemClockMillis() - m_iReadyTime > m_iMaxAge;
+  }
+
+  const CPVRChannelPtr m_channel;
+  const unsigned int m_iMaxAge;
+  mutable CCriticalSection m_critSection;
+  CDVDInputStream* m_inputStream = nullptr;
+  CDVDDemux* m_demuxer = nullptr;
+  unsigned int m_iReadyTime = 0;
+  bool m_bReady = false;
+  bool m_bAborted = false;
+};
+
+CDVDZapAccelerator::CDVDZapAccelerator()
+  : CDVDZapAccelerator(CreateInputStream, OpenDemuxer, PREPARED_STREAM_MAX_AGE)
+{
+}
+
+CDVDZapAccelerator::CDVDZapAccelerator(InputStreamFactory inputStreamFactory, DemuxerFactory demuxerFactory, unsigned int iMaxAge)
+  : m_inputStreamFactory(std::move(inputStreamFactory)),
+    m_demuxerFactory(std::move(demuxerFactory)),
+    m_iMaxAge(iMaxAge)
+{
+}
+
+CDVDZapAccelerator::~CDVDZapAccelerator()
+{
+  Clear();
+}
+
+void CDVDZapAccelerator::PrepareAdjacentChannels(const CFileItem& playingItem)
+{
+  std::vector<CPVRChannelPtr> channels;
+
+  const int iAdjacentChannels = g_advancedSettings.m_iPVRZapAdjacentChannels;
+  if (iAdjacentChannels > 0 && playingItem.HasPVRChannelInfoTag())
+  {
+    CPVRManager& pvrManager = CServiceBroker::GetPVRManager();
+    const CPVRChannelPtr playingChannel(playingItem.GetPVRChannelInfoTag());
+    const CPVRChannelGroupPtr group(pvrManager.GetPlayingGroup(playingChannel->IsRadio()));
+    if (group)
+    {
+      std::vector<CFileItemPtr> adjacentItems;
+      adjacentItems.push_back(group->GetNextChannel(playingChannel));
+      if (iAdjacentChannels > 1)
+        adjacentItems.push_back(group->GetPreviousChannel(playingChannel));
+
+      for (const auto& item : adjacentItems)
+      {
+        if (!item || !item->HasPVRChannelInfoTag())
+          continue;
+
+        const CPVRChannelPtr channel(item->GetPVRChannelInfoTag());
+        if (channel->StorageId() == playingChannel->StorageId() ||
+            pvrManager.IsParentalLocked(channel) ||
+            std::find_if(channels.begin(), channels.end(),
+                         [&channel](const CPVRChannelPtr& other) { return other->StorageId() == channel->StorageId(); }) != channels.end())
+          continue;
+
+        channels.push_back(channel);
+      }
+    }
+  }
+
+  PrepareChannels(channels);
+}
+
+void CDVDZapAccelerator::PrepareChannels(const std::vector<CPVRChannelPtr>& channels)
+{
+  // release the tuners of channels that are no longer adjacent
+  for (auto it = m_streams.begin(); it != m_streams.end();)
+  {
+    if (std::find_if(channels.begin(), channels.end(),
+                     [&it](const CPVRChannelPtr& channel) { return (*it)->IsChannel(channel); }) == channels.end())
+    {
+      (*it)->Abort();
+      it = m_streams.erase(it);
+    }
+    else
+      ++it;
+  }
+
+  for (const auto& channel : channels)
+  {
+    if (std::find_if(m_streams.begin(), m_streams.end(),
+                     [&channel](const PreparedStreamPtr& stream) { return stream->IsChannel(channel); }) == m_streams.end())
+      Prepare(channel);
+  }
+
+  m_refreshTimer.Set(std::min(REFRESH_INTERVAL, m_iMaxAge));
+}
+
+bool CDVDZapAccelerator::HasPreparedStream(const CPVRChannelPtr& channel) const
+{
+  auto it = std::find_if(m_streams.begin(), m_streams.end(),
+                         [&channel](const PreparedStreamPtr& stream) { return stream->IsChannel(channel); });
+  return it != m_streams.end() && (*it)->IsReady();
+}
+
+void CDVDZapAccelerator::Process()
+{
+  if (m_streams.empty() || !m_refreshTimer.IsTimePast())
+    return;
+
+  std::vector<CPVRChannelPtr> expiredChannels;
+  for (auto it = m_streams.begin(); it != m_streams.end();)
+  {
+    if ((*it)->IsExpired())
+    {
+      expiredChannels.push_back((*it)->GetChannel());
+      (*it)->Abort();
+      it = m_streams.erase(it);
+    }
+    else
+      ++it;
+  }
+
+  for (const auto& channel : expiredChannels)
+    Prepare(channel);
+
+  m_refreshTimer.Set(std::min(REFRESH_INTERVAL, m_iMaxAge));
+}
+
+bool CDVDZapAccelerator::TakePreparedStream(const CFileItem& item, CDVDInputStream*& inputStream, CDVDDemux*& demuxer)
+{
+  if (!item.HasPVRChannelInfoTag())
+    return false;
+
+  const CPVRChannelPtr channel(item.GetPVRChannelInfoTag());
+  auto it = std::find_if(m_streams.begin(), m_streams.end(),
+                         [&channel](const PreparedStreamPtr& stream) { return stream->IsChannel(channel); });
+  if (it == m_streams.end())
+    return false;
+
+  // a stream still being prepared or expired is dropped, the player opens the channel itself
+  bool bTaken = (*it)->Take(inputStream, demuxer);
+  if (!bTaken)
+    (*it)->Abort();
+
+  m_streams.erase(it);
+
+  if (bTaken)
+    CLog::Log(LOGNOTICE, "CDVDZapAccelerator::%s - using prepared stream for channel '%s'", __FUNCTION__, channel->ChannelName().c_str());
+
+  return bTaken;
+}
+
+void CDVDZapAccelerator::Clear()
+{
+  for (const auto& stream : m_streams)
+    stream->Abort();
+
+  m_streams.clear();
+}
+
+void CDVDZapAccelerator::Prepare(const CPVRChannelPtr& channel)
+{
+  PreparedStreamPtr stream(new CPreparedStream(channel, m_iMaxAge));
+  m_streams.push_back(stream);
+
+  // opening and probing a live stream blocks for seconds, don't hold up the shared workers
+  InputStreamFactory inputStreamFactory(m_inputStreamFactory);
+  DemuxerFactory demuxerFactory(m_demuxerFactory);
+  CJobManager::GetInstance().Submit([stream, inputStreamFactory, demuxerFactory]() {
+    stream->Open(inputStreamFactory, demuxerFactory);
+  }, CJob::PRIORITY_DEDICATED);
+}
@@ -0,0 +1,127 @@
+#pragma once
+
+/*
+ *      Copyright (C) 2017 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "threads/SystemClock.h"
+
+class CDVDDemux;
+class CDVDInputStream;
+class CFileItem;
+
+namespace PVR
+{
+  class CPVRChannel;
+}
+
+/*!
+ * @brief Keeps the streams of the channels next to the playing pvr channel opened for fast channel switching.
+ *
+ * The input streams of the adjacent channels in the playing group are opened
+ * and their demuxers probed by background jobs. A switch to one of these
+ * channels takes over the prepared input stream and demuxer and skips the
+ * slowest steps of opening a live stream.
+ *
+ * Only channels whose pvr client provides a stream url can be prepared, as a
+ * pvr client can only have a single live stream opened through the client api.
+ * Every prepared stream occupies a tuner of the backend, so the number of
+ * prepared channels is limited by advanced setting pvr/zapadjacentchannels.
+ *
+ * A prepared input stream stops reading once its cache is full, so a switch
+ * to it starts up to the maximum age of a prepared stream behind the live
+ * position. Older streams are reopened and never handed over.
+ *
+ * All methods must be called from the player thread.
+ */
+class CDVDZapAccelerator
+{
+public:
+  typedef std::function<CDVDInputStream*(const std::shared_ptr<PVR::CPVRChannel>&)> InputStreamFactory;
+  typedef std::function<CDVDDemux*(CDVDInputStream*)> DemuxerFactory;
+
+  CDVDZapAccelerator();
+
+  /*!
+   * @brief Create a zap accelerator with custom stream factories, used by tests.
+   * @param inputStreamFactory Creates the input stream of a channel, returns nullptr if the channel can not be prepared.
+   * @param demuxerFactory Opens the input stream and probes its demuxer, returns nullptr on failure. May block.
+   * @param iMaxAge The time in ms after which a prepared stream is reopened.
+   */
+  CDVDZapAccelerator(InputStreamFactory inputStreamFactory, DemuxerFactory demuxerFactory, unsigned int iMaxAge);
+
+  ~CDVDZapAccelerator();
+
+  CDVDZapAccelerator(const CDVDZapAccelerator&) = delete;
+  CDVDZapAccelerator& operator=(const CDVDZapAccelerator&) = delete;
+
+  /*!
+   * @brief Prepare the channels next to the playing channel and release all other prepared streams.
+   * @param playingItem The item being played. Nothing is prepared if it is not a pvr channel.
+   */
+  void PrepareAdjacentChannels(const CFileItem& playingItem);
+
+  /*!
+   * @brief Prepare the given channels and release all other prepared streams.
+   * @param channels The channels to prepare.
+   */
+  void PrepareChannels(const std::vector<std::shared_ptr<PVR::CPVRChannel>>& channels);
+
+  /*!
+   * @brief Check whether the stream of a channel is prepared and can be taken over.
+   * @param channel The channel.
+   * @return True if the prepared stream is ready, false if it is missing, still being opened or expired.
+   */
+  bool HasPreparedStream(const std::shared_ptr<PVR::CPVRChannel>& channel) const;
+
+  /*!
+   * @brief Reopen prepared streams that waited too long to still start near the live position.
+   */
+  void Process();
+
+  /*!
+   * @brief Take over the prepared stream of a channel.
+   * @param item The item to play.
+   * @param inputStream Set to the opened input stream on success. The caller takes ownership.
+   * @param demuxer Set to the probed demuxer on success. The caller takes ownership.
+   * @return True if a prepared stream was handed over, false otherwise.
+   */
+  bool TakePreparedStream(const CFileItem& item, CDVDInputStream*& inputStream, CDVDDemux*& demuxer);
+
+  /*!
+   * @brief Release all prepared streams.
+   */
+  void Clear();
+
+private:
+  class CPreparedStream;
+  typedef std::shared_ptr<CPreparedStream> PreparedStreamPtr;
+
+  void Prepare(const std::shared_ptr<PVR::CPVRChannel>& channel);
+
+  const InputStreamFactory m_inputStreamFactory;
+  const DemuxerFactory m_demuxerFactory;
+  const unsigned int m_iMaxAge;
+  std::vector<PreparedStreamPtr> m_streams;
+  XbmcThreads::EndTime m_refreshTimer;
+};
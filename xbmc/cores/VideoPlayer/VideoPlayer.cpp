@@ -653,7 +653,9 @@ CVideoPlayer::CVideoPlayer(IPlayerCallback& callback)
   m_pDemuxer = NULL;
   m_pSubtitleDemuxer = NULL;
   m_pCCDemuxer = NULL;
+  m_pPreparedDemuxer = NULL;
   m_pInputStream = NULL;
+  m_bPrepareAdjacentChannels = false;
 
   m_dvd.Clear();
   m_State.Clear();
@@ -669,6 +671,7 @@ CVideoPlayer::CVideoPlayer(IPlayerCallback& callback)
   m_HasAudio = false;
 
   memset(&m_SpeedState, 0, sizeof(m_SpeedState));
+  memset(&m_zapTiming, 0, sizeof(m_zapTiming));
 
   // omxplayer variables
   m_OmxPlayerState.last_check_time     = 0;
@@ -802,28 +805,40 @@ bool CVideoPlayer::OpenInputStream()
 {
   if(m_pInputStream)
     SAFE_DELETE(m_pInputStream);
+  SAFE_DELETE(m_pPreparedDemuxer);
 
-  CLog::Log(LOGNOTICE, "Creating InputStream");
-
-  // correct the filename if needed
-  std::string filename(m_item.GetPath());
-  if (URIUtils::IsProtocol(filename, "dvd") ||
-      StringUtils::EqualsNoCase(filename, "iso9660://video_ts/video_ts.ifo"))
+  if (m_zapAccelerator.TakePreparedStream(m_item, m_pInputStream, m_pPreparedDemuxer))
   {
-    m_item.SetPath(g_mediaManager.TranslateDevicePath(""));
+    CLog::Log(LOGNOTICE, "Using prepared InputStream");
+    m_zapTiming.prepared = true;
   }
-
-  m_pInputStream = CDVDFactoryInputStream::CreateInputStream(this, m_item, true);
-  if(m_pInputStream == NULL)
+  else
   {
-    CLog::Log(LOGERROR, "CVideoPlayer::OpenInputStream - unable to create input stream for [%s]", CURL::GetRedacted(m_item.GetPath()).c_str());
-    return false;
-  }
+    // free the tuners held by prepared channels for the stream we are about to open
+    m_zapAccelerator.Clear();
 
-  if (!m_pInputStream->Open())
-  {
-    CLog::Log(LOGERROR, "CVideoPlayer::OpenInputStream - error opening [%s]", CURL::GetRedacted(m_item.GetPath()).c_str());
-    return false;
+    CLog::Log(LOGNOTICE, "Creating InputStream");
+
+    // correct the filename if needed
+    std::string filename(m_item.GetPath());
+    if (URIUtils::IsProtocol(filename, "dvd") ||
+        StringUtils::EqualsNoCase(filename, "iso9660://video_ts/video_ts.ifo"))
+    {
+      m_item.SetPath(g_mediaManager.TranslateDevicePath(""));
+    }
+
+    m_pInputStream = CDVDFactoryInputStream::CreateInputStream(this, m_item, true);
+    if(m_pInputStream == NULL)
+    {
+      CLog::Log(LOGERROR, "CVideoPlayer::OpenInputStream - unable to create input stream for [%s]", CURL::GetRedacted(m_item.GetPath()).c_str());
+      return false;
+    }
+
+    if (!m_pInputStream->Open())
+    {
+      CLog::Log(LOGERROR, "CVideoPlayer::OpenInputStream - error opening [%s]", CURL::GetRedacted(m_item.GetPath()).c_str());
+      return false;
+    }
   }
 
   // find any available external subtitles for non dvd files
@@ -884,8 +899,12 @@ bool CVideoPlayer::OpenDemuxStream()
 
   CLog::Log(LOGNOTICE, "Creating Demuxer");
 
+  // a prepared input stream comes with an already probed demuxer
+  m_pDemuxer = m_pPreparedDemuxer;
+  m_pPreparedDemuxer = NULL;
+
   int attempts = 10;
-  while (!m_bStop && attempts-- > 0)
+  while (!m_pDemuxer && !m_bStop && attempts-- > 0)
   {
     m_pDemuxer = CDVDFactoryDemuxer::CreateDemuxer(m_pInputStream);
     if(!m_pDemuxer && m_pInputStream->IsStreamType(DVDSTREAM_TYPE_PVRMANAGER))
@@ -1258,6 +1277,11 @@ void CVideoPlayer::Prepare()
   m_CurrentAudio.lastdts = DVD_NOPTS_VALUE;
   m_CurrentVideo.lastdts = DVD_NOPTS_VALUE;
 
+  memset(&m_zapTiming, 0, sizeof(m_zapTiming));
+  if (m_item.HasPVRChannelInfoTag() && m_item.HasProperty("zapstarttime"))
+    m_zapTiming.start = static_cast<unsigned int>(m_item.GetProperty("zapstarttime").asUnsignedInteger());
+  m_bPrepareAdjacentChannels = true;
+
   IPlayerCallback *cb = &m_callback;
   CFileItem fileItem = m_item;
   CJobManager::GetInstance().Submit([=]() {
@@ -1270,6 +1294,7 @@ void CVideoPlayer::Prepare()
     m_error = true;
     return;
   }
+  m_zapTiming.inputStream = XbmcThreads::SystemClockMillis();
 
   if (CDVDInputStream::IMenus* ptr = dynamic_cast<CDVDInputStream::IMenus*>(m_pInputStream))
   {
@@ -1289,6 +1314,8 @@ void CVideoPlayer::Prepare()
     m_error = true;
     return;
   }
+  m_zapTiming.demuxer = XbmcThreads::SystemClockMillis();
+
   // give players a chance to reconsider now codecs are known
   CreatePlayers();
 
@@ -1415,6 +1442,9 @@ void CVideoPlayer::Process()
     if (m_bAbortRequest)
       break;
 
+    // keep the streams of adjacent channels close to the live position
+    m_zapAccelerator.Process();
+
     // should we open a new input stream?
     if (!m_pInputStream)
     {
@@ -2064,6 +2094,23 @@ void CVideoPlayer::HandlePlaySpeed()
       UpdatePlayState(0);
 
       m_syncTimer.Set(3000);
+
+      if (m_zapTiming.start)
+      {
+        unsigned int now = XbmcThreads::SystemClockMillis();
+        CLog::Log(LOGNOTICE, "VideoPlayer::Sync - channel switch took %u ms (input stream: %u ms, demuxer: %u ms, first frame: %u ms, prepared: %s)",
+                  now - m_zapTiming.start, m_zapTiming.inputStream - m_zapTiming.start,
+                  m_zapTiming.demuxer - m_zapTiming.inputStream, now - m_zapTiming.demuxer,
+                  m_zapTiming.prepared ? "yes" : "no");
+        m_zapTiming.start = 0;
+      }
+
+      // prepare the next channels once this one plays, not to slow down its start
+      if (m_bPrepareAdjacentChannels)
+      {
+        m_zapAccelerator.PrepareAdjacentChannels(m_item);
+        m_bPrepareAdjacentChannels = false;
+      }
     }
     else
     {
@@ -2464,7 +2511,9 @@ void CVideoPlayer::OnExit()
   SAFE_DELETE(m_pDemuxer);
   SAFE_DELETE(m_pSubtitleDemuxer);
   SAFE_DELETE(m_pCCDemuxer);
+  SAFE_DELETE(m_pPreparedDemuxer);
   SAFE_DELETE(m_pInputStream);
+  m_zapAccelerator.Clear();
 
   // clean up all selection streams
   m_SelectionStreams.Clear(STREAM_NONE, STREAM_SOURCE_NONE);
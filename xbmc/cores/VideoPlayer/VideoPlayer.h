@@ -36,6 +36,7 @@
 #include "VideoPlayerTeletext.h"
 #include "VideoPlayerRadioRDS.h"
 #include "Edl.h"
+#include "DVDZapAccelerator.h"
 #include "FileItem.h"
 #include "system.h"
 #include "threads/SystemClock.h"
@@ -542,6 +543,18 @@ protected:
   CDVDDemux* m_pDemuxer;            // demuxer for current playing file
   CDVDDemux* m_pSubtitleDemuxer;
   CDVDDemuxCC* m_pCCDemuxer;
+  CDVDDemux* m_pPreparedDemuxer;    // demuxer handed over with a prepared input stream, taken by OpenDemuxStream
+
+  CDVDZapAccelerator m_zapAccelerator;
+  bool m_bPrepareAdjacentChannels;
+
+  struct SZapTiming
+  {
+    unsigned int start;       // time the channel switch was requested, 0 if not measured
+    unsigned int inputStream; // time the input stream was opened
+    unsigned int demuxer;     // time the demuxer was opened
+    bool prepared;            // the stream was prepared by the zap accelerator
+  } m_zapTiming;
 
   CRenderManager m_renderManager;
 
@@ -38,6 +38,7 @@
 #include <numeric>
 #include <iterator>
 #include "utils/log.h"
+#include "utils/Trace.h"
 
 using namespace RenderManager;
 
@@ -923,6 +924,7 @@ CVideoPlayerVideo::EOutputState CVideoPlayerVideo::OutputPicture(const VideoPict
     if (diff < mindiff)
     {
       m_droppingStats.AddOutputDropGain(pPicture->pts, 1);
+      KODI_TRACE(LOGAVTIMING, TraceEvent::VideoOutputDropped, pPicture->pts, iPlayingClock, "late for fast forward");
       return OUTPUT_DROPPED;
     }
   }
@@ -931,6 +933,7 @@ CVideoPlayerVideo::EOutputState CVideoPlayerVideo::OutputPicture(const VideoPict
   {
     m_droppingStats.AddOutputDropGain(pPicture->pts, 1);
     CLog::Log(LOGDEBUG,"%s - dropped in output", __FUNCTION__);
+    KODI_TRACE(LOGAVTIMING, TraceEvent::VideoOutputDropped, pPicture->pts, iPlayingClock, "dropped in output");
     return OUTPUT_DROPPED;
   }
 
@@ -957,9 +960,11 @@ CVideoPlayerVideo::EOutputState CVideoPlayerVideo::OutputPicture(const VideoPict
   if (!m_renderManager.AddVideoPicture(*pPicture, m_bAbortOutput, deintMethod, (m_syncState == ESyncState::SYNC_STARTING)))
   {
     m_droppingStats.AddOutputDropGain(pPicture->pts, 1);
+    KODI_TRACE(LOGAVTIMING, TraceEvent::VideoOutputDropped, pPicture->pts, iPlayingClock, "rejected by renderer");
     return OUTPUT_DROPPED;
   }
 
+  KODI_TRACE(LOGAVTIMING, TraceEvent::VideoOutput, pPicture->pts, iPlayingClock, timeToDisplay);
   return OUTPUT_NORMAL;
 }
 
@@ -28,6 +28,7 @@
 #include "threads/SingleLock.h"
 #include "utils/log.h"
 #include "utils/StringUtils.h"
+#include "utils/Trace.h"
 #include "windowing/WindowingFactory.h"
 
 #include "Application.h"
@@ -1112,6 +1113,7 @@ void CRenderManager::PrepareNextRender()
   }
 
   CLog::LogF(LOGDEBUG, LOGAVTIMING, "frameOnScreen: %f renderPts: %f nextFramePts: %f -> diff: %f  render: %u forceNext: %u", frameOnScreen, renderPts, nextFramePts, (renderPts - nextFramePts), renderPts >= nextFramePts, m_forceNext);
+  KODI_TRACE(LOGAVTIMING, TraceEvent::RenderPrepare, frameOnScreen, renderPts, nextFramePts, m_forceNext);
 
   bool combined = false;
   if (m_presentsourcePast >= 0)
@@ -0,0 +1,210 @@
+/*
+ *      Copyright (C) 2017 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "cores/VideoPlayer/DVDZapAccelerator.h"
+#include "cores/VideoPlayer/DVDDemuxers/DVDDemux.h"
+#include "cores/VideoPlayer/DVDInputStreams/DVDInputStream.h"
+#include "FileItem.h"
+#include "pvr/channels/PVRChannel.h"
+#include "threads/Event.h"
+#include "threads/SystemClock.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <thread>
+
+#include "gtest/gtest.h"
+
+using namespace PVR;
+
+namespace
+{
+  const unsigned int MAX_AGE = 200;
+
+  std::atomic<int> s_openedStreams(0);
+  std::atomic<int> s_deletedStreams(0);
+
+  class CTestInputStream : public CDVDInputStream
+  {
+  public:
+    explicit CTestInputStream(const CFileItem& item) : CDVDInputStream(DVDSTREAM_TYPE_FILE, item) { ++s_openedStreams; }
+    ~CTestInputStream() override { ++s_deletedStreams; }
+
+    int Read(uint8_t* buf, int buf_size) override { return 0; }
+    int64_t Seek(int64_t offset, int whence) override { return -1; }
+    bool Pause(double dTime) override { return false; }
+    int64_t GetLength() override { return 0; }
+    bool IsEOF() override { return false; }
+    void Abort() override { m_aborted.Set(); }
+
+    CEvent m_aborted;
+  };
+
+  class CTestDemuxer : public CDVDDemux
+  {
+  public:
+    void Reset() override {}
+    void Flush() override {}
+    DemuxPacket* Read() override { return nullptr; }
+    bool SeekTime(double time, bool backwards, double* startpts) override { return false; }
+    std::vector<CDemuxStream*> GetStreams() const override { return std::vector<CDemuxStream*>(); }
+    int GetNrOfStreams() const override { return 0; }
+    CDemuxStream* GetStream(int iStreamId) const override { return nullptr; }
+  };
+
+  CPVRChannelPtr MakeChannel(int iUniqueId)
+  {
+    PVR_CHANNEL channel;
+    memset(&channel, 0, sizeof(channel));
+    channel.iUniqueId = iUniqueId;
+    strcpy(channel.strChannelName, "channel");
+    return CPVRChannelPtr(new CPVRChannel(channel, 1));
+  }
+
+  CDVDInputStream* CreateInputStream(const CPVRChannelPtr& channel)
+  {
+    return new CTestInputStream(CFileItem(channel));
+  }
+
+  CDVDDemux* OpenDemuxer(CDVDInputStream* inputStream)
+  {
+    return new CTestDemuxer();
+  }
+
+  bool WaitForPreparedStream(const CDVDZapAccelerator& accelerator, const CPVRChannelPtr& channel)
+  {
+    XbmcThreads::EndTime timeout(5000);
+    while (!accelerator.HasPreparedStream(channel) && !timeout.IsTimePast())
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    return accelerator.HasPreparedStream(channel);
+  }
+
+  bool WaitForDeletedStreams(int count)
+  {
+    XbmcThreads::EndTime timeout(5000);
+    while (s_deletedStreams < count && !timeout.IsTimePast())
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    return s_deletedStreams == count;
+  }
+}
+
+class TestDVDZapAccelerator : public testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    s_openedStreams = 0;
+    s_deletedStreams = 0;
+  }
+};
+
+TEST_F(TestDVDZapAccelerator, TakePreparedStream)
+{
+  const CPVRChannelPtr channel(MakeChannel(1));
+  CDVDZapAccelerator accelerator(CreateInputStream, OpenDemuxer, 60000);
+  accelerator.PrepareChannels({ channel });
+  ASSERT_TRUE(WaitForPreparedStream(accelerator, channel));
+
+  CDVDInputStream* inputStream = nullptr;
+  CDVDDemux* demuxer = nullptr;
+  ASSERT_TRUE(accelerator.TakePreparedStream(CFileItem(channel), inputStream, demuxer));
+  EXPECT_TRUE(dynamic_cast<CTestInputStream*>(inputStream) != nullptr);
+  EXPECT_TRUE(dynamic_cast<CTestDemuxer*>(demuxer) != nullptr);
+  delete demuxer;
+  delete inputStream;
+
+  /* a stream is handed over only once */
+  EXPECT_FALSE(accelerator.HasPreparedStream(channel));
+  EXPECT_FALSE(accelerator.TakePreparedStream(CFileItem(channel), inputStream, demuxer));
+  EXPECT_FALSE(accelerator.TakePreparedStream(CFileItem(MakeChannel(2)), inputStream, demuxer));
+}
+
+TEST_F(TestDVDZapAccelerator, ReleaseChannelsNoLongerAdjacent)
+{
+  const CPVRChannelPtr channel1(MakeChannel(1));
+  const CPVRChannelPtr channel2(MakeChannel(2));
+  CDVDZapAccelerator accelerator(CreateInputStream, OpenDemuxer, 60000);
+  accelerator.PrepareChannels({ channel1, channel2 });
+  ASSERT_TRUE(WaitForPreparedStream(accelerator, channel1));
+  ASSERT_TRUE(WaitForPreparedStream(accelerator, channel2));
+
+  accelerator.PrepareChannels({ channel2 });
+  EXPECT_FALSE(accelerator.HasPreparedStream(channel1));
+  EXPECT_TRUE(accelerator.HasPreparedStream(channel2));
+  EXPECT_TRUE(WaitForDeletedStreams(1));
+
+  /* still prepared channels are not reopened */
+  EXPECT_EQ(2, s_openedStreams);
+}
+
+TEST_F(TestDVDZapAccelerator, ExpiredStreamIsNotHandedOver)
+{
+  const CPVRChannelPtr channel(MakeChannel(1));
+  CDVDZapAccelerator accelerator(CreateInputStream, OpenDemuxer, MAX_AGE);
+  accelerator.PrepareChannels({ channel });
+  ASSERT_TRUE(WaitForPreparedStream(accelerator, channel));
+
+  /* even if Process did not run since the stream expired */
+  std::this_thread::sleep_for(std::chrono::milliseconds(2 * MAX_AGE));
+  EXPECT_FALSE(accelerator.HasPreparedStream(channel));
+
+  CDVDInputStream* inputStream = nullptr;
+  CDVDDemux* demuxer = nullptr;
+  EXPECT_FALSE(accelerator.TakePreparedStream(CFileItem(channel), inputStream, demuxer));
+  EXPECT_EQ(nullptr, inputStream);
+  EXPECT_EQ(nullptr, demuxer);
+  EXPECT_TRUE(WaitForDeletedStreams(1));
+}
+
+TEST_F(TestDVDZapAccelerator, ProcessReopensExpiredStream)
+{
+  const CPVRChannelPtr channel(MakeChannel(1));
+  CDVDZapAccelerator accelerator(CreateInputStream, OpenDemuxer, MAX_AGE);
+  accelerator.PrepareChannels({ channel });
+  ASSERT_TRUE(WaitForPreparedStream(accelerator, channel));
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(2 * MAX_AGE));
+  accelerator.Process();
+  ASSERT_TRUE(WaitForPreparedStream(accelerator, channel));
+  EXPECT_EQ(2, s_openedStreams);
+  EXPECT_TRUE(WaitForDeletedStreams(1));
+}
+
+TEST_F(TestDVDZapAccelerator, StreamBeingPreparedIsAborted)
+{
+  CEvent opening;
+  CDVDZapAccelerator accelerator(CreateInputStream, [&opening](CDVDInputStream* inputStream) -> CDVDDemux* {
+    /* a stalling open only returns once the stream is aborted */
+    opening.Set();
+    static_cast<CTestInputStream*>(inputStream)->m_aborted.WaitMSec(5000);
+    return new CTestDemuxer();
+  }, 60000);
+
+  const CPVRChannelPtr channel(MakeChannel(1));
+  accelerator.PrepareChannels({ channel });
+  ASSERT_TRUE(opening.WaitMSec(5000));
+  EXPECT_FALSE(accelerator.HasPreparedStream(channel));
+
+  CDVDInputStream* inputStream = nullptr;
+  CDVDDemux* demuxer = nullptr;
+  EXPECT_FALSE(accelerator.TakePreparedStream(CFileItem(channel), inputStream, demuxer));
+  EXPECT_TRUE(WaitForDeletedStreams(1));
+}
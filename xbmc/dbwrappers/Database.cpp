@@ -29,6 +29,8 @@
 #include "sqlitedataset.h"
 #include "DatabaseManager.h"
 #include "DbUrl.h"
+#include "threads/SingleLock.h"
+#include "threads/ThreadLocal.h"
 
 #ifdef HAS_MYSQL
 #include "mysqldataset.h"
@@ -42,6 +44,8 @@ using namespace dbiplus;
 
 #define MAX_COMPRESS_COUNT 20
 
+static XbmcThreads::ThreadLocal<std::shared_ptr<CDatabase::CConnectionPool>> currentConnectionPool;
+
 void CDatabase::Filter::AppendField(const std::string &strField)
 {
   if (strField.empty())
@@ -149,6 +153,44 @@ bool CDatabase::ExistsSubQuery::BuildSQL(std::string & strSQL)
   return true;
 }
 
+CDatabase::CConnectionPool::CConnectionPool() = default;
+
+CDatabase::CConnectionPool::~CConnectionPool()
+{
+  for (auto& connection : m_connections)
+    connection.second->disconnect();
+}
+
+std::unique_ptr<Database> CDatabase::CConnectionPool::Take(const std::string &key)
+{
+  CSingleLock lock(m_critSection);
+  auto it = m_connections.find(key);
+  if (it == m_connections.end())
+    return nullptr;
+
+  std::unique_ptr<Database> connection = std::move(it->second);
+  m_connections.erase(it);
+  return connection;
+}
+
+void CDatabase::CConnectionPool::Return(const std::string &key, std::unique_ptr<Database> connection)
+{
+  CSingleLock lock(m_critSection);
+  m_connections.insert(std::make_pair(key, std::move(connection)));
+}
+
+CDatabase::CScopedConnectionPool::CScopedConnectionPool(const std::shared_ptr<CConnectionPool> &pool)
+  : m_pool(pool),
+    m_previous(currentConnectionPool.get())
+{
+  currentConnectionPool.set(&m_pool);
+}
+
+CDatabase::CScopedConnectionPool::~CScopedConnectionPool()
+{
+  currentConnectionPool.set(m_previous);
+}
+
 CDatabase::CDatabase(void)
 {
   m_openCount = 0;
@@ -416,6 +458,25 @@ void CDatabase::DropAnalytics()
 
 bool CDatabase::Connect(const std::string &dbName, const DatabaseSettings &dbSettings, bool create)
 {
+  // an existing database can use a pooled connection, it has been set up already
+  std::shared_ptr<CConnectionPool> pool;
+  if (!create && currentConnectionPool.get() != nullptr)
+    pool = *currentConnectionPool.get();
+  if (pool)
+  {
+    m_connectionKey = StringUtils::Format("%s://%s@%s:%s/%s", dbSettings.type.c_str(), dbSettings.user.c_str(),
+                                          dbSettings.host.c_str(), dbSettings.port.c_str(), dbName.c_str());
+    m_pDB = pool->Take(m_connectionKey);
+    if (m_pDB)
+    {
+      m_pDS.reset(m_pDB->CreateDataset());
+      m_pDS2.reset(m_pDB->CreateDataset());
+      m_connectionPool = pool;
+      m_openCount = 1;
+      return true;
+    }
+  }
+
   // create the appropriate database structure
   if (dbSettings.type == "sqlite3")
   {
@@ -500,6 +561,7 @@ bool CDatabase::Connect(const std::string &dbName, const DatabaseSettings &dbSet
   }
 
   m_openCount = 1; // our database is open
+  m_connectionPool = pool;
   return true;
 }
 
@@ -530,8 +592,21 @@ void CDatabase::Close()
   m_openCount = 0;
   m_multipleExecute = false;
 
+  std::shared_ptr<CConnectionPool> pool = std::move(m_connectionPool);
+  m_connectionPool.reset();
+
   if (NULL == m_pDB.get() ) return ;
   if (NULL != m_pDS.get()) m_pDS->close();
+
+  // hand a clean connection back to the pool instead of disconnecting
+  if (pool && !m_pDB->in_transaction())
+  {
+    m_pDS.reset();
+    m_pDS2.reset();
+    pool->Return(m_connectionKey, std::move(m_pDB));
+    return;
+  }
+
   m_pDB->disconnect();
   m_pDB.reset();
   m_pDS.reset();
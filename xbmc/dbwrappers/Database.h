@@ -25,10 +25,13 @@ namespace dbiplus {
   class Dataset;
 }
 
+#include <map>
 #include <memory>
 #include <string>
 #include <vector>
 
+#include "threads/CriticalSection.h"
+
 class DatabaseSettings; // forward
 class CDbUrl;
 struct SortDescription;
@@ -73,6 +76,50 @@ public:
   };
 
 
+  /*!
+   * @brief Keeps the connections of closed databases for the next database opened on the same data.
+   *
+   * While a pool is active on a thread (see CScopedConnectionPool), databases opened
+   * on that thread take an idle connection from the pool instead of connecting and
+   * hand it back when they are closed. A pool can be active on several threads at
+   * once, every connection is used by one database at a time. Databases keep the
+   * pool alive until they are closed, the idle connections are closed with the pool.
+   */
+  class CConnectionPool
+  {
+  public:
+    CConnectionPool();
+    ~CConnectionPool();
+
+  private:
+    CConnectionPool(const CConnectionPool&) = delete;
+    CConnectionPool& operator=(const CConnectionPool&) = delete;
+
+    friend class CDatabase;
+    std::unique_ptr<dbiplus::Database> Take(const std::string &key);
+    void Return(const std::string &key, std::unique_ptr<dbiplus::Database> connection);
+
+    CCriticalSection m_critSection;
+    std::multimap<std::string, std::unique_ptr<dbiplus::Database>> m_connections;
+  };
+
+  /*!
+   * @brief Activates a connection pool on the current thread while it exists.
+   */
+  class CScopedConnectionPool
+  {
+  public:
+    explicit CScopedConnectionPool(const std::shared_ptr<CConnectionPool> &pool);
+    ~CScopedConnectionPool();
+
+  private:
+    CScopedConnectionPool(const CScopedConnectionPool&) = delete;
+    CScopedConnectionPool& operator=(const CScopedConnectionPool&) = delete;
+
+    std::shared_ptr<CConnectionPool> m_pool;
+    std::shared_ptr<CConnectionPool> *m_previous;
+  };
+
   CDatabase(void);
   virtual ~CDatabase(void);
   bool IsOpen();
@@ -229,6 +276,9 @@ private:
   bool m_bMultiWrite; /*!< True if there are any queries in the queue, false otherwise */
   unsigned int m_openCount;
 
+  std::shared_ptr<CConnectionPool> m_connectionPool; /*!< Pool the connection is handed back to on Close(), if any */
+  std::string m_connectionKey;
+
   bool m_multipleExecute;
   std::vector<std::string> m_multipleQueries;
 };
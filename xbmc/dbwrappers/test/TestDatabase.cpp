@@ -0,0 +1,113 @@
+/*
+ *      Copyright (C) 2017 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <memory>
+
+#include <gtest/gtest.h>
+
+#include "dbwrappers/Database.h"
+#include "dbwrappers/dataset.h"
+#include "filesystem/File.h"
+#include "filesystem/SpecialProtocol.h"
+#include "settings/AdvancedSettings.h"
+
+#define TEST_DATABASE_NAME "connectionpooltest"
+
+namespace
+{
+  class CTestDatabase : public CDatabase
+  {
+  public:
+    const dbiplus::Database* GetConnection() const { return m_pDB.get(); }
+
+  protected:
+    void CreateTables() override
+    {
+      m_pDS->exec("CREATE TABLE item (id INTEGER PRIMARY KEY)");
+    }
+
+    void CreateAnalytics() override { }
+    int GetSchemaVersion() const override { return 1; }
+    const char* GetBaseDBName() const override { return "MyTest"; }
+  };
+}
+
+class TestDatabase : public testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    m_settings.type = "sqlite3";
+    m_settings.host = CSpecialProtocol::TranslatePath("special://temp/");
+
+    CTestDatabase database;
+    ASSERT_TRUE(database.Connect(TEST_DATABASE_NAME, m_settings, true));
+    database.Close();
+  }
+
+  void TearDown() override
+  {
+    XFILE::CFile::Delete(m_settings.host + TEST_DATABASE_NAME ".db");
+  }
+
+  DatabaseSettings m_settings;
+};
+
+TEST_F(TestDatabase, ReusesPooledConnection)
+{
+  std::shared_ptr<CDatabase::CConnectionPool> pool = std::make_shared<CDatabase::CConnectionPool>();
+  CDatabase::CScopedConnectionPool scopedPool(pool);
+
+  CTestDatabase first;
+  ASSERT_TRUE(first.Connect(TEST_DATABASE_NAME, m_settings, false));
+  const dbiplus::Database *connection = first.GetConnection();
+  first.Close();
+
+  // the pool keeps the connection alive, so an equal pointer is the same connection
+  CTestDatabase second;
+  ASSERT_TRUE(second.Connect(TEST_DATABASE_NAME, m_settings, false));
+  EXPECT_EQ(connection, second.GetConnection());
+
+  // every connection is used by one database at a time
+  CTestDatabase concurrent;
+  ASSERT_TRUE(concurrent.Connect(TEST_DATABASE_NAME, m_settings, false));
+  EXPECT_NE(connection, concurrent.GetConnection());
+
+  concurrent.Close();
+  second.Close();
+}
+
+TEST_F(TestDatabase, DoesNotReuseConnectionInTransaction)
+{
+  std::shared_ptr<CDatabase::CConnectionPool> pool = std::make_shared<CDatabase::CConnectionPool>();
+  CDatabase::CScopedConnectionPool scopedPool(pool);
+
+  CTestDatabase first;
+  ASSERT_TRUE(first.Connect(TEST_DATABASE_NAME, m_settings, false));
+  first.BeginTransaction();
+  ASSERT_TRUE(first.ExecuteQuery("INSERT INTO item (id) VALUES (1)"));
+  first.Close();
+
+  // a reused connection would still be inside the transaction and see its changes
+  CTestDatabase second;
+  ASSERT_TRUE(second.Connect(TEST_DATABASE_NAME, m_settings, false));
+  EXPECT_EQ("0", second.GetSingleValue("SELECT COUNT(*) FROM item"));
+  second.Close();
+}
@@ -526,7 +526,8 @@
 #define PVR_RADIO_NEXT_RECORDING_CHAN_ICO (PVR_STRINGS_START + 57)
 #define PVR_RADIO_NEXT_RECORDING_DATETIME (PVR_STRINGS_START + 58)
 #define PVR_CHANNEL_NUMBER_INPUT    (PVR_STRINGS_START + 59)
-#define PVR_STRINGS_END             PVR_CHANNEL_NUMBER_INPUT
+#define PVR_BACKEND_RESPONSE_TIME   (PVR_STRINGS_START + 60)
+#define PVR_STRINGS_END             PVR_BACKEND_RESPONSE_TIME
 
 #define ADSP_CONDITIONS_START       1300
 #define ADSP_IS_ACTIVE              (ADSP_CONDITIONS_START)
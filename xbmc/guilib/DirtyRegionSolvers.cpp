@@ -20,6 +20,8 @@
 
 #include "DirtyRegionSolvers.h"
 #include "GraphicContext.h"
+
+#include <limits>
 #include <stdio.h>
 
 void CUnionDirtyRegionSolver::Solve(const CDirtyRegionList &input, CDirtyRegionList &output)
@@ -81,3 +83,95 @@ void CGreedyDirtyRegionSolver::Solve(const CDirtyRegionList &input, CDirtyRegion
       output.push_back(currentRegion);
   }
 }
+
+namespace
+{
+
+bool Overlaps(const CRect &first, const CRect &second)
+{
+  return first.x1 < second.x2 && second.x1 < first.x2 &&
+         first.y1 < second.y2 && second.y1 < first.y2;
+}
+
+}
+
+CPartialRedrawRegionSolver::CPartialRedrawRegionSolver()
+{
+  m_costNewRegion = 10.0f;
+  m_costPerArea   = 0.01f;
+  m_maxRegions    = 8;
+}
+
+float CPartialRedrawRegionSolver::MergeCost(const CDirtyRegion &first, const CDirtyRegion &second) const
+{
+  CDirtyRegion merged = first;
+  merged.Union(second);
+
+  // only the area that neither region needed is wasted by the merge
+  CDirtyRegion intersection = first;
+  intersection.Intersect(second);
+  float wasted = merged.Area() - first.Area() - second.Area() + intersection.Area();
+
+  return m_costPerArea * wasted;
+}
+
+void CPartialRedrawRegionSolver::AddRegion(CDirtyRegionList &regions, CDirtyRegion region) const
+{
+  // absorbing a region can grow the current one into its neighbours, so keep
+  // scanning until no region overlaps or is cheap enough to merge
+  bool merged = true;
+  while (merged)
+  {
+    merged = false;
+    for (CDirtyRegionList::iterator it = regions.begin(); it != regions.end(); ++it)
+    {
+      if (Overlaps(region, *it) || MergeCost(region, *it) < m_costNewRegion)
+      {
+        region.Union(*it);
+        regions.erase(it);
+        merged = true;
+        break;
+      }
+    }
+  }
+
+  regions.push_back(region);
+}
+
+void CPartialRedrawRegionSolver::Solve(const CDirtyRegionList &input, CDirtyRegionList &output)
+{
+  CDirtyRegionList regions;
+  for (CDirtyRegionList::const_iterator it = input.begin(); it != input.end(); ++it)
+  {
+    if (!it->IsEmpty())
+      AddRegion(regions, *it);
+  }
+
+  while (regions.size() > m_maxRegions)
+  {
+    size_t first = 0;
+    size_t second = 1;
+    float bestCost = std::numeric_limits<float>::max();
+    for (size_t i = 0; i < regions.size(); i++)
+    {
+      for (size_t j = i + 1; j < regions.size(); j++)
+      {
+        float cost = MergeCost(regions[i], regions[j]);
+        if (cost < bestCost)
+        {
+          bestCost = cost;
+          first = i;
+          second = j;
+        }
+      }
+    }
+
+    CDirtyRegion merged = regions[first];
+    merged.Union(regions[second]);
+    regions.erase(regions.begin() + second);
+    regions.erase(regions.begin() + first);
+    AddRegion(regions, merged);
+  }
+
+  output.insert(output.end(), regions.begin(), regions.end());
+}
@@ -48,3 +48,26 @@ private:
   float m_costNewRegion;
   float m_costPerArea;
 };
+
+/*!
+ \brief Keeps a small set of disjoint rectangles, each of which is rendered
+ in its own scissored pass.
+
+ Overlapping regions are always merged so no pixel is drawn twice. Regions
+ that merely lie close to each other are merged when the wasted area of the
+ union is cheaper than an extra render pass. If the result still exceeds the
+ pass limit the cheapest pairs are merged until it fits.
+ */
+class CPartialRedrawRegionSolver : public IDirtyRegionSolver
+{
+public:
+  CPartialRedrawRegionSolver();
+  void Solve(const CDirtyRegionList &input, CDirtyRegionList &output) override;
+private:
+  void AddRegion(CDirtyRegionList &regions, CDirtyRegion region) const;
+  float MergeCost(const CDirtyRegion &first, const CDirtyRegion &second) const;
+
+  float m_costNewRegion;
+  float m_costPerArea;
+  unsigned int m_maxRegions;
+};
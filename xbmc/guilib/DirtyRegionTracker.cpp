@@ -19,6 +19,7 @@
  */
 
 #include "DirtyRegionTracker.h"
+#include "GraphicContext.h"
 #include "settings/AdvancedSettings.h"
 #include "utils/log.h"
 #include <stdio.h>
@@ -27,6 +28,8 @@
 CDirtyRegionTracker::CDirtyRegionTracker(int buffering)
 {
   m_buffering = buffering;
+  m_bufferAge = -1;
+  m_useBufferAge = false;
   m_solver = NULL;
 }
 
@@ -38,6 +41,7 @@ CDirtyRegionTracker::~CDirtyRegionTracker()
 void CDirtyRegionTracker::SelectAlgorithm()
 {
   delete m_solver;
+  m_useBufferAge = false;
 
   switch (g_advancedSettings.m_guiAlgorithmDirtyRegions)
   {
@@ -49,6 +53,11 @@ void CDirtyRegionTracker::SelectAlgorithm()
       CLog::Log(LOGDEBUG, "guilib: Cost reduction as algorithm for solving rendering passes");
       m_solver = new CGreedyDirtyRegionSolver();
       break;
+    case DIRTYREGION_SOLVER_PARTIAL_REDRAW:
+      CLog::Log(LOGDEBUG, "guilib: Partial redraw of disjoint regions for solving rendering passes");
+      m_solver = new CPartialRedrawRegionSolver();
+      m_useBufferAge = true;
+      break;
     case DIRTYREGION_SOLVER_UNION:
       m_solver = new CUnionDirtyRegionSolver();
       CLog::Log(LOGDEBUG, "guilib: Union as algorithm for solving rendering passes");
@@ -67,6 +76,11 @@ void CDirtyRegionTracker::MarkDirtyRegion(const CDirtyRegion &region)
     m_markedRegions.push_back(region);
 }
 
+void CDirtyRegionTracker::SetBufferAge(int age)
+{
+  m_bufferAge = age;
+}
+
 const CDirtyRegionList &CDirtyRegionTracker::GetMarkedRegions() const
 {
   return m_markedRegions;
@@ -76,8 +90,29 @@ CDirtyRegionList CDirtyRegionTracker::GetDirtyRegions()
 {
   CDirtyRegionList output;
 
-  if (m_solver)
+  if (!m_solver)
+    return output;
+
+  // only the partial redraw window systems drop the preserved back buffer
+  if (!m_useBufferAge || m_bufferAge < 0 || g_advancedSettings.m_guiVisualizeDirtyRegions)
     m_solver->Solve(m_markedRegions, output);
+  else if (!m_markedRegions.empty())
+  {
+    // the back buffer is older than the regions we still track, so its
+    // content can not be repaired and has to be drawn from scratch
+    if (m_bufferAge == 0 || m_bufferAge > m_buffering)
+      output.push_back(CDirtyRegion(CRect(0, 0, float(g_graphicsContext.GetWidth()), float(g_graphicsContext.GetHeight()))));
+    else
+    {
+      CDirtyRegionList regions;
+      for (CDirtyRegionList::const_iterator i = m_markedRegions.begin(); i != m_markedRegions.end(); ++i)
+      {
+        if (i->GetAge() < m_bufferAge)
+          regions.push_back(*i);
+      }
+      m_solver->Solve(regions, output);
+    }
+  }
 
   return output;
 }
@@ -35,6 +35,15 @@ public:
   void SelectAlgorithm();
   void MarkDirtyRegion(const CDirtyRegion &region);
 
+  /*!
+   \brief Set the age of the back buffer the next frame is rendered into.
+   \param age number of frames since the buffer was last presented, 0 if its
+   content is undefined, or a negative value if unknown. With a known age only
+   the regions marked during the last age frames need to be redrawn. The age
+   is only used by the partial redraw solver.
+   */
+  void SetBufferAge(int age);
+
   const CDirtyRegionList &GetMarkedRegions() const;
   CDirtyRegionList GetDirtyRegions();
   void CleanMarkedRegions();
@@ -42,5 +51,7 @@ public:
 private:
   CDirtyRegionList m_markedRegions;
   int m_buffering;
+  int m_bufferAge;
+  bool m_useBufferAge;
   IDirtyRegionSolver *m_solver;
 };
@@ -34,6 +34,8 @@
 #include "settings/Settings.h"
 #include "guiinfo/GUIInfoLabels.h"
 
+#include <algorithm>
+
 #define HOLD_TIME_START 100
 #define HOLD_TIME_END   3000
 #define SCROLLING_GAP   200U
@@ -61,6 +63,7 @@ CGUIBaseContainer::CGUIBaseContainer(int parentID, int controlID, float posX, fl
   m_autoScrollDelayTime = 0;
   m_autoScrollIsReversed = false;
   m_lastRenderTime = 0;
+  m_letterOffsetsValid = false;
 }
 
 CGUIBaseContainer::~CGUIBaseContainer(void)
@@ -157,6 +160,9 @@ void CGUIBaseContainer::ProcessItem(float posX, float posY, CGUIListItemPtr& ite
 
   if (m_bInvalidated)
     item->SetInvalid();
+  // remember which items get layouts, so they can be freed without walking the whole list
+  if (!item->GetLayout() && !item->GetFocusedLayout())
+    m_allocatedItems.insert(std::make_pair(item, CAllocatedItem{ m_freeMemoryPass, true }));
   if (focused)
   {
     if (!item->GetFocusedLayout())
@@ -187,11 +193,7 @@ void CGUIBaseContainer::ProcessItem(float posX, float posY, CGUIListItemPtr& ite
     if (item->GetFocusedLayout())
       item->GetFocusedLayout()->SetFocusedItem(0);  // focus is not set
     if (!item->GetLayout())
-    {
-      CGUIListItemLayout *layout = new CGUIListItemLayout(*m_layout);
-      layout->SetParentControl(this);
-      item->SetLayout(layout);
-    }
+      item->SetLayout(CreateLayout());
     if (item->GetFocusedLayout())
       item->GetFocusedLayout()->Process(item.get(), m_parentID, currentTime, dirtyregions);
     if (item->GetLayout())
@@ -413,10 +415,12 @@ bool CGUIBaseContainer::OnMessage(CGUIMessage& message)
       { // bind our items
         Reset();
         CFileItemList *items = static_cast<CFileItemList*>(message.GetPointer());
+        m_items.reserve(items->Size());
         for (int i = 0; i < items->Size(); i++)
           m_items.push_back(items->Get(i));
+        AddAllocatedItems();
         UpdateLayout(true); // true to refresh all items
-        UpdateScrollByLetter();
+        m_letterOffsetsValid = false;
         SelectItem(message.GetParam1());
         return true;
       }
@@ -534,12 +538,13 @@ void CGUIBaseContainer::OnRight()
 
 void CGUIBaseContainer::OnNextLetter()
 {
+  const auto &letterOffsets = GetLetterOffsets();
   int offset = CorrectOffset(GetOffset(), GetCursor());
-  for (unsigned int i = 0; i < m_letterOffsets.size(); i++)
+  for (unsigned int i = 0; i < letterOffsets.size(); i++)
   {
-    if (m_letterOffsets[i].first > offset)
+    if (letterOffsets[i].first > offset)
     {
-      SelectItem(m_letterOffsets[i].first);
+      SelectItem(letterOffsets[i].first);
       return;
     }
   }
@@ -547,14 +552,15 @@ void CGUIBaseContainer::OnNextLetter()
 
 void CGUIBaseContainer::OnPrevLetter()
 {
+  const auto &letterOffsets = GetLetterOffsets();
   int offset = CorrectOffset(GetOffset(), GetCursor());
-  if (!m_letterOffsets.size())
+  if (!letterOffsets.size())
     return;
-  for (int i = (int)m_letterOffsets.size() - 1; i >= 0; i--)
+  for (int i = (int)letterOffsets.size() - 1; i >= 0; i--)
   {
-    if (m_letterOffsets[i].first < offset)
+    if (letterOffsets[i].first < offset)
     {
-      SelectItem(m_letterOffsets[i].first);
+      SelectItem(letterOffsets[i].first);
       return;
     }
   }
@@ -570,7 +576,7 @@ void CGUIBaseContainer::OnJumpLetter(char letter, bool skip /*=false*/)
   m_matchTimer.StartZero();
 
   // we can't jump through letters if we have none
-  if (0 == m_letterOffsets.size())
+  if (GetLetterOffsets().empty())
     return;
 
   // find the current letter we're focused on
@@ -601,30 +607,32 @@ void CGUIBaseContainer::OnJumpSMS(int letter)
 {
   static const char letterMap[8][6] = { "ABC2", "DEF3", "GHI4", "JKL5", "MNO6", "PQRS7", "TUV8", "WXYZ9" };
 
+  const auto &letterOffsets = GetLetterOffsets();
+
   // only 2..9 supported
-  if (letter < 2 || letter > 9 || !m_letterOffsets.size())
+  if (letter < 2 || letter > 9 || !letterOffsets.size())
     return;
 
   const std::string letters = letterMap[letter - 2];
   // find where we currently are
   int offset = CorrectOffset(GetOffset(), GetCursor());
   unsigned int currentLetter = 0;
-  while (currentLetter + 1 < m_letterOffsets.size() && m_letterOffsets[currentLetter + 1].first <= offset)
+  while (currentLetter + 1 < letterOffsets.size() && letterOffsets[currentLetter + 1].first <= offset)
     currentLetter++;
 
   // now switch to the next letter
-  std::string current = m_letterOffsets[currentLetter].second;
+  std::string current = letterOffsets[currentLetter].second;
   size_t startPos = (letters.find(current) + 1) % letters.size();
   // now jump to letters[startPos], or another one in the same range if possible
   size_t pos = startPos;
   while (true)
   {
     // check if we can jump to this letter
-    for (size_t i = 0; i < m_letterOffsets.size(); i++)
+    for (size_t i = 0; i < letterOffsets.size(); i++)
     {
-      if (m_letterOffsets[i].second == letters.substr(pos, 1))
+      if (letterOffsets[i].second == letters.substr(pos, 1))
       {
-        SelectItem(m_letterOffsets[i].first);
+        SelectItem(letterOffsets[i].first);
         return;
       }
     }
@@ -879,6 +887,7 @@ void CGUIBaseContainer::UpdateLayout(bool updateAllItems)
 {
   if (updateAllItems)
   { // free memory of items
+    FreeAllItemMemory();
     for (iItems it = m_items.begin(); it != m_items.end(); ++it)
       (*it)->FreeMemory();
   }
@@ -941,6 +950,7 @@ void CGUIBaseContainer::UpdateListProvider(bool forceRefresh /* = false */)
 
       Reset();
       m_listProvider->Fetch(m_items);
+      AddAllocatedItems();
       SetPageControlRange();
       // update the newly selected item
       bool found = false;
@@ -984,8 +994,9 @@ void CGUIBaseContainer::UpdateListProvider(bool forceRefresh /* = false */)
       SetInvalid();
     }
     // always update the scroll by letter, as the list provider may have altered labels
-    // while not actually changing the list items.
-    UpdateScrollByLetter();
+    // while not actually changing the list items. The offsets are only rebuilt
+    // once they are needed, as walking the whole list every frame is too costly.
+    m_letterOffsetsValid = false;
   }
 }
 
@@ -1002,15 +1013,31 @@ void CGUIBaseContainer::CalculateLayout()
   if (oldLayout == m_layout && oldFocusedLayout == m_focusedLayout)
     return; // nothing has changed, so don't update stuff
 
+  if (oldLayout != m_layout)
+  { // layouts created from the old template can't be reused
+    for (const auto &item : m_allocatedItems)
+      item.first->FreeMemory();
+    m_allocatedItems.clear();
+    m_recycledLayouts.clear();
+  }
+
   m_itemsPerPage = std::max((int)((Size() - m_focusedLayout->Size(m_orientation)) / m_layout->Size(m_orientation)) + 1, 1);
 
   // ensure that the scroll offset is a multiple of our size
   m_scroller.SetValue(GetOffset() * m_layout->Size(m_orientation));
 }
 
+const std::vector< std::pair<int, std::string> > &CGUIBaseContainer::GetLetterOffsets()
+{
+  if (!m_letterOffsetsValid)
+    UpdateScrollByLetter();
+  return m_letterOffsets;
+}
+
 void CGUIBaseContainer::UpdateScrollByLetter()
 {
   m_letterOffsets.clear();
+  m_letterOffsetsValid = true;
 
   // for scrolling by letter we have an offset table into our vector.
   std::string currentMatch;
@@ -1137,6 +1164,7 @@ int CGUIBaseContainer::CorrectOffset(int offset, int cursor) const
 void CGUIBaseContainer::Reset()
 {
   m_wasReset = true;
+  FreeAllItemMemory();
   m_items.clear();
   m_lastItem.reset();
   ResetAutoScrolling();
@@ -1184,20 +1212,94 @@ void CGUIBaseContainer::SetRenderOffset(const CPoint &offset)
 
 void CGUIBaseContainer::FreeMemory(int keepStart, int keepEnd)
 {
+  // only the items that hold layouts are visited, so the cost depends on the
+  // number of items on screen rather than on the size of the list. The kept
+  // items are stamped with the current pass, everything else is freed.
+  const int size = static_cast<int>(m_items.size());
+  if (keepStart >= keepEnd && keepEnd + 1 >= keepStart)
+    return; // wrapping around the whole list
+
+  const unsigned int pass = ++m_freeMemoryPass;
+  auto keep = [this, pass](int i)
+  {
+    auto it = m_allocatedItems.find(m_items[i]);
+    if (it != m_allocatedItems.end())
+      it->second.pass = pass;
+  };
+
   if (keepStart < keepEnd)
-  { // remove before keepStart and after keepEnd
-    for (int i = 0; i < keepStart && i < (int)m_items.size(); ++i)
-      m_items[i]->FreeMemory();
-    for (int i = std::max(keepEnd + 1, 0); i < (int)m_items.size(); ++i)
-      m_items[i]->FreeMemory();
+  { // keep everything between keepStart and keepEnd
+    for (int i = std::max(keepStart, 0); i <= keepEnd && i < size; ++i)
+      keep(i);
   }
   else
   { // wrapping
-    for (int i = std::max(keepEnd + 1, 0); i < keepStart && i < (int)m_items.size(); ++i)
-      m_items[i]->FreeMemory();
+    for (int i = 0; i <= keepEnd && i < size; ++i)
+      keep(i);
+    for (int i = std::max(keepStart, 0); i < size; ++i)
+      keep(i);
+  }
+
+  auto it = m_allocatedItems.begin();
+  while (it != m_allocatedItems.end())
+  {
+    if (it->second.pass != pass)
+    {
+      FreeItemMemory(it->first, it->second.recycle);
+      it = m_allocatedItems.erase(it);
+    }
+    else
+      ++it;
   }
 }
 
+void CGUIBaseContainer::FreeItemMemory(const CGUIListItemPtr &item, bool recycle /* = true */)
+{
+  CGUIListItemLayout *layout = recycle ? item->ReleaseLayout() : nullptr;
+  if (layout)
+  {
+    layout->FreeResources();
+    if (m_recycledLayouts.size() < max_recycled_layouts)
+      m_recycledLayouts.emplace_back(layout);
+    else
+      delete layout;
+  }
+  item->FreeMemory();
+}
+
+void CGUIBaseContainer::FreeAllItemMemory()
+{
+  for (const auto &item : m_allocatedItems)
+    FreeItemMemory(item.first, item.second.recycle);
+  m_allocatedItems.clear();
+}
+
+void CGUIBaseContainer::AddAllocatedItems()
+{
+  // bound items may still hold layouts from another container or an earlier
+  // bind, which have to be freed once the items leave the view
+  for (const auto &item : m_items)
+  {
+    if (item->GetLayout() || item->GetFocusedLayout())
+      m_allocatedItems.insert(std::make_pair(item, CAllocatedItem{ m_freeMemoryPass, false }));
+  }
+}
+
+CGUIListItemLayout *CGUIBaseContainer::CreateLayout()
+{
+  if (!m_recycledLayouts.empty())
+  {
+    CGUIListItemLayout *layout = m_recycledLayouts.back().release();
+    m_recycledLayouts.pop_back();
+    layout->Recycle();
+    return layout;
+  }
+
+  CGUIListItemLayout *layout = new CGUIListItemLayout(*m_layout);
+  layout->SetParentControl(this);
+  return layout;
+}
+
 bool CGUIBaseContainer::InsideLayout(const CGUIListItemLayout *layout, const CPoint &point) const
 {
   if (!layout) return false;
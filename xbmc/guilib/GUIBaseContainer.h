@@ -25,6 +25,8 @@
  *
  */
 
+#include <memory>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
@@ -135,6 +137,10 @@ protected:
   int ScrollCorrectionRange() const;
   inline float Size() const;
   void FreeMemory(int keepStart, int keepEnd);
+  void FreeItemMemory(const CGUIListItemPtr &item, bool recycle = true);
+  void FreeAllItemMemory();
+  void AddAllocatedItems();
+  CGUIListItemLayout *CreateLayout();
   void GetCurrentLayouts();
   CGUIListItemLayout *GetFocusedLayout() const;
 
@@ -157,6 +163,15 @@ protected:
 
   CGUIListItemLayout *m_layout;
   CGUIListItemLayout *m_focusedLayout;
+
+  struct CAllocatedItem
+  {
+    unsigned int pass; ///< \brief the last FreeMemory() pass that kept the item
+    bool recycle;      ///< \brief false if the layouts were created by another container and can't be reused
+  };
+  std::unordered_map<CGUIListItemPtr, CAllocatedItem> m_allocatedItems; ///< \brief items currently holding layouts, so they can be freed without walking the whole list
+  unsigned int m_freeMemoryPass = 0;
+  std::vector<std::unique_ptr<CGUIListItemLayout>> m_recycledLayouts; ///< \brief unused copies of m_layout ready for reuse
   bool m_layoutCondition = false;
   bool m_focusedLayoutCondition = false;
 
@@ -174,6 +189,7 @@ protected:
                     // changing around)
 
   void UpdateScrollByLetter();
+  const std::vector< std::pair<int, std::string> > &GetLetterOffsets();
   void GetCacheOffsets(int &cacheBefore, int &cacheAfter) const;
   int GetCacheCount() const { return m_cacheItems; };
   bool ScrollingDown() const { return m_scroller.IsScrollingDown(); };
@@ -183,6 +199,7 @@ protected:
   void OnJumpLetter(char letter, bool skip = false);
   void OnJumpSMS(int letter);
   std::vector< std::pair<int, std::string> > m_letterOffsets;
+  bool m_letterOffsetsValid;
 
   /*! \brief Set the cursor position
    Should be used by all base classes rather than directly setting it, as
@@ -235,6 +252,7 @@ private:
   float m_scrollItemsPerFrame;
 
   static const int letter_match_timeout = 1000;
+  static const unsigned int max_recycled_layouts = 100;
 };
 
 
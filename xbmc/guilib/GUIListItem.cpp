@@ -374,6 +374,13 @@ CGUIListItemLayout *CGUIListItem::GetLayout()
   return m_layout;
 }
 
+CGUIListItemLayout *CGUIListItem::ReleaseLayout()
+{
+  CGUIListItemLayout *layout = m_layout;
+  m_layout = NULL;
+  return layout;
+}
+
 void CGUIListItem::SetFocusedLayout(CGUIListItemLayout *layout)
 {
   delete m_focusedLayout;
@@ -144,6 +144,10 @@ public:
 
   void SetLayout(CGUIListItemLayout *layout);
   CGUIListItemLayout *GetLayout();
+  /*! \brief Hand the item's layout over to the caller without destroying it.
+   \return the layout, which the caller now owns, or NULL if the item has none.
+   */
+  CGUIListItemLayout *ReleaseLayout();
 
   void SetFocusedLayout(CGUIListItemLayout *layout);
   CGUIListItemLayout *GetFocusedLayout();
@@ -44,6 +44,10 @@ public:
   void ResetAnimation(ANIMATION_TYPE animType);
   void SetInvalid() { m_invalidated = true; };
   void FreeResources(bool immediately = false);
+  /*! \brief Drop the state left behind by the previous item so the layout can be
+   reused for another one. Resources must have been freed beforehand.
+   */
+  void Recycle();
   void SetParentControl(CGUIControl *control) { m_group.SetParentControl(control); };
 
 //#ifdef GUILIB_PYTHON_COMPATIBILITY
@@ -36,6 +36,7 @@
 #include "utils/log.h"
 #include "utils/StringUtils.h"
 #include "utils/SeekHandler.h"
+#include "windowing/WindowingFactory.h"
 
 #include "windows/GUIWindowHome.h"
 #include "events/windows/GUIWindowEventLog.h"
@@ -1167,6 +1168,7 @@ bool CGUIWindowManager::Render()
   assert(g_application.IsCurrentThread());
   CSingleExit lock(g_graphicsContext);
 
+  m_tracker.SetBufferAge(g_Windowing.GetBufferAge());
   CDirtyRegionList dirtyRegions = m_tracker.GetDirtyRegions();
 
   bool hasRendered = false;
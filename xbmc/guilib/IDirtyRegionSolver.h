@@ -25,6 +25,7 @@
 #define DIRTYREGION_SOLVER_UNION 1
 #define DIRTYREGION_SOLVER_COST_REDUCTION 2
 #define DIRTYREGION_SOLVER_FILL_VIEWPORT_ON_CHANGE 3
+#define DIRTYREGION_SOLVER_PARTIAL_REDRAW 4
 
 class IDirtyRegionSolver
 {
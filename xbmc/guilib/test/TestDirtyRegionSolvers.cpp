@@ -0,0 +1,231 @@
+/*
+ *      Copyright (C) 2005-2017 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "guilib/DirtyRegionSolvers.h"
+
+#include "gtest/gtest.h"
+
+namespace
+{
+
+// regions a 1080p home window marks in typical frames
+const CDirtyRegion clockLabel(1640, 20, 1880, 70);
+const CDirtyRegion dateLabel(1640, 70, 1880, 100);
+const CDirtyRegion oldMenuItem(0, 300, 400, 380);
+const CDirtyRegion newMenuItem(0, 380, 400, 460);
+const CDirtyRegion busySpinner(920, 500, 1000, 580);
+
+float RedrawnPixels(const CDirtyRegionList &regions)
+{
+  float pixels = 0;
+  for (const auto &region : regions)
+    pixels += region.Area();
+  return pixels;
+}
+
+// regions of the Estuary home window at 1920x1080, taken from the control
+// layout in Home.xml, Includes.xml and Includes_Home.xml
+
+// TopBar: the System.Time label in the right aligned grouplist at right 20,
+// height 200, about 170 pixels wide in font_clock
+const CDirtyRegion estuaryClock(1730, 0, 1900, 200);
+// main menu: fixedlist 9000 at left 0, top 240, width 462, bottom -10
+const CDirtyRegion estuaryMainMenu(0, 240, 462, 1070);
+// widget area: group 2000 at left 462 that slides in when the menu item changes
+const CDirtyRegion estuaryWidgets(462, 0, 1920, 1080);
+
+// poster of the given item in the first WidgetListPoster panel of group 2000:
+// 310 pixels per item, the poster at 83,115 is 290x400 and zoomed to 110%
+// around 230,130 of its item group while focused
+CDirtyRegion EstuaryPoster(int item, bool focused)
+{
+  const float left = 462 + 310 * item;
+  const float zoom = focused ? 1.1f : 1.0f;
+  const float centerX = left + 68 + 230;
+  const float centerY = 115 + 10 + 130;
+  return CDirtyRegion(centerX + (left + 83 - centerX) * zoom,
+                      centerY + (115 - centerY) * zoom,
+                      centerX + (left + 373 - centerX) * zoom,
+                      centerY + (515 - centerY) * zoom);
+}
+
+bool Overlap(const CRect &first, const CRect &second)
+{
+  return first.x1 < second.x2 && second.x1 < first.x2 &&
+         first.y1 < second.y2 && second.y1 < first.y2;
+}
+
+bool Disjoint(const CDirtyRegionList &regions)
+{
+  for (size_t i = 0; i < regions.size(); i++)
+    for (size_t j = i + 1; j < regions.size(); j++)
+      if (Overlap(regions[i], regions[j]))
+        return false;
+  return true;
+}
+
+bool Covers(const CDirtyRegionList &regions, const CDirtyRegion &region)
+{
+  for (const auto &r : regions)
+    if (r.x1 <= region.x1 && r.y1 <= region.y1 && r.x2 >= region.x2 && r.y2 >= region.y2)
+      return true;
+  return false;
+}
+
+}
+
+TEST(TestDirtyRegionSolvers, ClockTick)
+{
+  CDirtyRegionList input = { clockLabel };
+  CDirtyRegionList output;
+
+  CPartialRedrawRegionSolver solver;
+  solver.Solve(input, output);
+
+  ASSERT_EQ(1u, output.size());
+  EXPECT_EQ(clockLabel.Area(), RedrawnPixels(output));
+}
+
+TEST(TestDirtyRegionSolvers, ClockAndFocusChange)
+{
+  CDirtyRegionList input = { clockLabel, oldMenuItem, dateLabel, newMenuItem, busySpinner };
+  CDirtyRegionList partial;
+  CDirtyRegionList unified;
+
+  CPartialRedrawRegionSolver solver;
+  solver.Solve(input, partial);
+  CUnionDirtyRegionSolver unionSolver;
+  unionSolver.Solve(input, unified);
+
+  // adjacent labels and menu items collapse, distant ones stay separate
+  EXPECT_EQ(3u, partial.size());
+  EXPECT_TRUE(Disjoint(partial));
+  for (const auto &region : input)
+    EXPECT_TRUE(Covers(partial, region));
+
+  float needed = clockLabel.Area() + dateLabel.Area() + oldMenuItem.Area() +
+                 newMenuItem.Area() + busySpinner.Area();
+  EXPECT_EQ(needed, RedrawnPixels(partial));
+  EXPECT_LT(RedrawnPixels(partial), RedrawnPixels(unified));
+}
+
+TEST(TestDirtyRegionSolvers, OverlappingRegionsAreMerged)
+{
+  CDirtyRegionList input = { CDirtyRegion(0, 0, 600, 100),
+                             CDirtyRegion(1000, 0, 1600, 100),
+                             CDirtyRegion(500, 50, 1100, 400) };
+  CDirtyRegionList output;
+
+  CPartialRedrawRegionSolver solver;
+  solver.Solve(input, output);
+
+  EXPECT_TRUE(Disjoint(output));
+  for (const auto &region : input)
+    EXPECT_TRUE(Covers(output, region));
+}
+
+TEST(TestDirtyRegionSolvers, PassLimit)
+{
+  CDirtyRegionList input;
+  for (int i = 0; i < 32; i++)
+  {
+    float x = (i % 8) * 240.0f;
+    float y = (i / 8) * 270.0f;
+    input.push_back(CDirtyRegion(x, y, x + 20, y + 20));
+  }
+  CDirtyRegionList output;
+
+  CPartialRedrawRegionSolver solver;
+  solver.Solve(input, output);
+
+  EXPECT_GE(8u, output.size());
+  EXPECT_TRUE(Disjoint(output));
+  for (const auto &region : input)
+    EXPECT_TRUE(Covers(output, region));
+}
+
+TEST(TestDirtyRegionSolvers, FullscreenFade)
+{
+  CDirtyRegionList input = { clockLabel, CDirtyRegion(0, 0, 1920, 1080), newMenuItem };
+  CDirtyRegionList output;
+
+  CPartialRedrawRegionSolver solver;
+  solver.Solve(input, output);
+
+  ASSERT_EQ(1u, output.size());
+  EXPECT_EQ(1920.0f * 1080.0f, RedrawnPixels(output));
+}
+
+TEST(TestDirtyRegionSolvers, EstuaryHomeClockTick)
+{
+  CDirtyRegionList input = { estuaryClock };
+  CDirtyRegionList output;
+
+  CPartialRedrawRegionSolver solver;
+  solver.Solve(input, output);
+
+  ASSERT_EQ(1u, output.size());
+  EXPECT_EQ(estuaryClock.Area(), RedrawnPixels(output));
+}
+
+TEST(TestDirtyRegionSolvers, EstuaryHomeWidgetFocusChange)
+{
+  // the previous poster zooms out while the next one zooms in, and the clock ticks
+  CDirtyRegionList input = { EstuaryPoster(0, true), EstuaryPoster(0, false),
+                             EstuaryPoster(1, false), EstuaryPoster(1, true),
+                             estuaryClock };
+  CDirtyRegionList partial;
+  CDirtyRegionList unified;
+
+  CPartialRedrawRegionSolver solver;
+  solver.Solve(input, partial);
+  CUnionDirtyRegionSolver unionSolver;
+  unionSolver.Solve(input, unified);
+
+  // the zoomed posters overlap and are drawn in one pass, the clock in another
+  EXPECT_EQ(2u, partial.size());
+  EXPECT_TRUE(Disjoint(partial));
+  for (const auto &region : input)
+    EXPECT_TRUE(Covers(partial, region));
+
+  CDirtyRegion posters = EstuaryPoster(0, true);
+  posters.Union(EstuaryPoster(1, true));
+  EXPECT_FLOAT_EQ(posters.Area() + estuaryClock.Area(), RedrawnPixels(partial));
+  EXPECT_LT(RedrawnPixels(partial), RedrawnPixels(unified) / 2);
+}
+
+TEST(TestDirtyRegionSolvers, EstuaryHomeMainMenuChange)
+{
+  // the main menu scrolls and the widgets of the new item slide in
+  CDirtyRegionList input = { estuaryMainMenu, estuaryWidgets, estuaryClock };
+  CDirtyRegionList output;
+
+  CPartialRedrawRegionSolver solver;
+  solver.Solve(input, output);
+
+  // the clock lies within the widget area, the strip below the main menu
+  // costs more than a second pass
+  EXPECT_EQ(2u, output.size());
+  EXPECT_TRUE(Disjoint(output));
+  for (const auto &region : input)
+    EXPECT_TRUE(Covers(output, region));
+  EXPECT_EQ(estuaryMainMenu.Area() + estuaryWidgets.Area(), RedrawnPixels(output));
+  EXPECT_LT(RedrawnPixels(output), 1920.0f * 1080.0f);
+}
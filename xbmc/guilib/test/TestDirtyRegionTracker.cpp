@@ -0,0 +1,102 @@
+/*
+ *      Copyright (C) 2017 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "guilib/DirtyRegionTracker.h"
+#include "settings/AdvancedSettings.h"
+
+#include "gtest/gtest.h"
+
+namespace
+{
+
+const CDirtyRegion previousFrame(0, 0, 100, 100);
+const CDirtyRegion currentFrame(1000, 500, 1100, 600);
+
+bool Covers(const CDirtyRegionList &regions, const CDirtyRegion &region)
+{
+  for (const auto &r : regions)
+    if (r.x1 <= region.x1 && r.y1 <= region.y1 && r.x2 >= region.x2 && r.y2 >= region.y2)
+      return true;
+  return false;
+}
+
+}
+
+class TestDirtyRegionTracker : public testing::Test
+{
+protected:
+  TestDirtyRegionTracker()
+  {
+    m_algorithm = g_advancedSettings.m_guiAlgorithmDirtyRegions;
+  }
+
+  ~TestDirtyRegionTracker() override
+  {
+    g_advancedSettings.m_guiAlgorithmDirtyRegions = m_algorithm;
+  }
+
+  // marks a region in the previous and in the current frame, then solves the
+  // current frame for a back buffer of the given age
+  CDirtyRegionList Solve(int algorithm, int bufferAge)
+  {
+    g_advancedSettings.m_guiAlgorithmDirtyRegions = algorithm;
+    CDirtyRegionTracker tracker;
+    tracker.SelectAlgorithm();
+
+    tracker.MarkDirtyRegion(previousFrame);
+    tracker.CleanMarkedRegions();
+    tracker.MarkDirtyRegion(currentFrame);
+
+    tracker.SetBufferAge(bufferAge);
+    return tracker.GetDirtyRegions();
+  }
+
+  int m_algorithm;
+};
+
+TEST_F(TestDirtyRegionTracker, PartialRedrawUsesBufferAge)
+{
+  CDirtyRegionList output = Solve(DIRTYREGION_SOLVER_PARTIAL_REDRAW, 1);
+  EXPECT_TRUE(Covers(output, currentFrame));
+  EXPECT_FALSE(Covers(output, previousFrame));
+
+  output = Solve(DIRTYREGION_SOLVER_PARTIAL_REDRAW, 2);
+  EXPECT_TRUE(Covers(output, currentFrame));
+  EXPECT_TRUE(Covers(output, previousFrame));
+}
+
+TEST_F(TestDirtyRegionTracker, PartialRedrawWithUnknownBufferAge)
+{
+  CDirtyRegionList output = Solve(DIRTYREGION_SOLVER_PARTIAL_REDRAW, -1);
+  EXPECT_TRUE(Covers(output, currentFrame));
+  EXPECT_TRUE(Covers(output, previousFrame));
+}
+
+TEST_F(TestDirtyRegionTracker, OtherSolversIgnoreBufferAge)
+{
+  // these solvers render into a preserved back buffer, so the regions of all
+  // buffered frames have to be redrawn whatever age is reported
+  for (int algorithm : { DIRTYREGION_SOLVER_UNION, DIRTYREGION_SOLVER_COST_REDUCTION })
+  {
+    CDirtyRegionList output = Solve(algorithm, 1);
+    EXPECT_TRUE(Covers(output, currentFrame));
+    EXPECT_TRUE(Covers(output, previousFrame));
+  }
+}
@@ -20,6 +20,7 @@
 
 #include <map>
 #include <string.h>
+#include <utility>
 
 #include "FileItemHandler.h"
 #include "AudioLibrary.h"
@@ -121,7 +122,7 @@ bool CFileItemHandler::GetField(const std::string &field, const CVariant &info,
           artObj[artIt->first] = CTextureUtils::GetWrappedImageURL(artIt->second);
       }
 
-      result["art"] = artObj;
+      result["art"] = std::move(artObj);
       return true;
     }
     
@@ -379,9 +380,9 @@ void CFileItemHandler::HandleFileItem(const char *ID, bool allowFile, const char
   if (resultname)
   {
     if (append)
-      result[resultname].append(object);
+      result[resultname].append(std::move(object));
     else
-      result[resultname] = object;
+      result[resultname] = std::move(object);
   }
 }
 
@@ -19,6 +19,9 @@
  *
  */
 
+#include <cstring>
+#include <string>
+
 #include "interfaces/IAnnouncer.h"
 #include "utils/JSONVariantWriter.h"
 #include "utils/Variant.h"
@@ -49,5 +52,50 @@ namespace JSONRPC
 
       return str;
     }
+
+    /*!
+     * @brief Identify the library item an announcement is about.
+     *
+     * Announcements about the same item must keep their order, but a client
+     * that hasn't received an update of an item yet only needs the latest one.
+     * Updates only replace each other if they carry the same data members, as
+     * e.g. an update of the playcount must not be replaced by one without it.
+     * @param key Set to the item, empty if the announcement isn't about a single library item.
+     * @param fields Set to the data members of a replaceable update.
+     * @return true if the announcement replaces an update of the same item with the same fields that wasn't sent yet.
+     */
+    static bool GetAnnouncementItem(ANNOUNCEMENT::AnnouncementFlag flag, const char *method, const CVariant &data, std::string &key, std::string &fields)
+    {
+      key.clear();
+      fields.clear();
+      if (flag != ANNOUNCEMENT::VideoLibrary && flag != ANNOUNCEMENT::AudioLibrary)
+        return false;
+
+      const CVariant &item = data.isMember("item") ? data["item"] : data;
+      if (!item.isMember("type") || !item.isMember("id"))
+        return false;
+
+      key = ANNOUNCEMENT::AnnouncementFlagToString(flag);
+      key += ":" + item["type"].asString() + ":" + item["id"].asString();
+
+      // an added item must be announced as such, only plain updates are replaced
+      if (strcmp(method, "OnUpdate") != 0 || data["added"].asBoolean())
+        return false;
+
+      for (CVariant::const_iterator_map field = data.begin_map(); field != data.end_map(); ++field)
+        fields += field->first + ",";
+
+      return true;
+    }
+
+    /*!
+     * @brief Check whether an announcement may be dropped for a client that doesn't keep up.
+     *
+     * A client that missed the removal of an item would keep showing it, so removals are always sent.
+     */
+    static bool IsAnnouncementDroppable(const char *method)
+    {
+      return strcmp(method, "OnRemove") != 0;
+    }
   };
 }
@@ -18,18 +18,28 @@
  *
  */
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
 #include <string.h>
+#include <utility>
 
 #include "JSONRPC.h"
 #include "ServiceDescription.h"
 #include "addons/Addon.h"
 #include "addons/IAddon.h"
+#include "dbwrappers/Database.h"
 #include "dbwrappers/DatabaseQuery.h"
 #include "input/ActionTranslator.h"
 #include "input/WindowTranslator.h"
 #include "interfaces/AnnouncementManager.h"
+#include "network/NetworkServices.h"
 #include "playlists/SmartPlayList.h"
 #include "settings/AdvancedSettings.h"
+#include "threads/Event.h"
+#include "threads/SingleLock.h"
+#include "utils/JobManager.h"
 #include "utils/log.h"
 #include "utils/StringUtils.h"
 #include "utils/Variant.h"
@@ -38,8 +48,64 @@
 using namespace ANNOUNCEMENT;
 using namespace JSONRPC;
 
+// number of threads executing the read-only calls of a batch, including the thread handling the request
+#define MAX_BATCH_THREADS   4
+// calls are counted by duration in buckets of <1 ms, <2 ms, <4 ms, ... and one for all longer calls
+#define LATENCY_BUCKETS     16
+
 bool CJSONRPC::m_initialized = false;
 
+namespace
+{
+  struct MethodStatistics
+  {
+    uint64_t calls = 0;
+    uint64_t totalTime = 0;   // in microseconds
+    uint64_t maximumTime = 0; // in microseconds
+    uint64_t histogram[LATENCY_BUCKETS] = { };
+  };
+
+  CCriticalSection statisticsSection;
+  std::map<std::string, MethodStatistics> methodStatistics;
+  uint64_t batches = 0;
+  uint64_t concurrentCalls = 0;
+
+  void AddMethodStatistics(const std::string &method, uint64_t duration)
+  {
+    unsigned int bucket = 0;
+    for (uint64_t limit = 1000; bucket < LATENCY_BUCKETS - 1 && duration >= limit; limit *= 2)
+      bucket++;
+
+    CSingleLock lock(statisticsSection);
+    MethodStatistics &statistics = methodStatistics[method];
+    statistics.calls++;
+    statistics.totalTime += duration;
+    statistics.maximumTime = std::max(statistics.maximumTime, duration);
+    statistics.histogram[bucket]++;
+  }
+
+  /*!
+   \brief State of the read-only calls of a batch which are executed concurrently.
+
+   Every thread takes the next call until all calls have been taken. The thread
+   handling the request takes part as well, so the batch completes even if no
+   job worker is available. Helper jobs which start after the last call has been
+   taken return without touching the requests or responses.
+   */
+  struct ConcurrentCalls
+  {
+    const CVariant *requests;
+    std::vector<CVariant> *responses;
+    std::vector<char> *hasResponses;
+    unsigned int end;
+    std::atomic<unsigned int> next;
+    std::atomic<unsigned int> remaining;
+    CEvent done;
+    // shared by all calls of the batch so that a database is only connected once per thread
+    std::shared_ptr<CDatabase::CConnectionPool> connectionPool;
+  };
+}
+
 void CJSONRPC::Initialize()
 {
   if (m_initialized)
@@ -234,9 +300,44 @@ JSONRPC_STATUS CJSONRPC::NotifyAll(const std::string &method, ITransportLayer *t
   return ACK;
 }
 
+JSONRPC_STATUS CJSONRPC::GetStatistics(const std::string &method, ITransportLayer *transport, IClient *client, const CVariant& parameterObject, CVariant &result)
+{
+  result = CVariant(CVariant::VariantTypeObject);
+  CNetworkServices::GetInstance().GetStatistics(result);
+
+  CVariant &statistics = result["jsonrpc"];
+  statistics["methods"] = CVariant(CVariant::VariantTypeObject);
+
+  CSingleLock lock(statisticsSection);
+  statistics["batches"] = batches;
+  statistics["concurrentcalls"] = concurrentCalls;
+  for (const auto& it : methodStatistics)
+  {
+    CVariant &methodObject = statistics["methods"][it.first];
+    methodObject["calls"] = it.second.calls;
+    methodObject["totaltime"] = it.second.totalTime;
+    methodObject["maximumtime"] = it.second.maximumTime;
+    methodObject["histogram"] = CVariant(CVariant::VariantTypeArray);
+    for (unsigned int bucket = 0; bucket < LATENCY_BUCKETS; bucket++)
+      methodObject["histogram"].push_back(it.second.histogram[bucket]);
+  }
+
+  return OK;
+}
+
 std::string CJSONRPC::MethodCall(const std::string &inputString, ITransportLayer *transport, IClient *client)
 {
-  CVariant inputroot, outputroot, result;
+  CVariant outputroot;
+  std::string str;
+  if (MethodCall(inputString, transport, client, outputroot))
+    CJSONVariantWriter::Write(outputroot, str, g_advancedSettings.m_jsonOutputCompact);
+
+  return str;
+}
+
+bool CJSONRPC::MethodCall(const std::string &inputString, ITransportLayer *transport, IClient *client, CVariant &outputroot)
+{
+  CVariant inputroot;
   bool hasResponse = false;
 
   CLog::Log(LOGDEBUG, LOGJSONRPC, "JSONRPC: Incoming request: %s", inputString.c_str());
@@ -253,15 +354,8 @@ std::string CJSONRPC::MethodCall(const std::string &inputString, ITransportLayer
       }
       else
       {
-        for (CVariant::const_iterator_array itr = inputroot.begin_array(); itr != inputroot.end_array(); itr++)
-        {
-          CVariant response;
-          if (HandleMethodCall(*itr, response, transport, client))
-          {
-            outputroot.append(response);
-            hasResponse = true;
-          }
-        }
+        HandleBatch(inputroot, outputroot, transport, client);
+        hasResponse = !outputroot.isNull();
       }
     }
     else
@@ -274,11 +368,94 @@ std::string CJSONRPC::MethodCall(const std::string &inputString, ITransportLayer
     hasResponse = true;
   }
 
-  std::string str;
-  if (hasResponse)
-    CJSONVariantWriter::Write(outputroot, str, g_advancedSettings.m_jsonOutputCompact);
+  return hasResponse;
+}
 
-  return str;
+void CJSONRPC::HandleBatch(const CVariant& requests, CVariant& responses, ITransportLayer *transport, IClient *client)
+{
+  const unsigned int size = requests.size();
+  std::vector<CVariant> batchResponses(size);
+  std::vector<char> hasResponses(size, 0);
+
+  // consecutive read-only calls are executed concurrently, every other call
+  // waits for all previous calls and is completed before the next one starts
+  unsigned int index = 0;
+  while (index < size)
+  {
+    unsigned int end = index;
+    while (end < size && IsConcurrentCall(requests[end]))
+      end++;
+
+    if (end - index > 1)
+    {
+      HandleConcurrentCalls(requests, index, end, batchResponses, hasResponses, transport, client);
+      index = end;
+    }
+    else
+    {
+      hasResponses[index] = HandleMethodCall(requests[index], batchResponses[index], transport, client);
+      index++;
+    }
+  }
+
+  // the responses are in the order of the requests
+  for (unsigned int i = 0; i < size; i++)
+  {
+    if (hasResponses[i])
+      responses.append(std::move(batchResponses[i]));
+  }
+
+  CSingleLock lock(statisticsSection);
+  batches++;
+}
+
+void CJSONRPC::HandleConcurrentCalls(const CVariant& requests, unsigned int begin, unsigned int end, std::vector<CVariant>& responses, std::vector<char>& hasResponses, ITransportLayer *transport, IClient *client)
+{
+  std::shared_ptr<ConcurrentCalls> calls = std::make_shared<ConcurrentCalls>();
+  calls->requests = &requests;
+  calls->responses = &responses;
+  calls->hasResponses = &hasResponses;
+  calls->end = end;
+  calls->next = begin;
+  calls->remaining = end - begin;
+  calls->connectionPool = std::make_shared<CDatabase::CConnectionPool>();
+
+  auto execute = [calls, transport, client]()
+  {
+    CDatabase::CScopedConnectionPool connectionPool(calls->connectionPool);
+
+    unsigned int index;
+    while ((index = calls->next++) < calls->end)
+    {
+      (*calls->hasResponses)[index] = HandleMethodCall((*calls->requests)[index], (*calls->responses)[index], transport, client);
+      if (--calls->remaining == 0)
+        calls->done.Set();
+    }
+  };
+
+  const unsigned int helpers = std::min(end - begin, static_cast<unsigned int>(MAX_BATCH_THREADS)) - 1;
+  for (unsigned int i = 0; i < helpers; i++)
+  {
+    // every job keeps its own copy, a helper may only start after this call returned
+    auto helper = execute;
+    CJobManager::GetInstance().Submit(std::move(helper), CJob::PRIORITY_NORMAL);
+  }
+
+  execute();
+  calls->done.Wait();
+
+  CSingleLock lock(statisticsSection);
+  concurrentCalls += end - begin;
+}
+
+bool CJSONRPC::IsConcurrentCall(const CVariant& request)
+{
+  if (!IsProperJSONRPC(request))
+    return false;
+
+  std::string methodName = request["method"].asString();
+  StringUtils::ToLower(methodName);
+  return CJSONServiceDescription::IsReadOnly(methodName.c_str());
 }
 
 bool CJSONRPC::HandleMethodCall(const CVariant& request, CVariant& response, ITransportLayer *transport, IClient *client)
@@ -298,7 +475,11 @@ bool CJSONRPC::HandleMethodCall(const CVariant& request, CVariant& response, ITr
     CVariant params;
 
     if ((errorCode = CJSONServiceDescription::CheckCall(methodName.c_str(), request["params"], transport, client, isNotification, method, params)) == OK)
+    {
+      auto start = std::chrono::steady_clock::now();
       errorCode = method(methodName, transport, client, params, result);
+      AddMethodStatistics(methodName, std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count());
+    }
     else
       result = params;
   }
@@ -311,7 +492,7 @@ bool CJSONRPC::HandleMethodCall(const CVariant& request, CVariant& response, ITr
     errorCode = InvalidRequest;
   }
 
-  BuildResponse(request, errorCode, result, response);
+  BuildResponse(request, errorCode, std::move(result), response);
 
   return !isNotification;
 }
@@ -321,7 +502,7 @@ inline bool CJSONRPC::IsProperJSONRPC(const CVariant& inputroot)
   return inputroot.isMember("jsonrpc") && inputroot["jsonrpc"].isString() && inputroot["jsonrpc"] == CVariant("2.0") && inputroot.isMember("method") && inputroot["method"].isString() && (!inputroot.isMember("params") || inputroot["params"].isArray() || inputroot["params"].isObject());
 }
 
-inline void CJSONRPC::BuildResponse(const CVariant& request, JSONRPC_STATUS code, const CVariant& result, CVariant& response)
+inline void CJSONRPC::BuildResponse(const CVariant& request, JSONRPC_STATUS code, CVariant&& result, CVariant& response)
 {
   response["jsonrpc"] = "2.0";
   response["id"] = request.isMember("id") ? request["id"] : CVariant();
@@ -329,7 +510,7 @@ inline void CJSONRPC::BuildResponse(const CVariant& request, JSONRPC_STATUS code
   switch (code)
   {
     case OK:
-      response["result"] = result;
+      response["result"] = std::move(result);
       break;
     case ACK:
       response["result"] = "OK";
@@ -342,7 +523,7 @@ inline void CJSONRPC::BuildResponse(const CVariant& request, JSONRPC_STATUS code
       response["error"]["code"] = InvalidParams;
       response["error"]["message"] = "Invalid params.";
       if (!result.isNull())
-        response["error"]["data"] = result;
+        response["error"]["data"] = std::move(result);
       break;
     case MethodNotFound:
       response["error"]["code"] = MethodNotFound;
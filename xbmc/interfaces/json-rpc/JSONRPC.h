@@ -23,6 +23,7 @@
 #include <map>
 #include <stdio.h>
 #include <string>
+#include <vector>
 
 #include "JSONRPCUtils.h"
 #include "JSONServiceDescription.h"
@@ -64,6 +65,20 @@ namespace JSONRPC
      */
     static std::string MethodCall(const std::string &inputString, ITransportLayer *transport, IClient *client);
 
+    /*!
+     \brief Handles the given JSON-RPC request like the other MethodCall()
+     but hands over the response without writing it as JSON
+     \param inputString received JSON-RPC request
+     \param transport Transport protocol on which the request arrived
+     \param client Client which sent the request
+     \param response JSON-RPC response to be sent back to the client
+     \return false if there is no response to send, e.g. for a notification
+
+     Lets the transport write a big response in chunks with
+     CJSONVariantChunkedWriter while sending it.
+     */
+    static bool MethodCall(const std::string &inputString, ITransportLayer *transport, IClient *client, CVariant &response);
+
     static JSONRPC_STATUS Introspect(const std::string &method, ITransportLayer *transport, IClient *client, const CVariant& parameterObject, CVariant &result);
     static JSONRPC_STATUS Version(const std::string &method, ITransportLayer *transport, IClient *client, const CVariant& parameterObject, CVariant &result);
     static JSONRPC_STATUS Permission(const std::string &method, ITransportLayer *transport, IClient *client, const CVariant& parameterObject, CVariant &result);
@@ -71,12 +86,16 @@ namespace JSONRPC
     static JSONRPC_STATUS GetConfiguration(const std::string &method, ITransportLayer *transport, IClient *client, const CVariant& parameterObject, CVariant &result);
     static JSONRPC_STATUS SetConfiguration(const std::string &method, ITransportLayer *transport, IClient *client, const CVariant& parameterObject, CVariant &result);
     static JSONRPC_STATUS NotifyAll(const std::string &method, ITransportLayer *transport, IClient *client, const CVariant& parameterObject, CVariant &result);
+    static JSONRPC_STATUS GetStatistics(const std::string &method, ITransportLayer *transport, IClient *client, const CVariant& parameterObject, CVariant &result);
   
   private:
+    static void HandleBatch(const CVariant& requests, CVariant& responses, ITransportLayer *transport, IClient *client);
+    static void HandleConcurrentCalls(const CVariant& requests, unsigned int begin, unsigned int end, std::vector<CVariant>& responses, std::vector<char>& hasResponses, ITransportLayer *transport, IClient *client);
     static bool HandleMethodCall(const CVariant& request, CVariant& response, ITransportLayer *transport, IClient *client);
+    static bool IsConcurrentCall(const CVariant& request);
     static inline bool IsProperJSONRPC(const CVariant& inputroot);
 
-    inline static void BuildResponse(const CVariant& request, JSONRPC_STATUS code, const CVariant& result, CVariant& response);
+    inline static void BuildResponse(const CVariant& request, JSONRPC_STATUS code, CVariant&& result, CVariant& response);
 
     static bool m_initialized;
   };
@@ -18,6 +18,8 @@
  *
  */
 
+#include <algorithm>
+
 #include "ServiceDescription.h"
 #include "JSONServiceDescription.h"
 #include "utils/log.h"
@@ -57,6 +59,7 @@ JsonRpcMethodMap CJSONServiceDescription::m_methodMaps[] = {
   { "JSONRPC.GetConfiguration",                     CJSONRPC::GetConfiguration },
   { "JSONRPC.SetConfiguration",                     CJSONRPC::SetConfiguration },
   { "JSONRPC.NotifyAll",                            CJSONRPC::NotifyAll },
+  { "JSONRPC.GetStatistics",                        CJSONRPC::GetStatistics },
 
 // Player
   { "Player.GetActivePlayers",                      CPlayerOperations::GetActivePlayers },
@@ -273,7 +276,9 @@ JSONSchemaTypeDefinition::JSONSchemaTypeDefinition()
     additionalItems(),
     properties(),
     hasAdditionalProperties(false),
-    additionalProperties(nullptr)
+    additionalProperties(nullptr),
+    compiled(false),
+    stringEnums()
 { }
 
 bool JSONSchemaTypeDefinition::Parse(const CVariant &value, bool isParameter /* = false */)
@@ -649,26 +654,75 @@ bool JSONSchemaTypeDefinition::Parse(const CVariant &value, bool isParameter /*
   return true;
 }
 
-JSONRPC_STATUS JSONSchemaTypeDefinition::Check(const CVariant &value, CVariant &outputValue, CVariant &errorData)
+void JSONSchemaTypeDefinition::Compile()
 {
-  if (!name.empty())
-    errorData["name"] = name;
-  SchemaValueTypeToJson(type, errorData["type"]);
-  std::string errorMessage;
+  if (compiled)
+    return;
 
+  // take over the referenced type once instead of on every check
   if (referencedType != NULL && !referencedTypeSet)
     Set(referencedType);
+  compiled = true;
+
+  for (std::vector<JSONSchemaTypeDefinitionPtr>::const_iterator it = extends.begin(); it != extends.end(); ++it)
+    (*it)->Compile();
+  for (std::vector<JSONSchemaTypeDefinitionPtr>::const_iterator it = unionTypes.begin(); it != unionTypes.end(); ++it)
+    (*it)->Compile();
+  for (std::vector<JSONSchemaTypeDefinitionPtr>::const_iterator it = items.begin(); it != items.end(); ++it)
+    (*it)->Compile();
+  for (std::vector<JSONSchemaTypeDefinitionPtr>::const_iterator it = additionalItems.begin(); it != additionalItems.end(); ++it)
+    (*it)->Compile();
+  for (CJsonSchemaPropertiesMap::JSONSchemaPropertiesIterator it = properties.begin(); it != properties.end(); ++it)
+    it->second->Compile();
+  if (additionalProperties != NULL)
+    additionalProperties->Compile();
+
+  // most enums are long lists of strings (e.g. the properties of a player)
+  // which would otherwise be compared one by one against every value
+  stringEnums.clear();
+  if (std::all_of(enums.begin(), enums.end(), [](const CVariant &value) { return value.isString(); }))
+  {
+    for (std::vector<CVariant>::const_iterator it = enums.begin(); it != enums.end(); ++it)
+      stringEnums.insert(it->asString());
+  }
+}
+
+JSONRPC_STATUS JSONSchemaTypeDefinition::Check(const CVariant &value, CVariant &outputValue, CVariant &errorData) const
+{
+  return check(value, outputValue, &errorData);
+}
+
+JSONRPC_STATUS JSONSchemaTypeDefinition::Check(const CVariant &value, CVariant &outputValue) const
+{
+  return check(value, outputValue, NULL);
+}
+
+JSONRPC_STATUS JSONSchemaTypeDefinition::check(const CVariant &value, CVariant &outputValue, CVariant *errorData) const
+{
+  // Without error data only the result of the check is of interest,
+  // so none of the error information is built and nothing is logged
+  if (errorData != NULL)
+  {
+    if (!name.empty())
+      (*errorData)["name"] = name;
+    SchemaValueTypeToJson(type, (*errorData)["type"]);
+  }
+  std::string errorMessage;
 
   // Let's check the type of the provided parameter
   if (!IsType(value, type))
   {
-    errorMessage = StringUtils::Format("Invalid type %s received", ValueTypeToString(value.type()));
-    errorData["message"] = errorMessage.c_str();
+    if (errorData != NULL)
+    {
+      errorMessage = StringUtils::Format("Invalid type %s received", ValueTypeToString(value.type()));
+      (*errorData)["message"] = errorMessage.c_str();
+    }
     return InvalidParams;
   }
   else if (value.isNull() && !HasType(type, NullValue))
   {
-    errorData["message"] = "Received value is null";
+    if (errorData != NULL)
+      (*errorData)["message"] = "Received value is null";
     return InvalidParams;
   }
 
@@ -678,19 +732,19 @@ JSONRPC_STATUS JSONSchemaTypeDefinition::Check(const CVariant &value, CVariant &
     bool ok = false;
     for (unsigned int unionIndex = 0; unionIndex < unionTypes.size(); unionIndex++)
     {
-      CVariant dummyError;
       CVariant testOutput = outputValue;
-      if (unionTypes.at(unionIndex)->Check(value, testOutput, dummyError) == OK)
+      if (unionTypes.at(unionIndex)->check(value, testOutput, NULL) == OK)
       {
         ok = true;
-        outputValue = testOutput;
+        outputValue = std::move(testOutput);
         break;
       }
     }
 
     if (!ok)
     {
-      errorData["message"] = "Received value does not match any of the union type definitions";
+      if (errorData != NULL)
+        (*errorData)["message"] = "Received value does not match any of the union type definitions";
       return InvalidParams;
     }
   }
@@ -702,13 +756,16 @@ JSONRPC_STATUS JSONSchemaTypeDefinition::Check(const CVariant &value, CVariant &
   {
     for (unsigned int extendsIndex = 0; extendsIndex < extends.size(); extendsIndex++)
     {
-      JSONRPC_STATUS status = extends.at(extendsIndex)->Check(value, outputValue, errorData);
+      JSONRPC_STATUS status = extends.at(extendsIndex)->check(value, outputValue, errorData);
 
       if (status != OK)
       {
-        CLog::Log(LOGDEBUG, "JSONRPC: Value does not match extended type %s of type %s", extends.at(extendsIndex)->ID.c_str(), name.c_str());
-        errorMessage = StringUtils::Format("value does not match extended type %s", extends.at(extendsIndex)->ID.c_str());
-        errorData["message"] = errorMessage.c_str();
+        if (errorData != NULL)
+        {
+          CLog::Log(LOGDEBUG, "JSONRPC: Value does not match extended type %s of type %s", extends.at(extendsIndex)->ID.c_str(), name.c_str());
+          errorMessage = StringUtils::Format("value does not match extended type %s", extends.at(extendsIndex)->ID.c_str());
+          (*errorData)["message"] = errorMessage.c_str();
+        }
         return status;
       }
     }
@@ -723,14 +780,17 @@ JSONRPC_STATUS JSONSchemaTypeDefinition::Check(const CVariant &value, CVariant &
     // Check the number of items against minItems and maxItems
     if ((minItems > 0 && value.size() < minItems) || (maxItems > 0 && value.size() > maxItems))
     {
-      CLog::Log(LOGDEBUG, "JSONRPC: Number of array elements does not match minItems and/or maxItems in type %s", name.c_str());
-      if (minItems > 0 && maxItems > 0)
-        errorMessage = StringUtils::Format("Between %d and %d array items expected but %d received", minItems, maxItems, value.size());
-      else if (minItems > 0)
-        errorMessage = StringUtils::Format("At least %d array items expected but only %d received", minItems, value.size());
-      else
-        errorMessage = StringUtils::Format("Only %d array items expected but %d received", maxItems, value.size());
-      errorData["message"] = errorMessage.c_str();
+      if (errorData != NULL)
+      {
+        CLog::Log(LOGDEBUG, "JSONRPC: Number of array elements does not match minItems and/or maxItems in type %s", name.c_str());
+        if (minItems > 0 && maxItems > 0)
+          errorMessage = StringUtils::Format("Between %d and %d array items expected but %d received", minItems, maxItems, value.size());
+        else if (minItems > 0)
+          errorMessage = StringUtils::Format("At least %d array items expected but only %d received", minItems, value.size());
+        else
+          errorMessage = StringUtils::Format("Only %d array items expected but %d received", maxItems, value.size());
+        (*errorData)["message"] = errorMessage.c_str();
+      }
       return InvalidParams;
     }
 
@@ -738,19 +798,22 @@ JSONRPC_STATUS JSONSchemaTypeDefinition::Check(const CVariant &value, CVariant &
       outputValue = value;
     else if (items.size() == 1)
     {
-      JSONSchemaTypeDefinitionPtr itemType = items.at(0);
+      const JSONSchemaTypeDefinitionPtr &itemType = items.at(0);
 
       // Loop through all array elements
       for (unsigned int arrayIndex = 0; arrayIndex < value.size(); arrayIndex++)
       {
         CVariant temp;
-        JSONRPC_STATUS status = itemType->Check(value[arrayIndex], temp, errorData["property"]);
-        outputValue.push_back(temp);
+        JSONRPC_STATUS status = itemType->check(value[arrayIndex], temp, errorData != NULL ? &(*errorData)["property"] : NULL);
+        outputValue.push_back(std::move(temp));
         if (status != OK)
         {
-          CLog::Log(LOGDEBUG, "JSONRPC: Array element at index %u does not match in type %s", arrayIndex, name.c_str());
-          errorMessage = StringUtils::Format("array element at index %u does not match", arrayIndex);
-          errorData["message"] = errorMessage.c_str();
+          if (errorData != NULL)
+          {
+            CLog::Log(LOGDEBUG, "JSONRPC: Array element at index %u does not match in type %s", arrayIndex, name.c_str());
+            errorMessage = StringUtils::Format("array element at index %u does not match", arrayIndex);
+            (*errorData)["message"] = errorMessage.c_str();
+          }
           return status;
         }
       }
@@ -768,9 +831,12 @@ JSONRPC_STATUS JSONSchemaTypeDefinition::Check(const CVariant &value, CVariant &
       // allowed there is no need to check every element
       if (value.size() < items.size() || (value.size() != items.size() && additionalItems.size() == 0))
       {
-        CLog::Log(LOGDEBUG, "JSONRPC: One of the array elements does not match in type %s", name.c_str());
-        errorMessage = StringUtils::Format("{0} array elements expected but {1} received", items.size(), value.size());
-        errorData["message"] = errorMessage.c_str();
+        if (errorData != NULL)
+        {
+          CLog::Log(LOGDEBUG, "JSONRPC: One of the array elements does not match in type %s", name.c_str());
+          errorMessage = StringUtils::Format("{0} array elements expected but {1} received", items.size(), value.size());
+          (*errorData)["message"] = errorMessage.c_str();
+        }
         return InvalidParams;
       }
 
@@ -780,10 +846,11 @@ JSONRPC_STATUS JSONSchemaTypeDefinition::Check(const CVariant &value, CVariant &
       unsigned int arrayIndex;
       for (arrayIndex = 0; arrayIndex < std::min(items.size(), (size_t)value.size()); arrayIndex++)
       {
-        JSONRPC_STATUS status = items.at(arrayIndex)->Check(value[arrayIndex], outputValue[arrayIndex], errorData["property"]);
+        JSONRPC_STATUS status = items.at(arrayIndex)->check(value[arrayIndex], outputValue[arrayIndex], errorData != NULL ? &(*errorData)["property"] : NULL);
         if (status != OK)
         {
-          CLog::Log(LOGDEBUG, "JSONRPC: Array element at index %u does not match with items schema in type %s", arrayIndex, name.c_str());
+          if (errorData != NULL)
+            CLog::Log(LOGDEBUG, "JSONRPC: Array element at index %u does not match with items schema in type %s", arrayIndex, name.c_str());
           return status;
         }
       }
@@ -798,8 +865,7 @@ JSONRPC_STATUS JSONSchemaTypeDefinition::Check(const CVariant &value, CVariant &
           bool ok = false;
           for (unsigned int additionalIndex = 0; additionalIndex < additionalItems.size(); additionalIndex++)
           {
-            CVariant dummyError;
-            if (additionalItems.at(additionalIndex)->Check(value[arrayIndex], outputValue[arrayIndex], dummyError) == OK)
+            if (additionalItems.at(additionalIndex)->check(value[arrayIndex], outputValue[arrayIndex], NULL) == OK)
             {
               ok = true;
               break;
@@ -808,9 +874,12 @@ JSONRPC_STATUS JSONSchemaTypeDefinition::Check(const CVariant &value, CVariant &
 
           if (!ok)
           {
-            CLog::Log(LOGDEBUG, "JSONRPC: Array contains non-conforming additional items in type %s", name.c_str());
-            errorMessage = StringUtils::Format("Array element at index %u does not match the \"additionalItems\" schema", arrayIndex);
-            errorData["message"] = errorMessage.c_str();
+            if (errorData != NULL)
+            {
+              CLog::Log(LOGDEBUG, "JSONRPC: Array contains non-conforming additional items in type %s", name.c_str());
+              errorMessage = StringUtils::Format("Array element at index %u does not match the \"additionalItems\" schema", arrayIndex);
+              (*errorData)["message"] = errorMessage.c_str();
+            }
             return InvalidParams;
           }
         }
@@ -827,9 +896,12 @@ JSONRPC_STATUS JSONSchemaTypeDefinition::Check(const CVariant &value, CVariant &
           // If two elements are the same they are not unique
           if (outputValue[checkingIndex] == outputValue[checkedIndex])
           {
-            CLog::Log(LOGDEBUG, "JSONRPC: Not unique array element at index %u and %u in type %s", checkingIndex, checkedIndex, name.c_str());
-            errorMessage = StringUtils::Format("Array element at index %u is not unique (same as array element at index %u)", checkingIndex, checkedIndex);
-            errorData["message"] = errorMessage.c_str();
+            if (errorData != NULL)
+            {
+              CLog::Log(LOGDEBUG, "JSONRPC: Not unique array element at index %u and %u in type %s", checkingIndex, checkedIndex, name.c_str());
+              errorMessage = StringUtils::Format("Array element at index %u is not unique (same as array element at index %u)", checkingIndex, checkedIndex);
+              (*errorData)["message"] = errorMessage.c_str();
+            }
             return InvalidParams;
           }
         }
@@ -850,10 +922,12 @@ JSONRPC_STATUS JSONSchemaTypeDefinition::Check(const CVariant &value, CVariant &
     {
       if (value.isMember(propertiesIterator->second->name))
       {
-        JSONRPC_STATUS status = propertiesIterator->second->Check(value[propertiesIterator->second->name], outputValue[propertiesIterator->second->name], errorData["property"]);
+        JSONRPC_STATUS status = propertiesIterator->second->check(value[propertiesIterator->second->name], outputValue[propertiesIterator->second->name],
+                                                                  errorData != NULL ? &(*errorData)["property"] : NULL);
         if (status != OK)
         {
-          CLog::Log(LOGDEBUG, "JSONRPC: Invalid property \"%s\" in type %s", propertiesIterator->second->name.c_str(), name.c_str());
+          if (errorData != NULL)
+            CLog::Log(LOGDEBUG, "JSONRPC: Invalid property \"%s\" in type %s", propertiesIterator->second->name.c_str(), name.c_str());
           return status;
         }
         handled++;
@@ -862,9 +936,12 @@ JSONRPC_STATUS JSONSchemaTypeDefinition::Check(const CVariant &value, CVariant &
         outputValue[propertiesIterator->second->name] = propertiesIterator->second->defaultValue;
       else
       {
-        errorData["property"]["name"] = propertiesIterator->second->name.c_str();
-        errorData["property"]["type"] = SchemaValueTypeToString(propertiesIterator->second->type);
-        errorData["message"] = "Missing property";
+        if (errorData != NULL)
+        {
+          (*errorData)["property"]["name"] = propertiesIterator->second->name.c_str();
+          (*errorData)["property"]["type"] = SchemaValueTypeToString(propertiesIterator->second->type);
+          (*errorData)["message"] = "Missing property";
+        }
         return InvalidParams;
       }
     }
@@ -888,14 +965,15 @@ JSONRPC_STATUS JSONSchemaTypeDefinition::Check(const CVariant &value, CVariant &
           // object
           if (additionalProperties->type == AnyValue)
           {
-            outputValue[iter->first] = value[iter->first];
+            outputValue[iter->first] = iter->second;
             continue;
           }
 
-          JSONRPC_STATUS status = additionalProperties->Check(value[iter->first], outputValue[iter->first], errorData["property"]);
+          JSONRPC_STATUS status = additionalProperties->check(iter->second, outputValue[iter->first], errorData != NULL ? &(*errorData)["property"] : NULL);
           if (status != OK)
           {
-            CLog::Log(LOGDEBUG, "JSONRPC: Invalid additional property \"%s\" in type %s", iter->first.c_str(), name.c_str());
+            if (errorData != NULL)
+              CLog::Log(LOGDEBUG, "JSONRPC: Invalid additional property \"%s\" in type %s", iter->first.c_str(), name.c_str());
             return status;
           }
         }
@@ -904,8 +982,11 @@ JSONRPC_STATUS JSONSchemaTypeDefinition::Check(const CVariant &value, CVariant &
       // properties are not allowed, we have invalid parameters
       else if (!hasAdditionalProperties || additionalProperties == NULL)
       {
-        errorData["message"] = "Unexpected additional properties received";
-        errorData.erase("property");
+        if (errorData != NULL)
+        {
+          (*errorData)["message"] = "Unexpected additional properties received";
+          errorData->erase("property");
+        }
         return InvalidParams;
       }
     }
@@ -920,19 +1001,27 @@ JSONRPC_STATUS JSONSchemaTypeDefinition::Check(const CVariant &value, CVariant &
   if (enums.size() > 0)
   {
     bool valid = false;
-    for (std::vector<CVariant>::const_iterator enumItr = enums.begin(); enumItr != enums.end(); ++enumItr)
+    if (!stringEnums.empty())
+      valid = value.isString() && stringEnums.find(value.asString()) != stringEnums.end();
+    else
     {
-      if (*enumItr == value)
+      for (std::vector<CVariant>::const_iterator enumItr = enums.begin(); enumItr != enums.end(); ++enumItr)
       {
-        valid = true;
-        break;
+        if (*enumItr == value)
+        {
+          valid = true;
+          break;
+        }
       }
     }
 
     if (!valid)
     {
-      CLog::Log(LOGDEBUG, "JSONRPC: Value does not match any of the enum values in type %s", name.c_str());
-      errorData["message"] = "Received value does not match any of the defined enum values";
+      if (errorData != NULL)
+      {
+        CLog::Log(LOGDEBUG, "JSONRPC: Value does not match any of the enum values in type %s", name.c_str());
+        (*errorData)["message"] = "Received value does not match any of the defined enum values";
+      }
       return InvalidParams;
     }
   }
@@ -951,22 +1040,28 @@ JSONRPC_STATUS JSONSchemaTypeDefinition::Check(const CVariant &value, CVariant &
     // Check maximum
         (exclusiveMaximum && numberValue >= maximum) || (!exclusiveMaximum && numberValue > maximum))        
     {
-      CLog::Log(LOGDEBUG, "JSONRPC: Value does not lay between minimum and maximum in type %s", name.c_str());
-      if (value.isDouble())
-        errorMessage = StringUtils::Format("Value between %f (%s) and %f (%s) expected but %f received", 
-          minimum, exclusiveMinimum ? "exclusive" : "inclusive", maximum, exclusiveMaximum ? "exclusive" : "inclusive", numberValue);
-      else
-        errorMessage = StringUtils::Format("Value between %d (%s) and %d (%s) expected but %d received", 
-          (int)minimum, exclusiveMinimum ? "exclusive" : "inclusive", (int)maximum, exclusiveMaximum ? "exclusive" : "inclusive", (int)numberValue);
-      errorData["message"] = errorMessage.c_str();
+      if (errorData != NULL)
+      {
+        CLog::Log(LOGDEBUG, "JSONRPC: Value does not lay between minimum and maximum in type %s", name.c_str());
+        if (value.isDouble())
+          errorMessage = StringUtils::Format("Value between %f (%s) and %f (%s) expected but %f received", 
+            minimum, exclusiveMinimum ? "exclusive" : "inclusive", maximum, exclusiveMaximum ? "exclusive" : "inclusive", numberValue);
+        else
+          errorMessage = StringUtils::Format("Value between %d (%s) and %d (%s) expected but %d received", 
+            (int)minimum, exclusiveMinimum ? "exclusive" : "inclusive", (int)maximum, exclusiveMaximum ? "exclusive" : "inclusive", (int)numberValue);
+        (*errorData)["message"] = errorMessage.c_str();
+      }
       return InvalidParams;
     }
     // Check divisibleBy
     if ((HasType(type, IntegerValue) && divisibleBy > 0 && ((int)numberValue % divisibleBy) != 0))
     {
-      CLog::Log(LOGDEBUG, "JSONRPC: Value does not meet divisibleBy requirements in type %s", name.c_str());
-      errorMessage = StringUtils::Format("Value should be divisible by %d but %d received", divisibleBy, (int)numberValue);
-      errorData["message"] = errorMessage.c_str();
+      if (errorData != NULL)
+      {
+        CLog::Log(LOGDEBUG, "JSONRPC: Value does not meet divisibleBy requirements in type %s", name.c_str());
+        errorMessage = StringUtils::Format("Value should be divisible by %d but %d received", divisibleBy, (int)numberValue);
+        (*errorData)["message"] = errorMessage.c_str();
+      }
       return InvalidParams;
     }
   }
@@ -974,20 +1069,26 @@ JSONRPC_STATUS JSONSchemaTypeDefinition::Check(const CVariant &value, CVariant &
   // If we have a string, we need to check the length
   if (HasType(type, StringValue) && value.isString())
   {
-    int size = value.asString().size();
+    int size = value.size();
     if (size < minLength)
     {
-      CLog::Log(LOGDEBUG, "JSONRPC: Value does not meet minLength requirements in type %s", name.c_str());
-      errorMessage = StringUtils::Format("Value should have a minimum length of %d but has a length of %d", minLength, size);
-      errorData["message"] = errorMessage.c_str();
+      if (errorData != NULL)
+      {
+        CLog::Log(LOGDEBUG, "JSONRPC: Value does not meet minLength requirements in type %s", name.c_str());
+        errorMessage = StringUtils::Format("Value should have a minimum length of %d but has a length of %d", minLength, size);
+        (*errorData)["message"] = errorMessage.c_str();
+      }
       return InvalidParams;
     }
 
     if (maxLength >= 0 && size > maxLength)
     {
-      CLog::Log(LOGDEBUG, "JSONRPC: Value does not meet maxLength requirements in type %s", name.c_str());
-      errorMessage = StringUtils::Format("Value should have a maximum length of %d but has a length of %d", maxLength, size);
-      errorData["message"] = errorMessage.c_str();
+      if (errorData != NULL)
+      {
+        CLog::Log(LOGDEBUG, "JSONRPC: Value does not meet maxLength requirements in type %s", name.c_str());
+        errorMessage = StringUtils::Format("Value should have a maximum length of %d but has a length of %d", maxLength, size);
+        (*errorData)["message"] = errorMessage.c_str();
+      }
       return InvalidParams;
     }
   }
@@ -1228,7 +1329,9 @@ JsonRpcMethod::JsonRpcMethod()
     permission(ReadData),
     description(),
     parameters(),
-    returns(new JSONSchemaTypeDefinition())
+    returns(new JSONSchemaTypeDefinition()),
+    optionalParameters(false),
+    defaultParameters()
 { }
 
 bool JsonRpcMethod::Parse(const CVariant &value)
@@ -1299,6 +1402,19 @@ bool JsonRpcMethod::Parse(const CVariant &value)
   return true;
 }
 
+void JsonRpcMethod::Compile()
+{
+  optionalParameters = true;
+  defaultParameters = CVariant();
+  for (std::vector<JSONSchemaTypeDefinitionPtr>::const_iterator it = parameters.begin(); it != parameters.end(); ++it)
+  {
+    (*it)->Compile();
+
+    optionalParameters &= (*it)->optional;
+    defaultParameters[(*it)->name] = (*it)->defaultValue;
+  }
+}
+
 JSONRPC_STATUS JsonRpcMethod::Check(const CVariant &requestParameters, ITransportLayer *transport, IClient *client, bool notification, MethodCall &methodCall, CVariant &outputParameters) const
 {
   if (transport != NULL && (transport->GetCapabilities() & transportneed) == transportneed)
@@ -1307,34 +1423,30 @@ JSONRPC_STATUS JsonRpcMethod::Check(const CVariant &requestParameters, ITranspor
     {
       methodCall = method;
 
-      // Count the number of actually handled (present)
-      // parameters
-      unsigned int handled = 0;
-      CVariant errorData = CVariant(CVariant::VariantTypeObject);
-      errorData["method"] = name;
-
-      // Loop through all the parameters to check
-      for (unsigned int i = 0; i < parameters.size(); i++)
+      // Methods with only optional parameters (like many of the polled
+      // getters) are usually called without any parameters at all
+      if (optionalParameters && requestParameters.size() == 0)
       {
-        // Evaluate the current parameter
-        JSONRPC_STATUS status = checkParameter(requestParameters, parameters.at(i), i, outputParameters, handled, errorData);
-        if (status != OK)
-        {
-          // Return the error data object in the outputParameters reference
-          outputParameters = errorData;
-          return status;
-        }
+        outputParameters = defaultParameters;
+        return OK;
       }
 
-      // Check if there were unnecessary parameters
-      if (handled < requestParameters.size())
+      // Valid parameters are checked without collecting any error data,
+      // invalid ones are checked again to tell the client what is wrong
+      JSONRPC_STATUS status = checkParameters(requestParameters, outputParameters, NULL);
+      if (status != OK)
       {
-        errorData["message"] = "Too many parameters";
-        outputParameters = errorData;
-        return InvalidParams;
+        CVariant errorData = CVariant(CVariant::VariantTypeObject);
+        errorData["method"] = name;
+
+        CVariant parameters;
+        checkParameters(requestParameters, parameters, &errorData);
+
+        // Return the error data object in the outputParameters reference
+        outputParameters = std::move(errorData);
       }
 
-      return OK;
+      return status;
     }
     else
       return BadPermission;
@@ -1343,6 +1455,32 @@ JSONRPC_STATUS JsonRpcMethod::Check(const CVariant &requestParameters, ITranspor
   return MethodNotFound;
 }
 
+JSONRPC_STATUS JsonRpcMethod::checkParameters(const CVariant &requestParameters, CVariant &outputParameters, CVariant *errorData) const
+{
+  // Count the number of actually handled (present)
+  // parameters
+  unsigned int handled = 0;
+
+  // Loop through all the parameters to check
+  for (unsigned int i = 0; i < parameters.size(); i++)
+  {
+    // Evaluate the current parameter
+    JSONRPC_STATUS status = checkParameter(requestParameters, parameters.at(i), i, outputParameters, handled, errorData);
+    if (status != OK)
+      return status;
+  }
+
+  // Check if there were unnecessary parameters
+  if (handled < requestParameters.size())
+  {
+    if (errorData != NULL)
+      (*errorData)["message"] = "Too many parameters";
+    return InvalidParams;
+  }
+
+  return OK;
+}
+
 bool JsonRpcMethod::parseParameter(const CVariant &value, JSONSchemaTypeDefinitionPtr parameter)
 {
   parameter->name = GetString(value["name"], "");
@@ -1374,16 +1512,17 @@ bool JsonRpcMethod::parseReturn(const CVariant &value)
   return true;
 }
 
-JSONRPC_STATUS JsonRpcMethod::checkParameter(const CVariant &requestParameters, JSONSchemaTypeDefinitionPtr type, unsigned int position, CVariant &outputParameters, unsigned int &handled, CVariant &errorData)
+JSONRPC_STATUS JsonRpcMethod::checkParameter(const CVariant &requestParameters, const JSONSchemaTypeDefinitionPtr &type, unsigned int position, CVariant &outputParameters, unsigned int &handled, CVariant *errorData)
 {
   // Let's check if the parameter has been provided
   if (ParameterExists(requestParameters, type->name, position))
   {
     // Get the parameter
-    CVariant parameterValue = GetParameter(requestParameters, type->name, position);
+    const CVariant &parameterValue = requestParameters.isMember(type->name) ? requestParameters[type->name] : requestParameters[position];
 
     // Evaluate the type of the parameter
-    JSONRPC_STATUS status = type->Check(parameterValue, outputParameters[type->name], errorData["stack"]);
+    JSONRPC_STATUS status = errorData != NULL ? type->Check(parameterValue, outputParameters[type->name], (*errorData)["stack"]) :
+                                                type->Check(parameterValue, outputParameters[type->name]);
     if (status != OK)
       return status;
 
@@ -1397,9 +1536,12 @@ JSONRPC_STATUS JsonRpcMethod::checkParameter(const CVariant &requestParameters,
   // The parameter is required but has not been provided => invalid
   else
   {
-    errorData["stack"]["name"] = type->name;
-    SchemaValueTypeToJson(type->type, errorData["stack"]["type"]);
-    errorData["stack"]["message"] = "Missing parameter";
+    if (errorData != NULL)
+    {
+      (*errorData)["stack"]["name"] = type->name;
+      SchemaValueTypeToJson(type->type, (*errorData)["stack"]["type"]);
+      (*errorData)["stack"]["message"] = "Missing parameter";
+    }
     return InvalidParams;
   }
 
@@ -1518,6 +1660,8 @@ bool CJSONServiceDescription::addMethod(const std::string &jsonMethod, MethodCal
     return false;
   }
 
+  // resolve the schema once so that calls are only checked against it
+  newMethod.Compile();
   m_actionMap.add(newMethod);
 
   return true;
@@ -1895,6 +2039,12 @@ JSONRPC_STATUS CJSONServiceDescription::CheckCall(const char* const method, cons
   return MethodNotFound;
 }
 
+bool CJSONServiceDescription::IsReadOnly(const char* const method)
+{
+  CJsonRpcMethodMap::JsonRpcMethodIterator iter = m_actionMap.find(method);
+  return iter != m_actionMap.end() && iter->second.permission == ReadData;
+}
+
 JSONSchemaTypeDefinitionPtr CJSONServiceDescription::GetType(const std::string &identification)
 {
   std::map<std::string, JSONSchemaTypeDefinitionPtr>::iterator iter = m_types.find(identification);
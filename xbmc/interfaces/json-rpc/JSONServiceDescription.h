@@ -20,6 +20,7 @@
  */
 
 #include <string>
+#include <unordered_set>
 #include <vector>
 #include <limits>
 #include <memory>
@@ -48,7 +49,21 @@ namespace JSONRPC
     JSONSchemaTypeDefinition();
     
     bool Parse(const CVariant &value, bool isParameter = false);
-    JSONRPC_STATUS Check(const CVariant &value, CVariant &outputValue, CVariant &errorData);
+    /*!
+     \brief Resolves the referenced types and prepares the
+     lookup tables of the type and all its nested types
+
+     Has to be called once before the type is used to check
+     values. Afterwards the type isn't modified by checks, so
+     it can be used by several threads at once.
+     */
+    void Compile();
+    JSONRPC_STATUS Check(const CVariant &value, CVariant &outputValue, CVariant &errorData) const;
+    /*!
+     \brief Checks the given value without providing any
+     information on why the value is invalid
+     */
+    JSONRPC_STATUS Check(const CVariant &value, CVariant &outputValue) const;
     void Print(bool isParameter, bool isGlobal, bool printDefault, bool printDescriptions, CVariant &output) const;
     void Set(const JSONSchemaTypeDefinitionPtr typeDefinition);
     
@@ -222,6 +237,20 @@ namespace JSONRPC
      \brief Type definition for additional properties
      */
     JSONSchemaTypeDefinitionPtr additionalProperties;
+
+    /*!
+     \brief Whether the type has been compiled
+     */
+    bool compiled;
+
+    /*!
+     \brief Hash set of the allowed values if all
+     of them are strings (see Compile())
+     */
+    std::unordered_set<std::string> stringEnums;
+
+  private:
+    JSONRPC_STATUS check(const CVariant &value, CVariant &outputValue, CVariant *errorData) const;
   };
 
   /*! 
@@ -239,6 +268,11 @@ namespace JSONRPC
     JsonRpcMethod();
   
     bool Parse(const CVariant &value);
+    /*!
+     \brief Compiles the types of all parameters, see
+     JSONSchemaTypeDefinition::Compile()
+     */
+    void Compile();
     JSONRPC_STATUS Check(const CVariant &requestParameters, ITransportLayer *transport, IClient *client, bool notification, MethodCall &methodCall, CVariant &outputParameters) const;
     
     std::string missingReference;    
@@ -274,11 +308,21 @@ namespace JSONRPC
      \brief Definition of the return value
      */
     JSONSchemaTypeDefinitionPtr returns;
+    /*!
+     \brief Whether all parameters are optional
+     */
+    bool optionalParameters;
+    /*!
+     \brief Parameters passed to the method if
+     the request doesn't contain any parameters
+     */
+    CVariant defaultParameters;
   
   private:
     bool parseParameter(const CVariant &value, JSONSchemaTypeDefinitionPtr parameter);
     bool parseReturn(const CVariant &value);
-    static JSONRPC_STATUS checkParameter(const CVariant &requestParameters, JSONSchemaTypeDefinitionPtr type, unsigned int position, CVariant &outputParameters, unsigned int &handled, CVariant &errorData);
+    JSONRPC_STATUS checkParameters(const CVariant &requestParameters, CVariant &outputParameters, CVariant *errorData) const;
+    static JSONRPC_STATUS checkParameter(const CVariant &requestParameters, const JSONSchemaTypeDefinitionPtr &type, unsigned int position, CVariant &outputParameters, unsigned int &handled, CVariant *errorData);
   };
 
   /*! 
@@ -390,6 +434,15 @@ namespace JSONRPC
      given parameters from the request against the json schema description for the given method.
      */
     static JSONRPC_STATUS CheckCall(const char* method, const CVariant &requestParameters, ITransportLayer *transport, IClient *client, bool notification, MethodCall &methodCall, CVariant &outputParameters);
+
+    /*!
+     \brief Whether the given method only needs the ReadData permission
+     \param method Called method
+     \return True if the method exists and only reads data, false otherwise
+
+     Read-only methods don't change any state and may be executed concurrently.
+     */
+    static bool IsReadOnly(const char* method);
     
     static JSONSchemaTypeDefinitionPtr GetType(const std::string &identification);
 
@@ -0,0 +1,167 @@
+/*
+ *      Copyright (C) 2017 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include "interfaces/json-rpc/JSONRPC.h"
+#include "interfaces/json-rpc/JSONServiceDescription.h"
+#include "utils/JSONVariantParser.h"
+#include "utils/Variant.h"
+
+using namespace JSONRPC;
+
+namespace
+{
+  class CTestClient : public IClient
+  {
+  public:
+    int GetPermissionFlags() override { return OPERATION_PERMISSION_ALL; }
+    int GetAnnouncementFlags() override { return 0; }
+    bool SetAnnouncementFlags(int flags) override { return true; }
+  };
+
+  class CTestTransport : public ITransportLayer
+  {
+  public:
+    bool PrepareDownload(const char *path, CVariant &details, std::string &protocol) override { return false; }
+    bool Download(const char *path, CVariant &result) override { return false; }
+    int GetCapabilities() override { return Response; }
+  };
+
+  const char *TEST_METHOD_READ =
+    "\"Test.Read\": {"
+      "\"type\": \"method\","
+      "\"transport\": \"Response\","
+      "\"permission\": \"ReadData\","
+      "\"params\": [ { \"name\": \"value\", \"type\": \"integer\", \"required\": true } ],"
+      "\"returns\": \"integer\""
+    "}";
+
+  const char *TEST_METHOD_WRITE =
+    "\"Test.Write\": {"
+      "\"type\": \"method\","
+      "\"transport\": \"Response\","
+      "\"permission\": \"UpdateData\","
+      "\"params\": [ { \"name\": \"value\", \"type\": \"integer\", \"required\": true } ],"
+      "\"returns\": \"integer\""
+    "}";
+
+  std::mutex s_mutex;
+  std::condition_variable s_condition;
+  int s_activeReads = 0;
+  int s_maxActiveReads = 0;
+  bool s_writeOverlapped = false;
+
+  // waits for another read to run alongside, so that a batch only completes
+  // quickly if its read-only calls really are executed concurrently
+  JSONRPC_STATUS Read(const std::string &method, ITransportLayer *transport, IClient *client, const CVariant &parameterObject, CVariant &result)
+  {
+    std::unique_lock<std::mutex> lock(s_mutex);
+    s_activeReads++;
+    s_maxActiveReads = std::max(s_maxActiveReads, s_activeReads);
+    s_condition.notify_all();
+    s_condition.wait_for(lock, std::chrono::seconds(5), []() { return s_maxActiveReads > 1; });
+    s_activeReads--;
+
+    result = parameterObject["value"];
+    return OK;
+  }
+
+  // returns the highest number of concurrent reads since the previous write
+  JSONRPC_STATUS Write(const std::string &method, ITransportLayer *transport, IClient *client, const CVariant &parameterObject, CVariant &result)
+  {
+    std::unique_lock<std::mutex> lock(s_mutex);
+    if (s_activeReads > 0)
+      s_writeOverlapped = true;
+
+    result = s_maxActiveReads;
+    s_maxActiveReads = 0;
+    return OK;
+  }
+}
+
+class TestJSONRPC : public testing::Test
+{
+protected:
+  static void SetUpTestCase()
+  {
+    CJSONRPC::Initialize();
+    CJSONServiceDescription::AddMethod(TEST_METHOD_READ, Read);
+    CJSONServiceDescription::AddMethod(TEST_METHOD_WRITE, Write);
+  }
+
+  static void TearDownTestCase()
+  {
+    CJSONRPC::Cleanup();
+  }
+
+  void SetUp() override
+  {
+    s_activeReads = 0;
+    s_maxActiveReads = 0;
+    s_writeOverlapped = false;
+  }
+
+  CTestClient m_client;
+  CTestTransport m_transport;
+};
+
+TEST_F(TestJSONRPC, MixedBatchKeepsOrderAndRunsReadsConcurrently)
+{
+  const std::string batch =
+    "["
+      "{ \"jsonrpc\": \"2.0\", \"method\": \"Test.Read\", \"params\": { \"value\": 1 }, \"id\": 1 },"
+      "{ \"jsonrpc\": \"2.0\", \"method\": \"Test.Read\", \"params\": { \"value\": 2 }, \"id\": 2 },"
+      "{ \"jsonrpc\": \"2.0\", \"method\": \"Test.Read\", \"params\": { \"value\": 3 }, \"id\": 3 },"
+      "{ \"jsonrpc\": \"2.0\", \"method\": \"Test.Write\", \"params\": { \"value\": 4 }, \"id\": 4 },"
+      "{ \"jsonrpc\": \"2.0\", \"method\": \"Test.Read\", \"params\": { \"value\": 5 }, \"id\": 5 },"
+      "{ \"jsonrpc\": \"2.0\", \"method\": \"Test.Read\", \"params\": { \"value\": 6 }, \"id\": 6 },"
+      "{ \"jsonrpc\": \"2.0\", \"method\": \"Test.Write\", \"params\": { \"value\": 7 }, \"id\": 7 }"
+    "]";
+
+  CVariant responses;
+  ASSERT_TRUE(CJSONVariantParser::Parse(CJSONRPC::MethodCall(batch, &m_transport, &m_client), responses));
+  ASSERT_TRUE(responses.isArray());
+  ASSERT_EQ(7u, responses.size());
+
+  for (unsigned int index = 0; index < responses.size(); index++)
+  {
+    const CVariant &response = responses[index];
+    EXPECT_EQ(index + 1, response["id"].asUnsignedInteger());
+    EXPECT_FALSE(response.isMember("error"));
+  }
+
+  // the reads return their value, the writes the concurrency of the reads before them
+  EXPECT_EQ(1, responses[0]["result"].asInteger());
+  EXPECT_EQ(2, responses[1]["result"].asInteger());
+  EXPECT_EQ(3, responses[2]["result"].asInteger());
+  EXPECT_LE(2, responses[3]["result"].asInteger());
+  EXPECT_EQ(5, responses[4]["result"].asInteger());
+  EXPECT_EQ(6, responses[5]["result"].asInteger());
+  EXPECT_LE(2, responses[6]["result"].asInteger());
+
+  EXPECT_FALSE(s_writeOverlapped);
+}
@@ -0,0 +1,92 @@
+/*
+ *      Copyright (C) 2017 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include "interfaces/json-rpc/IJSONRPCAnnouncer.h"
+#include "utils/Variant.h"
+
+using namespace ANNOUNCEMENT;
+using namespace JSONRPC;
+
+namespace
+{
+  class CTestAnnouncer : public IJSONRPCAnnouncer
+  {
+  public:
+    void Announce(AnnouncementFlag flag, const char *sender, const char *message, const CVariant &data) override {}
+
+    using IJSONRPCAnnouncer::GetAnnouncementItem;
+    using IJSONRPCAnnouncer::IsAnnouncementDroppable;
+  };
+
+  CVariant MakeUpdate(int id)
+  {
+    CVariant data;
+    data["item"]["type"] = "movie";
+    data["item"]["id"] = id;
+    return data;
+  }
+}
+
+TEST(TestJSONRPCAnnouncer, GetAnnouncementItem)
+{
+  std::string key, fields;
+  EXPECT_TRUE(CTestAnnouncer::GetAnnouncementItem(VideoLibrary, "OnUpdate", MakeUpdate(1), key, fields));
+  EXPECT_EQ("VideoLibrary:movie:1", key);
+
+  /* removals and added items are about the item, but never replaced */
+  EXPECT_FALSE(CTestAnnouncer::GetAnnouncementItem(VideoLibrary, "OnRemove", MakeUpdate(1), key, fields));
+  EXPECT_EQ("VideoLibrary:movie:1", key);
+  CVariant added = MakeUpdate(1);
+  added["added"] = true;
+  EXPECT_FALSE(CTestAnnouncer::GetAnnouncementItem(VideoLibrary, "OnUpdate", added, key, fields));
+
+  EXPECT_FALSE(CTestAnnouncer::GetAnnouncementItem(Player, "OnPlay", MakeUpdate(1), key, fields));
+  EXPECT_TRUE(key.empty());
+}
+
+TEST(TestJSONRPCAnnouncer, UpdatesWithDifferentFieldsDontReplaceEachOther)
+{
+  std::string key, fields, playcountKey, playcountFields;
+  CVariant playcount = MakeUpdate(1);
+  playcount["playcount"] = 1;
+  ASSERT_TRUE(CTestAnnouncer::GetAnnouncementItem(VideoLibrary, "OnUpdate", MakeUpdate(1), key, fields));
+  ASSERT_TRUE(CTestAnnouncer::GetAnnouncementItem(VideoLibrary, "OnUpdate", playcount, playcountKey, playcountFields));
+
+  EXPECT_EQ(key, playcountKey);
+  EXPECT_NE(fields, playcountFields);
+
+  /* the order the members were set in doesn't matter */
+  CVariant reordered;
+  reordered["playcount"] = 2;
+  reordered["item"]["id"] = 1;
+  reordered["item"]["type"] = "movie";
+  ASSERT_TRUE(CTestAnnouncer::GetAnnouncementItem(VideoLibrary, "OnUpdate", reordered, key, fields));
+  EXPECT_EQ(playcountFields, fields);
+}
+
+TEST(TestJSONRPCAnnouncer, RemovalsAreNeverDropped)
+{
+  EXPECT_FALSE(CTestAnnouncer::IsAnnouncementDroppable("OnRemove"));
+  EXPECT_TRUE(CTestAnnouncer::IsAnnouncementDroppable("OnUpdate"));
+}
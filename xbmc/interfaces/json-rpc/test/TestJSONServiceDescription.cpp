@@ -0,0 +1,208 @@
+/*
+ *      Copyright (C) 2017 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "interfaces/json-rpc/JSONRPC.h"
+#include "interfaces/json-rpc/JSONServiceDescription.h"
+#include "utils/JSONVariantParser.h"
+#include "utils/StringUtils.h"
+#include "utils/Variant.h"
+
+using namespace JSONRPC;
+
+namespace
+{
+  class CTestClient : public IClient
+  {
+  public:
+    int GetPermissionFlags() override { return OPERATION_PERMISSION_ALL; }
+    int GetAnnouncementFlags() override { return 0; }
+    bool SetAnnouncementFlags(int flags) override { return true; }
+  };
+
+  class CTestTransport : public ITransportLayer
+  {
+  public:
+    bool PrepareDownload(const char *path, CVariant &details, std::string &protocol) override { return false; }
+    bool Download(const char *path, CVariant &result) override { return false; }
+    int GetCapabilities() override { return Response | Announcing | FileDownloadDirect | FileDownloadRedirect; }
+  };
+
+  // calls remotes typically send, with their usual parameters
+  const char *TYPICAL_REMOTE_CALLS[] = {
+    "[ \"Player.GetProperties\", { \"playerid\": 1, \"properties\": [ \"speed\", \"time\", \"totaltime\", \"percentage\", \"playlistid\", \"position\", \"repeat\", \"shuffled\" ] } ]",
+    "[ \"Player.GetItem\", { \"playerid\": 1, \"properties\": [ \"title\", \"album\", \"artist\", \"duration\", \"thumbnail\", \"file\", \"fanart\" ] } ]",
+    "[ \"Application.GetProperties\", { \"properties\": [ \"volume\", \"muted\" ] } ]",
+    "[ \"GUI.GetProperties\", { \"properties\": [ \"currentwindow\", \"fullscreen\" ] } ]",
+    "[ \"VideoLibrary.GetMovies\", { \"properties\": [ \"title\", \"year\", \"rating\", \"playcount\", \"art\" ], \"limits\": { \"start\": 0, \"end\": 50 }, \"sort\": { \"method\": \"title\", \"ignorearticle\": true } } ]",
+    "[ \"AudioLibrary.GetSongs\", { \"properties\": [ \"title\", \"artist\", \"album\", \"track\", \"duration\" ], \"limits\": { \"start\": 0, \"end\": 100 } } ]",
+    "[ \"Player.Open\", { \"item\": { \"file\": \"special://temp/test.mkv\" }, \"options\": { \"resume\": true } } ]",
+    "[ \"Input.ExecuteAction\", { \"action\": \"select\" } ]"
+  };
+}
+
+class TestJSONServiceDescription : public testing::Test
+{
+protected:
+  static void SetUpTestCase()
+  {
+    CJSONRPC::Initialize();
+  }
+
+  static void TearDownTestCase()
+  {
+    CJSONRPC::Cleanup();
+  }
+
+  JSONRPC_STATUS CheckCall(const std::string &method, const char *parameters, CVariant &result)
+  {
+    CVariant requestParameters;
+    EXPECT_TRUE(CJSONVariantParser::Parse(parameters, requestParameters));
+
+    return CheckCall(method, requestParameters, result);
+  }
+
+  JSONRPC_STATUS CheckCall(std::string method, const CVariant &parameters, CVariant &result)
+  {
+    StringUtils::ToLower(method);
+
+    MethodCall methodCall = nullptr;
+    result = CVariant();
+    return CJSONServiceDescription::CheckCall(method.c_str(), parameters, &m_transport, &m_client, false, methodCall, result);
+  }
+
+  CTestClient m_client;
+  CTestTransport m_transport;
+};
+
+TEST_F(TestJSONServiceDescription, AppliesDefaultValues)
+{
+  CVariant result;
+  ASSERT_EQ(OK, CheckCall("AudioLibrary.GetSongs", "{ \"limits\": { \"start\": 0, \"end\": 100 } }", result));
+  EXPECT_EQ(100, result["limits"]["end"].asInteger());
+  EXPECT_TRUE(result["includesingles"].asBoolean());
+  EXPECT_EQ("none", result["sort"]["method"].asString());
+  EXPECT_EQ("ascending", result["sort"]["order"].asString());
+}
+
+TEST_F(TestJSONServiceDescription, OptionalParametersWithoutRequest)
+{
+  CVariant withoutParameters, emptyParameters;
+  ASSERT_EQ(OK, CheckCall("JSONRPC.Introspect", CVariant(), withoutParameters));
+  ASSERT_EQ(OK, CheckCall("JSONRPC.Introspect", CVariant(CVariant::VariantTypeObject), emptyParameters));
+  EXPECT_TRUE(withoutParameters == emptyParameters);
+  EXPECT_TRUE(withoutParameters["getdescriptions"].asBoolean());
+  EXPECT_TRUE(withoutParameters["filter"]["getreferences"].asBoolean());
+
+  // an explicit value replaces the default value
+  CVariant result;
+  ASSERT_EQ(OK, CheckCall("JSONRPC.Introspect", "{ \"getdescriptions\": false }", result));
+  EXPECT_FALSE(result["getdescriptions"].asBoolean());
+  EXPECT_TRUE(result["filterbytransport"].asBoolean());
+
+  // methods without parameters don't get any
+  ASSERT_EQ(OK, CheckCall("JSONRPC.Ping", CVariant(), result));
+  EXPECT_TRUE(result.isNull());
+  EXPECT_EQ(InvalidParams, CheckCall("JSONRPC.Ping", "{ \"unknown\": 1 }", result));
+  EXPECT_EQ("Too many parameters", result["message"].asString());
+}
+
+TEST_F(TestJSONServiceDescription, ChecksEnums)
+{
+  CVariant result;
+  ASSERT_EQ(OK, CheckCall("Player.GetProperties", "{ \"playerid\": 1, \"properties\": [ \"speed\", \"time\", \"totaltime\" ] }", result));
+  ASSERT_EQ(3U, result["properties"].size());
+  EXPECT_EQ("totaltime", result["properties"][2].asString());
+
+  ASSERT_EQ(InvalidParams, CheckCall("Player.GetProperties", "{ \"playerid\": 1, \"properties\": [ \"speed\", \"unknown\" ] }", result));
+  EXPECT_EQ("Player.GetProperties", result["method"].asString());
+  EXPECT_EQ("properties", result["stack"]["name"].asString());
+  EXPECT_EQ("array element at index 1 does not match", result["stack"]["message"].asString());
+  EXPECT_EQ("Received value does not match any of the defined enum values", result["stack"]["property"]["message"].asString());
+
+  // only strings can match the string enums
+  EXPECT_EQ(InvalidParams, CheckCall("Player.GetProperties", "{ \"playerid\": 1, \"properties\": [ 1 ] }", result));
+}
+
+TEST_F(TestJSONServiceDescription, ReportsInvalidParameters)
+{
+  CVariant result;
+  ASSERT_EQ(InvalidParams, CheckCall("Player.GetProperties", "{ \"properties\": [ \"speed\" ] }", result));
+  EXPECT_EQ("playerid", result["stack"]["name"].asString());
+  EXPECT_EQ("Missing parameter", result["stack"]["message"].asString());
+
+  ASSERT_EQ(InvalidParams, CheckCall("Player.GetProperties", "{ \"playerid\": \"1\", \"properties\": [ \"speed\" ] }", result));
+  EXPECT_EQ("playerid", result["stack"]["name"].asString());
+  EXPECT_EQ("Invalid type string received", result["stack"]["message"].asString());
+
+  EXPECT_EQ(MethodNotFound, CheckCall("Unknown.Method", CVariant(), result));
+}
+
+TEST_F(TestJSONServiceDescription, ChecksTypicalRemoteCalls)
+{
+  for (const char *request : TYPICAL_REMOTE_CALLS)
+  {
+    CVariant call;
+    ASSERT_TRUE(CJSONVariantParser::Parse(request, call));
+
+    CVariant result;
+    EXPECT_EQ(OK, CheckCall(call[0].asString(), call[1], result)) << request;
+  }
+}
+
+TEST_F(TestJSONServiceDescription, DISABLED_Benchmark)
+{
+  CVariant description;
+  ASSERT_EQ(OK, CJSONServiceDescription::Print(description, &m_transport, &m_client, false, false, false));
+
+  // every method without parameters (mostly invalid calls) and the typical calls of remotes
+  std::vector<std::pair<std::string, CVariant>> calls;
+  for (CVariant::const_iterator_map method = description["methods"].begin_map(); method != description["methods"].end_map(); ++method)
+    calls.push_back(std::make_pair(method->first, CVariant()));
+  ASSERT_LT(100U, calls.size());
+
+  for (const char *request : TYPICAL_REMOTE_CALLS)
+  {
+    CVariant call;
+    ASSERT_TRUE(CJSONVariantParser::Parse(request, call));
+    calls.push_back(std::make_pair(call[0].asString(), call[1]));
+  }
+
+  const size_t rounds = 200;
+  auto start = std::chrono::steady_clock::now();
+  for (size_t round = 0; round < rounds; round++)
+  {
+    for (const auto& call : calls)
+    {
+      CVariant result;
+      CheckCall(call.first, call.second, result);
+    }
+  }
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  std::cout << calls.size() << " calls checked: " << static_cast<int64_t>(rounds * calls.size() / seconds) << " calls/s" << std::endl;
+}
@@ -0,0 +1,438 @@
+/*
+ *      Copyright (C) 2017 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "HTTPResponseCache.h"
+
+#include <stdlib.h>
+#include <utility>
+#include <vector>
+
+#include <zlib.h>
+
+#include "threads/SingleLock.h"
+#include "utils/StringUtils.h"
+#include "utils/Variant.h"
+#include "utils/md5.h"
+
+// compressing smaller responses doesn't pay off
+#define MIN_COMPRESSIBLE_SIZE 256
+
+// a single response may not take more than this fraction of the cache
+#define MAX_RESPONSE_SIZE_DIVISOR 8
+
+// the output of a compressed stream grows by this size
+#define STREAM_COMPRESSION_BLOCK_SIZE 16384
+
+namespace
+{
+
+int GetWindowBits(HTTPContentEncoding encoding)
+{
+  // gzip needs the gzip wrapper while deflate means the zlib format (RFC 7230 4.2.2)
+  if (encoding == HTTPContentEncodingGzip)
+    return MAX_WBITS + 16;
+  return MAX_WBITS;
+}
+
+}
+
+CHTTPResponseCache::CHTTPResponseCache(size_t maximumSize /* = 0 */)
+  : m_size(0),
+    m_maximumSize(maximumSize),
+    m_hits(0),
+    m_misses(0),
+    m_notModified(0),
+    m_evictions(0),
+    m_compressions(0)
+{ }
+
+void CHTTPResponseCache::SetMaximumSize(size_t maximumSize)
+{
+  CSingleLock lock(m_critSection);
+  m_maximumSize = maximumSize;
+  Trim();
+}
+
+bool CHTTPResponseCache::IsEnabled() const
+{
+  CSingleLock lock(m_critSection);
+  return m_maximumSize > 0;
+}
+
+size_t CHTTPResponseCache::GetMaximumResponseSize() const
+{
+  CSingleLock lock(m_critSection);
+  return m_maximumSize / MAX_RESPONSE_SIZE_DIVISOR;
+}
+
+bool CHTTPResponseCache::Get(const std::string &key, const std::string &validator, int acceptedEncodings, CResponse &response)
+{
+  CSingleLock lock(m_critSection);
+
+  Entries::iterator it = m_entries.find(key);
+  if (it == m_entries.end() || it->second.validator != validator)
+  {
+    // the response data has changed since it was cached
+    if (it != m_entries.end())
+      Remove(it);
+
+    m_misses++;
+    return false;
+  }
+
+  m_hits++;
+  m_usage.splice(m_usage.begin(), m_usage, it->second.usage);
+
+  GetVariant(key, acceptedEncodings, response);
+  return true;
+}
+
+bool CHTTPResponseCache::Put(const std::string &key, const std::string &validator, const std::string &contentType, const std::string &etag,
+                             const BufferPtr &data, int acceptedEncodings, CResponse &response)
+{
+  if (data == nullptr)
+    return false;
+
+  CSingleLock lock(m_critSection);
+  if (data->size() > m_maximumSize / MAX_RESPONSE_SIZE_DIVISOR)
+    return false;
+
+  Entries::iterator it = m_entries.find(key);
+  if (it != m_entries.end())
+    Remove(it);
+
+  m_usage.push_front(key);
+
+  CEntry &entry = m_entries[key];
+  entry.validator = validator;
+  entry.contentType = contentType;
+  entry.etag = etag;
+  entry.data[HTTPContentEncodingIdentity] = data;
+  entry.compressible = IsCompressible(contentType) && data->size() >= MIN_COMPRESSIBLE_SIZE;
+  entry.size = key.size() + data->size();
+  entry.usage = m_usage.begin();
+
+  m_size += entry.size;
+
+  GetVariant(key, acceptedEncodings, response);
+  Trim();
+
+  return true;
+}
+
+void CHTTPResponseCache::Clear()
+{
+  CSingleLock lock(m_critSection);
+  m_entries.clear();
+  m_usage.clear();
+  m_size = 0;
+}
+
+void CHTTPResponseCache::AddNotModified()
+{
+  CSingleLock lock(m_critSection);
+  m_notModified++;
+}
+
+void CHTTPResponseCache::GetStatistics(CVariant &statistics) const
+{
+  CSingleLock lock(m_critSection);
+  statistics["enabled"] = m_maximumSize > 0;
+  statistics["entries"] = static_cast<uint64_t>(m_entries.size());
+  statistics["size"] = static_cast<uint64_t>(m_size);
+  statistics["maximumsize"] = static_cast<uint64_t>(m_maximumSize);
+  statistics["hits"] = m_hits;
+  statistics["misses"] = m_misses;
+  statistics["notmodified"] = m_notModified;
+  statistics["evictions"] = m_evictions;
+  statistics["compressions"] = m_compressions;
+}
+
+std::string CHTTPResponseCache::CreateETag(const std::string &value)
+{
+  std::string etag = XBMC::XBMC_MD5::GetMD5(value);
+  StringUtils::ToLower(etag);
+  return "\"" + etag + "\"";
+}
+
+std::string CHTTPResponseCache::GetETag(const std::string &etag, HTTPContentEncoding encoding)
+{
+  if (encoding == HTTPContentEncodingIdentity || etag.size() < 2)
+    return etag;
+
+  // every variant is a different representation and needs its own strong ETag
+  return etag.substr(0, etag.size() - 1) + "-" + GetEncodingName(encoding) + "\"";
+}
+
+bool CHTTPResponseCache::MatchesETag(const std::string &ifNoneMatch, const std::string &etag)
+{
+  std::string matchingETag;
+  return MatchesETag(ifNoneMatch, etag, matchingETag);
+}
+
+bool CHTTPResponseCache::MatchesETag(const std::string &ifNoneMatch, const std::string &etag, std::string &matchingETag)
+{
+  if (etag.empty())
+    return false;
+
+  std::vector<std::string> tags = StringUtils::Split(ifNoneMatch, ",");
+  for (auto tag : tags)
+  {
+    StringUtils::Trim(tag);
+    if (tag == "*")
+    {
+      matchingETag = etag;
+      return true;
+    }
+
+    // If-None-Match uses the weak comparison
+    if (StringUtils::StartsWith(tag, "W/"))
+      tag.erase(0, 2);
+
+    for (int encoding = HTTPContentEncodingIdentity; encoding < HTTPContentEncodingCount; encoding++)
+    {
+      const std::string variantETag = GetETag(etag, static_cast<HTTPContentEncoding>(encoding));
+      if (tag == variantETag)
+      {
+        matchingETag = variantETag;
+        return true;
+      }
+    }
+  }
+
+  return false;
+}
+
+int CHTTPResponseCache::GetAcceptedEncodings(const std::string &acceptEncoding)
+{
+  int encodings = 1 << HTTPContentEncodingIdentity;
+
+  std::vector<std::string> codings = StringUtils::Split(acceptEncoding, ",");
+  for (const auto& coding : codings)
+  {
+    std::vector<std::string> parameters = StringUtils::Split(coding, ";");
+    if (parameters.empty())
+      continue;
+
+    std::string name = StringUtils::Trim(parameters.front());
+    StringUtils::ToLower(name);
+
+    // skip codings which are explicitly not acceptable
+    bool acceptable = true;
+    for (size_t i = 1; i < parameters.size(); i++)
+    {
+      std::string parameter = StringUtils::Trim(parameters[i]);
+      if (StringUtils::StartsWithNoCase(parameter, "q=") && strtod(parameter.c_str() + 2, nullptr) <= 0.0)
+        acceptable = false;
+    }
+    if (!acceptable)
+      continue;
+
+    if (name == "gzip" || name == "x-gzip")
+      encodings |= 1 << HTTPContentEncodingGzip;
+    else if (name == "deflate")
+      encodings |= 1 << HTTPContentEncodingDeflate;
+    else if (name == "*")
+      encodings |= (1 << HTTPContentEncodingGzip) | (1 << HTTPContentEncodingDeflate);
+  }
+
+  return encodings;
+}
+
+HTTPContentEncoding CHTTPResponseCache::GetPreferredEncoding(int acceptedEncodings)
+{
+  // gzip is supported by more clients than deflate
+  if (acceptedEncodings & (1 << HTTPContentEncodingGzip))
+    return HTTPContentEncodingGzip;
+  if (acceptedEncodings & (1 << HTTPContentEncodingDeflate))
+    return HTTPContentEncodingDeflate;
+
+  return HTTPContentEncodingIdentity;
+}
+
+const char* CHTTPResponseCache::GetEncodingName(HTTPContentEncoding encoding)
+{
+  switch (encoding)
+  {
+  case HTTPContentEncodingGzip:
+    return "gzip";
+
+  case HTTPContentEncodingDeflate:
+    return "deflate";
+
+  default:
+    break;
+  }
+
+  return "identity";
+}
+
+bool CHTTPResponseCache::IsCompressible(const std::string &contentType)
+{
+  std::string mimeType = contentType.substr(0, contentType.find(';'));
+  StringUtils::Trim(mimeType);
+  StringUtils::ToLower(mimeType);
+
+  return StringUtils::StartsWith(mimeType, "text/") ||
+         StringUtils::EndsWith(mimeType, "+xml") ||
+         StringUtils::EndsWith(mimeType, "+json") ||
+         mimeType == "application/json" ||
+         mimeType == "application/javascript" ||
+         mimeType == "application/x-javascript" ||
+         mimeType == "application/xml";
+}
+
+bool CHTTPResponseCache::Compress(const std::string &data, HTTPContentEncoding encoding, std::string &compressed)
+{
+  if (encoding == HTTPContentEncodingIdentity || data.size() < MIN_COMPRESSIBLE_SIZE)
+    return false;
+
+  z_stream stream = {};
+  if (deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, GetWindowBits(encoding), 8, Z_DEFAULT_STRATEGY) != Z_OK)
+    return false;
+
+  compressed.resize(deflateBound(&stream, data.size()) + 32);
+  stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.c_str()));
+  stream.avail_in = static_cast<uInt>(data.size());
+  stream.next_out = reinterpret_cast<Bytef*>(&compressed[0]);
+  stream.avail_out = static_cast<uInt>(compressed.size());
+
+  int result = deflate(&stream, Z_FINISH);
+  compressed.resize(stream.total_out);
+  deflateEnd(&stream);
+
+  return result == Z_STREAM_END && compressed.size() < data.size();
+}
+
+void CHTTPResponseCache::GetVariant(const std::string &key, int acceptedEncodings, CResponse &response)
+{
+  Entries::iterator it = m_entries.find(key);
+  const CEntry &entry = it->second;
+
+  response.contentType = entry.contentType;
+  response.encoding = HTTPContentEncodingIdentity;
+  response.data = entry.data[HTTPContentEncodingIdentity];
+
+  const std::string etag = entry.etag;
+  HTTPContentEncoding encoding = GetPreferredEncoding(acceptedEncodings);
+  if (encoding != HTTPContentEncodingIdentity && entry.compressible)
+  {
+    BufferPtr variant = entry.data[encoding];
+    if (variant == nullptr)
+    {
+      // compress without blocking other requests, the entry might be gone afterwards
+      BufferPtr data = response.data;
+      std::string compressed;
+      bool success;
+      {
+        CSingleExit exit(m_critSection);
+        success = Compress(*data, encoding, compressed);
+      }
+
+      it = m_entries.find(key);
+      bool unchanged = it != m_entries.end() && it->second.data[HTTPContentEncodingIdentity] == data;
+      if (success)
+      {
+        variant = std::make_shared<const std::string>(std::move(compressed));
+        if (unchanged && it->second.data[encoding] == nullptr)
+        {
+          it->second.data[encoding] = variant;
+          it->second.size += variant->size();
+          m_size += variant->size();
+          m_compressions++;
+          Trim();
+        }
+      }
+      else if (unchanged)
+        it->second.compressible = false;
+    }
+
+    if (variant != nullptr)
+    {
+      response.data = variant;
+      response.encoding = encoding;
+    }
+  }
+
+  response.etag = GetETag(etag, response.encoding);
+}
+
+void CHTTPResponseCache::Remove(Entries::iterator entry)
+{
+  m_size -= entry->second.size;
+  m_usage.erase(entry->second.usage);
+  m_entries.erase(entry);
+}
+
+void CHTTPResponseCache::Trim()
+{
+  while (m_size > m_maximumSize && !m_usage.empty())
+  {
+    Remove(m_entries.find(m_usage.back()));
+    m_evictions++;
+  }
+}
+
+CHTTPStreamCompressor::CHTTPStreamCompressor() = default;
+
+CHTTPStreamCompressor::~CHTTPStreamCompressor()
+{
+  if (m_stream != nullptr)
+    deflateEnd(m_stream.get());
+}
+
+bool CHTTPStreamCompressor::Initialize(HTTPContentEncoding encoding)
+{
+  if (m_stream != nullptr || encoding == HTTPContentEncodingIdentity || encoding >= HTTPContentEncodingCount)
+    return false;
+
+  std::unique_ptr<z_stream> stream(new z_stream());
+  if (deflateInit2(stream.get(), Z_DEFAULT_COMPRESSION, Z_DEFLATED, GetWindowBits(encoding), 8, Z_DEFAULT_STRATEGY) != Z_OK)
+    return false;
+
+  m_stream = std::move(stream);
+  return true;
+}
+
+bool CHTTPStreamCompressor::Compress(const char *data, size_t size, bool finish, std::string &compressed)
+{
+  if (m_stream == nullptr)
+    return false;
+
+  m_stream->next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data));
+  m_stream->avail_in = static_cast<uInt>(size);
+
+  while (true)
+  {
+    const size_t offset = compressed.size();
+    compressed.resize(offset + STREAM_COMPRESSION_BLOCK_SIZE);
+    m_stream->next_out = reinterpret_cast<Bytef*>(&compressed[offset]);
+    m_stream->avail_out = STREAM_COMPRESSION_BLOCK_SIZE;
+
+    int result = deflate(m_stream.get(), finish ? Z_FINISH : Z_NO_FLUSH);
+    compressed.resize(offset + STREAM_COMPRESSION_BLOCK_SIZE - m_stream->avail_out);
+    if (result == Z_STREAM_ERROR)
+      return false;
+
+    // without room left in the output zlib may hold back more output
+    if (finish ? result == Z_STREAM_END : (m_stream->avail_in == 0 && m_stream->avail_out > 0))
+      return true;
+  }
+}
@@ -0,0 +1,212 @@
+#pragma once
+/*
+ *      Copyright (C) 2017 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <stdint.h>
+#include <list>
+#include <map>
+#include <memory>
+#include <string>
+
+#include "threads/CriticalSection.h"
+
+class CVariant;
+struct z_stream_s;
+
+enum HTTPContentEncoding
+{
+  HTTPContentEncodingIdentity = 0,
+  HTTPContentEncodingGzip,
+  HTTPContentEncodingDeflate,
+  HTTPContentEncodingCount
+};
+
+/*!
+ * \brief Keeps complete responses of the web server in memory.
+ *
+ * \details Responses are identified by a key built from the request handler
+ * and all request parameters the response depends on. Every response carries
+ * the validator of the response data it was created from, a response whose
+ * validator changed is dropped on the next lookup. Compressible responses
+ * are compressed once per content encoding and the compressed variants are
+ * kept next to the original data. The least recently used responses are
+ * dropped when the cache exceeds its size.
+ */
+class CHTTPResponseCache
+{
+public:
+  typedef std::shared_ptr<const std::string> BufferPtr;
+
+  struct CResponse
+  {
+    BufferPtr data;
+    HTTPContentEncoding encoding;
+    std::string contentType;
+    std::string etag;
+  };
+
+  explicit CHTTPResponseCache(size_t maximumSize = 0);
+  ~CHTTPResponseCache() = default;
+
+  /*!
+   * \brief Sets the maximum size of all cached data in bytes, 0 disables the cache.
+   */
+  void SetMaximumSize(size_t maximumSize);
+  bool IsEnabled() const;
+
+  /*!
+   * \brief Returns the size of the largest response worth caching.
+   */
+  size_t GetMaximumResponseSize() const;
+
+  /*!
+   * \brief Looks up a response and picks the variant for the accepted content encodings.
+   *
+   * \param key Key of the response
+   * \param validator Validator of the current response data
+   * \param acceptedEncodings Bitmask of the HTTPContentEncoding values (1 << encoding) accepted by the client
+   * \param response Set to the cached response
+   * \return True if a valid response was found, otherwise false.
+   */
+  bool Get(const std::string &key, const std::string &validator, int acceptedEncodings, CResponse &response);
+
+  /*!
+   * \brief Adds a response, replacing the one with the same key, and picks the variant like Get().
+   *
+   * \param etag Strong ETag of the response data
+   * \return False if the response is too large to be cached.
+   */
+  bool Put(const std::string &key, const std::string &validator, const std::string &contentType, const std::string &etag,
+           const BufferPtr &data, int acceptedEncodings, CResponse &response);
+
+  void Clear();
+
+  /*!
+   * \brief Counts a request that was answered with 304 Not Modified.
+   */
+  void AddNotModified();
+
+  void GetStatistics(CVariant &statistics) const;
+
+  /*!
+   * \brief Creates a strong ETag from an arbitrary value.
+   */
+  static std::string CreateETag(const std::string &value);
+
+  /*!
+   * \brief Returns the ETag of the variant of a response with the given content encoding.
+   */
+  static std::string GetETag(const std::string &etag, HTTPContentEncoding encoding);
+
+  /*!
+   * \brief Checks if the value of an If-None-Match header matches any variant of the given ETag.
+   */
+  static bool MatchesETag(const std::string &ifNoneMatch, const std::string &etag);
+
+  /*!
+   * \brief Checks if the value of an If-None-Match header matches any variant of the given ETag.
+   * \param matchingETag Set to the ETag of the matching variant, or to the given ETag for a wildcard.
+   */
+  static bool MatchesETag(const std::string &ifNoneMatch, const std::string &etag, std::string &matchingETag);
+
+  /*!
+   * \brief Parses the value of an Accept-Encoding header into a bitmask of HTTPContentEncoding values.
+   */
+  static int GetAcceptedEncodings(const std::string &acceptEncoding);
+
+  /*!
+   * \brief Picks the preferred content encoding out of a bitmask of accepted content encodings.
+   */
+  static HTTPContentEncoding GetPreferredEncoding(int acceptedEncodings);
+
+  static const char* GetEncodingName(HTTPContentEncoding encoding);
+
+  /*!
+   * \brief Whether data of the given MIME type benefits from compression.
+   */
+  static bool IsCompressible(const std::string &contentType);
+
+  /*!
+   * \brief Compresses the given data with the given content encoding.
+   *
+   * \return False if the data couldn't be compressed or didn't get smaller.
+   */
+  static bool Compress(const std::string &data, HTTPContentEncoding encoding, std::string &compressed);
+
+private:
+  struct CEntry
+  {
+    std::string validator;
+    std::string contentType;
+    std::string etag;
+    BufferPtr data[HTTPContentEncodingCount];
+    bool compressible;
+    size_t size;
+    std::list<std::string>::iterator usage;
+  };
+  typedef std::map<std::string, CEntry> Entries;
+
+  void GetVariant(const std::string &key, int acceptedEncodings, CResponse &response);
+  void Remove(Entries::iterator entry);
+  void Trim();
+
+  mutable CCriticalSection m_critSection;
+  Entries m_entries;
+  std::list<std::string> m_usage; // most recently used first
+  size_t m_size;
+  size_t m_maximumSize;
+
+  uint64_t m_hits;
+  uint64_t m_misses;
+  uint64_t m_notModified;
+  uint64_t m_evictions;
+  uint64_t m_compressions;
+};
+
+/*!
+ * \brief Compresses a response of unknown length while it is sent.
+ */
+class CHTTPStreamCompressor
+{
+public:
+  CHTTPStreamCompressor();
+  ~CHTTPStreamCompressor();
+
+  /*!
+   * \brief Starts compressing with the given content encoding.
+   *
+   * \return False if the content encoding isn't supported.
+   */
+  bool Initialize(HTTPContentEncoding encoding);
+
+  /*!
+   * \brief Compresses the next part of the data and appends the output to compressed.
+   *
+   * \details The output may be empty until enough data was passed in.
+   * \param finish Whether this is the last part of the data, completes the compressed stream.
+   */
+  bool Compress(const char *data, size_t size, bool finish, std::string &compressed);
+
+private:
+  CHTTPStreamCompressor(const CHTTPStreamCompressor&) = delete;
+  CHTTPStreamCompressor& operator=(const CHTTPStreamCompressor&) = delete;
+
+  std::unique_ptr<z_stream_s> m_stream;
+};
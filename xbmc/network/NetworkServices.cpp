@@ -171,6 +171,13 @@ CNetworkServices& CNetworkServices::GetInstance()
   return sNetworkServices;
 }
 
+void CNetworkServices::GetStatistics(CVariant &statistics) const
+{
+#ifdef HAS_WEB_SERVER
+  m_webserver.GetResponseCacheStatistics(statistics["webserver"]["responsecache"]);
+#endif // HAS_WEB_SERVER
+}
+
 bool CNetworkServices::OnSettingChanging(std::shared_ptr<const CSetting> setting)
 {
   if (setting == NULL)
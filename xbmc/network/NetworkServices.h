@@ -22,6 +22,8 @@
 #include "system.h"
 #include "settings/lib/ISettingCallback.h"
 
+class CVariant;
+
 #ifdef HAS_WEB_SERVER
 class CWebServer;
 class CHTTPImageHandler;
@@ -94,6 +96,11 @@ public:
   bool IsZeroconfRunning();
   bool StopZeroconf();
 
+  /*!
+   \brief Fills the runtime statistics of the running services.
+   */
+  void GetStatistics(CVariant &statistics) const;
+
 private:
   CNetworkServices();
   CNetworkServices(const CNetworkServices&);
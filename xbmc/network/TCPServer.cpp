@@ -19,18 +19,31 @@
  */
 
 #include "TCPServer.h"
+#include <algorithm>
+#include <errno.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <memory.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
 
+#if defined(TARGET_LINUX) || defined(TARGET_ANDROID)
+#define HAS_EPOLL
+#include <sys/epoll.h>
+#include <unistd.h>
+#endif
+#if !defined(TARGET_WINDOWS)
+#include <fcntl.h>
+#endif
+
 #include "settings/AdvancedSettings.h"
 #include "interfaces/json-rpc/JSONRPC.h"
 #include "interfaces/AnnouncementManager.h"
+#include "utils/JSONVariantWriter.h"
 #include "utils/log.h"
 #include "utils/Variant.h"
 #include "threads/SingleLock.h"
+#include "threads/SystemClock.h"
 #include "websocket/WebSocketManager.h"
 #include "Network.h"
 
@@ -60,7 +73,299 @@ static const bdaddr_t bt_bdaddr_local = {{0, 0, 0, 0xff, 0xff, 0xff}};
 using namespace JSONRPC;
 using namespace ANNOUNCEMENT;
 
-#define RECEIVEBUFFER 1024
+#define RECEIVEBUFFER 16384
+// pending TCP connections, a backlog of 10 makes clients connecting at once wait for SYN retransmissions
+#define LISTEN_BACKLOG SOMAXCONN
+// reads of a connection per event, so one busy client can't starve the others
+#define MAX_READS_PER_EVENT 16
+// maximum number of method calls that execute at the same time
+#define MAX_CONCURRENT_REQUESTS 4
+// queued bytes of a client above which announcements to it are dropped
+#define MAX_ANNOUNCEMENT_BACKLOG (1024 * 1024)
+// queued bytes of a client above which it is disconnected, it doesn't read its responses
+#define MAX_SEND_BACKLOG (16 * 1024 * 1024)
+// size of the chunks a response is written in
+#define STREAM_CHUNK_SIZE (64 * 1024)
+// queued bytes of a client below which the next chunk of a response is written
+#define MAX_STREAM_BACKLOG (4 * STREAM_CHUNK_SIZE)
+// time a client may take to read the queued chunks of a response before it is disconnected
+#define STREAM_SEND_TIMEOUT 60000
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+namespace
+{
+  bool SetNonBlocking(SOCKET socket)
+  {
+#ifdef TARGET_WINDOWS
+    u_long nonblocking = 1;
+    return ioctlsocket(socket, FIONBIO, &nonblocking) == 0;
+#else
+    return fcntl(socket, F_SETFL, fcntl(socket, F_GETFL) | O_NONBLOCK) == 0;
+#endif
+  }
+
+  bool WouldBlock()
+  {
+#ifdef TARGET_WINDOWS
+    return WSAGetLastError() == WSAEWOULDBLOCK;
+#else
+    return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+#endif
+  }
+}
+
+/*!
+ * Waits for readable and writable sockets. All sockets are watched for
+ * incoming data, writability only on request because it is reported
+ * continuously. Add and Remove are only called by the server thread,
+ * SetWantWrite from any thread.
+ */
+class CTCPServer::CSocketPoller
+{
+public:
+  struct Event
+  {
+    SOCKET socket;
+    bool readable; // also set for errors and hangups, recv reports them
+    bool writable;
+  };
+
+  CSocketPoller();
+  ~CSocketPoller();
+
+  bool IsValid() const;
+  void Add(SOCKET socket);
+  void Remove(SOCKET socket);
+  void SetWantWrite(SOCKET socket, bool wantWrite);
+  /*!
+   * @return false if waiting failed, an interrupted or timed out wait returns no events.
+   */
+  bool Wait(int timeoutMs, std::vector<Event>& events);
+
+private:
+#ifdef HAS_EPOLL
+  int m_epoll;
+#else
+  void Wakeup();
+
+  CCriticalSection m_section;
+  std::map<SOCKET, bool> m_sockets; // socket, wants to write
+  SOCKET m_wakeup; // a loopback udp socket connected to itself, to interrupt select
+#endif
+};
+
+#ifdef HAS_EPOLL
+CTCPServer::CSocketPoller::CSocketPoller()
+{
+  m_epoll = epoll_create1(EPOLL_CLOEXEC);
+}
+
+CTCPServer::CSocketPoller::~CSocketPoller()
+{
+  if (m_epoll >= 0)
+    close(m_epoll);
+}
+
+bool CTCPServer::CSocketPoller::IsValid() const
+{
+  return m_epoll >= 0;
+}
+
+void CTCPServer::CSocketPoller::Add(SOCKET socket)
+{
+  epoll_event event = {};
+  event.events = EPOLLIN;
+  event.data.fd = socket;
+  if (epoll_ctl(m_epoll, EPOLL_CTL_ADD, socket, &event) < 0)
+    CLog::Log(LOGERROR, "JSONRPC Server: Failed to watch socket: %d", errno);
+}
+
+void CTCPServer::CSocketPoller::Remove(SOCKET socket)
+{
+  epoll_ctl(m_epoll, EPOLL_CTL_DEL, socket, NULL);
+}
+
+void CTCPServer::CSocketPoller::SetWantWrite(SOCKET socket, bool wantWrite)
+{
+  epoll_event event = {};
+  event.events = EPOLLIN | (wantWrite ? EPOLLOUT : 0);
+  event.data.fd = socket;
+  epoll_ctl(m_epoll, EPOLL_CTL_MOD, socket, &event);
+}
+
+bool CTCPServer::CSocketPoller::Wait(int timeoutMs, std::vector<Event>& events)
+{
+  epoll_event ready[64];
+  int count = epoll_wait(m_epoll, ready, 64, timeoutMs);
+  if (count < 0)
+    return errno == EINTR;
+
+  for (int i = 0; i < count; i++)
+  {
+    Event event;
+    event.socket = ready[i].data.fd;
+    event.readable = (ready[i].events & (EPOLLIN | EPOLLERR | EPOLLHUP)) != 0;
+    event.writable = (ready[i].events & EPOLLOUT) != 0;
+    events.push_back(event);
+  }
+  return true;
+}
+#else
+CTCPServer::CSocketPoller::CSocketPoller()
+{
+  m_wakeup = socket(AF_INET, SOCK_DGRAM, 0);
+  if (m_wakeup == INVALID_SOCKET)
+    return;
+
+  sockaddr_in addr = {};
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  socklen_t len = sizeof(addr);
+  if (bind(m_wakeup, (sockaddr*)&addr, sizeof(addr)) < 0 ||
+      getsockname(m_wakeup, (sockaddr*)&addr, &len) < 0 ||
+      connect(m_wakeup, (sockaddr*)&addr, sizeof(addr)) < 0 ||
+      !SetNonBlocking(m_wakeup))
+  {
+    closesocket(m_wakeup);
+    m_wakeup = INVALID_SOCKET;
+  }
+}
+
+CTCPServer::CSocketPoller::~CSocketPoller()
+{
+  if (m_wakeup != INVALID_SOCKET)
+    closesocket(m_wakeup);
+}
+
+bool CTCPServer::CSocketPoller::IsValid() const
+{
+  return m_wakeup != INVALID_SOCKET;
+}
+
+void CTCPServer::CSocketPoller::Add(SOCKET socket)
+{
+  CSingleLock lock(m_section);
+  m_sockets[socket] = false;
+}
+
+void CTCPServer::CSocketPoller::Remove(SOCKET socket)
+{
+  CSingleLock lock(m_section);
+  m_sockets.erase(socket);
+}
+
+void CTCPServer::CSocketPoller::SetWantWrite(SOCKET socket, bool wantWrite)
+{
+  CSingleLock lock(m_section);
+  std::map<SOCKET, bool>::iterator it = m_sockets.find(socket);
+  if (it == m_sockets.end() || it->second == wantWrite)
+    return;
+
+  it->second = wantWrite;
+  if (wantWrite)
+    Wakeup();
+}
+
+void CTCPServer::CSocketPoller::Wakeup()
+{
+  char c = 0;
+  send(m_wakeup, &c, 1, 0);
+}
+
+bool CTCPServer::CSocketPoller::Wait(int timeoutMs, std::vector<Event>& events)
+{
+  SOCKET max_fd = m_wakeup;
+  fd_set rfds, wfds;
+  FD_ZERO(&rfds);
+  FD_ZERO(&wfds);
+  FD_SET(m_wakeup, &rfds);
+
+  {
+    CSingleLock lock(m_section);
+    for (std::map<SOCKET, bool>::const_iterator it = m_sockets.begin(); it != m_sockets.end(); ++it)
+    {
+      FD_SET(it->first, &rfds);
+      if (it->second)
+        FD_SET(it->first, &wfds);
+      if ((intptr_t)it->first > (intptr_t)max_fd)
+        max_fd = it->first;
+    }
+  }
+
+  struct timeval to = { timeoutMs / 1000, (timeoutMs % 1000) * 1000 };
+  int res = select((intptr_t)max_fd + 1, &rfds, &wfds, NULL, &to);
+  if (res < 0)
+    return WouldBlock();
+
+  if (FD_ISSET(m_wakeup, &rfds))
+  {
+    char buffer[64];
+    while (recv(m_wakeup, buffer, sizeof(buffer), 0) > 0)
+      ;
+  }
+
+  CSingleLock lock(m_section);
+  for (std::map<SOCKET, bool>::const_iterator it = m_sockets.begin(); it != m_sockets.end(); ++it)
+  {
+    Event event;
+    event.socket = it->first;
+    event.readable = FD_ISSET(it->first, &rfds) != 0;
+    event.writable = FD_ISSET(it->first, &wfds) != 0;
+    if (event.readable || event.writable)
+      events.push_back(event);
+  }
+  return true;
+}
+#endif
+
+/*!
+ * Executes the requests of a client in the order they were received. A job
+ * executes one request and queues a new job for the next one, so that the
+ * requests of other clients get their turn in between.
+ */
+class CTCPServer::CRequestJob : public CJob
+{
+public:
+  CRequestJob(CTCPServer *server, const ClientPtr& client)
+    : m_server(server),
+      m_client(client)
+  {
+    CSingleLock lock(m_server->m_jobsSection);
+    if (m_server->m_pendingJobs++ == 0)
+      m_server->m_jobsDone.Reset();
+  }
+
+  ~CRequestJob() override
+  {
+    CSingleLock lock(m_server->m_jobsSection);
+    if (--m_server->m_pendingJobs == 0)
+      m_server->m_jobsDone.Set();
+  }
+
+  const char *GetType() const override { return "jsonrpc-request"; }
+
+  bool DoWork() override
+  {
+    std::string request;
+    if (m_client->PopRequest(request))
+    {
+      CVariant response;
+      if (CJSONRPC::MethodCall(request, m_server, m_client.get(), response))
+        m_client->SendResponse(response);
+    }
+
+    if (m_client->HasPendingRequests())
+      m_server->ScheduleRequests(m_client);
+    return true;
+  }
+
+private:
+  CTCPServer *m_server;
+  ClientPtr m_client;
+};
 
 CTCPServer *CTCPServer::ServerInstance = NULL;
 
@@ -81,6 +386,7 @@ bool CTCPServer::StartServer(int port, bool nonlocal)
     // double the stack size under tvos, not sure why yet
     // but it stoped crashing using Kodi json -> play video.
     // non-tvos will pass a value of zero which means 'system default'
+    // the job workers executing the method calls get the same, see CJobWorker
     thread_stacksize *= 2;
   CLog::Log(LOGDEBUG, "CTCPServer: increasing thread stack to %zu", thread_stacksize);
 #endif
@@ -112,118 +418,76 @@ bool CTCPServer::IsRunning()
   return ((CThread*)ServerInstance)->IsRunning();
 }
 
-CTCPServer::CTCPServer(int port, bool nonlocal) : CThread("TCPServer")
+int CTCPServer::GetPort()
+{
+  if (ServerInstance == NULL)
+    return 0;
+
+  return ServerInstance->m_port;
+}
+
+
+CTCPServer::CTCPServer(int port, bool nonlocal)
+  : CThread("TCPServer"),
+    m_requestQueue(false, MAX_CONCURRENT_REQUESTS, CJob::PRIORITY_DEDICATED),
+    m_jobsDone(true, true)
 {
   m_port = port;
   m_nonlocal = nonlocal;
   m_sdpd = NULL;
+  m_pendingJobs = 0;
+  m_bStopping = false;
+}
+
+CTCPServer::~CTCPServer()
+{
+  Deinitialize();
 }
 
 void CTCPServer::Process()
 {
   m_bStop = false;
 
+  std::vector<CSocketPoller::Event> events;
   while (!m_bStop)
   {
-    SOCKET          max_fd = 0;
-    fd_set          rfds;
-    struct timeval  to     = {1, 0};
-    FD_ZERO(&rfds);
-
-    for (std::vector<SOCKET>::iterator it = m_servers.begin(); it != m_servers.end(); ++it)
-    {
-      FD_SET(*it, &rfds);
-      if ((intptr_t)*it > (intptr_t)max_fd)
-        max_fd = *it;
-    }
-
-    for (unsigned int i = 0; i < m_connections.size(); i++)
-    {
-      FD_SET(m_connections[i]->m_socket, &rfds);
-      if ((intptr_t)m_connections[i]->m_socket > (intptr_t)max_fd)
-        max_fd = m_connections[i]->m_socket;
-    }
-
-    int res = select((intptr_t)max_fd+1, &rfds, NULL, NULL, &to);
-    if (res < 0)
+    events.clear();
+    if (!m_poller || !m_poller->Wait(1000, events))
     {
-      CLog::Log(LOGERROR, "JSONRPC Server: Select failed");
+      CLog::Log(LOGERROR, "JSONRPC Server: Waiting for socket events failed");
       Sleep(1000);
       Initialize();
+      continue;
     }
-    else if (res > 0)
+
+    for (std::vector<CSocketPoller::Event>::const_iterator event = events.begin(); event != events.end(); ++event)
     {
-      for (int i = m_connections.size() - 1; i >= 0; i--)
+      if (std::find(m_servers.begin(), m_servers.end(), event->socket) != m_servers.end())
       {
-        int socket = m_connections[i]->m_socket;
-        if (FD_ISSET(socket, &rfds))
+        if (!AcceptConnection(event->socket))
         {
-          char buffer[RECEIVEBUFFER] = {};
-          int  nread = 0;
-          nread = recv(socket, (char*)&buffer, RECEIVEBUFFER, 0);
-          bool close = false;
-          if (nread > 0)
-          {
-            std::string response;
-            if (m_connections[i]->IsNew())
-            {
-              CWebSocket *websocket = CWebSocketManager::Handle(buffer, nread, response);
-
-              if (!response.empty())
-                m_connections[i]->Send(response.c_str(), response.size());
-
-              if (websocket != NULL)
-              {
-                // Replace the CTCPClient with a CWebSocketClient
-                CWebSocketClient *websocketClient = new CWebSocketClient(websocket, *(m_connections[i]));
-                delete m_connections[i];
-                m_connections.erase(m_connections.begin() + i);
-                m_connections.insert(m_connections.begin() + i, websocketClient);
-              }
-            }
-
-            if (response.size() <= 0)
-              m_connections[i]->PushBuffer(this, buffer, nread);
-
-            close = m_connections[i]->Closing();
-          }
-          else
-            close = true;
-
-          if (close)
-          {
-            CLog::Log(LOGINFO, "JSONRPC Server: Disconnection detected");
-            m_connections[i]->Disconnect();
-            delete m_connections[i];
-            m_connections.erase(m_connections.begin() + i);
-          }
+          Sleep(1000);
+          Initialize();
+          break;
         }
+        continue;
       }
 
-      for (std::vector<SOCKET>::iterator it = m_servers.begin(); it != m_servers.end(); ++it)
+      std::map<SOCKET, ClientPtr>::iterator it = m_connections.find(event->socket);
+      if (it == m_connections.end())
+        continue;
+
+      ClientPtr client = it->second;
+      bool close = false;
+      if (event->writable)
+        close = !client->Flush();
+      if (!close && event->readable)
+        close = !ReadFromClient(client);
+
+      if (close)
       {
-        if (FD_ISSET(*it, &rfds))
-        {
-          CLog::Log(LOGDEBUG, "JSONRPC Server: New connection detected");
-          CTCPClient *newconnection = new CTCPClient();
-          newconnection->m_socket = accept(*it, (sockaddr*)&newconnection->m_cliaddr, &newconnection->m_addrlen);
-
-          if (newconnection->m_socket == INVALID_SOCKET)
-          {
-            CLog::Log(LOGERROR, "JSONRPC Server: Accept of new connection failed: %d", errno);
-            if (EBADF == errno)
-            {
-              Sleep(1000);
-              Initialize();
-              break;
-            }
-          }
-          else
-          {
-            CLog::Log(LOGINFO, "JSONRPC Server: New connection added");
-            m_connections.push_back(newconnection);
-          }
-        }
+        CLog::Log(LOGINFO, "JSONRPC Server: Disconnection detected");
+        RemoveClient(event->socket);
       }
     }
   }
@@ -231,6 +495,108 @@ void CTCPServer::Process()
   Deinitialize();
 }
 
+bool CTCPServer::AcceptConnection(SOCKET server)
+{
+  // the listening socket is non-blocking, accept all pending connections
+  while (true)
+  {
+    ClientPtr newconnection = std::make_shared<CTCPClient>();
+    newconnection->m_socket = accept(server, (sockaddr*)&newconnection->m_cliaddr, &newconnection->m_addrlen);
+
+    if (newconnection->m_socket == INVALID_SOCKET)
+    {
+      if (WouldBlock())
+        return true;
+
+      CLog::Log(LOGERROR, "JSONRPC Server: Accept of new connection failed: %d", errno);
+      return EBADF != errno;
+    }
+
+    if (!SetNonBlocking(newconnection->m_socket))
+    {
+      CLog::Log(LOGERROR, "JSONRPC Server: Failed to set the new connection non-blocking");
+      closesocket(newconnection->m_socket);
+      continue;
+    }
+
+    CLog::Log(LOGINFO, "JSONRPC Server: New connection added");
+    newconnection->m_server = this;
+    {
+      CSingleLock lock(m_connectionsSection);
+      m_connections[newconnection->m_socket] = newconnection;
+    }
+    m_poller->Add(newconnection->m_socket);
+  }
+}
+
+bool CTCPServer::ReadFromClient(ClientPtr& client)
+{
+  for (int reads = 0; reads < MAX_READS_PER_EVENT; reads++)
+  {
+    char buffer[RECEIVEBUFFER];
+    int nread = recv(client->m_socket, (char*)&buffer, RECEIVEBUFFER, 0);
+    if (nread == 0)
+      return false;
+    if (nread < 0)
+      return WouldBlock();
+
+    std::string response;
+    if (client->IsNew())
+    {
+      CWebSocket *websocket = CWebSocketManager::Handle(buffer, nread, response);
+
+      if (websocket != NULL)
+      {
+        // Replace the CTCPClient with a CWebSocketClient
+        ClientPtr websocketClient = std::make_shared<CWebSocketClient>(websocket, *client);
+        CSingleLock lock(m_connectionsSection);
+        m_connections[client->m_socket] = websocketClient;
+        client = websocketClient;
+      }
+
+      if (!response.empty())
+        client->Send(response.c_str(), response.size());
+    }
+
+    if (response.size() <= 0)
+      client->PushBuffer(this, buffer, nread);
+
+    if (client->Closing())
+      return false;
+  }
+
+  return true;
+}
+
+void CTCPServer::RemoveClient(SOCKET socket)
+{
+  CSingleLock lock(m_connectionsSection);
+  std::map<SOCKET, ClientPtr>::iterator it = m_connections.find(socket);
+  if (it == m_connections.end())
+    return;
+
+  m_poller->Remove(socket);
+  it->second->Disconnect();
+  m_connections.erase(it);
+}
+
+void CTCPServer::ScheduleRequests(const ClientPtr& client)
+{
+  {
+    CSingleLock lock(m_jobsSection);
+    if (m_bStopping)
+      return;
+  }
+
+  m_requestQueue.AddJob(new CRequestJob(this, client));
+}
+
+void CTCPServer::SetWantWrite(SOCKET socket, bool wantWrite)
+{
+  if (m_poller)
+    m_poller->SetWantWrite(socket, wantWrite);
+}
+
 bool CTCPServer::PrepareDownload(const char *path, CVariant &details, std::string &protocol)
 {
   return false;
@@ -248,17 +614,22 @@ int CTCPServer::GetCapabilities()
 
 void CTCPServer::Announce(AnnouncementFlag flag, const char *sender, const char *message, const CVariant &data)
 {
-  std::string str = IJSONRPCAnnouncer::AnnouncementToJSONRPC(flag, sender, message, data, g_advancedSettings.m_jsonOutputCompact);
-
-  for (unsigned int i = 0; i < m_connections.size(); i++)
+  // serialize once, all clients queue the same buffer
+  CAnnouncement announcement;
+  announcement.message = std::make_shared<const std::string>(IJSONRPCAnnouncer::AnnouncementToJSONRPC(flag, sender, message, data, g_advancedSettings.m_jsonOutputCompact));
+  announcement.replaceable = IJSONRPCAnnouncer::GetAnnouncementItem(flag, message, data, announcement.item, announcement.fields);
+  announcement.droppable = IJSONRPCAnnouncer::IsAnnouncementDroppable(message);
+
+  CSingleLock connectionsLock(m_connectionsSection);
+  for (std::map<SOCKET, ClientPtr>::const_iterator it = m_connections.begin(); it != m_connections.end(); ++it)
   {
     {
-      CSingleLock lock (m_connections[i]->m_critSection);
-      if ((m_connections[i]->GetAnnouncementFlags() & flag) == 0)
+      CSingleLock lock (it->second->m_critSection);
+      if ((it->second->GetAnnouncementFlags() & flag) == 0)
         continue;
     }
 
-    m_connections[i]->Send(str.c_str(), str.size());
+    it->second->Announce(announcement);
   }
 }
 
@@ -273,6 +644,20 @@ bool CTCPServer::Initialize()
 
   if (started)
   {
+    m_poller.reset(new CSocketPoller());
+    if (!m_poller->IsValid())
+    {
+      CLog::Log(LOGERROR, "JSONRPC Server: Failed to create the socket poller");
+      Deinitialize();
+      return false;
+    }
+
+    for (std::vector<SOCKET>::const_iterator it = m_servers.begin(); it != m_servers.end(); ++it)
+    {
+      SetNonBlocking(*it);
+      m_poller->Add(*it);
+    }
+
     CAnnouncementManager::GetInstance().AddAnnouncer(this);
     CLog::Log(LOGINFO, "JSONRPC Server: Successfully initialized");
     return true;
@@ -472,41 +857,64 @@ bool CTCPServer::InitializeBlue()
 }
 #endif
 
+
 bool CTCPServer::InitializeTCP()
 {
   SOCKET fd;
 
   Deinitialize();
 
-  if ((fd = CreateTCPServerSocket(m_port, !m_nonlocal, 10, "JSONRPC")) == INVALID_SOCKET)
+  if ((fd = CreateTCPServerSocket(m_port, !m_nonlocal, LISTEN_BACKLOG, "JSONRPC")) == INVALID_SOCKET)
     return false;
 
+  // keep the port assigned by the system, a reinitialization binds the same one
+  if (m_port == 0)
+  {
+    sockaddr_storage addr;
+    socklen_t len = sizeof(addr);
+    if (getsockname(fd, (sockaddr*)&addr, &len) == 0)
+      m_port = ntohs(addr.ss_family == AF_INET6 ? ((sockaddr_in6*)&addr)->sin6_port : ((sockaddr_in*)&addr)->sin_port);
+  }
+
   m_servers.push_back(fd);
   return true;
 }
 
 void CTCPServer::Deinitialize()
 {
-  for (unsigned int i = 0; i < m_connections.size(); i++)
+  CAnnouncementManager::GetInstance().RemoveAnnouncer(this);
+
   {
-    m_connections[i]->Disconnect();
-    delete m_connections[i];
+    CSingleLock lock(m_connectionsSection);
+    for (std::map<SOCKET, ClientPtr>::iterator it = m_connections.begin(); it != m_connections.end(); ++it)
+      it->second->Disconnect();
+
+    m_connections.clear();
   }
 
-  m_connections.clear();
+  // running requests can't send anymore, wait for them so that no job outlives the server
+  {
+    CSingleLock lock(m_jobsSection);
+    m_bStopping = true;
+  }
+  m_requestQueue.CancelJobs();
+  m_jobsDone.Wait();
+  {
+    CSingleLock lock(m_jobsSection);
+    m_bStopping = false;
+  }
 
   for (unsigned int i = 0; i < m_servers.size(); i++)
     closesocket(m_servers[i]);
 
   m_servers.clear();
+  m_poller.reset();
 
 #ifdef HAVE_LIBBLUETOOTH
   if (m_sdpd)
     sdp_close((sdp_session_t*)m_sdpd);
   m_sdpd = NULL;
 #endif
-
-  CAnnouncementManager::GetInstance().RemoveAnnouncer(this);
 }
 
 CTCPServer::CTCPClient::CTCPClient()
@@ -514,10 +922,19 @@ CTCPServer::CTCPClient::CTCPClient()
   m_new = true;
   m_announcementflags = ANNOUNCE_ALL;
   m_socket = INVALID_SOCKET;
+  m_server = NULL;
   m_beginBrackets = 0;
   m_endBrackets = 0;
   m_beginChar = 0;
   m_endChar = 0;
+  m_processing = false;
+  m_sendSequence = 0;
+  m_sendOffset = 0;
+  m_queuedBytes = 0;
+  m_droppedAnnouncements = 0;
+  m_wantWrite = false;
+  m_streaming = false;
+  m_heldBytes = 0;
 
   m_addrlen = sizeof(m_cliaddr);
 }
@@ -551,12 +968,221 @@ bool CTCPServer::CTCPClient::SetAnnouncementFlags(int flags)
 
 void CTCPServer::CTCPClient::Send(const char *data, unsigned int size)
 {
-  unsigned int sent = 0;
-  do
+  CTCPClient::Send(std::make_shared<const std::string>(data, size));
+}
+
+void CTCPServer::CTCPClient::Send(const BufferPtr& buffer)
+{
+  Queue(buffer);
+}
+
+void CTCPServer::CTCPClient::SendResponse(const CVariant& response)
+{
+  CJSONVariantChunkedWriter writer(response, g_advancedSettings.m_jsonOutputCompact, STREAM_CHUNK_SIZE);
+  std::string chunk;
+  if (!writer.Next(chunk) || chunk.empty())
+    return;
+
+  // most responses fit into a single chunk
+  if (writer.IsComplete())
+  {
+    Send(std::make_shared<const std::string>(std::move(chunk)));
+    return;
+  }
+
   {
     CSingleLock lock (m_critSection);
-    sent += send(m_socket, data + sent, size - sent, 0);
-  } while (sent < size);
+    m_streaming = true;
+  }
+
+  bool failed = false;
+  while (true)
+  {
+    Send(std::make_shared<const std::string>(std::move(chunk)));
+    if (writer.IsComplete())
+      break;
+
+    if (!WaitForSendBacklog() || !writer.Next(chunk))
+    {
+      failed = true;
+      break;
+    }
+  }
+
+  std::vector<CAnnouncement> heldAnnouncements;
+  {
+    CSingleLock lock (m_critSection);
+    m_streaming = false;
+    heldAnnouncements.swap(m_heldAnnouncements);
+    m_heldBytes = 0;
+
+    // the client can't tell where the incomplete response ends
+    if (failed && m_socket != INVALID_SOCKET)
+    {
+      CLog::Log(LOGERROR, "JSONRPC Server: Failed to send a response, disconnecting");
+      shutdown(m_socket, SHUT_RDWR);
+      ClearQueue();
+      return;
+    }
+  }
+
+  for (std::vector<CAnnouncement>::iterator it = heldAnnouncements.begin(); it != heldAnnouncements.end(); ++it)
+    Queue(it->message, &*it);
+}
+
+bool CTCPServer::CTCPClient::WaitForSendBacklog()
+{
+  XbmcThreads::EndTime timeout(STREAM_SEND_TIMEOUT);
+  while (true)
+  {
+    {
+      CSingleLock lock (m_critSection);
+      if (m_socket == INVALID_SOCKET)
+        return false;
+      if (m_queuedBytes <= MAX_STREAM_BACKLOG)
+        return true;
+      m_sendDrained.Reset();
+    }
+
+    if (!m_sendDrained.WaitMSec(timeout.MillisLeft()))
+    {
+      CLog::Log(LOGERROR, "JSONRPC Server: Client doesn't read its response");
+      return false;
+    }
+  }
+}
+
+void CTCPServer::CTCPClient::Announce(CAnnouncement& announcement)
+{
+  CSingleLock lock (m_critSection);
+  if (m_streaming)
+  {
+    // announcements can't be sent in the middle of a response
+    if (announcement.droppable && m_heldBytes + announcement.message->size() > MAX_ANNOUNCEMENT_BACKLOG)
+    {
+      if (m_droppedAnnouncements++ == 0)
+        CLog::Log(LOGWARNING, "JSONRPC Server: Client doesn't keep up, dropping announcements");
+      return;
+    }
+
+    m_heldAnnouncements.push_back(announcement);
+    m_heldBytes += announcement.message->size();
+    return;
+  }
+
+  Queue(announcement.message, &announcement);
+}
+
+void CTCPServer::CTCPClient::Queue(const BufferPtr& buffer, const CAnnouncement *announcement /* = NULL */)
+{
+  CSingleLock lock (m_critSection);
+  if (m_socket == INVALID_SOCKET || buffer->empty())
+    return;
+
+  const std::string item = announcement ? announcement->item : "";
+  const std::string fields = announcement ? announcement->fields : "";
+  const bool replaceable = announcement && announcement->replaceable;
+  if (replaceable)
+  {
+    // only the latest queued announcement about the item can be replaced, unless it is partially sent
+    std::map<std::string, uint64_t>::const_iterator latest = m_queuedItems.find(item);
+    if (latest != m_queuedItems.end() && (latest->second > m_sendSequence || m_sendOffset == 0))
+    {
+      CQueuedBuffer &queued = m_sendQueue[latest->second - m_sendSequence];
+      if (queued.replaceable && queued.fields == fields)
+      {
+        m_queuedBytes = m_queuedBytes - queued.buffer->size() + buffer->size();
+        queued.buffer = buffer;
+        return;
+      }
+    }
+  }
+
+  if (announcement && announcement->droppable && m_queuedBytes + buffer->size() > MAX_ANNOUNCEMENT_BACKLOG)
+  {
+    if (m_droppedAnnouncements++ == 0)
+      CLog::Log(LOGWARNING, "JSONRPC Server: Client doesn't keep up, dropping announcements");
+    return;
+  }
+
+  if (m_queuedBytes + buffer->size() > MAX_SEND_BACKLOG)
+  {
+    // the server thread removes the client once it sees the connection closed
+    CLog::Log(LOGERROR, "JSONRPC Server: Client doesn't read its responses, disconnecting");
+    shutdown(m_socket, SHUT_RDWR);
+    ClearQueue();
+    return;
+  }
+
+  if (!item.empty())
+    m_queuedItems[item] = m_sendSequence + m_sendQueue.size();
+  CQueuedBuffer queued = { buffer, item, fields, replaceable };
+  m_sendQueue.push_back(queued);
+  m_queuedBytes += buffer->size();
+  // if older data is still queued the socket is full, the server thread continues once it's writable
+  if (m_sendQueue.size() == 1)
+    Flush();
+}
+
+bool CTCPServer::CTCPClient::Flush()
+{
+  CSingleLock lock (m_critSection);
+  while (!m_sendQueue.empty())
+  {
+    if (m_socket == INVALID_SOCKET)
+    {
+      ClearQueue();
+      return false;
+    }
+
+    const std::string &buffer = *m_sendQueue.front().buffer;
+    int sent = send(m_socket, buffer.c_str() + m_sendOffset, buffer.size() - m_sendOffset, MSG_NOSIGNAL);
+    if (sent < 0)
+    {
+      if (!WouldBlock())
+      {
+        ClearQueue();
+        return false;
+      }
+
+      if (!m_wantWrite && m_server)
+      {
+        m_wantWrite = true;
+        m_server->SetWantWrite(m_socket, true);
+      }
+      return true;
+    }
+
+    m_sendOffset += sent;
+    if (m_sendOffset == buffer.size())
+    {
+      const CQueuedBuffer &sent = m_sendQueue.front();
+      std::map<std::string, uint64_t>::iterator latest = m_queuedItems.find(sent.item);
+      if (latest != m_queuedItems.end() && latest->second == m_sendSequence)
+        m_queuedItems.erase(latest);
+
+      m_queuedBytes -= buffer.size();
+      m_sendOffset = 0;
+      m_sendSequence++;
+      m_sendQueue.pop_front();
+
+      if (m_streaming && m_queuedBytes <= MAX_STREAM_BACKLOG)
+        m_sendDrained.Set();
+    }
+  }
+
+  if (m_droppedAnnouncements > 0)
+  {
+    CLog::Log(LOGWARNING, "JSONRPC Server: Client caught up, %u announcements were dropped", m_droppedAnnouncements);
+    m_droppedAnnouncements = 0;
+  }
+
+  if (m_wantWrite && m_server)
+  {
+    m_wantWrite = false;
+    m_server->SetWantWrite(m_socket, false);
+  }
+  return true;
 }
 
 void CTCPServer::CTCPClient::PushBuffer(CTCPServer *host, const char *buffer, int length)
@@ -587,8 +1213,7 @@ void CTCPServer::CTCPClient::PushBuffer(CTCPServer *host, const char *buffer, in
         m_endBrackets++;
       if (m_beginBrackets > 0 && m_endBrackets > 0 && m_beginBrackets == m_endBrackets)
       {
-        std::string line = CJSONRPC::MethodCall(m_buffer, host, this);
-        Send(line.c_str(), line.size());
+        QueueRequest(host, std::move(m_buffer));
         m_beginChar = m_beginBrackets = m_endBrackets = 0;
         m_buffer.clear();
       }
@@ -596,29 +1221,88 @@ void CTCPServer::CTCPClient::PushBuffer(CTCPServer *host, const char *buffer, in
   }
 }
 
+void CTCPServer::CTCPClient::QueueRequest(CTCPServer *host, std::string&& request)
+{
+  {
+    CSingleLock lock (m_critSection);
+    m_requests.push(std::move(request));
+    // a job is already executing the requests of this client, it takes this one next
+    if (m_processing)
+      return;
+    m_processing = true;
+  }
+
+  host->ScheduleRequests(shared_from_this());
+}
+
+bool CTCPServer::CTCPClient::PopRequest(std::string& request)
+{
+  CSingleLock lock (m_critSection);
+  if (m_requests.empty())
+    return false;
+
+  request = std::move(m_requests.front());
+  m_requests.pop();
+  return true;
+}
+
+bool CTCPServer::CTCPClient::HasPendingRequests()
+{
+  CSingleLock lock (m_critSection);
+  if (m_requests.empty())
+    m_processing = false;
+  return m_processing;
+}
+
 void CTCPServer::CTCPClient::Disconnect()
 {
   if (m_socket > 0)
   {
     CSingleLock lock (m_critSection);
+    // best effort to deliver what is still queued, e.g. a websocket close frame
+    Flush();
     shutdown(m_socket, SHUT_RDWR);
     closesocket(m_socket);
     m_socket = INVALID_SOCKET;
+    ClearQueue();
   }
 }
 
+void CTCPServer::CTCPClient::ClearQueue()
+{
+  m_sendSequence += m_sendQueue.size();
+  m_sendQueue.clear();
+  m_queuedItems.clear();
+  m_sendOffset = 0;
+  m_queuedBytes = 0;
+  m_sendDrained.Set();
+}
+
 void CTCPServer::CTCPClient::Copy(const CTCPClient& client)
 {
   m_new               = client.m_new;
   m_socket            = client.m_socket;
   m_cliaddr           = client.m_cliaddr;
   m_addrlen           = client.m_addrlen;
+  m_server            = client.m_server;
   m_announcementflags = client.m_announcementflags;
   m_beginBrackets     = client.m_beginBrackets;
   m_endBrackets       = client.m_endBrackets;
   m_beginChar         = client.m_beginChar;
   m_endChar           = client.m_endChar;
   m_buffer            = client.m_buffer;
+  m_requests          = client.m_requests;
+  m_processing        = client.m_processing;
+  m_sendQueue         = client.m_sendQueue;
+  m_queuedItems       = client.m_queuedItems;
+  m_sendSequence      = client.m_sendSequence;
+  m_sendOffset        = client.m_sendOffset;
+  m_queuedBytes       = client.m_queuedBytes;
+  m_droppedAnnouncements = client.m_droppedAnnouncements;
+  m_wantWrite         = client.m_wantWrite;
+  m_streaming         = client.m_streaming;
+  m_heldAnnouncements = client.m_heldAnnouncements;
+  m_heldBytes         = client.m_heldBytes;
 }
 
 CTCPServer::CWebSocketClient::CWebSocketClient(CWebSocket *websocket)
@@ -652,44 +1336,63 @@ CTCPServer::CWebSocketClient& CTCPServer::CWebSocketClient::operator=(const CWeb
   return *this;
 }
 
-void CTCPServer::CWebSocketClient::Send(const char *data, unsigned int size)
+void CTCPServer::CWebSocketClient::Send(const BufferPtr& buffer)
 {
-  const CWebSocketMessage *msg = m_websocket->Send(WebSocketTextFrame, data, size);
-  if (msg == NULL || !msg->IsComplete())
-    return;
+  BufferPtr frame = Frame(buffer);
+  if (frame)
+    Queue(frame);
+}
 
-  std::vector<const CWebSocketFrame *> frames = msg->GetFrames();
-  for (unsigned int index = 0; index < frames.size(); index++)
-    CTCPClient::Send(frames.at(index)->GetFrameData(), (unsigned int)frames.at(index)->GetFrameLength());
+void CTCPServer::CWebSocketClient::SendResponse(const CVariant& response)
+{
+  // a response is a single websocket message, it's framed as a whole
+  std::string message;
+  if (CJSONVariantWriter::Write(response, message, g_advancedSettings.m_jsonOutputCompact) && !message.empty())
+    Send(std::make_shared<const std::string>(std::move(message)));
 }
 
-void CTCPServer::CWebSocketClient::PushBuffer(CTCPServer *host, const char *buffer, int length)
+void CTCPServer::CWebSocketClient::Announce(CAnnouncement& announcement)
+{
+  // frames sent by the server aren't masked and are compressed without context takeover,
+  // so all websocket clients with the same compression can share them
+  BufferPtr& frame = m_websocket->IsCompressing() ? announcement.compressedWebsocketFrame : announcement.websocketFrame;
+  if (!frame)
+    frame = Frame(announcement.message);
+
+  if (frame)
+    Queue(frame, &announcement);
+}
+
+CTCPServer::BufferPtr CTCPServer::CWebSocketClient::Frame(const BufferPtr& buffer)
 {
-  bool send;
-  const CWebSocketMessage *msg = NULL;
-  size_t len = length;
-  do
+  std::string frames;
   {
-    if ((msg = m_websocket->Handle(buffer, len, send)) != NULL && msg->IsComplete())
-    {
-      std::vector<const CWebSocketFrame *> frames = msg->GetFrames();
-      if (send)
-      {
-        for (unsigned int index = 0; index < frames.size(); index++)
-          Send(frames.at(index)->GetFrameData(), (unsigned int)frames.at(index)->GetFrameLength());
-      }
-      else
-      {
-        for (unsigned int index = 0; index < frames.size(); index++)
-          CTCPClient::PushBuffer(host, frames.at(index)->GetApplicationData(), (int)frames.at(index)->GetLength());
-      }
+    CSingleLock lock (m_critSection);
+    if (!m_websocket->Frame(WebSocketTextFrame, buffer->c_str(), buffer->size(), frames))
+      return BufferPtr();
+  }
 
-      delete msg;
-    }
+  return std::make_shared<const std::string>(std::move(frames));
+}
+
+void CTCPServer::CWebSocketClient::PushBuffer(CTCPServer *host, const char *buffer, int length)
+{
+  std::vector<std::string> messages;
+  std::string response;
+  bool success;
+  {
+    CSingleLock lock (m_critSection);
+    success = m_websocket->Receive(buffer, length, messages, response);
   }
-  while (len > 0 && msg != NULL);
 
-  if (m_websocket->GetState() == WebSocketStateClosed)
+  // control frames like pong and close are ready to send
+  if (!response.empty())
+    CTCPClient::Send(response.c_str(), response.size());
+
+  for (std::vector<std::string>::const_iterator message = messages.begin(); message != messages.end(); ++message)
+    CTCPClient::PushBuffer(host, message->c_str(), (int)message->size());
+
+  if (!success || m_websocket->GetState() == WebSocketStateClosed)
     Disconnect();
 }
 
@@ -697,15 +1400,18 @@ void CTCPServer::CWebSocketClient::Disconnect()
 {
   if (m_socket > 0)
   {
+    CSingleLock lock (m_critSection);
     if (m_websocket->GetState() != WebSocketStateClosed && m_websocket->GetState() != WebSocketStateNotConnected)
     {
       const CWebSocketFrame *closeFrame = m_websocket->Close();
       if (closeFrame)
-        Send(closeFrame->GetFrameData(), (unsigned int)closeFrame->GetFrameLength());
+      {
+        CTCPClient::Send(closeFrame->GetFrameData(), (unsigned int)closeFrame->GetFrameLength());
+        delete closeFrame;
+      }
     }
 
     if (m_websocket->GetState() == WebSocketStateClosed)
       CTCPClient::Disconnect();
   }
 }
-
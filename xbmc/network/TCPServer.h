@@ -19,6 +19,11 @@
  *
  */
 
+#include <deque>
+#include <map>
+#include <memory>
+#include <queue>
+#include <string>
 #include <vector>
 #include <sys/socket.h>
 
@@ -27,19 +32,40 @@
 #include "interfaces/json-rpc/IJSONRPCAnnouncer.h"
 #include "interfaces/json-rpc/ITransportLayer.h"
 #include "threads/CriticalSection.h"
+#include "threads/Event.h"
 #include "threads/Thread.h"
+#include "utils/JobManager.h"
 #include "websocket/WebSocket.h"
 
 class CVariant;
 
 namespace JSONRPC
 {
+  /*!
+   * @brief JSON-RPC over raw TCP, bluetooth and WebSocket connections.
+   *
+   * A single thread waits for socket events (epoll on linux, select elsewhere)
+   * on non-blocking sockets, reads the incoming data and splits it into
+   * requests. The requests are executed by a bounded pool of jobs, so a slow
+   * method call of one client doesn't block the others. The requests of a
+   * client are executed one at a time, in the order they were received.
+   * Responses and announcements are queued per client and written as far as
+   * the socket accepts them, the event thread writes the rest once the socket
+   * is writable again. Responses to raw TCP clients are written as JSON in
+   * chunks, the next chunk is only written once the client read most of the
+   * queued data.
+   */
   class CTCPServer : public ITransportLayer, public JSONRPC::IJSONRPCAnnouncer, public CThread
   {
   public:
     static bool StartServer(int port, bool nonlocal);
     static void StopServer(bool bWait);
     static bool IsRunning();
+    /*!
+     * @brief The port the server listens on.
+     * @return the port assigned by the system if the server was started with port 0, 0 if it isn't running.
+     */
+    static int GetPort();
 
     bool PrepareDownload(const char *path, CVariant &details, std::string &protocol) override;
     bool Download(const char *path, CVariant &result) override;
@@ -50,12 +76,31 @@ namespace JSONRPC
     void Process() override;
   private:
     CTCPServer(int port, bool nonlocal);
+    ~CTCPServer() override;
     bool Initialize();
     bool InitializeBlue();
     bool InitializeTCP();
     void Deinitialize();
 
-    class CTCPClient : public IClient
+    class CSocketPoller;
+    class CRequestJob;
+    typedef std::shared_ptr<const std::string> BufferPtr;
+
+    /*!
+     * @brief An announcement, serialized once for all clients.
+     */
+    struct CAnnouncement
+    {
+      BufferPtr message;                  // the JSON-RPC notification
+      BufferPtr websocketFrame;           // the notification framed for websocket clients, created on demand
+      BufferPtr compressedWebsocketFrame; // the same for websocket clients using permessage-deflate
+      std::string item;                   // the library item it is about, see IJSONRPCAnnouncer::GetAnnouncementItem
+      std::string fields;                 // the data members of a replaceable update
+      bool replaceable;                   // replaces an update of the same item with the same fields that wasn't sent yet
+      bool droppable;                     // may be dropped if the client doesn't keep up
+    };
+
+    class CTCPClient : public IClient, public std::enable_shared_from_this<CTCPClient>
     {
     public:
       CTCPClient();
@@ -69,26 +114,91 @@ namespace JSONRPC
       int GetAnnouncementFlags() override;
       bool SetAnnouncementFlags(int flags) override;
 
-      virtual void Send(const char *data, unsigned int size);
+      /*!
+       * @brief Queue data to send as is, also bypassing the websocket framing.
+       */
+      void Send(const char *data, unsigned int size);
+      /*!
+       * @brief Queue a response or announcement, the buffer may be shared by several clients.
+       */
+      virtual void Send(const BufferPtr& buffer);
+      /*!
+       * @brief Write and queue a response in chunks while the client reads it.
+       * Announcements are held back until the response is complete.
+       */
+      virtual void SendResponse(const CVariant& response);
+      /*!
+       * @brief Queue an announcement. Announcements are dropped while the
+       * client doesn't read what was already queued.
+       */
+      virtual void Announce(CAnnouncement& announcement);
       virtual void PushBuffer(CTCPServer *host, const char *buffer, int length);
       virtual void Disconnect();
 
       virtual bool IsNew() const { return m_new; }
       virtual bool Closing() const { return false; }
 
+      /*!
+       * @brief Write queued data until the socket would block.
+       * @return false if the connection failed.
+       */
+      bool Flush();
+
+      /*!
+       * @brief Take the next request to execute.
+       * @return false if there is none.
+       */
+      bool PopRequest(std::string& request);
+
+      /*!
+       * @brief Check whether more requests are waiting, after a request was executed.
+       * @return false if there are none, the next request schedules a new job then.
+       */
+      bool HasPendingRequests();
+
       SOCKET m_socket;
       sockaddr_storage m_cliaddr;
       socklen_t m_addrlen;
       CCriticalSection m_critSection;
+      CTCPServer *m_server;
 
     protected:
       void Copy(const CTCPClient& client);
+      void QueueRequest(CTCPServer *host, std::string&& request);
+      void Queue(const BufferPtr& buffer, const CAnnouncement *announcement = NULL);
+      void ClearQueue();
+      /*!
+       * @brief Wait until the client read most of the queued data.
+       * @return false if the connection failed or the client doesn't read.
+       */
+      bool WaitForSendBacklog();
     private:
+      struct CQueuedBuffer
+      {
+        BufferPtr buffer;
+        std::string item;
+        std::string fields;
+        bool replaceable;
+      };
+
       bool m_new;
       int m_announcementflags;
       int m_beginBrackets, m_endBrackets;
       char m_beginChar, m_endChar;
       std::string m_buffer;
+      std::queue<std::string> m_requests; // protected by m_critSection
+      bool m_processing;                  // a job executes the requests, protected by m_critSection
+      std::deque<CQueuedBuffer> m_sendQueue; // protected by m_critSection
+      std::map<std::string, uint64_t> m_queuedItems; // item, sequence number of its latest queued announcement
+      uint64_t m_sendSequence;            // sequence number of the first queued buffer
+      size_t m_sendOffset;                // bytes of the first buffer already sent
+      size_t m_queuedBytes;               // size of all queued buffers
+      unsigned int m_droppedAnnouncements;
+      bool m_wantWrite;                   // waiting for the socket to become writable
+      bool m_streaming;                   // a response is queued in chunks, protected by m_critSection
+      std::vector<CAnnouncement> m_heldAnnouncements; // announced while streaming, protected by m_critSection
+      size_t m_heldBytes;                 // size of the held announcements
+      CEvent m_sendDrained;               // the queued bytes dropped below MAX_STREAM_BACKLOG
     };
 
     class CWebSocketClient : public CTCPClient
@@ -100,7 +210,10 @@ namespace JSONRPC
       CWebSocketClient& operator=(const CWebSocketClient& client);
       ~CWebSocketClient() override;
 
-      void Send(const char *data, unsigned int size) override;
+      using CTCPClient::Send;
+      void Send(const BufferPtr& buffer) override;
+      void SendResponse(const CVariant& response) override;
+      void Announce(CAnnouncement& announcement) override;
       void PushBuffer(CTCPServer *host, const char *buffer, int length) override;
       void Disconnect() override;
 
@@ -108,11 +221,28 @@ namespace JSONRPC
       bool Closing() const override { return m_websocket != NULL && m_websocket->GetState() == WebSocketStateClosed; }
 
     private:
+      BufferPtr Frame(const BufferPtr& buffer);
+
       CWebSocket *m_websocket;
     };
 
-    std::vector<CTCPClient*> m_connections;
+    typedef std::shared_ptr<CTCPClient> ClientPtr;
+
+    bool AcceptConnection(SOCKET server);
+    bool ReadFromClient(ClientPtr& client);
+    void RemoveClient(SOCKET socket);
+    void ScheduleRequests(const ClientPtr& client);
+    void SetWantWrite(SOCKET socket, bool wantWrite);
+
+    std::map<SOCKET, ClientPtr> m_connections; // modified by the server thread only, protected by m_connectionsSection
+    CCriticalSection m_connectionsSection;
     std::vector<SOCKET> m_servers;
+    std::unique_ptr<CSocketPoller> m_poller;
+    CJobQueue m_requestQueue;
+    CCriticalSection m_jobsSection;
+    int m_pendingJobs;   // jobs that were created and not yet destroyed, protected by m_jobsSection
+    bool m_bStopping;    // no new jobs are scheduled, protected by m_jobsSection
+    CEvent m_jobsDone;
     int m_port;
     bool m_nonlocal;
     void* m_sdpd;
@@ -24,13 +24,18 @@
 #include <algorithm>
 #include <memory>
 #include <stdexcept>
+#include <typeinfo>
 #include <utility>
 
 #if defined(TARGET_POSIX)
+#include <fcntl.h>
 #include <pthread.h>
+#include <sys/stat.h>
+#include <unistd.h>
 #endif
 
 #include "filesystem/File.h"
+#include "filesystem/SpecialProtocol.h"
 #include "network/httprequesthandler/HTTPRequestHandlerUtils.h"
 #include "network/httprequesthandler/IHTTPRequestHandler.h"
 #include "settings/AdvancedSettings.h"
@@ -63,6 +68,16 @@
 
 #define HEADER_NEWLINE        "\r\n"
 
+// preferred size of the blocks of a streamed response
+#define STREAM_BLOCK_SIZE 16384
+
+#ifndef MHD_CONTENT_READER_END_OF_STREAM
+#define MHD_CONTENT_READER_END_OF_STREAM -1
+#endif
+#ifndef MHD_CONTENT_READER_END_WITH_ERROR
+#define MHD_CONTENT_READER_END_WITH_ERROR -1
+#endif
+
 typedef struct {
   std::shared_ptr<XFILE::CFile> file;
   CHttpRanges ranges;
@@ -75,6 +90,14 @@ typedef struct {
   uint64_t writePosition;
 } HttpFileDownloadContext;
 
+typedef struct {
+  std::shared_ptr<IHTTPRequestHandler> handler;
+  std::unique_ptr<CHTTPStreamCompressor> compressor;
+  std::string data;
+  size_t writePosition;
+  bool complete;
+} HttpStreamDownloadContext;
+
 CWebServer::CWebServer()
   : m_port(0),
     m_daemon_ip6(nullptr),
@@ -226,6 +249,19 @@ int CWebServer::HandlePartialRequest(struct MHD_Connection *connection, Connecti
         {
           bool cacheable = IsRequestCacheable(request);
 
+          // handle If-None-Match which takes precedence over If-Modified-Since
+          std::string etag = CreateETag(handler);
+          std::string ifNoneMatch = HTTPRequestHandlerUtils::GetRequestHeaderValue(connection, MHD_HEADER_KIND, MHD_HTTP_HEADER_IF_NONE_MATCH);
+          bool checkModifiedSince = true;
+          if (!etag.empty() && !ifNoneMatch.empty())
+          {
+            std::string matchingETag;
+            if (cacheable && CHTTPResponseCache::MatchesETag(ifNoneMatch, etag, matchingETag))
+              return SendNotModifiedResponse(handler, matchingETag);
+
+            checkModifiedSince = false;
+          }
+
           CDateTime lastModified;
           if (handler->GetLastModifiedDate(lastModified) && lastModified.IsValid())
           {
@@ -236,19 +272,10 @@ int CWebServer::HandlePartialRequest(struct MHD_Connection *connection, Connecti
             CDateTime ifModifiedSinceDate;
             CDateTime ifUnmodifiedSinceDate;
             // handle If-Modified-Since (but only if the response is cacheable)
-            if (cacheable &&
+            if (cacheable && checkModifiedSince &&
               ifModifiedSinceDate.SetFromRFC1123DateTime(ifModifiedSince) &&
               lastModified.GetAsUTCDateTime() <= ifModifiedSinceDate)
-            {
-              struct MHD_Response *response = create_response(0, nullptr, MHD_NO, MHD_NO);
-              if (response == nullptr)
-              {
-                CLog::Log(LOGERROR, "CWebServer[%hu]: failed to create a HTTP 304 response", m_port);
-                return MHD_NO;
-              }
-
-              return FinalizeRequest(handler, MHD_HTTP_NOT_MODIFIED, response);
-            }
+              return SendNotModifiedResponse(handler, etag);
             // handle If-Unmodified-Since
             else if (ifUnmodifiedSinceDate.SetFromRFC1123DateTime(ifUnmodifiedSince) &&
               lastModified.GetAsUTCDateTime() > ifUnmodifiedSinceDate)
@@ -256,7 +283,7 @@ int CWebServer::HandlePartialRequest(struct MHD_Connection *connection, Connecti
           }
 
           // pass the requested ranges on to the request handler
-          handler->SetRequestRanged(IsRequestRanged(request, lastModified));
+          handler->SetRequestRanged(IsRequestRanged(request, lastModified, etag));
         }
       }
       // if we got a POST request we need to take care of the POST data
@@ -341,6 +368,15 @@ int CWebServer::HandleRequest(const std::shared_ptr<IHTTPRequestHandler>& handle
     return MHD_NO;
 
   HTTPRequest request = handler->GetRequest();
+  const int acceptedEncodings = CHTTPResponseCache::GetAcceptedEncodings(
+    HTTPRequestHandlerUtils::GetRequestHeaderValue(request.connection, MHD_HEADER_KIND, MHD_HTTP_HEADER_ACCEPT_ENCODING));
+
+  // serve the whole response from the response cache if it's still valid
+  CHTTPResponseCache::CResponse completeResponse;
+  const std::string cacheKey = GetResponseCacheKey(handler);
+  if (!cacheKey.empty() && m_responseCache.Get(cacheKey, handler->GetResponseValidator(), acceptedEncodings, completeResponse))
+    return SendCompleteResponse(handler, completeResponse);
+
   int ret = handler->HandleRequest();
   if (ret == MHD_NO)
   {
@@ -348,6 +384,20 @@ int CWebServer::HandleRequest(const std::shared_ptr<IHTTPRequestHandler>& handle
     return SendErrorResponse(request, MHD_HTTP_INTERNAL_SERVER_ERROR, request.method);
   }
 
+  if (!cacheKey.empty() && AddToResponseCache(handler, cacheKey, acceptedEncodings, completeResponse))
+    return SendCompleteResponse(handler, completeResponse);
+
+  // responses without a validator are validated and compressed on the fly
+  if (GetCompleteMemoryResponse(handler, acceptedEncodings, completeResponse))
+  {
+    std::string ifNoneMatch = HTTPRequestHandlerUtils::GetRequestHeaderValue(request.connection, MHD_HEADER_KIND, MHD_HTTP_HEADER_IF_NONE_MATCH);
+    std::string matchingETag;
+    if (request.method == GET && IsRequestCacheable(request) && CHTTPResponseCache::MatchesETag(ifNoneMatch, completeResponse.etag, matchingETag))
+      return SendNotModifiedResponse(handler, matchingETag);
+
+    return SendCompleteResponse(handler, completeResponse);
+  }
+
   const HTTPResponseDetails &responseDetails = handler->GetResponseDetails();
   struct MHD_Response *response = nullptr;
   switch (responseDetails.type)
@@ -371,6 +421,10 @@ int CWebServer::HandleRequest(const std::shared_ptr<IHTTPRequestHandler>& handle
       ret = CreateMemoryDownloadResponse(handler, response);
       break;
 
+    case HTTPStreamDownload:
+      ret = CreateStreamDownloadResponse(handler, acceptedEncodings, response);
+      break;
+
     case HTTPError:
       ret = CreateErrorResponse(request.connection, responseDetails.status, request.method, response);
       break;
@@ -406,6 +460,11 @@ int CWebServer::FinalizeRequest(const std::shared_ptr<IHTTPRequestHandler>& hand
   if (handler->GetLastModifiedDate(lastModified) && lastModified.IsValid())
     handler->AddResponseHeader(MHD_HTTP_HEADER_LAST_MODIFIED, lastModified.GetAsRFC1123DateTime());
 
+  // if the response data has a validator and no ETag has been set as a header, add it
+  std::string etag = CreateETag(handler);
+  if (!etag.empty())
+    handler->AddResponseHeader(MHD_HTTP_HEADER_ETAG, etag);
+
   // check if the request handler has set Cache-Control and add it if not
   if (!handler->HasResponseHeader(MHD_HTTP_HEADER_CACHE_CONTROL))
   {
@@ -446,8 +505,9 @@ int CWebServer::FinalizeRequest(const std::shared_ptr<IHTTPRequestHandler>& hand
   else
     handler->AddResponseHeader(MHD_HTTP_HEADER_ACCEPT_RANGES, "none");
 
-  // add MHD_HTTP_HEADER_CONTENT_LENGTH
-  if (responseDetails.totalLength > 0)
+  // add MHD_HTTP_HEADER_CONTENT_LENGTH unless there's no or encoded response data
+  if (responseDetails.totalLength > 0 && responseStatus != MHD_HTTP_NOT_MODIFIED &&
+      !handler->HasResponseHeader(MHD_HTTP_HEADER_CONTENT_ENCODING))
     handler->AddResponseHeader(MHD_HTTP_HEADER_CONTENT_LENGTH, StringUtils::Format("%" PRIu64, responseDetails.totalLength));
 
   // add all headers set by the request handler
@@ -498,16 +558,25 @@ bool CWebServer::IsRequestCacheable(const HTTPRequest& request) const
   return true;
 }
 
-bool CWebServer::IsRequestRanged(const HTTPRequest& request, const CDateTime &lastModified) const
+bool CWebServer::IsRequestRanged(const HTTPRequest& request, const CDateTime &lastModified, const std::string &etag) const
 {
   // parse the Range header and store it in the request object
   CHttpRanges ranges;
   bool ranged = ranges.Parse(HTTPRequestHandlerUtils::GetRequestHeaderValue(request.connection, MHD_HEADER_KIND, MHD_HTTP_HEADER_RANGE));
 
   // handle If-Range header but only if the Range header is present
-  if (ranged && lastModified.IsValid())
+  std::string ifRange;
+  if (ranged)
+    ifRange = HTTPRequestHandlerUtils::GetRequestHeaderValue(request.connection, MHD_HEADER_KIND, MHD_HTTP_HEADER_IF_RANGE);
+
+  // an entity tag in If-Range must match the current one exactly
+  if (StringUtils::StartsWith(ifRange, "\"") || StringUtils::StartsWith(ifRange, "W/"))
+  {
+    if (etag.empty() || ifRange != etag)
+      ranges.Clear();
+  }
+  else if (ranged && lastModified.IsValid())
   {
-    std::string ifRange = HTTPRequestHandlerUtils::GetRequestHeaderValue(request.connection, MHD_HEADER_KIND, MHD_HTTP_HEADER_IF_RANGE);
     if (!ifRange.empty() && lastModified.IsValid())
     {
       CDateTime ifRangeDate;
@@ -523,6 +592,174 @@ bool CWebServer::IsRequestRanged(const HTTPRequest& request, const CDateTime &la
   return !ranges.IsEmpty();
 }
 
+std::string CWebServer::GetResponseCacheKey(const std::shared_ptr<IHTTPRequestHandler>& handler) const
+{
+  // only complete responses to GET requests are cached
+  if (handler->GetRequest().method != GET || !handler->CanBeCached() || handler->IsRequestRanged() ||
+      handler->GetResponseValidator().empty() || !m_responseCache.IsEnabled())
+    return "";
+
+  const std::string key = handler->GetResponseCacheKey();
+  if (key.empty())
+    return "";
+
+  // different request handlers can create different responses for the same key
+  const IHTTPRequestHandler &requestHandler = *handler;
+  return StringUtils::Format("%s|%s", typeid(requestHandler).name(), key.c_str());
+}
+
+std::string CWebServer::CreateETag(const std::shared_ptr<IHTTPRequestHandler>& handler) const
+{
+  if (!handler->CanBeCached())
+    return "";
+
+  const std::string validator = handler->GetResponseValidator();
+  if (validator.empty())
+    return "";
+
+  const IHTTPRequestHandler &requestHandler = *handler;
+  return CHTTPResponseCache::CreateETag(StringUtils::Format("%s|%s|%s", typeid(requestHandler).name(),
+                                                            handler->GetResponseCacheKey().c_str(), validator.c_str()));
+}
+
+bool CWebServer::AddToResponseCache(const std::shared_ptr<IHTTPRequestHandler>& handler, const std::string &key, int acceptedEncodings, CHTTPResponseCache::CResponse &cachedResponse)
+{
+  const HTTPResponseDetails &responseDetails = handler->GetResponseDetails();
+  if (responseDetails.status != MHD_HTTP_OK)
+    return false;
+
+  const uint64_t maximumSize = m_responseCache.GetMaximumResponseSize();
+  std::string contentType = responseDetails.contentType;
+  std::shared_ptr<std::string> data = std::make_shared<std::string>();
+  const void *dataToFree = nullptr;
+
+  switch (responseDetails.type)
+  {
+    case HTTPFileDownload:
+    {
+      const std::string filePath = handler->GetResponseFile();
+
+      // don't open files which are too big for the cache anyway
+      struct __stat64 fileStat;
+      if (XFILE::CFile::Stat(filePath, &fileStat) != 0 || fileStat.st_size < 0 ||
+          static_cast<uint64_t>(fileStat.st_size) > maximumSize)
+        return false;
+
+      XFILE::CFile file;
+      if (!file.Open(filePath, XFILE::READ_NO_CACHE))
+        return false;
+
+      const int64_t fileLength = file.GetLength();
+      if (fileLength < 0 || static_cast<uint64_t>(fileLength) > maximumSize)
+        return false;
+
+      data->resize(static_cast<size_t>(fileLength));
+      size_t position = 0;
+      while (position < data->size())
+      {
+        ssize_t read = file.Read(&(*data)[position], data->size() - position);
+        if (read <= 0)
+        {
+          CLog::Log(LOGWARNING, "CWebServer[%hu]: failed to read %s into the response cache", m_port, filePath.c_str());
+          return false;
+        }
+        position += static_cast<size_t>(read);
+      }
+
+      if (contentType.empty())
+      {
+        std::string ext = URIUtils::GetExtension(filePath);
+        StringUtils::ToLower(ext);
+        contentType = CreateMimeTypeFromExtension(ext.c_str());
+      }
+      break;
+    }
+
+    case HTTPMemoryDownloadNoFreeNoCopy:
+    case HTTPMemoryDownloadNoFreeCopy:
+    case HTTPMemoryDownloadFreeNoCopy:
+    case HTTPMemoryDownloadFreeCopy:
+    {
+      // the response data must be complete
+      HttpResponseRanges responseRanges = handler->GetResponseData();
+      if (responseRanges.size() != 1 || !responseRanges.front().IsValid() || responseRanges.front().GetFirstPosition() != 0 ||
+          responseRanges.front().GetLength() > maximumSize ||
+          (responseDetails.totalLength > 0 && responseRanges.front().GetLength() != responseDetails.totalLength))
+        return false;
+
+      const CHttpResponseRange &responseRange = responseRanges.front();
+      data->assign(static_cast<const char*>(responseRange.GetData()), static_cast<size_t>(responseRange.GetLength()));
+
+      if (responseDetails.type == HTTPMemoryDownloadFreeNoCopy || responseDetails.type == HTTPMemoryDownloadFreeCopy)
+        dataToFree = responseRange.GetData();
+      break;
+    }
+
+    default:
+      return false;
+  }
+
+  if (!m_responseCache.Put(key, handler->GetResponseValidator(), contentType, CreateETag(handler), data, acceptedEncodings, cachedResponse))
+    return false;
+
+  // the response is sent from the cached copy
+  if (dataToFree != nullptr)
+    free(const_cast<void*>(dataToFree));
+
+  return true;
+}
+
+bool CWebServer::GetCompleteMemoryResponse(const std::shared_ptr<IHTTPRequestHandler>& handler, int acceptedEncodings, CHTTPResponseCache::CResponse &completeResponse) const
+{
+  const HTTPRequest &request = handler->GetRequest();
+  const HTTPResponseDetails &responseDetails = handler->GetResponseDetails();
+
+  // buffers which have to be freed are left to MHD
+  if ((responseDetails.type != HTTPMemoryDownloadNoFreeNoCopy && responseDetails.type != HTTPMemoryDownloadNoFreeCopy) ||
+      responseDetails.status != MHD_HTTP_OK || request.method == HEAD || handler->IsRequestRanged() ||
+      handler->HasResponseHeader(MHD_HTTP_HEADER_CONTENT_ENCODING))
+    return false;
+
+  HttpResponseRanges responseRanges = handler->GetResponseData();
+  if (responseRanges.size() != 1 || !responseRanges.front().IsValid() || responseRanges.front().GetFirstPosition() != 0 ||
+      (responseDetails.totalLength > 0 && responseRanges.front().GetLength() != responseDetails.totalLength))
+    return false;
+
+  // only responses to GET requests can be validated, others are only worth compressing
+  HTTPContentEncoding encoding = CHTTPResponseCache::GetPreferredEncoding(acceptedEncodings);
+  if (!CHTTPResponseCache::IsCompressible(responseDetails.contentType))
+    encoding = HTTPContentEncodingIdentity;
+  if (request.method != GET && encoding == HTTPContentEncodingIdentity)
+    return false;
+
+  const CHttpResponseRange &responseRange = responseRanges.front();
+  CHTTPResponseCache::BufferPtr data = std::make_shared<const std::string>(static_cast<const char*>(responseRange.GetData()),
+                                                                           static_cast<size_t>(responseRange.GetLength()));
+
+  completeResponse.contentType = responseDetails.contentType;
+  completeResponse.data = data;
+  completeResponse.encoding = HTTPContentEncodingIdentity;
+
+  std::string compressed;
+  if (encoding != HTTPContentEncodingIdentity && CHTTPResponseCache::Compress(*data, encoding, compressed))
+  {
+    completeResponse.data = std::make_shared<const std::string>(std::move(compressed));
+    completeResponse.encoding = encoding;
+  }
+
+  // without a validator the ETag is created from the response data
+  completeResponse.etag.clear();
+  if (request.method == GET)
+  {
+    std::string etag = CreateETag(handler);
+    if (etag.empty())
+      etag = CHTTPResponseCache::CreateETag(*data);
+    completeResponse.etag = CHTTPResponseCache::GetETag(etag, completeResponse.encoding);
+  }
+
+  return true;
+}
+
 void CWebServer::SetupPostDataProcessing(const HTTPRequest& request, ConnectionHandler *connectionHandler, std::shared_ptr<IHTTPRequestHandler> handler, void **con_cls) const
 {
   connectionHandler->requestHandler = handler;
@@ -763,18 +1000,8 @@ int CWebServer::CreateFileDownloadResponse(const std::shared_ptr<IHTTPRequestHan
   const HTTPResponseDetails &responseDetails = handler->GetResponseDetails();
   HttpResponseRanges responseRanges = handler->GetResponseData();
 
-  std::shared_ptr<XFILE::CFile> file = std::make_shared<XFILE::CFile>();
   std::string filePath = handler->GetResponseFile();
 
-  if (!file->Open(filePath, XFILE::READ_NO_CACHE))
-  {
-    CLog::Log(LOGERROR, "CWebServer[%hu]: Failed to open %s", m_port, filePath.c_str());
-    return SendErrorResponse(request, MHD_HTTP_NOT_FOUND, request.method);
-  }
-
-  bool ranged = false;
-  uint64_t fileLength = static_cast<uint64_t>(file->GetLength());
-
   // get the MIME type for the Content-Type header
   std::string mimeType = responseDetails.contentType;
   if (mimeType.empty())
@@ -784,6 +1011,25 @@ int CWebServer::CreateFileDownloadResponse(const std::shared_ptr<IHTTPRequestHan
     mimeType = CreateMimeTypeFromExtension(ext.c_str());
   }
 
+  // local files don't need to be copied through the VFS
+  if (request.method != HEAD && CreateLocalFileDownloadResponse(handler, filePath, response))
+  {
+    if (!mimeType.empty())
+      handler->AddResponseHeader(MHD_HTTP_HEADER_CONTENT_TYPE, mimeType);
+
+    return MHD_YES;
+  }
+
+  std::shared_ptr<XFILE::CFile> file = std::make_shared<XFILE::CFile>();
+  if (!file->Open(filePath, XFILE::READ_NO_CACHE))
+  {
+    CLog::Log(LOGERROR, "CWebServer[%hu]: Failed to open %s", m_port, filePath.c_str());
+    return SendErrorResponse(request, MHD_HTTP_NOT_FOUND, request.method);
+  }
+
+  bool ranged = false;
+  uint64_t fileLength = static_cast<uint64_t>(file->GetLength());
+
   if (request.method != HEAD)
   {
     uint64_t totalLength = 0;
@@ -887,6 +1133,131 @@ int CWebServer::CreateFileDownloadResponse(const std::shared_ptr<IHTTPRequestHan
   return MHD_YES;
 }
 
+int CWebServer::CreateStreamDownloadResponse(const std::shared_ptr<IHTTPRequestHandler>& handler, int acceptedEncodings, struct MHD_Response *&response) const
+{
+  if (handler == nullptr)
+    return MHD_NO;
+
+  const HTTPRequest &request = handler->GetRequest();
+  const HTTPResponseDetails &responseDetails = handler->GetResponseDetails();
+
+  // the length of the response data isn't known without creating it
+  if (request.method == HEAD)
+  {
+    response = create_response(0, nullptr, MHD_NO, MHD_NO);
+    if (response == nullptr)
+    {
+      CLog::Log(LOGERROR, "CWebServer[%hu]: failed to create a HTTP HEAD response for %s", m_port, request.pathUrl.c_str());
+      return MHD_NO;
+    }
+
+    return MHD_YES;
+  }
+
+  std::unique_ptr<HttpStreamDownloadContext> context(new HttpStreamDownloadContext());
+  context->handler = handler;
+  context->writePosition = 0;
+  context->complete = false;
+
+  // the response data is compressed while it is sent
+  if (CHTTPResponseCache::IsCompressible(responseDetails.contentType) && !handler->HasResponseHeader(MHD_HTTP_HEADER_CONTENT_ENCODING))
+  {
+    handler->AddResponseHeader(MHD_HTTP_HEADER_VARY, MHD_HTTP_HEADER_ACCEPT_ENCODING);
+
+    const HTTPContentEncoding encoding = CHTTPResponseCache::GetPreferredEncoding(acceptedEncodings);
+    context->compressor.reset(new CHTTPStreamCompressor());
+    if (context->compressor->Initialize(encoding))
+      handler->AddResponseHeader(MHD_HTTP_HEADER_CONTENT_ENCODING, CHTTPResponseCache::GetEncodingName(encoding));
+    else
+      context->compressor.reset();
+  }
+
+  // without a length MHD uses the chunked transfer encoding
+  response = MHD_create_response_from_callback(MHD_SIZE_UNKNOWN, STREAM_BLOCK_SIZE,
+                                               &CWebServer::StreamReaderCallback,
+                                               context.get(),
+                                               &CWebServer::StreamReaderFreeCallback);
+  if (response == nullptr)
+  {
+    CLog::Log(LOGERROR, "CWebServer[%hu]: failed to create a streamed HTTP response for %s", m_port, request.pathUrl.c_str());
+    return MHD_NO;
+  }
+
+  context.release(); // ownership was passed to mhd
+
+  return MHD_YES;
+}
+
+bool CWebServer::CreateLocalFileDownloadResponse(const std::shared_ptr<IHTTPRequestHandler>& handler, const std::string &filePath, struct MHD_Response *&response) const
+{
+#if defined(TARGET_POSIX) && (MHD_VERSION >= 0x00095000)
+  // MHD sends responses backed by a file descriptor with sendfile() instead of
+  // copying every chunk through ContentReaderCallback()
+  const std::string localPath = CSpecialProtocol::TranslatePath(filePath);
+  if (localPath.empty() || !CURL(localPath).GetProtocol().empty())
+    return false;
+
+  int fd = open(localPath.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0)
+    return false;
+
+  struct stat fileStat;
+  if (fstat(fd, &fileStat) != 0 || !S_ISREG(fileStat.st_mode))
+  {
+    close(fd);
+    return false;
+  }
+
+  const HTTPRequest &request = handler->GetRequest();
+  const uint64_t fileLength = static_cast<uint64_t>(fileStat.st_size);
+
+  CHttpRanges ranges;
+  if (handler->IsRequestRanged())
+  {
+    if (!request.ranges.IsEmpty())
+      ranges = request.ranges;
+    else
+      HTTPRequestHandlerUtils::GetRequestedRanges(request.connection, fileLength, ranges);
+  }
+
+  // multiple ranges are sent as multipart data which needs boundaries between the ranges
+  if (ranges.Size() > 1)
+  {
+    close(fd);
+    return false;
+  }
+
+  uint64_t firstPosition = 0;
+  uint64_t length = fileLength;
+  CHttpRange range;
+  if (ranges.GetFirst(range))
+  {
+    firstPosition = range.GetFirstPosition();
+    length = range.GetLength();
+  }
+
+  response = MHD_create_response_from_fd_at_offset64(length, fd, firstPosition);
+  if (response == nullptr)
+  {
+    CLog::Log(LOGWARNING, "CWebServer[%hu]: failed to create a HTTP response for %s from its file descriptor", m_port, request.pathUrl.c_str());
+    close(fd);
+    return false;
+  }
+
+  // the file descriptor is closed by MHD together with the response
+  if (!ranges.IsEmpty())
+  {
+    handler->SetResponseStatus(MHD_HTTP_PARTIAL_CONTENT);
+    handler->AddResponseHeader(MHD_HTTP_HEADER_CONTENT_RANGE, HttpRangeUtils::GenerateContentRangeHeaderValue(range.GetFirstPosition(), range.GetLastPosition(), fileLength));
+  }
+
+  CLog::Log(LOGDEBUG, LOGWEBSERVER, "CWebServer[%hu]: sending %" PRIu64 " bytes from %" PRIu64 " of %s", m_port, length, firstPosition, localPath.c_str());
+  return true;
+#else
+  return false;
+#endif
+}
+
 int CWebServer::CreateErrorResponse(struct MHD_Connection *connection, int responseType, HTTPMethod method, struct MHD_Response *&response) const
 {
   size_t payloadSize = 0;
@@ -950,6 +1321,45 @@ int CWebServer::SendErrorResponse(const HTTPRequest& request, int errorType, HTT
   return SendResponse(request, errorType, response);
 }
 
+int CWebServer::SendNotModifiedResponse(const std::shared_ptr<IHTTPRequestHandler>& handler, const std::string &etag)
+{
+  struct MHD_Response *response = create_response(0, nullptr, MHD_NO, MHD_NO);
+  if (response == nullptr)
+  {
+    CLog::Log(LOGERROR, "CWebServer[%hu]: failed to create a HTTP 304 response", m_port);
+    return MHD_NO;
+  }
+
+  m_responseCache.AddNotModified();
+
+  if (!etag.empty())
+    handler->AddResponseHeader(MHD_HTTP_HEADER_ETAG, etag);
+
+  return FinalizeRequest(handler, MHD_HTTP_NOT_MODIFIED, response);
+}
+
+int CWebServer::SendCompleteResponse(const std::shared_ptr<IHTTPRequestHandler>& handler, const CHTTPResponseCache::CResponse &completeResponse)
+{
+  const HTTPRequest &request = handler->GetRequest();
+  const std::string &data = *completeResponse.data;
+
+  struct MHD_Response *response = nullptr;
+  if (CreateMemoryDownloadResponse(request.connection, data.c_str(), data.size(), false, true, response) == MHD_NO)
+    return SendErrorResponse(request, MHD_HTTP_INTERNAL_SERVER_ERROR, request.method);
+
+  handler->SetResponseStatus(MHD_HTTP_OK);
+  handler->AddResponseHeader(MHD_HTTP_HEADER_CONTENT_TYPE, completeResponse.contentType);
+  handler->AddResponseHeader(MHD_HTTP_HEADER_ETAG, completeResponse.etag);
+
+  // the response data depends on the encodings accepted by the client
+  if (CHTTPResponseCache::IsCompressible(completeResponse.contentType))
+    handler->AddResponseHeader(MHD_HTTP_HEADER_VARY, MHD_HTTP_HEADER_ACCEPT_ENCODING);
+  if (completeResponse.encoding != HTTPContentEncodingIdentity)
+    handler->AddResponseHeader(MHD_HTTP_HEADER_CONTENT_ENCODING, CHTTPResponseCache::GetEncodingName(completeResponse.encoding));
+
+  return FinalizeRequest(handler, MHD_HTTP_OK, response);
+}
+
 void* CWebServer::UriRequestLogger(void *cls, const char *uri)
 {
   CWebServer *webServer = reinterpret_cast<CWebServer*>(cls);
@@ -1081,6 +1491,61 @@ void CWebServer::ContentReaderFreeCallback(void *cls)
   CLog::Log(LOGDEBUG, LOGWEBSERVER, "CWebServer [OUT] done");
 }
 
+#if (MHD_VERSION >= 0x00090200)
+ssize_t CWebServer::StreamReaderCallback(void *cls, uint64_t pos, char *buf, size_t max)
+#elif (MHD_VERSION >= 0x00040001)
+int CWebServer::StreamReaderCallback(void *cls, uint64_t pos, char *buf, int max)
+#else   //libmicrohttpd < 0.4.0
+int CWebServer::StreamReaderCallback(void *cls, size_t pos, char *buf, int max)
+#endif
+{
+  HttpStreamDownloadContext *context = (HttpStreamDownloadContext *)cls;
+  if (context == nullptr || context->handler == nullptr)
+    return MHD_CONTENT_READER_END_WITH_ERROR;
+
+  // take chunks from the request handler until there is data to write
+  while (context->writePosition >= context->data.size())
+  {
+    if (context->complete)
+      return MHD_CONTENT_READER_END_OF_STREAM;
+
+    std::string chunk;
+    if (!context->handler->GetNextResponseChunk(chunk))
+    {
+      CLog::Log(LOGERROR, "CWebServer: failed to create the response data for %s", context->handler->GetRequest().pathUrl.c_str());
+      return MHD_CONTENT_READER_END_WITH_ERROR;
+    }
+
+    context->complete = chunk.empty();
+    context->writePosition = 0;
+    if (context->compressor == nullptr)
+      context->data.swap(chunk);
+    else
+    {
+      // the compressor may keep the data of a chunk until it has enough of it
+      context->data.clear();
+      if (!context->compressor->Compress(chunk.c_str(), chunk.size(), context->complete, context->data))
+        return MHD_CONTENT_READER_END_WITH_ERROR;
+    }
+  }
+
+  const size_t written = std::min(static_cast<size_t>(max), context->data.size() - context->writePosition);
+  memcpy(buf, context->data.c_str() + context->writePosition, written);
+  context->writePosition += written;
+
+  CLog::Log(LOGDEBUG, LOGWEBSERVER, "CWebServer [OUT] wrote %zu bytes of a streamed response", written);
+
+  return written;
+}
+
+void CWebServer::StreamReaderFreeCallback(void *cls)
+{
+  HttpStreamDownloadContext *context = (HttpStreamDownloadContext *)cls;
+  delete context;
+
+  CLog::Log(LOGDEBUG, LOGWEBSERVER, "CWebServer [OUT] done");
+}
+
 // local helper
 static void panicHandlerForMHD(void* unused, const char* file, unsigned int line, const char *reason)
 {
@@ -1172,6 +1637,7 @@ bool CWebServer::Start(uint16_t port, const std::string &username, const std::st
     m_running = (m_daemon_ip6 != nullptr) || (m_daemon_ip4 != nullptr);
     if (m_running)
     {
+      m_responseCache.SetMaximumSize(static_cast<size_t>(g_advancedSettings.m_webserverResponseCacheSize) * 1024 * 1024);
       m_port = port;
       CLog::Log(LOGNOTICE, "CWebServer[%hu]: Started", m_port);
     }
@@ -1194,6 +1660,7 @@ bool CWebServer::Stop()
     MHD_stop_daemon(m_daemon_ip4);
     
   m_running = false;
+  m_responseCache.Clear();
   CLog::Log(LOGNOTICE, "CWebServer[%hu]: Stopped", m_port);
   m_port = 0;
 
@@ -1236,6 +1703,11 @@ void CWebServer::UnregisterRequestHandler(IHTTPRequestHandler *handler)
   m_requestHandlers.erase(std::remove(m_requestHandlers.begin(), m_requestHandlers.end(), handler), m_requestHandlers.end());
 }
 
+void CWebServer::GetResponseCacheStatistics(CVariant &statistics) const
+{
+  m_responseCache.GetStatistics(statistics);
+}
+
 void CWebServer::LogRequest(const HTTPRequest& request) const
 {
   if (!g_advancedSettings.CanLogComponent(LOGWEBSERVER))
@@ -25,6 +25,7 @@
 #include <memory>
 #include <vector>
 
+#include "network/HTTPResponseCache.h"
 #include "network/httprequesthandler/IHTTPRequestHandler.h"
 #include "threads/CriticalSection.h"
 
@@ -49,6 +50,8 @@ public:
   void RegisterRequestHandler(IHTTPRequestHandler *handler);
   void UnregisterRequestHandler(IHTTPRequestHandler *handler);
 
+  void GetResponseCacheStatistics(CVariant &statistics) const;
+
 protected:
   typedef struct ConnectionHandler
   {
@@ -83,7 +86,12 @@ private:
   bool IsAuthenticated(const HTTPRequest& request) const;
 
   bool IsRequestCacheable(const HTTPRequest& request) const;
-  bool IsRequestRanged(const HTTPRequest& request, const CDateTime &lastModified) const;
+  bool IsRequestRanged(const HTTPRequest& request, const CDateTime &lastModified, const std::string &etag) const;
+
+  std::string GetResponseCacheKey(const std::shared_ptr<IHTTPRequestHandler>& handler) const;
+  std::string CreateETag(const std::shared_ptr<IHTTPRequestHandler>& handler) const;
+  bool AddToResponseCache(const std::shared_ptr<IHTTPRequestHandler>& handler, const std::string &key, int acceptedEncodings, CHTTPResponseCache::CResponse &cachedResponse);
+  bool GetCompleteMemoryResponse(const std::shared_ptr<IHTTPRequestHandler>& handler, int acceptedEncodings, CHTTPResponseCache::CResponse &completeResponse) const;
 
   void SetupPostDataProcessing(const HTTPRequest& request, ConnectionHandler *connectionHandler, std::shared_ptr<IHTTPRequestHandler> handler, void **con_cls) const;
   bool ProcessPostData(const HTTPRequest& request, ConnectionHandler *connectionHandler, const char *upload_data, size_t *upload_data_size, void **con_cls) const;
@@ -94,11 +102,15 @@ private:
 
   int CreateRedirect(struct MHD_Connection *connection, const std::string &strURL, struct MHD_Response *&response) const;
   int CreateFileDownloadResponse(const std::shared_ptr<IHTTPRequestHandler>& handler, struct MHD_Response *&response) const;
+  int CreateStreamDownloadResponse(const std::shared_ptr<IHTTPRequestHandler>& handler, int acceptedEncodings, struct MHD_Response *&response) const;
+  bool CreateLocalFileDownloadResponse(const std::shared_ptr<IHTTPRequestHandler>& handler, const std::string &filePath, struct MHD_Response *&response) const;
   int CreateErrorResponse(struct MHD_Connection *connection, int responseType, HTTPMethod method, struct MHD_Response *&response) const;
   int CreateMemoryDownloadResponse(struct MHD_Connection *connection, const void *data, size_t size, bool free, bool copy, struct MHD_Response *&response) const;
 
   int SendResponse(const HTTPRequest& request, int responseStatus, MHD_Response *response) const;
   int SendErrorResponse(const HTTPRequest& request, int errorType, HTTPMethod method) const;
+  int SendNotModifiedResponse(const std::shared_ptr<IHTTPRequestHandler>& handler, const std::string &etag);
+  int SendCompleteResponse(const std::shared_ptr<IHTTPRequestHandler>& handler, const CHTTPResponseCache::CResponse &completeResponse);
 
   int AddHeader(struct MHD_Response *response, const std::string &name, const std::string &value) const;
 
@@ -119,6 +131,15 @@ private:
 #endif
   static void ContentReaderFreeCallback(void *cls);
 
+#if (MHD_VERSION >= 0x00090200)
+  static ssize_t StreamReaderCallback(void *cls, uint64_t pos, char *buf, size_t max);
+#elif (MHD_VERSION >= 0x00040001)
+  static int StreamReaderCallback(void *cls, uint64_t pos, char *buf, int max);
+#else
+  static int StreamReaderCallback(void *cls, size_t pos, char *buf, int max);
+#endif
+  static void StreamReaderFreeCallback(void *cls);
+
 #if (MHD_VERSION >= 0x00040001)
   static int AnswerToConnection (void *cls, struct MHD_Connection *connection,
                         const char *url, const char *method,
@@ -149,5 +170,6 @@ private:
   std::string m_authenticationPassword;
   CCriticalSection m_critSection;
   std::vector<IHTTPRequestHandler *> m_requestHandlers;
+  CHTTPResponseCache m_responseCache;
 };
 #endif
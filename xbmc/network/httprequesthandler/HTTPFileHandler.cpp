@@ -29,7 +29,8 @@ CHTTPFileHandler::CHTTPFileHandler()
     m_url(),
     m_canHandleRanges(true),
     m_canBeCached(true),
-    m_lastModified()
+    m_lastModified(),
+    m_validator()
 { }
 
 CHTTPFileHandler::CHTTPFileHandler(const HTTPRequest &request)
@@ -37,7 +38,8 @@ CHTTPFileHandler::CHTTPFileHandler(const HTTPRequest &request)
     m_url(),
     m_canHandleRanges(true),
     m_canBeCached(true),
-    m_lastModified()
+    m_lastModified(),
+    m_validator()
 { }
 
 int CHTTPFileHandler::HandleRequest()
@@ -54,6 +56,15 @@ bool CHTTPFileHandler::GetLastModifiedDate(CDateTime &lastModified) const
   return true;
 }
 
+std::string CHTTPFileHandler::GetResponseCacheKey() const
+{
+  // the response only depends on the file, not on any request parameters
+  if (m_response.type != HTTPFileDownload)
+    return "";
+
+  return m_url;
+}
+
 void CHTTPFileHandler::SetFile(const std::string& file, int responseStatus)
 {
   m_url = file;
@@ -115,4 +126,6 @@ void CHTTPFileHandler::SetLastModifiedDate(const struct __stat64 *statBuffer)
 #endif
   if (time != NULL)
     m_lastModified = *time;
+
+  m_validator = StringUtils::Format("%" PRIx64 "-%" PRIx64, static_cast<uint64_t>(statBuffer->st_mtime), static_cast<uint64_t>(statBuffer->st_size));
 }
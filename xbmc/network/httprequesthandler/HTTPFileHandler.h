@@ -35,6 +35,8 @@ public:
   bool CanHandleRanges() const override { return m_canHandleRanges; }
   bool CanBeCached() const override { return m_canBeCached; }
   bool GetLastModifiedDate(CDateTime &lastModified) const override;
+  std::string GetResponseValidator() const override { return m_validator; }
+  std::string GetResponseCacheKey() const override;
 
   std::string GetRedirectUrl() const override { return m_url; }
   std::string GetResponseFile() const override { return m_url; }
@@ -56,5 +58,6 @@ private:
   bool m_canBeCached;
 
   CDateTime m_lastModified;
+  std::string m_validator;
 
 };
@@ -0,0 +1,398 @@
+/*
+ *      Copyright (C) 2017 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "HTTPImageTransformationCache.h"
+
+#include <algorithm>
+#include <cinttypes>
+#include <set>
+#include <utility>
+#include <vector>
+
+#include "FileItem.h"
+#include "TextureCacheJob.h"
+#include "URL.h"
+#include "Util.h"
+#include "filesystem/Directory.h"
+#include "filesystem/File.h"
+#include "profiles/ProfilesManager.h"
+#include "settings/AdvancedSettings.h"
+#include "threads/SingleLock.h"
+#include "utils/CPUInfo.h"
+#include "utils/Crc32.h"
+#include "utils/StringUtils.h"
+#include "utils/URIUtils.h"
+#include "utils/log.h"
+#include "utils/md5.h"
+
+#define TRANSFORMED_IMAGES_FOLDER "transformed"
+
+// decoding and scaling is memory hungry, run at most one transformation per core up to this limit
+#define MAX_CONCURRENT_TRANSFORMATIONS 4
+
+// variants not requested within this number of days are removed by the cleanup
+#define MAX_TRANSFORMED_IMAGE_AGE 30
+// variants handed out within this number of seconds are kept by the cleanup until the request opened them
+#define TRANSFORMED_IMAGE_IN_USE_PERIOD 60
+// a cleanup is started once this part of the maximum size was written
+#define CLEANUP_INTERVAL_DIVISOR 8
+
+class CHTTPImageTransformationCache::CTransformationJob : public CJob
+{
+public:
+  CTransformationJob(CHTTPImageTransformationCache *cache, const std::string &imagePath, const std::string &cachedPath, const TransformationPtr &transformation)
+    : m_cache(cache),
+      m_imagePath(imagePath),
+      m_cachedPath(cachedPath),
+      m_transformation(transformation),
+      m_success(false),
+      m_size(0)
+  { }
+
+  // the waiting requests are woken up even if the job is cancelled
+  ~CTransformationJob() override
+  {
+    m_cache->OnTransformationDone(m_cachedPath, m_transformation, m_success, m_size);
+  }
+
+  const char* GetType() const override { return "imagetransformation"; }
+
+  bool DoWork() override
+  {
+    m_success = m_cache->Transform(m_imagePath, m_cachedPath, m_size);
+    return m_success;
+  }
+
+private:
+  CHTTPImageTransformationCache *m_cache;
+  std::string m_imagePath;
+  std::string m_cachedPath;
+  TransformationPtr m_transformation;
+  bool m_success;
+  size_t m_size;
+};
+
+class CHTTPImageTransformationCache::CCleanupJob : public CJob
+{
+public:
+  explicit CCleanupJob(CHTTPImageTransformationCache *cache)
+    : m_cache(cache)
+  { }
+
+  ~CCleanupJob() override
+  {
+    m_cache->OnCleanupDone();
+  }
+
+  const char* GetType() const override { return "imagetransformationcleanup"; }
+
+  bool DoWork() override
+  {
+    m_cache->Cleanup();
+    return true;
+  }
+
+private:
+  CHTTPImageTransformationCache *m_cache;
+};
+
+CHTTPImageTransformationCache::CHTTPImageTransformationCache()
+  : m_jobQueue(false, std::max(1, std::min(g_cpuInfo.getCPUCount(), MAX_CONCURRENT_TRANSFORMATIONS)), CJob::PRIORITY_NORMAL),
+    m_maximumSize(static_cast<uint64_t>(g_advancedSettings.m_webserverTransformedImagesSize) * 1024 * 1024),
+    m_inUsePeriod(TRANSFORMED_IMAGE_IN_USE_PERIOD)
+{ }
+
+CHTTPImageTransformationCache& CHTTPImageTransformationCache::GetInstance()
+{
+  static CHTTPImageTransformationCache sImageTransformationCache;
+  return sImageTransformationCache;
+}
+
+std::string CHTTPImageTransformationCache::GetTransformedImage(const std::string &imagePath, const std::string &sourceHash)
+{
+  if (imagePath.empty() || sourceHash.empty())
+    return "";
+
+  const std::string cachedPath = GetCachedPath(imagePath, sourceHash);
+
+  // recorded before checking for the variant, so the cleanup either keeps it
+  // or has already removed it and it is created again
+  OnAccess(cachedPath);
+  if (XFILE::CFile::Exists(cachedPath, false))
+    return cachedPath;
+
+  TransformationPtr transformation;
+  bool transform = false;
+  {
+    CSingleLock lock(m_critSection);
+    auto it = m_transformations.find(cachedPath);
+    if (it != m_transformations.end())
+      transformation = it->second;
+    else
+    {
+      // the variant might have been created since the check above
+      if (XFILE::CFile::Exists(cachedPath, false))
+        return cachedPath;
+
+      transformation = std::make_shared<CTransformation>();
+      m_transformations.insert(std::make_pair(cachedPath, transformation));
+      transform = true;
+    }
+  }
+
+  if (transform)
+    m_jobQueue.AddJob(new CTransformationJob(this, imagePath, cachedPath, transformation));
+
+  // concurrent requests for the same variant wait for the same job
+  transformation->done.Wait();
+  if (!transformation->success)
+    return "";
+
+  OnAccess(cachedPath);
+  return cachedPath;
+}
+
+void CHTTPImageTransformationCache::SetMaximumSize(uint64_t maximumSize)
+{
+  CSingleLock lock(m_critSection);
+  m_maximumSize = maximumSize;
+}
+
+uint64_t CHTTPImageTransformationCache::GetMaximumSize() const
+{
+  CSingleLock lock(m_critSection);
+  return m_maximumSize;
+}
+
+void CHTTPImageTransformationCache::SetInUsePeriod(unsigned int seconds)
+{
+  CSingleLock lock(m_critSection);
+  m_inUsePeriod = seconds;
+}
+
+unsigned int CHTTPImageTransformationCache::GetInUsePeriod() const
+{
+  CSingleLock lock(m_critSection);
+  return m_inUsePeriod;
+}
+
+void CHTTPImageTransformationCache::OnTransformationDone(const std::string &cachedPath, const TransformationPtr &transformation, bool success, size_t size)
+{
+  CSingleLock lock(m_critSection);
+  m_transformations.erase(cachedPath);
+
+  transformation->success = success;
+  transformation->done.Set();
+
+  if (!success)
+    return;
+
+  m_sizeSinceCleanup += size;
+  if (!m_cleanupQueued && (!m_cleanedUp || m_sizeSinceCleanup >= m_maximumSize / CLEANUP_INTERVAL_DIVISOR))
+  {
+    m_cleanupQueued = true;
+    m_jobQueue.AddJob(new CCleanupJob(this));
+  }
+}
+
+void CHTTPImageTransformationCache::OnCleanupDone()
+{
+  CSingleLock lock(m_critSection);
+  m_cleanupQueued = false;
+}
+
+void CHTTPImageTransformationCache::OnAccess(const std::string &cachedPath)
+{
+  CSingleLock lock(m_critSection);
+  m_lastAccess[cachedPath] = time(nullptr);
+}
+
+bool CHTTPImageTransformationCache::IsInUse(const std::string &cachedPath, time_t now) const
+{
+  CSingleLock lock(m_critSection);
+  auto it = m_lastAccess.find(cachedPath);
+  return it != m_lastAccess.end() && now - it->second < static_cast<time_t>(m_inUsePeriod);
+}
+
+bool CHTTPImageTransformationCache::DeleteUnlessInUse(const std::string &cachedPath)
+{
+  // the lock keeps requests from handing out the variant while it is removed
+  CSingleLock lock(m_critSection);
+  if (IsInUse(cachedPath, time(nullptr)))
+    return false;
+
+  return XFILE::CFile::Delete(cachedPath);
+}
+
+time_t CHTTPImageTransformationCache::GetLastAccess(const std::string &cachedPath) const
+{
+  {
+    CSingleLock lock(m_critSection);
+    auto it = m_lastAccess.find(cachedPath);
+    if (it != m_lastAccess.end())
+      return it->second;
+  }
+
+  // variants left by earlier runs were last requested when they were last
+  // read, or created if the file system doesn't track the access time
+  struct __stat64 st;
+  if (XFILE::CFile::Stat(cachedPath, &st) != 0)
+    return 0;
+
+  return std::max(static_cast<time_t>(st.st_atime), static_cast<time_t>(st.st_mtime));
+}
+
+void CHTTPImageTransformationCache::Cleanup()
+{
+  uint64_t maximumSize;
+  {
+    CSingleLock lock(m_critSection);
+    maximumSize = m_maximumSize;
+    m_sizeSinceCleanup = 0;
+    m_cleanedUp = true;
+  }
+
+  const std::string root = URIUtils::AddFileToFolder(CProfilesManager::GetInstance().GetThumbnailsFolder(), TRANSFORMED_IMAGES_FOLDER);
+  CFileItemList folders;
+  if (!XFILE::CDirectory::GetDirectory(root, folders, "", XFILE::DIR_FLAG_BYPASS_CACHE))
+    return;
+
+  const time_t now = time(nullptr);
+  const time_t oldest = now - MAX_TRANSFORMED_IMAGE_AGE * 24 * 60 * 60;
+  std::vector<std::pair<time_t, CFileItemPtr>> variants;
+  std::set<std::string> remaining;
+  uint64_t totalSize = 0;
+  for (int i = 0; i < folders.Size(); i++)
+  {
+    if (!folders[i]->m_bIsFolder)
+      continue;
+
+    CFileItemList items;
+    if (!XFILE::CDirectory::GetDirectory(folders[i]->GetPath(), items, "", XFILE::DIR_FLAG_NO_FILE_DIRS | XFILE::DIR_FLAG_BYPASS_CACHE))
+      continue;
+
+    for (int j = 0; j < items.Size(); j++)
+    {
+      const CFileItemPtr &item = items[j];
+      // temporary files belong to transformations in progress
+      if (item->m_bIsFolder || URIUtils::HasExtension(item->GetPath(), ".tmp"))
+        continue;
+
+      const time_t lastAccess = GetLastAccess(item->GetPath());
+      if (lastAccess < oldest && DeleteUnlessInUse(item->GetPath()))
+        continue;
+
+      totalSize += static_cast<uint64_t>(item->m_dwSize);
+      variants.push_back(std::make_pair(lastAccess, item));
+      remaining.insert(item->GetPath());
+    }
+  }
+
+  if (totalSize > maximumSize)
+  {
+    std::sort(variants.begin(), variants.end(), [](const std::pair<time_t, CFileItemPtr> &lhs, const std::pair<time_t, CFileItemPtr> &rhs) { return lhs.first < rhs.first; });
+    for (const auto &variant : variants)
+    {
+      if (totalSize <= maximumSize)
+        break;
+
+      if (DeleteUnlessInUse(variant.second->GetPath()))
+      {
+        totalSize -= static_cast<uint64_t>(variant.second->m_dwSize);
+        remaining.erase(variant.second->GetPath());
+      }
+    }
+  }
+
+  // forget the variants that were removed, unless they were requested again meanwhile
+  {
+    CSingleLock lock(m_critSection);
+    for (auto it = m_lastAccess.begin(); it != m_lastAccess.end();)
+    {
+      if (remaining.find(it->first) == remaining.end() && !IsInUse(it->first, now))
+        it = m_lastAccess.erase(it);
+      else
+        ++it;
+    }
+  }
+
+  CLog::Log(LOGDEBUG, "CHTTPImageTransformationCache: transformed images take %" PRIu64" bytes after cleanup", totalSize);
+}
+
+std::string CHTTPImageTransformationCache::GetCachedPath(const std::string &imagePath, const std::string &sourceHash)
+{
+  std::string imageHash = XBMC::XBMC_MD5::GetMD5(imagePath);
+  StringUtils::ToLower(imageHash);
+
+  // the extension determines the format of the transformed image
+  const std::string extension = URIUtils::GetExtension(CURL(imagePath).GetHostName());
+
+  const std::string file = StringUtils::Format("%s/%c/%s-%08x%s", TRANSFORMED_IMAGES_FOLDER, imageHash[0], imageHash.c_str(),
+                                               Crc32::Compute(sourceHash), extension.c_str());
+  return URIUtils::AddFileToFolder(CProfilesManager::GetInstance().GetThumbnailsFolder(), file);
+}
+
+bool CHTTPImageTransformationCache::Transform(const std::string &imagePath, const std::string &cachedPath, size_t &size)
+{
+  uint8_t *buffer = nullptr;
+  size_t bufferSize = 0;
+  if (!CTextureCacheJob::ResizeTexture(imagePath, buffer, bufferSize))
+    return false;
+
+  const std::string folder = URIUtils::GetDirectory(cachedPath);
+  const std::string tempPath = cachedPath + ".tmp";
+  bool success = false;
+
+  // write to a temporary file first so that no request gets an incomplete image
+  XFILE::CFile file;
+  if (CUtil::CreateDirectoryEx(folder) && file.OpenForWrite(tempPath, true))
+  {
+    success = file.Write(buffer, bufferSize) == static_cast<ssize_t>(bufferSize);
+    file.Close();
+
+    if (success)
+      success = XFILE::CFile::Rename(tempPath, cachedPath);
+    if (!success)
+      XFILE::CFile::Delete(tempPath);
+  }
+  delete[] buffer;
+  size = bufferSize;
+
+  if (!success)
+  {
+    CLog::Log(LOGWARNING, "CHTTPImageTransformationCache: failed to store %s in %s", CURL::GetRedacted(imagePath).c_str(), cachedPath.c_str());
+    return false;
+  }
+
+  // variants created from an older version of the source image aren't needed anymore
+  const std::string prefix = URIUtils::GetFileName(cachedPath).substr(0, 33);
+  CFileItemList items;
+  if (XFILE::CDirectory::GetDirectory(folder, items, "", XFILE::DIR_FLAG_NO_FILE_DIRS | XFILE::DIR_FLAG_BYPASS_CACHE))
+  {
+    for (int i = 0; i < items.Size(); i++)
+    {
+      const std::string &path = items[i]->GetPath();
+      if (path != cachedPath && StringUtils::StartsWith(URIUtils::GetFileName(path), prefix))
+        DeleteUnlessInUse(path);
+    }
+  }
+
+  return true;
+}
@@ -0,0 +1,123 @@
+#pragma once
+/*
+ *      Copyright (C) 2017 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <map>
+#include <memory>
+#include <stdint.h>
+#include <string>
+#include <time.h>
+
+#include "threads/CriticalSection.h"
+#include "threads/Event.h"
+#include "utils/JobManager.h"
+
+/*!
+ * \brief Keeps transformed (resized) images on disk.
+ *
+ * \details Every variant of an image is stored in the thumbnails folder under
+ * a name built from the image URL including its transformation options and
+ * the hash of the source image, so variants survive restarts and a changed
+ * source image creates a new variant. Missing variants are created by a
+ * bounded number of jobs and concurrent requests for the same variant wait
+ * for the same job.
+ *
+ * Variants that weren't requested within the last 30 days are removed, and
+ * the least recently requested ones are removed while the variants exceed the
+ * maximum size. Variants handed out within the last minute are kept, as the
+ * request may not have opened them yet. The cleanup runs as a job after every new eighth of the
+ * maximum size written.
+ */
+class CHTTPImageTransformationCache
+{
+public:
+  static CHTTPImageTransformationCache& GetInstance();
+
+  /*!
+   * \brief Returns the path of the transformed image, creating it if necessary.
+   *
+   * \details Blocks until the transformed image is available.
+   *
+   * \param imagePath image:// URL of the image including its transformation options
+   * \param sourceHash Hash which changes whenever the source image changes
+   * \return Path of the transformed image or an empty string if it couldn't be created.
+   */
+  std::string GetTransformedImage(const std::string &imagePath, const std::string &sourceHash);
+
+  /*!
+   * \brief Sets the size all variants may take on disk.
+   *
+   * \details Defaults to the <webserver><transformedimagessize> advanced setting.
+   * Takes effect with the next cleanup.
+   */
+  void SetMaximumSize(uint64_t maximumSize);
+  uint64_t GetMaximumSize() const;
+
+  /*!
+   * \brief Sets for how many seconds a variant that was handed out is kept by the cleanup.
+   *
+   * \details Defaults to a minute, which leaves the request enough time to open the file.
+   */
+  void SetInUsePeriod(unsigned int seconds);
+  unsigned int GetInUsePeriod() const;
+
+  /*!
+   * \brief Removes outdated variants and the least recently requested ones above the maximum size.
+   */
+  void Cleanup();
+
+private:
+  CHTTPImageTransformationCache();
+  CHTTPImageTransformationCache(const CHTTPImageTransformationCache&) = delete;
+  CHTTPImageTransformationCache& operator=(const CHTTPImageTransformationCache&) = delete;
+  ~CHTTPImageTransformationCache() = default;
+
+  class CTransformationJob;
+  class CCleanupJob;
+
+  struct CTransformation
+  {
+    CTransformation() : done(true) { }
+
+    CEvent done;
+    bool success = false;
+  };
+  typedef std::shared_ptr<CTransformation> TransformationPtr;
+
+  void OnTransformationDone(const std::string &cachedPath, const TransformationPtr &transformation, bool success, size_t size);
+  void OnCleanupDone();
+  void OnAccess(const std::string &cachedPath);
+
+  static std::string GetCachedPath(const std::string &imagePath, const std::string &sourceHash);
+  bool Transform(const std::string &imagePath, const std::string &cachedPath, size_t &size);
+  bool DeleteUnlessInUse(const std::string &cachedPath);
+  bool IsInUse(const std::string &cachedPath, time_t now) const;
+  time_t GetLastAccess(const std::string &cachedPath) const;
+
+  mutable CCriticalSection m_critSection;
+  std::map<std::string, TransformationPtr> m_transformations; // in progress, by cached path
+  std::map<std::string, time_t> m_lastAccess;                 // when variants were last handed out in this run, by cached path
+  CJobQueue m_jobQueue;
+  uint64_t m_maximumSize;
+  unsigned int m_inUsePeriod;
+  uint64_t m_sizeSinceCleanup = 0; // bytes written since the last cleanup
+  bool m_cleanedUp = false;        // the variants left by earlier runs are only known after the first cleanup
+  bool m_cleanupQueued = false;
+};
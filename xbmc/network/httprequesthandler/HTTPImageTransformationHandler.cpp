@@ -21,6 +21,7 @@
 #include <map>
 
 #include "HTTPImageTransformationHandler.h"
+#include "HTTPImageTransformationCache.h"
 #include "TextureCacheJob.h"
 #include "URL.h"
 #include "filesystem/ImageFile.h"
@@ -38,7 +39,10 @@ static const std::string ImageBasePath = "/image/";
 
 CHTTPImageTransformationHandler::CHTTPImageTransformationHandler()
   : m_url(),
+    m_imagePath(),
     m_lastModified(),
+    m_validator(),
+    m_transformedImage(),
     m_buffer(NULL),
     m_responseData()
 { }
@@ -46,7 +50,10 @@ CHTTPImageTransformationHandler::CHTTPImageTransformationHandler()
 CHTTPImageTransformationHandler::CHTTPImageTransformationHandler(const HTTPRequest &request)
   : IHTTPRequestHandler(request),
     m_url(),
+    m_imagePath(),
     m_lastModified(),
+    m_validator(),
+    m_transformedImage(),
     m_buffer(NULL),
     m_responseData()
 {
@@ -70,6 +77,31 @@ CHTTPImageTransformationHandler::CHTTPImageTransformationHandler(const HTTPReque
   m_response.type = HTTPMemoryDownloadNoFreeCopy;
   m_response.status = MHD_HTTP_OK;
 
+  // get the transformation options
+  std::map<std::string, std::string> options;
+  HTTPRequestHandlerUtils::GetRequestHeaderValues(m_request.connection, MHD_GET_ARGUMENT_KIND, options);
+
+  std::vector<std::string> urlOptions;
+  std::map<std::string, std::string>::const_iterator option = options.find(TRANSFORMATION_OPTION_WIDTH);
+  if (option != options.end())
+    urlOptions.push_back(TRANSFORMATION_OPTION_WIDTH "=" + option->second);
+
+  option = options.find(TRANSFORMATION_OPTION_HEIGHT);
+  if (option != options.end())
+    urlOptions.push_back(TRANSFORMATION_OPTION_HEIGHT "=" + option->second);
+
+  option = options.find(TRANSFORMATION_OPTION_SCALING_ALGORITHM);
+  if (option != options.end())
+    urlOptions.push_back(TRANSFORMATION_OPTION_SCALING_ALGORITHM "=" + option->second);
+
+  // the transformed image only depends on the image and the transformation options
+  m_imagePath = m_url;
+  if (!urlOptions.empty())
+  {
+    m_imagePath += "?";
+    m_imagePath += StringUtils::Join(urlOptions, "&");
+  }
+
   // determine the content type
   std::string ext = URIUtils::GetExtension(pathToUrl.GetHostName());
   StringUtils::ToLower(ext);
@@ -82,6 +114,8 @@ CHTTPImageTransformationHandler::CHTTPImageTransformationHandler(const HTTPReque
   if (imageFile.Stat(pathToUrl, &statBuffer) != 0)
     return;
 
+  m_validator = StringUtils::Format("%" PRIx64 "-%" PRIx64, static_cast<uint64_t>(statBuffer.st_mtime), static_cast<uint64_t>(statBuffer.st_size));
+
   struct tm *time;
 #ifdef HAVE_LOCALTIME_R
   struct tm result = {};
@@ -98,7 +132,7 @@ CHTTPImageTransformationHandler::CHTTPImageTransformationHandler(const HTTPReque
 CHTTPImageTransformationHandler::~CHTTPImageTransformationHandler()
 {
   m_responseData.clear();
-  delete m_buffer;
+  delete[] m_buffer;
   m_buffer = NULL;
 }
 
@@ -130,33 +164,17 @@ int CHTTPImageTransformationHandler::HandleRequest()
     return MHD_YES;
   }
 
-  // get the transformation options
-  std::map<std::string, std::string> options;
-  HTTPRequestHandlerUtils::GetRequestHeaderValues(m_request.connection, MHD_GET_ARGUMENT_KIND, options);
-
-  std::vector<std::string> urlOptions;
-  std::map<std::string, std::string>::const_iterator option = options.find(TRANSFORMATION_OPTION_WIDTH);
-  if (option != options.end())
-    urlOptions.push_back(TRANSFORMATION_OPTION_WIDTH "=" + option->second);
-
-  option = options.find(TRANSFORMATION_OPTION_HEIGHT);
-  if (option != options.end())
-    urlOptions.push_back(TRANSFORMATION_OPTION_HEIGHT "=" + option->second);
-
-  option = options.find(TRANSFORMATION_OPTION_SCALING_ALGORITHM);
-  if (option != options.end())
-    urlOptions.push_back(TRANSFORMATION_OPTION_SCALING_ALGORITHM "=" + option->second);
-
-  std::string imagePath = m_url;
-  if (!urlOptions.empty())
+  // every variant of an image is only created once and then sent from the disk
+  m_transformedImage = CHTTPImageTransformationCache::GetInstance().GetTransformedImage(m_imagePath, m_validator);
+  if (!m_transformedImage.empty())
   {
-    imagePath += "?";
-    imagePath += StringUtils::Join(urlOptions, "&");
+    m_response.type = HTTPFileDownload;
+    return MHD_YES;
   }
 
   // resize the image into the local buffer
   size_t bufferSize;
-  if (!CTextureCacheJob::ResizeTexture(imagePath, m_buffer, bufferSize))
+  if (!CTextureCacheJob::ResizeTexture(m_imagePath, m_buffer, bufferSize))
   {
     m_response.status = MHD_HTTP_INTERNAL_SERVER_ERROR;
     m_response.type = HTTPError;
@@ -188,3 +206,11 @@ bool CHTTPImageTransformationHandler::GetLastModifiedDate(CDateTime &lastModifie
   lastModified = m_lastModified;
   return true;
 }
+
+std::string CHTTPImageTransformationHandler::GetResponseCacheKey() const
+{
+  if (m_response.type == HTTPError)
+    return "";
+
+  return m_imagePath;
+}
@@ -39,8 +39,11 @@ public:
   bool CanHandleRanges() const override { return true; }
   bool CanBeCached() const override { return true; }
   bool GetLastModifiedDate(CDateTime &lastModified) const override;
+  std::string GetResponseValidator() const override { return m_validator; }
+  std::string GetResponseCacheKey() const override;
 
   HttpResponseRanges GetResponseData() const override { return m_responseData; }
+  std::string GetResponseFile() const override { return m_transformedImage; }
 
   // priority must be higher than the one of CHTTPImageHandler
   int GetPriority() const override { return 6; }
@@ -50,7 +53,10 @@ protected:
 
 private:
   std::string m_url;
+  std::string m_imagePath;
   CDateTime m_lastModified;
+  std::string m_validator;
+  std::string m_transformedImage;
 
   uint8_t* m_buffer;
   HttpResponseRanges m_responseData;
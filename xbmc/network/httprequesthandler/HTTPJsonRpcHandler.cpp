@@ -26,6 +26,7 @@
 #include "interfaces/json-rpc/JSONUtils.h"
 #include "network/WebServer.h"
 #include "network/httprequesthandler/HTTPRequestHandlerUtils.h"
+#include "settings/AdvancedSettings.h"
 #include "utils/JSONVariantWriter.h"
 #include "utils/log.h"
 #include "utils/Variant.h"
@@ -84,14 +85,28 @@ int CHTTPJsonRpcHandler::HandleRequest()
 
   if (isRequest)
   {
-    m_responseData = JSONRPC::CJSONRPC::MethodCall(m_requestData, &m_transportLayer, &client);
+    // the first chunk tells if the response is small enough to be sent from memory
+    if (JSONRPC::CJSONRPC::MethodCall(m_requestData, &m_transportLayer, &client, m_responseValue))
+    {
+      m_responseWriter.reset(new CJSONVariantChunkedWriter(m_responseValue, g_advancedSettings.m_jsonOutputCompact));
+      if (!m_responseWriter->Next(m_responseData))
+      {
+        m_response.type = HTTPError;
+        m_response.status = MHD_HTTP_INTERNAL_SERVER_ERROR;
+
+        return MHD_YES;
+      }
+    }
 
     if (!jsonpCallback.empty())
-      m_responseData = jsonpCallback + "(" + m_responseData + ");";
+    {
+      m_responseData.insert(0, jsonpCallback + "(");
+      m_responseSuffix = ");";
+    }
   }
   else if (jsonpCallback.empty())
   {
-    // get the whole output of JSONRPC.Introspect
+    // get the whole output of JSONRPC.Introspect, it's sent from memory to be validated by its ETag
     CVariant result;
     JSONRPC::CJSONServiceDescription::Print(result, &m_transportLayer, &client);
     if (!CJSONVariantWriter::Write(result, m_responseData, false))
@@ -112,11 +127,25 @@ int CHTTPJsonRpcHandler::HandleRequest()
 
   m_requestData.clear();
 
+  m_response.status = MHD_HTTP_OK;
+  m_response.contentType = "application/json";
+
+  // a bigger response is written while it is sent
+  if (m_responseWriter != nullptr && !m_responseWriter->IsComplete())
+  {
+    m_response.type = HTTPStreamDownload;
+    m_response.totalLength = 0;
+
+    return MHD_YES;
+  }
+
+  m_responseData += m_responseSuffix;
+  m_responseWriter.reset();
+  m_responseValue = CVariant();
+
   m_responseRange.SetData(m_responseData.c_str(), m_responseData.size());
 
   m_response.type = HTTPMemoryDownloadNoFreeCopy;
-  m_response.status = MHD_HTTP_OK;
-  m_response.contentType = "application/json";
   m_response.totalLength = m_responseData.size();
 
   return MHD_YES;
@@ -130,6 +159,35 @@ HttpResponseRanges CHTTPJsonRpcHandler::GetResponseData() const
   return ranges;
 }
 
+bool CHTTPJsonRpcHandler::GetNextResponseChunk(std::string &chunk)
+{
+  // the first chunk was written while handling the request
+  if (!m_responseData.empty())
+  {
+    chunk.swap(m_responseData);
+    m_responseData.clear();
+    return true;
+  }
+
+  if (m_responseWriter == nullptr)
+  {
+    chunk.clear();
+    return true;
+  }
+
+  if (!m_responseWriter->Next(chunk))
+    return false;
+
+  if (m_responseWriter->IsComplete())
+  {
+    chunk += m_responseSuffix;
+    m_responseWriter.reset();
+    m_responseValue = CVariant();
+  }
+
+  return true;
+}
+
 #if (MHD_VERSION >= 0x00040001)
 bool CHTTPJsonRpcHandler::appendPostData(const char *data, size_t size)
 #else
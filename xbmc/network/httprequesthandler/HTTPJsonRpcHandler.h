@@ -19,11 +19,14 @@
  *
  */
 
+#include <memory>
 #include <string>
 
 #include "interfaces/json-rpc/IClient.h"
 #include "interfaces/json-rpc/ITransportLayer.h"
 #include "network/httprequesthandler/IHTTPRequestHandler.h"
+#include "utils/JSONVariantWriter.h"
+#include "utils/Variant.h"
 
 class CHTTPJsonRpcHandler : public IHTTPRequestHandler
 {
@@ -38,6 +41,7 @@ public:
   int HandleRequest() override;
 
   HttpResponseRanges GetResponseData() const override;
+  bool GetNextResponseChunk(std::string &chunk) override;
 
   int GetPriority() const override { return 5; }
 
@@ -56,6 +60,10 @@ private:
   std::string m_requestData;
   std::string m_responseData;
   CHttpResponseRange m_responseRange;
+  // a response bigger than a chunk is written while it is sent
+  CVariant m_responseValue;
+  std::unique_ptr<CJSONVariantChunkedWriter> m_responseWriter;
+  std::string m_responseSuffix;
 
   class CHTTPTransportLayer : public JSONRPC::ITransportLayer
   {
@@ -65,7 +65,9 @@ typedef enum HTTPResponseType
   HTTPMemoryDownloadFreeNoCopy,
   // creates a HTTP response from a buffer by copying followed by freeing the buffer
   // the buffer must have been malloc'ed and not new'ed
-  HTTPMemoryDownloadFreeCopy
+  HTTPMemoryDownloadFreeCopy,
+  // creates a HTTP response of unknown length from chunks taken from the handler while it is sent
+  HTTPStreamDownload
 } HTTPResponseType;
 
 typedef struct HTTPRequest
@@ -150,6 +152,24 @@ public:
   * \details This is only used if the response can be cached.
   */
   virtual bool GetLastModifiedDate(CDateTime &lastModified) const { return false; }
+
+  /*!
+  * \brief Returns a value which changes whenever the response data changes.
+  *
+  * \details The validator is used to create a strong ETag without handling
+  * the request and to detect outdated responses in the response cache of the
+  * web server. This is only used if the response can be cached.
+  */
+  virtual std::string GetResponseValidator() const { return ""; }
+
+  /*!
+  * \brief Returns the key of the response in the response cache of the web server.
+  *
+  * \details The key must contain all the request parameters the response
+  * data depends on. The response is only cached if it has a key and a
+  * validator.
+  */
+  virtual std::string GetResponseCacheKey() const { return ""; }
  
   /*!
    * \brief Returns the ranges with raw data belonging to the response.
@@ -172,6 +192,16 @@ public:
   */
   virtual std::string GetResponseFile() const { return ""; }
 
+  /*!
+  * \brief Returns the next chunk of the response data, an empty chunk ends the response.
+  *
+  * \details This is only used if the response type is HTTPStreamDownload. It
+  * is called while the response is sent, so the response data doesn't have
+  * to be held in memory as a whole.
+  * \return False if the response data couldn't be created, the response is aborted then.
+  */
+  virtual bool GetNextResponseChunk(std::string &chunk) { return false; }
+
   /*!
   * \brief Returns the HTTP request handled by the HTTP request handler.
   */
@@ -0,0 +1,146 @@
+/*
+ *      Copyright (C) 2017 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "TextureDatabase.h"
+#include "filesystem/File.h"
+#include "network/httprequesthandler/HTTPImageTransformationCache.h"
+#include "test/TestUtils.h"
+
+namespace
+{
+  std::string GetTestImage(const std::string &options)
+  {
+    return CTextureUtils::GetWrappedImageURL(XBMC_REF_FILE_PATH("xbmc/network/test/data/webserver/test.png"), "", options);
+  }
+}
+
+TEST(TestHTTPImageTransformationCache, CoalescesConcurrentTransformations)
+{
+  const std::string image = GetTestImage("width=8");
+  const size_t requests = 8;
+
+  std::vector<std::string> paths(requests);
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < requests; i++)
+    threads.emplace_back([&paths, &image, i]() { paths[i] = CHTTPImageTransformationCache::GetInstance().GetTransformedImage(image, "hash1"); });
+  for (auto& thread : threads)
+    thread.join();
+
+  ASSERT_FALSE(paths.front().empty());
+  for (const auto& path : paths)
+    EXPECT_EQ(paths.front(), path);
+  EXPECT_TRUE(XFILE::CFile::Exists(paths.front(), false));
+
+  // an existing variant is reused
+  EXPECT_EQ(paths.front(), CHTTPImageTransformationCache::GetInstance().GetTransformedImage(image, "hash1"));
+
+  // other transformation options are a different variant
+  const std::string otherPath = CHTTPImageTransformationCache::GetInstance().GetTransformedImage(GetTestImage("width=4"), "hash1");
+  ASSERT_FALSE(otherPath.empty());
+  EXPECT_NE(paths.front(), otherPath);
+
+  // a changed source image replaces the outdated variant once it isn't sent anymore
+  const std::string newPath = CHTTPImageTransformationCache::GetInstance().GetTransformedImage(image, "hash2");
+  ASSERT_FALSE(newPath.empty());
+  EXPECT_NE(paths.front(), newPath);
+  EXPECT_TRUE(XFILE::CFile::Exists(paths.front(), false));
+
+  const unsigned int inUsePeriod = CHTTPImageTransformationCache::GetInstance().GetInUsePeriod();
+  CHTTPImageTransformationCache::GetInstance().SetInUsePeriod(0);
+  // transform the new variant again now that the outdated one isn't in use anymore
+  XFILE::CFile::Delete(newPath);
+  EXPECT_EQ(newPath, CHTTPImageTransformationCache::GetInstance().GetTransformedImage(image, "hash2"));
+  CHTTPImageTransformationCache::GetInstance().SetInUsePeriod(inUsePeriod);
+  EXPECT_FALSE(XFILE::CFile::Exists(paths.front(), false));
+  EXPECT_TRUE(XFILE::CFile::Exists(otherPath, false));
+
+  XFILE::CFile::Delete(otherPath);
+  XFILE::CFile::Delete(newPath);
+}
+
+TEST(TestHTTPImageTransformationCache, FailsForMissingImages)
+{
+  EXPECT_TRUE(CHTTPImageTransformationCache::GetInstance().GetTransformedImage(
+    CTextureUtils::GetWrappedImageURL(XBMC_REF_FILE_PATH("xbmc/network/test/data/webserver/missing.png"), "", "width=8"), "hash").empty());
+}
+
+TEST(TestHTTPImageTransformationCache, EvictsLeastRecentlyRequestedVariantsAboveMaximumSize)
+{
+  CHTTPImageTransformationCache &cache = CHTTPImageTransformationCache::GetInstance();
+
+  const std::string firstPath = cache.GetTransformedImage(GetTestImage("width=6"), "evict");
+  ASSERT_FALSE(firstPath.empty());
+
+  // the access times have a resolution of a second
+  std::this_thread::sleep_for(std::chrono::milliseconds(1100));
+
+  const std::string secondPath = cache.GetTransformedImage(GetTestImage("width=5"), "evict");
+  ASSERT_FALSE(secondPath.empty());
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(1100));
+
+  // requesting the first variant again makes the second the least recently requested one
+  EXPECT_EQ(firstPath, cache.GetTransformedImage(GetTestImage("width=6"), "evict"));
+
+  struct __stat64 st;
+  ASSERT_EQ(0, XFILE::CFile::Stat(firstPath, &st));
+
+  // only one variant fits
+  const uint64_t maximumSize = cache.GetMaximumSize();
+  const unsigned int inUsePeriod = cache.GetInUsePeriod();
+  cache.SetMaximumSize(static_cast<uint64_t>(st.st_size));
+  cache.SetInUsePeriod(0);
+  cache.Cleanup();
+  cache.SetMaximumSize(maximumSize);
+  cache.SetInUsePeriod(inUsePeriod);
+
+  EXPECT_TRUE(XFILE::CFile::Exists(firstPath, false));
+  EXPECT_FALSE(XFILE::CFile::Exists(secondPath, false));
+
+  XFILE::CFile::Delete(firstPath);
+}
+
+TEST(TestHTTPImageTransformationCache, KeepsVariantsInUse)
+{
+  CHTTPImageTransformationCache &cache = CHTTPImageTransformationCache::GetInstance();
+
+  const std::string path = cache.GetTransformedImage(GetTestImage("width=7"), "inuse");
+  ASSERT_FALSE(path.empty());
+
+  // the variant was just handed out and may not have been opened yet
+  const uint64_t maximumSize = cache.GetMaximumSize();
+  cache.SetMaximumSize(0);
+  cache.Cleanup();
+  EXPECT_TRUE(XFILE::CFile::Exists(path, false));
+
+  const unsigned int inUsePeriod = cache.GetInUsePeriod();
+  cache.SetInUsePeriod(0);
+  cache.Cleanup();
+  cache.SetMaximumSize(maximumSize);
+  cache.SetInUsePeriod(inUsePeriod);
+
+  EXPECT_FALSE(XFILE::CFile::Exists(path, false));
+}
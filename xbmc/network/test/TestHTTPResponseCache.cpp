@@ -0,0 +1,214 @@
+/*
+ *      Copyright (C) 2017 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <algorithm>
+#include <memory>
+#include <string>
+
+#include <gtest/gtest.h>
+#include <zlib.h>
+#include "network/HTTPResponseCache.h"
+#include "utils/Variant.h"
+
+namespace
+{
+  CHTTPResponseCache::BufferPtr CreateData(size_t size, char c = 'a')
+  {
+    return std::make_shared<const std::string>(size, c);
+  }
+
+  // inflates gzip as well as zlib data
+  bool Decompress(const std::string &compressed, std::string &data)
+  {
+    z_stream stream = {};
+    if (inflateInit2(&stream, MAX_WBITS + 32) != Z_OK)
+      return false;
+
+    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(compressed.c_str()));
+    stream.avail_in = static_cast<uInt>(compressed.size());
+    int result = Z_OK;
+    while (result == Z_OK)
+    {
+      char buffer[4096];
+      stream.next_out = reinterpret_cast<Bytef*>(buffer);
+      stream.avail_out = sizeof(buffer);
+      result = inflate(&stream, Z_NO_FLUSH);
+      data.append(buffer, sizeof(buffer) - stream.avail_out);
+    }
+    inflateEnd(&stream);
+
+    return result == Z_STREAM_END && stream.avail_in == 0;
+  }
+}
+
+TEST(TestHTTPResponseCache, GetAcceptedEncodings)
+{
+  const int identity = 1 << HTTPContentEncodingIdentity;
+  const int gzip = 1 << HTTPContentEncodingGzip;
+  const int deflate = 1 << HTTPContentEncodingDeflate;
+
+  EXPECT_EQ(identity, CHTTPResponseCache::GetAcceptedEncodings(""));
+  EXPECT_EQ(identity | gzip, CHTTPResponseCache::GetAcceptedEncodings("gzip"));
+  EXPECT_EQ(identity | gzip | deflate, CHTTPResponseCache::GetAcceptedEncodings("deflate, GZIP;q=0.5, br"));
+  EXPECT_EQ(identity | deflate, CHTTPResponseCache::GetAcceptedEncodings("gzip;q=0, deflate"));
+  EXPECT_EQ(identity | gzip | deflate, CHTTPResponseCache::GetAcceptedEncodings("*"));
+
+  EXPECT_EQ(HTTPContentEncodingGzip, CHTTPResponseCache::GetPreferredEncoding(identity | gzip | deflate));
+  EXPECT_EQ(HTTPContentEncodingIdentity, CHTTPResponseCache::GetPreferredEncoding(identity));
+}
+
+TEST(TestHTTPResponseCache, MatchesETag)
+{
+  const std::string etag = CHTTPResponseCache::CreateETag("value");
+  ASSERT_EQ(34u, etag.size());
+
+  EXPECT_TRUE(CHTTPResponseCache::MatchesETag(etag, etag));
+  EXPECT_TRUE(CHTTPResponseCache::MatchesETag("\"other\", W/" + etag, etag));
+  EXPECT_TRUE(CHTTPResponseCache::MatchesETag(CHTTPResponseCache::GetETag(etag, HTTPContentEncodingGzip), etag));
+  EXPECT_TRUE(CHTTPResponseCache::MatchesETag("*", etag));
+  EXPECT_FALSE(CHTTPResponseCache::MatchesETag("\"other\"", etag));
+  EXPECT_FALSE(CHTTPResponseCache::MatchesETag("", etag));
+  EXPECT_FALSE(CHTTPResponseCache::MatchesETag("*", ""));
+}
+
+TEST(TestHTTPResponseCache, MatchesETagReturnsMatchingVariant)
+{
+  const std::string etag = CHTTPResponseCache::CreateETag("value");
+  const std::string gzipETag = CHTTPResponseCache::GetETag(etag, HTTPContentEncodingGzip);
+  std::string matchingETag;
+
+  /* a 304 has to carry the ETag of the variant the client has cached */
+  EXPECT_TRUE(CHTTPResponseCache::MatchesETag("\"other\", W/" + gzipETag, etag, matchingETag));
+  EXPECT_EQ(gzipETag, matchingETag);
+  EXPECT_TRUE(CHTTPResponseCache::MatchesETag(etag, etag, matchingETag));
+  EXPECT_EQ(etag, matchingETag);
+  EXPECT_TRUE(CHTTPResponseCache::MatchesETag("*", etag, matchingETag));
+  EXPECT_EQ(etag, matchingETag);
+}
+
+TEST(TestHTTPResponseCache, DropsChangedResponses)
+{
+  CHTTPResponseCache cache(1024 * 1024);
+  CHTTPResponseCache::CResponse response;
+
+  ASSERT_TRUE(cache.Put("key", "1", "image/png", "\"1\"", CreateData(100), 0, response));
+  ASSERT_TRUE(cache.Get("key", "1", 0, response));
+  EXPECT_EQ(100u, response.data->size());
+  EXPECT_STREQ("\"1\"", response.etag.c_str());
+
+  EXPECT_FALSE(cache.Get("key", "2", 0, response));
+  EXPECT_FALSE(cache.Get("key", "1", 0, response));
+}
+
+TEST(TestHTTPResponseCache, EvictsLeastRecentlyUsedResponses)
+{
+  CHTTPResponseCache cache(8 * 1000);
+  CHTTPResponseCache::CResponse response;
+
+  // responses above an eighth of the cache size aren't cached
+  EXPECT_FALSE(cache.Put("large", "1", "image/png", "\"1\"", CreateData(1001), 0, response));
+
+  for (int i = 0; i < 8; i++)
+    ASSERT_TRUE(cache.Put(std::to_string(i), "1", "image/png", "\"1\"", CreateData(990), 0, response));
+
+  // using the first response makes the second one the least recently used
+  ASSERT_TRUE(cache.Get("0", "1", 0, response));
+  ASSERT_TRUE(cache.Put("8", "1", "image/png", "\"1\"", CreateData(990), 0, response));
+
+  EXPECT_TRUE(cache.Get("0", "1", 0, response));
+  EXPECT_FALSE(cache.Get("1", "1", 0, response));
+  EXPECT_TRUE(cache.Get("8", "1", 0, response));
+
+  CVariant statistics;
+  cache.GetStatistics(statistics);
+  EXPECT_EQ(1u, statistics["evictions"].asUnsignedInteger());
+  EXPECT_GE(8000u, statistics["size"].asUnsignedInteger());
+}
+
+TEST(TestHTTPResponseCache, CompressesResponsesOnce)
+{
+  CHTTPResponseCache cache(1024 * 1024);
+  CHTTPResponseCache::CResponse response;
+  const int gzip = (1 << HTTPContentEncodingIdentity) | (1 << HTTPContentEncodingGzip);
+
+  ASSERT_TRUE(cache.Put("key", "1", "text/html; charset=utf-8", "\"1\"", CreateData(4096), gzip, response));
+  EXPECT_EQ(HTTPContentEncodingGzip, response.encoding);
+  EXPECT_GT(4096u, response.data->size());
+  EXPECT_STREQ("\"1-gzip\"", response.etag.c_str());
+
+  // clients without gzip support get the original data
+  ASSERT_TRUE(cache.Get("key", "1", 0, response));
+  EXPECT_EQ(HTTPContentEncodingIdentity, response.encoding);
+  EXPECT_EQ(4096u, response.data->size());
+
+  ASSERT_TRUE(cache.Get("key", "1", gzip, response));
+  EXPECT_EQ(HTTPContentEncodingGzip, response.encoding);
+
+  CVariant statistics;
+  cache.GetStatistics(statistics);
+  EXPECT_EQ(1u, statistics["compressions"].asUnsignedInteger());
+
+  // binary data isn't compressed
+  ASSERT_TRUE(cache.Put("image", "1", "image/png", "\"2\"", CreateData(4096), gzip, response));
+  EXPECT_EQ(HTTPContentEncodingIdentity, response.encoding);
+}
+
+TEST(TestHTTPResponseCache, StreamCompressorCompressesChunks)
+{
+  std::string data;
+  for (int i = 0; data.size() < 256 * 1024; i++)
+    data += "{\"movieid\": " + std::to_string(i) + ", \"label\": \"Movie " + std::to_string(i * 7919 % 1000) + "\"},";
+
+  for (HTTPContentEncoding encoding : { HTTPContentEncodingGzip, HTTPContentEncodingDeflate })
+  {
+    CHTTPStreamCompressor compressor;
+    ASSERT_TRUE(compressor.Initialize(encoding));
+    EXPECT_FALSE(compressor.Initialize(encoding));
+
+    std::string compressed;
+    const size_t chunkSize = 10000;
+    for (size_t position = 0; position < data.size(); position += chunkSize)
+    {
+      const size_t size = std::min(chunkSize, data.size() - position);
+      ASSERT_TRUE(compressor.Compress(data.c_str() + position, size, position + size == data.size(), compressed));
+    }
+    EXPECT_GT(data.size() / 2, compressed.size());
+
+    std::string decompressed;
+    ASSERT_TRUE(Decompress(compressed, decompressed));
+    EXPECT_EQ(data, decompressed);
+  }
+
+  CHTTPStreamCompressor identity;
+  EXPECT_FALSE(identity.Initialize(HTTPContentEncodingIdentity));
+}
+
+TEST(TestHTTPResponseCache, StreamCompressorCompletesEmptyStream)
+{
+  CHTTPStreamCompressor compressor;
+  ASSERT_TRUE(compressor.Initialize(HTTPContentEncodingGzip));
+
+  std::string compressed;
+  ASSERT_TRUE(compressor.Compress("", 0, true, compressed));
+
+  std::string decompressed;
+  ASSERT_TRUE(Decompress(compressed, decompressed));
+  EXPECT_TRUE(decompressed.empty());
+}
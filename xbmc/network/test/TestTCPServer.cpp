@@ -0,0 +1,321 @@
+/*
+ *      Copyright (C) 2017 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "system.h"
+
+#if defined(HAS_JSONRPC) && defined(TARGET_POSIX)
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "interfaces/json-rpc/JSONRPC.h"
+#include "interfaces/json-rpc/JSONServiceDescription.h"
+#include "network/TCPServer.h"
+#include "utils/JSONVariantParser.h"
+#include "utils/StringUtils.h"
+#include "utils/Variant.h"
+
+using namespace JSONRPC;
+
+namespace
+{
+  const char *TEST_METHOD_WAIT =
+    "\"Test.Wait\": {"
+      "\"type\": \"method\","
+      "\"transport\": \"Response\","
+      "\"permission\": \"ReadData\","
+      "\"params\": [],"
+      "\"returns\": \"string\""
+    "}";
+
+  const char *TEST_METHOD_LARGE =
+    "\"Test.Large\": {"
+      "\"type\": \"method\","
+      "\"transport\": \"Response\","
+      "\"permission\": \"ReadData\","
+      "\"params\": [],"
+      "\"returns\": \"array\""
+    "}";
+
+  const unsigned int LARGE_RESULT_ITEMS = 20000;
+
+  std::mutex s_waitMutex;
+  std::condition_variable s_waitCondition;
+  bool s_waitStarted = false;
+  bool s_waitReleased = false;
+  bool s_waitFinished = false;
+
+  // blocks until the test releases it, like a slow method call
+  JSONRPC_STATUS Wait(const std::string &method, ITransportLayer *transport, IClient *client, const CVariant &parameterObject, CVariant &result)
+  {
+    std::unique_lock<std::mutex> lock(s_waitMutex);
+    s_waitStarted = true;
+    s_waitCondition.notify_all();
+    s_waitCondition.wait_for(lock, std::chrono::seconds(10), []() { return s_waitReleased; });
+    s_waitFinished = true;
+
+    result = "released";
+    return OK;
+  }
+
+  // a result much bigger than a chunk of the response, like a whole library
+  JSONRPC_STATUS Large(const std::string &method, ITransportLayer *transport, IClient *client, const CVariant &parameterObject, CVariant &result)
+  {
+    result = CVariant(CVariant::VariantTypeArray);
+    for (unsigned int i = 0; i < LARGE_RESULT_ITEMS; i++)
+    {
+      CVariant item(CVariant::VariantTypeObject);
+      item["movieid"] = i;
+      item["label"] = StringUtils::Format("Movie %u", i);
+      result.push_back(item);
+    }
+    return OK;
+  }
+
+  int Connect(int port)
+  {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0)
+      return -1;
+
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (connect(fd, (sockaddr*)&addr, sizeof(addr)) < 0)
+    {
+      close(fd);
+      return -1;
+    }
+    return fd;
+  }
+
+  bool SendAll(int fd, const std::string& data)
+  {
+    size_t sent = 0;
+    while (sent < data.size())
+    {
+      ssize_t res = send(fd, data.c_str() + sent, data.size() - sent, 0);
+      if (res <= 0)
+        return false;
+      sent += res;
+    }
+    return true;
+  }
+
+  /* reads responses until count objects were received, unparsable ones are null */
+  std::vector<CVariant> ReceiveResponses(int fd, size_t count)
+  {
+    std::vector<CVariant> responses;
+    std::string response;
+    int depth = 0;
+    char buffer[4096];
+    while (responses.size() < count)
+    {
+      ssize_t res = recv(fd, buffer, sizeof(buffer), 0);
+      if (res <= 0)
+        break;
+
+      for (ssize_t i = 0; i < res; i++)
+      {
+        if (depth == 0 && buffer[i] != '{')
+          continue;
+
+        response.push_back(buffer[i]);
+        if (buffer[i] == '{')
+          depth++;
+        else if (buffer[i] == '}' && --depth == 0)
+        {
+          CVariant result;
+          if (!CJSONVariantParser::Parse(response, result))
+            result = CVariant();
+          responses.push_back(result);
+          response.clear();
+        }
+      }
+    }
+    return responses;
+  }
+
+  std::string GetRequests(size_t count)
+  {
+    std::string requests;
+    for (size_t i = 0; i < count; i++)
+      requests += StringUtils::Format("{ \"jsonrpc\": \"2.0\", \"method\": \"JSONRPC.Ping\", \"id\": %u }", static_cast<unsigned int>(i));
+    return requests;
+  }
+
+  /* every client pipelines its requests and checks that the responses arrive in order */
+  bool RunClient(int port, size_t requests)
+  {
+    int fd = Connect(port);
+    if (fd < 0)
+      return false;
+
+    bool ok = SendAll(fd, GetRequests(requests));
+    std::vector<CVariant> responses = ReceiveResponses(fd, requests);
+    close(fd);
+
+    ok &= responses.size() == requests;
+    for (size_t i = 0; ok && i < responses.size(); i++)
+      ok = responses[i]["result"].asString() == "pong" && responses[i]["id"].asInteger() == static_cast<int64_t>(i);
+    return ok;
+  }
+}
+
+class TestTCPServer : public testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    CJSONRPC::Initialize();
+    CJSONServiceDescription::AddMethod(TEST_METHOD_WAIT, Wait);
+    CJSONServiceDescription::AddMethod(TEST_METHOD_LARGE, Large);
+    s_waitStarted = false;
+    s_waitReleased = false;
+    s_waitFinished = false;
+
+    // an ephemeral port, so that parallel test runs don't collide
+    ASSERT_TRUE(CTCPServer::StartServer(0, false));
+    m_port = CTCPServer::GetPort();
+    ASSERT_NE(0, m_port);
+  }
+
+  void TearDown() override
+  {
+    ReleaseWait();
+    CTCPServer::StopServer(true);
+    CJSONRPC::Cleanup();
+  }
+
+  /* runs the clients in parallel, returns the number of clients that got all responses in order */
+  size_t RunClients(size_t clients, size_t requests)
+  {
+    std::vector<std::thread> threads;
+    std::vector<char> results(clients, 0);
+    const int port = m_port;
+    for (size_t i = 0; i < clients; i++)
+      threads.emplace_back([&results, i, port, requests]() { results[i] = RunClient(port, requests); });
+    for (auto& thread : threads)
+      thread.join();
+
+    size_t succeeded = 0;
+    for (char result : results)
+      succeeded += result ? 1 : 0;
+    return succeeded;
+  }
+
+  static bool WaitStarted()
+  {
+    std::unique_lock<std::mutex> lock(s_waitMutex);
+    return s_waitCondition.wait_for(lock, std::chrono::seconds(10), []() { return s_waitStarted; });
+  }
+
+  static bool WaitFinished()
+  {
+    std::unique_lock<std::mutex> lock(s_waitMutex);
+    return s_waitFinished;
+  }
+
+  static void ReleaseWait()
+  {
+    std::unique_lock<std::mutex> lock(s_waitMutex);
+    s_waitReleased = true;
+    s_waitCondition.notify_all();
+  }
+
+  int m_port = 0;
+};
+
+TEST_F(TestTCPServer, RespondsInRequestOrder)
+{
+  EXPECT_TRUE(RunClient(m_port, 100));
+}
+
+TEST_F(TestTCPServer, ConcurrentClientsRespondInRequestOrder)
+{
+  EXPECT_EQ(8u, RunClients(8, 100));
+}
+
+TEST_F(TestTCPServer, SlowCallDoesNotBlockOtherClients)
+{
+  int slow = Connect(m_port);
+  ASSERT_GE(slow, 0);
+  ASSERT_TRUE(SendAll(slow, "{ \"jsonrpc\": \"2.0\", \"method\": \"Test.Wait\", \"id\": 1 }"));
+  ASSERT_TRUE(WaitStarted());
+
+  // the other client is answered while the slow call is still running
+  EXPECT_TRUE(RunClient(m_port, 100));
+  EXPECT_FALSE(WaitFinished());
+
+  ReleaseWait();
+  std::vector<CVariant> responses = ReceiveResponses(slow, 1);
+  close(slow);
+  ASSERT_EQ(1u, responses.size());
+  EXPECT_EQ(1, responses[0]["id"].asInteger());
+  EXPECT_EQ("released", responses[0]["result"].asString());
+}
+
+TEST_F(TestTCPServer, LargeResponseIsSentCompletelyAndInOrder)
+{
+  int fd = Connect(m_port);
+  ASSERT_GE(fd, 0);
+
+  // the response is sent in chunks, the next response must not get in between
+  ASSERT_TRUE(SendAll(fd, "{ \"jsonrpc\": \"2.0\", \"method\": \"Test.Large\", \"id\": 1 }" + GetRequests(1)));
+  std::vector<CVariant> responses = ReceiveResponses(fd, 2);
+  close(fd);
+  ASSERT_EQ(2u, responses.size());
+
+  EXPECT_EQ(1, responses[0]["id"].asInteger());
+  const CVariant &result = responses[0]["result"];
+  ASSERT_TRUE(result.isArray());
+  ASSERT_EQ(LARGE_RESULT_ITEMS, result.size());
+  for (unsigned int i = 0; i < LARGE_RESULT_ITEMS; i++)
+    ASSERT_EQ(i, result[i]["movieid"].asUnsignedInteger());
+
+  EXPECT_EQ(0, responses[1]["id"].asInteger());
+  EXPECT_EQ("pong", responses[1]["result"].asString());
+}
+
+TEST_F(TestTCPServer, DISABLED_ThroughputBenchmark)
+{
+  const size_t clients = 32;
+  const size_t requests = 500;
+
+  auto start = std::chrono::steady_clock::now();
+  EXPECT_EQ(clients, RunClients(clients, requests));
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  std::cout << clients << " clients: " << static_cast<int64_t>(clients * requests / seconds) << " requests/s" << std::endl;
+}
+
+#endif
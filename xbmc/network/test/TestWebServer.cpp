@@ -28,6 +28,9 @@
 #include <errno.h>
 #include <stdlib.h>
 
+#include <chrono>
+#include <iostream>
+
 #include <gtest/gtest.h>
 #include "system.h"
 #include "URL.h"
@@ -37,6 +40,7 @@
 #include "network/WebServer.h"
 #include "network/httprequesthandler/HTTPVfsHandler.h"
 #ifdef HAS_JSONRPC
+#include "interfaces/json-rpc/JSONServiceDescription.h"
 #include "network/httprequesthandler/HTTPJsonRpcHandler.h"
 #endif // HAS_JSONRPC
 #include "settings/MediaSourceSettings.h"
@@ -58,6 +62,39 @@ using namespace XFILE;
 #define TEST_FILES_HTML         TEST_FILES_DATA ".html"
 #define TEST_FILES_RANGES       TEST_FILES_DATA "-ranges.txt"
 
+// the response cache holds responses up to 2 MiB with the default settings
+#define LARGE_FILE_CHUNK_SIZE   (1024u * 1024u)
+
+// a JSON-RPC result much bigger than a chunk of the streamed response
+#define LARGE_RESULT_ITEMS      20000u
+
+#ifdef HAS_JSONRPC
+namespace
+{
+  const char *TEST_METHOD_LARGE =
+    "\"Test.Large\": {"
+      "\"type\": \"method\","
+      "\"transport\": \"Response\","
+      "\"permission\": \"ReadData\","
+      "\"params\": [],"
+      "\"returns\": \"array\""
+    "}";
+
+  JSONRPC::JSONRPC_STATUS Large(const std::string &method, JSONRPC::ITransportLayer *transport, JSONRPC::IClient *client, const CVariant &parameterObject, CVariant &result)
+  {
+    result = CVariant(CVariant::VariantTypeArray);
+    for (unsigned int i = 0; i < LARGE_RESULT_ITEMS; i++)
+    {
+      CVariant item(CVariant::VariantTypeObject);
+      item["movieid"] = i;
+      item["label"] = StringUtils::Format("Movie %u", i);
+      result.push_back(item);
+    }
+    return JSONRPC::OK;
+  }
+}
+#endif // HAS_JSONRPC
+
 class TestWebServer : public testing::Test
 {
 protected:
@@ -90,11 +127,16 @@ protected:
   }
 
   void SetupMediaSources()
+  {
+    AddMediaSource(sourcePath);
+  }
+
+  void AddMediaSource(const std::string& path)
   {
     CMediaSource source;
     source.strName = "WebServer Share";
-    source.strPath = sourcePath;
-    source.vecPaths.push_back(sourcePath);
+    source.strPath = path;
+    source.vecPaths.push_back(path);
     source.m_allowSharing = true;
     source.m_iDriveType = CMediaSource::SOURCE_TYPE_LOCAL;
     source.m_iLockMode = LOCK_MODE_EVERYONE;
@@ -121,8 +163,12 @@ protected:
     if (testFile.empty())
       return "";
 
-    std::string path = URIUtils::AddFileToFolder(sourcePath, testFile);
-    path = CURL::Encode(path);
+    return GetUrlOfFile(URIUtils::AddFileToFolder(sourcePath, testFile));
+  }
+
+  std::string GetUrlOfFile(const std::string& filePath)
+  {
+    std::string path = CURL::Encode(filePath);
     path = URIUtils::AddFileToFolder("vfs", path);
 
     return GetUrl(path);
@@ -346,6 +392,29 @@ protected:
     return StringUtils::Format("bytes=%u-%u", start, end);
   }
 
+  // creates a local file which is too large for the response cache out of the given number of equal chunks
+  XFILE::CFile* CreateLargeTestFile(size_t chunks, std::string& chunk)
+  {
+    XFILE::CFile *file = XBMC_CREATETEMPFILE(".bin");
+    if (file == nullptr)
+      return nullptr;
+
+    chunk.assign(LARGE_FILE_CHUNK_SIZE, '\0');
+    for (size_t i = 0; i < LARGE_FILE_CHUNK_SIZE; i++)
+      chunk[i] = static_cast<char>(i % 251);
+    for (size_t i = 0; i < chunks; i++)
+    {
+      if (file->Write(chunk.c_str(), LARGE_FILE_CHUNK_SIZE) != static_cast<ssize_t>(LARGE_FILE_CHUNK_SIZE))
+      {
+        XBMC_DELETETEMPFILE(file);
+        return nullptr;
+      }
+    }
+    file->Flush();
+
+    return file;
+  }
+
   CWebServer webserver;
   CHTTPJsonRpcHandler m_jsonRpcHandler;
   CHTTPVfsHandler m_vfsHandler;
@@ -379,6 +448,49 @@ TEST_F(TestWebServer, CanGetJsonRpcApiDescriptionWithHttpGet)
   EXPECT_TRUE(cacheControl.find("no-cache") != std::string::npos);
 }
 
+TEST_F(TestWebServer, CanGetJsonRpcApiDescriptionWithHttpGetAndIfNoneMatch)
+{
+  std::string result;
+  CCurlFile curl;
+  ASSERT_TRUE(curl.Get(GetUrl(TEST_URL_JSONRPC), result));
+  ASSERT_FALSE(result.empty());
+
+  // the response must have a strong ETag
+  std::string etag = curl.GetHttpHeader().GetValue(MHD_HTTP_HEADER_ETAG);
+  ASSERT_TRUE(StringUtils::StartsWith(etag, "\""));
+
+  // an unchanged response isn't sent again
+  result.clear();
+  CCurlFile curlCached;
+  curlCached.SetRequestHeader(MHD_HTTP_HEADER_IF_NONE_MATCH, etag);
+  ASSERT_TRUE(curlCached.Get(GetUrl(TEST_URL_JSONRPC), result));
+  EXPECT_TRUE(result.empty());
+
+  const CHttpHeader& httpHeader = curlCached.GetHttpHeader();
+  EXPECT_TRUE(httpHeader.GetProtoLine().find(StringUtils::Format(" %d ", MHD_HTTP_NOT_MODIFIED)) != std::string::npos);
+  EXPECT_STREQ(etag.c_str(), httpHeader.GetValue(MHD_HTTP_HEADER_ETAG).c_str());
+}
+
+TEST_F(TestWebServer, CanGetCompressedJsonRpcApiDescriptionWithHttpGet)
+{
+  std::string result;
+  CCurlFile curl;
+  curl.SetAcceptEncoding("gzip");
+  ASSERT_TRUE(curl.Get(GetUrl(TEST_URL_JSONRPC), result));
+
+  // get the HTTP header details
+  const CHttpHeader& httpHeader = curl.GetHttpHeader();
+
+  // Content-Encoding must be "gzip" and the decoded response must be valid JSON
+  EXPECT_STREQ("gzip", httpHeader.GetValue(MHD_HTTP_HEADER_CONTENT_ENCODING).c_str());
+  EXPECT_TRUE(httpHeader.GetValue(MHD_HTTP_HEADER_VARY).find(MHD_HTTP_HEADER_ACCEPT_ENCODING) != std::string::npos);
+  EXPECT_TRUE(StringUtils::EndsWith(httpHeader.GetValue(MHD_HTTP_HEADER_ETAG), "-gzip\""));
+
+  CVariant resultObj;
+  ASSERT_TRUE(CJSONVariantParser::Parse(result, resultObj));
+  ASSERT_TRUE(resultObj.isObject());
+}
+
 TEST_F(TestWebServer, CanReadDataOverJsonRpcWithHttpGet)
 {
   // initialized JSON-RPC
@@ -483,6 +595,45 @@ TEST_F(TestWebServer, CanReadDataOverJsonRpcWithHttpPost)
   JSONRPC::CJSONRPC::Cleanup();
 }
 
+TEST_F(TestWebServer, CanReadLargeDataOverJsonRpcWithHttpPost)
+{
+  // initialized JSON-RPC
+  JSONRPC::CJSONRPC::Initialize();
+  JSONRPC::CJSONServiceDescription::AddMethod(TEST_METHOD_LARGE, Large);
+
+  for (const std::string encoding : { "", "gzip" })
+  {
+    std::string result;
+    CCurlFile curl;
+    curl.SetMimeType("application/json");
+    if (!encoding.empty())
+      curl.SetAcceptEncoding(encoding);
+    ASSERT_TRUE(curl.Post(GetUrl(TEST_URL_JSONRPC), "{ \"jsonrpc\": \"2.0\", \"method\": \"Test.Large\", \"id\": 1 }", result));
+
+    // get the HTTP header details
+    const CHttpHeader& httpHeader = curl.GetHttpHeader();
+
+    // the response is written while it is sent so its length isn't known in advance
+    EXPECT_STREQ("application/json", httpHeader.GetMimeType().c_str());
+    EXPECT_TRUE(httpHeader.GetValue(MHD_HTTP_HEADER_CONTENT_LENGTH).empty());
+    EXPECT_STREQ(encoding.c_str(), httpHeader.GetValue(MHD_HTTP_HEADER_CONTENT_ENCODING).c_str());
+
+    // parse the JSON-RPC response, it must contain the whole result in order
+    CVariant resultObj;
+    ASSERT_TRUE(CJSONVariantParser::Parse(result, resultObj));
+    ASSERT_TRUE(resultObj.isObject());
+    EXPECT_EQ(1, resultObj["id"].asInteger());
+    const CVariant &items = resultObj["result"];
+    ASSERT_TRUE(items.isArray());
+    ASSERT_EQ(LARGE_RESULT_ITEMS, items.size());
+    for (unsigned int i = 0; i < LARGE_RESULT_ITEMS; i++)
+      ASSERT_EQ(i, items[i]["movieid"].asUnsignedInteger());
+  }
+
+  // uninitialize JSON-RPC
+  JSONRPC::CJSONRPC::Cleanup();
+}
+
 TEST_F(TestWebServer, CanModifyOverJsonRpcWithHttpPost)
 {
   // initialized JSON-RPC
@@ -702,6 +853,60 @@ TEST_F(TestWebServer, CanGetCachedFileWithNewerIfUnmodifiedSince)
   CheckRangesTestFileResponse(curl);
 }
 
+TEST_F(TestWebServer, CanGetCachedFileWithMatchingIfNoneMatch)
+{
+  // get the ETag of the file
+  std::string result;
+  CCurlFile curl;
+  curl.SetRequestHeader(MHD_HTTP_HEADER_RANGE, "");
+  ASSERT_TRUE(curl.Get(GetUrlOfTestFile(TEST_FILES_RANGES), result));
+  EXPECT_STREQ(TEST_FILES_DATA_RANGES, result.c_str());
+  std::string etag = curl.GetHttpHeader().GetValue(MHD_HTTP_HEADER_ETAG);
+  ASSERT_FALSE(etag.empty());
+
+  // get the file again with the same ETag, If-None-Match takes precedence over an older If-Modified-Since
+  CDateTime lastModified;
+  ASSERT_TRUE(GetLastModifiedOfTestFile(TEST_FILES_RANGES, lastModified));
+  CDateTime lastModifiedOlder = lastModified - CDateTimeSpan(1, 0, 0, 0);
+
+  result.clear();
+  CCurlFile curlCached;
+  curlCached.SetRequestHeader(MHD_HTTP_HEADER_RANGE, "");
+  curlCached.SetRequestHeader(MHD_HTTP_HEADER_IF_NONE_MATCH, "\"other\", " + etag);
+  curlCached.SetRequestHeader(MHD_HTTP_HEADER_IF_MODIFIED_SINCE, lastModifiedOlder.GetAsRFC1123DateTime());
+  ASSERT_TRUE(curlCached.Get(GetUrlOfTestFile(TEST_FILES_RANGES), result));
+  EXPECT_TRUE(result.empty());
+
+  const CHttpHeader& httpHeader = curlCached.GetHttpHeader();
+  EXPECT_TRUE(httpHeader.GetProtoLine().find(StringUtils::Format(" %d ", MHD_HTTP_NOT_MODIFIED)) != std::string::npos);
+  EXPECT_STREQ(etag.c_str(), httpHeader.GetValue(MHD_HTTP_HEADER_ETAG).c_str());
+}
+
+TEST_F(TestWebServer, CanGetCachedFileWithDifferentIfNoneMatch)
+{
+  // get the file with a different ETag
+  std::string result;
+  CCurlFile curl;
+  curl.SetRequestHeader(MHD_HTTP_HEADER_RANGE, "");
+  curl.SetRequestHeader(MHD_HTTP_HEADER_IF_NONE_MATCH, "\"other\"");
+  ASSERT_TRUE(curl.Get(GetUrlOfTestFile(TEST_FILES_RANGES), result));
+  EXPECT_STREQ(TEST_FILES_DATA_RANGES, result.c_str());
+  CheckRangesTestFileResponse(curl);
+
+  // the file is served from the response cache the second time
+  result.clear();
+  CCurlFile curlCached;
+  curlCached.SetRequestHeader(MHD_HTTP_HEADER_RANGE, "");
+  ASSERT_TRUE(curlCached.Get(GetUrlOfTestFile(TEST_FILES_RANGES), result));
+  EXPECT_STREQ(TEST_FILES_DATA_RANGES, result.c_str());
+  CheckRangesTestFileResponse(curlCached);
+  EXPECT_STREQ(curl.GetHttpHeader().GetValue(MHD_HTTP_HEADER_ETAG).c_str(), curlCached.GetHttpHeader().GetValue(MHD_HTTP_HEADER_ETAG).c_str());
+
+  CVariant statistics;
+  webserver.GetResponseCacheStatistics(statistics);
+  EXPECT_LE(1u, statistics["hits"].asUnsignedInteger());
+}
+
 TEST_F(TestWebServer, CanGetRangedFileRange0_)
 {
   const std::string rangedFileContent = TEST_FILES_DATA_RANGES;
@@ -902,4 +1107,64 @@ TEST_F(TestWebServer, CanGetCachedRangedFileWithNewerIfRange)
   curl.SetRequestHeader(MHD_HTTP_HEADER_IF_RANGE, lastModifiedNewer.GetAsRFC1123DateTime());
   ASSERT_TRUE(curl.Get(GetUrlOfTestFile(TEST_FILES_RANGES), result));
   CheckRangesTestFileResponse(curl, result, ranges);
-}
\ No newline at end of file
+}
+
+TEST_F(TestWebServer, CanGetRangeOfLargeLocalFile)
+{
+  const size_t chunks = 3;
+  std::string chunk;
+  XFILE::CFile *file = CreateLargeTestFile(chunks, chunk);
+  ASSERT_TRUE(file != nullptr);
+
+  const std::string filePath = XBMC_TEMPFILEPATH(file);
+  AddMediaSource(CXBMCTestUtils::Instance().TempFileDirectory(file));
+
+  // a single range spanning a chunk boundary
+  std::string result;
+  CCurlFile curlRanged;
+  curlRanged.SetRequestHeader(MHD_HTTP_HEADER_RANGE, GenerateRangeHeaderValue(LARGE_FILE_CHUNK_SIZE - 10, LARGE_FILE_CHUNK_SIZE + 9));
+  ASSERT_TRUE(curlRanged.Get(GetUrlOfFile(filePath), result));
+  EXPECT_EQ(chunk.substr(LARGE_FILE_CHUNK_SIZE - 10) + chunk.substr(0, 10), result);
+  EXPECT_STREQ(StringUtils::Format("bytes %u-%u/%u", LARGE_FILE_CHUNK_SIZE - 10, LARGE_FILE_CHUNK_SIZE + 9,
+                                   static_cast<unsigned int>(LARGE_FILE_CHUNK_SIZE * chunks)).c_str(),
+               curlRanged.GetHttpHeader().GetValue(MHD_HTTP_HEADER_CONTENT_RANGE).c_str());
+
+  // the complete file
+  result.clear();
+  CCurlFile curl;
+  ASSERT_TRUE(curl.Get(GetUrlOfFile(filePath), result));
+  ASSERT_EQ(LARGE_FILE_CHUNK_SIZE * chunks, result.size());
+  EXPECT_EQ(0, result.compare(result.size() - LARGE_FILE_CHUNK_SIZE, LARGE_FILE_CHUNK_SIZE, chunk));
+
+  XBMC_DELETETEMPFILE(file);
+}
+
+// writes 64 MiB and downloads them 8 times, run it with --gtest_also_run_disabled_tests
+TEST_F(TestWebServer, DISABLED_LocalFileDownloadThroughputBenchmark)
+{
+  const size_t chunks = 64;
+  const size_t downloads = 8;
+
+  std::string chunk;
+  XFILE::CFile *file = CreateLargeTestFile(chunks, chunk);
+  ASSERT_TRUE(file != nullptr);
+
+  const std::string filePath = XBMC_TEMPFILEPATH(file);
+  AddMediaSource(CXBMCTestUtils::Instance().TempFileDirectory(file));
+
+  std::string result;
+  auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < downloads; i++)
+  {
+    result.clear();
+    CCurlFile curl;
+    ASSERT_TRUE(curl.Get(GetUrlOfFile(filePath), result));
+    ASSERT_EQ(LARGE_FILE_CHUNK_SIZE * chunks, result.size());
+  }
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  EXPECT_EQ(0, result.compare(result.size() - LARGE_FILE_CHUNK_SIZE, LARGE_FILE_CHUNK_SIZE, chunk));
+
+  std::cout << downloads * chunks / seconds << " MB/s" << std::endl;
+
+  XBMC_DELETETEMPFILE(file);
+}
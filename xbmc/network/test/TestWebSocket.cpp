@@ -0,0 +1,445 @@
+/*
+ *      Copyright (C) 2017 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "system.h"
+
+#if defined(HAS_JSONRPC) && defined(TARGET_POSIX)
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <iostream>
+#include <thread>
+#endif
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+#if defined(HAS_JSONRPC) && defined(TARGET_POSIX)
+#include "interfaces/json-rpc/JSONRPC.h"
+#include "network/TCPServer.h"
+#include "utils/JSONVariantParser.h"
+#include "utils/Variant.h"
+#endif
+#include "network/websocket/WebSocket.h"
+#include "network/websocket/WebSocketV13.h"
+
+#define WEBSOCKET_PORT 23458
+
+namespace
+{
+  std::string GetHandshake(const std::string &extensions)
+  {
+    std::string handshake = "GET /jsonrpc HTTP/1.1\r\n"
+                            "Host: localhost\r\n"
+                            "Upgrade: websocket\r\n"
+                            "Connection: Upgrade\r\n"
+                            "Sec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\n"
+                            "Sec-WebSocket-Version: 13\r\n";
+    if (!extensions.empty())
+      handshake += "Sec-WebSocket-Extensions: " + extensions + "\r\n";
+    return handshake + "\r\n";
+  }
+
+  bool OpenConnection(CWebSocket &websocket, const std::string &extensions, std::string &response)
+  {
+    const std::string handshake = GetHandshake(extensions);
+    return websocket.Handshake(handshake.c_str(), handshake.size(), response) && websocket.GetState() == WebSocketStateConnected;
+  }
+
+  /* a JSON-RPC like message which compresses well */
+  std::string GetJsonMessage(size_t size)
+  {
+    std::string message = "[";
+    for (size_t i = 0; message.size() < size; i++)
+      message += "{\"label\":\"Item " + std::to_string(i) + "\",\"type\":\"unknown\"},";
+    message.back() = ']';
+    return message;
+  }
+
+  /* the frames of a message as a client sends them */
+  std::string GetMaskedFrames(const std::string &message, size_t fragments)
+  {
+    std::string frames;
+    size_t fragmentSize = message.size() / fragments + 1;
+    for (size_t offset = 0; offset < message.size(); offset += fragmentSize)
+    {
+      size_t length = std::min(fragmentSize, message.size() - offset);
+      CWebSocketFrame frame(offset == 0 ? WebSocketTextFrame : WebSocketContinuationFrame, message.c_str() + offset,
+                            static_cast<uint32_t>(length), offset + length == message.size(), true, 0x12345678);
+      frames.append(frame.GetFrameData(), static_cast<size_t>(frame.GetFrameLength()));
+    }
+    return frames;
+  }
+
+  /* splits framed data into its frames, the frames point into the data */
+  std::vector<CWebSocketFrame*> GetFrames(const std::string &data)
+  {
+    std::vector<CWebSocketFrame*> frames;
+    uint64_t frameLength;
+    for (size_t offset = 0; CWebSocketFrame::ReadFrameLength(data.c_str() + offset, data.size() - offset, frameLength); offset += frameLength)
+      frames.push_back(new CWebSocketFrame(data.c_str() + offset, frameLength));
+    return frames;
+  }
+}
+
+TEST(TestWebSocket, NegotiatesPerMessageDeflate)
+{
+  std::string response;
+
+  CWebSocketV13 plain;
+  ASSERT_TRUE(OpenConnection(plain, "", response));
+  EXPECT_FALSE(plain.IsCompressing());
+  EXPECT_EQ(std::string::npos, response.find("Sec-WebSocket-Extensions"));
+
+  CWebSocketV13 compressing;
+  ASSERT_TRUE(OpenConnection(compressing, "permessage-deflate; client_max_window_bits", response));
+  EXPECT_TRUE(compressing.IsCompressing());
+  EXPECT_NE(std::string::npos, response.find("Sec-WebSocket-Extensions: permessage-deflate; server_no_context_takeover\r\n"));
+
+  // an offer limiting the window of the server is declined in favour of the next one
+  CWebSocketV13 fallback;
+  ASSERT_TRUE(OpenConnection(fallback, "permessage-deflate; server_max_window_bits=10, permessage-deflate; client_no_context_takeover", response));
+  EXPECT_TRUE(fallback.IsCompressing());
+  EXPECT_NE(std::string::npos, response.find("permessage-deflate; server_no_context_takeover; client_no_context_takeover\r\n"));
+
+  // the largest window is accepted and confirmed
+  CWebSocketV13 largestWindow;
+  ASSERT_TRUE(OpenConnection(largestWindow, "permessage-deflate; server_max_window_bits=15", response));
+  EXPECT_TRUE(largestWindow.IsCompressing());
+  EXPECT_NE(std::string::npos, response.find("Sec-WebSocket-Extensions: permessage-deflate; server_no_context_takeover; server_max_window_bits=15\r\n"));
+
+  CWebSocketV13 unknown;
+  ASSERT_TRUE(OpenConnection(unknown, "x-webkit-deflate-frame, permessage-deflate; unknown_parameter", response));
+  EXPECT_FALSE(unknown.IsCompressing());
+}
+
+TEST(TestWebSocket, ReceivesFramesSplitAcrossReads)
+{
+  CWebSocketV13 websocket;
+  std::string response;
+  ASSERT_TRUE(OpenConnection(websocket, "", response));
+
+  const std::string message = GetJsonMessage(1000);
+  const std::string frames = GetMaskedFrames(message, 3) + GetMaskedFrames("{}", 1);
+
+  std::vector<std::string> messages;
+  for (size_t offset = 0; offset < frames.size(); offset += 7)
+  {
+    response.clear();
+    ASSERT_TRUE(websocket.Receive(frames.c_str() + offset, std::min<size_t>(7, frames.size() - offset), messages, response));
+    EXPECT_TRUE(response.empty());
+  }
+
+  ASSERT_EQ(2u, messages.size());
+  EXPECT_EQ(message, messages[0]);
+  EXPECT_EQ("{}", messages[1]);
+}
+
+TEST(TestWebSocket, AnswersPingWithPayload)
+{
+  CWebSocketV13 websocket;
+  std::string response;
+  ASSERT_TRUE(OpenConnection(websocket, "", response));
+
+  CWebSocketFrame ping(WebSocketPing, "kodi", 4, true, true, 0x01020304);
+  std::vector<std::string> messages;
+  response.clear();
+  ASSERT_TRUE(websocket.Receive(ping.GetFrameData(), static_cast<size_t>(ping.GetFrameLength()), messages, response));
+  EXPECT_TRUE(messages.empty());
+
+  CWebSocketFrame pong(response.c_str(), response.size());
+  ASSERT_TRUE(pong.IsValid());
+  EXPECT_EQ(WebSocketPong, pong.GetOpcode());
+  EXPECT_EQ("kodi", std::string(pong.GetApplicationData(), static_cast<size_t>(pong.GetLength())));
+}
+
+TEST(TestWebSocket, FailsOnUnnegotiatedCompression)
+{
+  CWebSocketV13 websocket;
+  std::string response;
+  ASSERT_TRUE(OpenConnection(websocket, "", response));
+
+  CWebSocketFrame frame(WebSocketTextFrame, "{}", 2, true, true, 0x01020304, WEBSOCKET_EXTENSION_DEFLATE);
+  std::vector<std::string> messages;
+  response.clear();
+  EXPECT_FALSE(websocket.Receive(frame.GetFrameData(), static_cast<size_t>(frame.GetFrameLength()), messages, response));
+  EXPECT_EQ(WebSocketStateClosed, websocket.GetState());
+
+  CWebSocketFrame close(response.c_str(), response.size());
+  ASSERT_TRUE(close.IsValid());
+  EXPECT_EQ(WebSocketConnectionClose, close.GetOpcode());
+}
+
+TEST(TestWebSocket, CompressesLargeMessagesInFragments)
+{
+  std::string response;
+  CWebSocketV13 sender, receiver;
+  ASSERT_TRUE(OpenConnection(sender, "permessage-deflate", response));
+  ASSERT_TRUE(OpenConnection(receiver, "permessage-deflate", response));
+
+  const std::string message = GetJsonMessage(1024 * 1024);
+  std::string frames;
+  ASSERT_TRUE(sender.Frame(WebSocketTextFrame, message.c_str(), message.size(), frames));
+  EXPECT_GT(message.size() / 4, frames.size());
+
+  // only the first frame carries the opcode and the compression bit
+  std::vector<CWebSocketFrame*> parsed = GetFrames(frames);
+  ASSERT_LT(1u, parsed.size());
+  for (size_t i = 0; i < parsed.size(); i++)
+  {
+    EXPECT_TRUE(parsed[i]->IsValid());
+    EXPECT_EQ(i == 0 ? WebSocketTextFrame : WebSocketContinuationFrame, parsed[i]->GetOpcode());
+    EXPECT_EQ(i == 0 ? WEBSOCKET_EXTENSION_DEFLATE : 0, parsed[i]->GetExtension());
+    EXPECT_EQ(i == parsed.size() - 1, parsed[i]->IsFinal());
+    delete parsed[i];
+  }
+
+  // every message is compressed on its own, so it can be decompressed twice
+  for (int i = 0; i < 2; i++)
+  {
+    std::vector<std::string> messages;
+    ASSERT_TRUE(receiver.Receive(frames.c_str(), frames.size(), messages, response));
+    ASSERT_EQ(1u, messages.size());
+    EXPECT_EQ(message, messages.front());
+  }
+
+  // small messages aren't compressed
+  ASSERT_TRUE(sender.Frame(WebSocketTextFrame, "{}", 2, frames));
+  CWebSocketFrame small(frames.c_str(), frames.size());
+  EXPECT_EQ(0, small.GetExtension());
+  EXPECT_EQ("{}", std::string(small.GetApplicationData(), static_cast<size_t>(small.GetLength())));
+}
+
+#if defined(HAS_JSONRPC) && defined(TARGET_POSIX)
+
+namespace
+{
+  /*!
+   * A client of the JSON-RPC server, it decodes the frames of the server with
+   * a CWebSocketV13 which negotiated the same extensions as the server.
+   */
+  class CTestClient
+  {
+  public:
+    explicit CTestClient(bool compress)
+      : m_fd(-1),
+        m_handshake(GetHandshake(compress ? "permessage-deflate; client_max_window_bits" : ""))
+    { }
+
+    ~CTestClient()
+    {
+      if (m_fd >= 0)
+        close(m_fd);
+    }
+
+    bool Connect()
+    {
+      m_fd = socket(AF_INET, SOCK_STREAM, 0);
+      if (m_fd < 0)
+        return false;
+
+      sockaddr_in addr = {};
+      addr.sin_family = AF_INET;
+      addr.sin_port = htons(WEBSOCKET_PORT);
+      addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+      if (connect(m_fd, (sockaddr*)&addr, sizeof(addr)) < 0 || !SendAll(m_handshake))
+        return false;
+
+      // the response ends with an empty line, anything after it are frames
+      std::string response;
+      size_t end;
+      while ((end = response.find("\r\n\r\n")) == std::string::npos)
+      {
+        char buffer[1024];
+        ssize_t res = recv(m_fd, buffer, sizeof(buffer), 0);
+        if (res <= 0)
+          return false;
+        response.append(buffer, res);
+      }
+      m_data = response.substr(end + 4);
+
+      std::string decoderResponse;
+      if (response.compare(0, 12, "HTTP/1.1 101") != 0 || !OpenConnection(m_decoder, ExtensionsOf(m_handshake), decoderResponse))
+        return false;
+
+      // the server accepts the same extensions as the decoder
+      return (response.find("Sec-WebSocket-Extensions") != std::string::npos) == m_decoder.IsCompressing();
+    }
+
+    bool SendAll(const std::string &data)
+    {
+      size_t sent = 0;
+      while (sent < data.size())
+      {
+        ssize_t res = send(m_fd, data.c_str() + sent, data.size() - sent, 0);
+        if (res <= 0)
+          return false;
+        sent += res;
+      }
+      return true;
+    }
+
+    /* receives at least one more message */
+    bool Receive(std::vector<std::string> &messages)
+    {
+      size_t count = messages.size();
+      std::string response;
+      while (true)
+      {
+        if (!m_data.empty() && !m_decoder.Receive(m_data.c_str(), m_data.size(), messages, response))
+          return false;
+        m_data.clear();
+
+        if (messages.size() > count)
+          return true;
+
+        char buffer[16384];
+        ssize_t res = recv(m_fd, buffer, sizeof(buffer), 0);
+        if (res <= 0)
+          return false;
+        m_data.assign(buffer, res);
+      }
+    }
+
+  private:
+    static std::string ExtensionsOf(const std::string &handshake)
+    {
+      size_t pos = handshake.find("Sec-WebSocket-Extensions: ");
+      if (pos == std::string::npos)
+        return "";
+      pos += 26;
+      return handshake.substr(pos, handshake.find("\r\n", pos) - pos);
+    }
+
+    int m_fd;
+    std::string m_handshake;
+    std::string m_data;
+    CWebSocketV13 m_decoder;
+  };
+
+  std::string GetRequest(const std::string &method, size_t id)
+  {
+    return "{ \"jsonrpc\": \"2.0\", \"method\": \"" + method + "\", \"id\": " + std::to_string(id) + " }";
+  }
+
+  /* every client sends its requests, some of them fragmented, and checks that the responses arrive in order */
+  bool RunClient(bool compress, size_t requests)
+  {
+    CTestClient client(compress);
+    if (!client.Connect())
+      return false;
+
+    std::string frames;
+    for (size_t i = 0; i < requests; i++)
+      frames += GetMaskedFrames(GetRequest("JSONRPC.Ping", i), i % 2 + 1);
+    if (!client.SendAll(frames))
+      return false;
+
+    std::vector<std::string> messages;
+    while (messages.size() < requests)
+    {
+      if (!client.Receive(messages))
+        return false;
+    }
+
+    for (size_t i = 0; i < messages.size(); i++)
+    {
+      CVariant response;
+      if (!CJSONVariantParser::Parse(messages[i], response) || response["id"].asUnsignedInteger() != i || response["result"].asString() != "pong")
+        return false;
+    }
+    return true;
+  }
+}
+
+class TestWebSocketServer : public testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    JSONRPC::CJSONRPC::Initialize();
+    ASSERT_TRUE(JSONRPC::CTCPServer::StartServer(WEBSOCKET_PORT, false));
+  }
+
+  void TearDown() override
+  {
+    JSONRPC::CTCPServer::StopServer(true);
+    JSONRPC::CJSONRPC::Cleanup();
+  }
+
+  /* runs the clients in parallel, every other one with compression, returns the number of clients that got all responses in order */
+  size_t RunClients(size_t clients, size_t requests)
+  {
+    std::vector<std::thread> threads;
+    std::vector<char> results(clients, 0);
+    for (size_t i = 0; i < clients; i++)
+      threads.emplace_back([&results, i, requests]() { results[i] = RunClient(i % 2 == 0, requests); });
+    for (auto& thread : threads)
+      thread.join();
+
+    size_t succeeded = 0;
+    for (char result : results)
+      succeeded += result ? 1 : 0;
+    return succeeded;
+  }
+};
+
+TEST_F(TestWebSocketServer, RespondsInRequestOrder)
+{
+  EXPECT_TRUE(RunClient(false, 100));
+  EXPECT_TRUE(RunClient(true, 100));
+}
+
+TEST_F(TestWebSocketServer, StreamsLargeResponses)
+{
+  for (int compress = 0; compress < 2; compress++)
+  {
+    CTestClient client(compress != 0);
+    ASSERT_TRUE(client.Connect());
+    ASSERT_TRUE(client.SendAll(GetMaskedFrames(GetRequest("JSONRPC.Introspect", 1), 1)));
+
+    std::vector<std::string> messages;
+    ASSERT_TRUE(client.Receive(messages));
+    ASSERT_EQ(1u, messages.size());
+
+    CVariant response;
+    ASSERT_TRUE(CJSONVariantParser::Parse(messages.front(), response));
+    EXPECT_EQ(1u, response["id"].asUnsignedInteger());
+    EXPECT_TRUE(response["result"].isObject());
+  }
+}
+
+TEST_F(TestWebSocketServer, DISABLED_LoadBenchmark)
+{
+  const size_t clients = 256;
+  const size_t requests = 100;
+
+  auto start = std::chrono::steady_clock::now();
+  EXPECT_EQ(clients, RunClients(clients, requests));
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  std::cout << clients << " websocket clients: " << static_cast<int64_t>(clients * requests / seconds) << " requests/s" << std::endl;
+}
+
+#endif
@@ -18,6 +18,7 @@
  *
  */
 
+#include <algorithm>
 #include <string>
 #include <sstream>
 
@@ -41,6 +42,14 @@
 #define CONTROL_FRAME 0x08
 
 #define LENGTH_MIN    0x2
+#define LENGTH_MAX_HEADER (LENGTH_MIN + 8 + 4)
+
+// messages are sent in fragments of this size
+#define FRAGMENT_SIZE           (64 * 1024)
+// smaller messages aren't worth compressing
+#define MIN_COMPRESSIBLE_SIZE   128
+// larger messages (before and after decompression) fail the connection
+#define MAX_MESSAGE_SIZE        (16 * 1024 * 1024)
 
 CWebSocketFrame::CWebSocketFrame(const char* data, uint64_t length)
 {
@@ -56,9 +65,7 @@ CWebSocketFrame::CWebSocketFrame(const char* data, uint64_t length)
   // Get the FIN flag
   m_final = ((m_data[0] & MASK_FIN) == MASK_FIN);
   // Get the RSV1 - RSV3 flags
-  m_extension |= m_data[0] & MASK_RSV1;
-  m_extension |= (m_data[0] & MASK_RSV2) << 1;
-  m_extension |= (m_data[0] & MASK_RSV3) << 2;
+  m_extension = (m_data[0] & MASK_RSV) >> 4;
   // Get the opcode
   m_opcode = (WebSocketFrameOpcode)(m_data[0] & MASK_OPCODE);
   if (m_opcode >= WebSocketUnknownFrame)
@@ -95,15 +102,20 @@ CWebSocketFrame::CWebSocketFrame(const char* data, uint64_t length)
     return;
   }
 
+  // Frames can start anywhere in the received data, so don't assume any alignment
   int offset = 0;
   if (m_length == 126)
   {
-    m_length = (uint64_t)Endian_SwapBE16(*(uint16_t *)(m_data + 2));
+    uint16_t dataLength;
+    memcpy(&dataLength, m_data + LENGTH_MIN, 2);
+    m_length = (uint64_t)Endian_SwapBE16(dataLength);
     offset = 2;
   }
   else if (m_length == 127)
   {
-    m_length = Endian_SwapBE64(*(uint64_t *)(m_data + 2));
+    uint64_t dataLength;
+    memcpy(&dataLength, m_data + LENGTH_MIN, 8);
+    m_length = Endian_SwapBE64(dataLength);
     offset = 8;
   }
 
@@ -117,7 +129,7 @@ CWebSocketFrame::CWebSocketFrame(const char* data, uint64_t length)
   // Get the mask
   if (m_masked)
   {
-    m_mask = *(uint32_t *)(m_data + LENGTH_MIN + offset);
+    memcpy(&m_mask, m_data + LENGTH_MIN + offset, sizeof(m_mask));
     offset += 4;
   }
 
@@ -158,81 +170,122 @@ CWebSocketFrame::CWebSocketFrame(WebSocketFrameOpcode opcode, const char* data /
   m_final = final;
   m_extension = extension;
 
-  std::string buffer;
+  char header[LENGTH_MAX_HEADER];
+  size_t headerLength = WriteHeader(header, m_opcode, m_length, m_final, m_masked, m_mask, m_extension);
+
+  // Build the whole frame in a single allocation
+  m_lengthFrame = headerLength + (data ? m_length : 0);
+  char *frameData = new char[(size_t)m_lengthFrame];
+  memcpy(frameData, header, headerLength);
+
+  if (data)
+  {
+    m_applicationData = frameData + headerLength;
+
+    // Mask the application data if necessary
+    if (m_masked)
+    {
+      for (uint64_t index = 0; index < m_length; index++)
+        m_applicationData[index] = data[index] ^ ((char *)(&m_mask))[index % 4];
+    }
+    else
+      memcpy(m_applicationData, data, (size_t)m_length);
+  }
+
+  m_data = frameData;
+  m_valid = true;
+}
+
+size_t CWebSocketFrame::WriteHeader(char *header, WebSocketFrameOpcode opcode, uint64_t length,
+                                    bool final /* = true */, bool masked /* = false */, int32_t mask /* = 0 */, int8_t extension /* = 0 */)
+{
+  size_t headerLength = 0;
   char dataByte = 0;
 
   // Set the FIN flag
-  if (m_final)
+  if (final)
     dataByte |= MASK_FIN;
 
   // Set RSV1 - RSV3 flags
-  if (m_extension != 0)
-    dataByte |= (m_extension << 4) & MASK_RSV;
+  if (extension != 0)
+    dataByte |= (extension << 4) & MASK_RSV;
 
   // Set opcode flag
   dataByte |= opcode & MASK_OPCODE;
 
-  buffer.push_back(dataByte);
+  header[headerLength++] = dataByte;
   dataByte = 0;
 
   // Set MASK flag
-  if (m_masked)
+  if (masked)
     dataByte |= MASK_MASK;
 
   // Set payload length
-  if (m_length < 126)
+  if (length < 126)
+    header[headerLength++] = dataByte | (length & MASK_LENGTH);
+  else if (length <= 65535)
   {
-    dataByte |= m_length & MASK_LENGTH;
-    buffer.push_back(dataByte);
-  }
-  else if (m_length <= 65535)
-  {
-    dataByte |= 126 & MASK_LENGTH;
-    buffer.push_back(dataByte);
+    header[headerLength++] = dataByte | (126 & MASK_LENGTH);
 
-    uint16_t dataLength = Endian_SwapBE16((uint16_t)m_length);
-    buffer.append((const char*)&dataLength, 2);
+    uint16_t dataLength = Endian_SwapBE16((uint16_t)length);
+    memcpy(header + headerLength, &dataLength, 2);
+    headerLength += 2;
   }
   else
   {
-    dataByte |= 127 & MASK_LENGTH;
-    buffer.push_back(dataByte);
-    
-    uint64_t dataLength = Endian_SwapBE64(m_length);
-    buffer.append((const char*)&dataLength, 8);
+    header[headerLength++] = dataByte | (127 & MASK_LENGTH);
+
+    uint64_t dataLength = Endian_SwapBE64(length);
+    memcpy(header + headerLength, &dataLength, 8);
+    headerLength += 8;
   }
 
-  uint64_t applicationDataOffset = 0;
-  if (data)
+  // Set masking key
+  if (masked)
   {
-    // Set masking key
-    if (m_masked)
-    {
-      buffer.append((char *)&m_mask, sizeof(m_mask));
-      applicationDataOffset = buffer.size();
-
-      for (uint64_t index = 0; index < m_length; index++)
-        buffer.push_back(data[index] ^ ((char *)(&m_mask))[index % 4]);
-    }
-    else
-    {
-      applicationDataOffset = buffer.size();
-      buffer.append(data, (unsigned int)length);
-    }
+    memcpy(header + headerLength, &mask, sizeof(mask));
+    headerLength += sizeof(mask);
   }
 
-  // Get the whole data
-  m_lengthFrame = buffer.size();
-  m_data = new char[(uint32_t)m_lengthFrame];
-  memcpy((char *)m_data, buffer.c_str(), (uint32_t)m_lengthFrame);
+  return headerLength;
+}
 
-  if (data)
+bool CWebSocketFrame::ReadFrameLength(const char* data, uint64_t length, uint64_t &frameLength)
+{
+  if (data == NULL || length < LENGTH_MIN)
+    return false;
+
+  uint64_t payloadLength = (uint64_t)(data[1] & MASK_LENGTH);
+  uint64_t headerLength = LENGTH_MIN;
+  if (payloadLength == 126)
+    headerLength += 2;
+  else if (payloadLength == 127)
+    headerLength += 8;
+  if ((data[1] & MASK_MASK) == MASK_MASK)
+    headerLength += 4;
+
+  if (length < headerLength)
+    return false;
+
+  if (payloadLength == 126)
+  {
+    uint16_t dataLength;
+    memcpy(&dataLength, data + LENGTH_MIN, 2);
+    payloadLength = Endian_SwapBE16(dataLength);
+  }
+  else if (payloadLength == 127)
   {
-    m_applicationData = (char *)m_data;
-    m_applicationData += applicationDataOffset;
+    uint64_t dataLength;
+    memcpy(&dataLength, data + LENGTH_MIN, 8);
+    payloadLength = Endian_SwapBE64(dataLength);
   }
 
-  m_valid = true;
+  if (payloadLength > UINT64_MAX - headerLength)
+    frameLength = UINT64_MAX;
+  else
+    frameLength = headerLength + payloadLength;
+
+  return true;
 }
 
 CWebSocketFrame::~CWebSocketFrame()
@@ -441,3 +494,221 @@ const CWebSocketMessage* CWebSocket::Send(WebSocketFrameOpcode opcode, const cha
 
   return NULL;
 }
+
+bool CWebSocket::Receive(const char* data, size_t length, std::vector<std::string> &messages, std::string &response)
+{
+  if (m_state != WebSocketStateConnected && m_state != WebSocketStateClosing)
+  {
+    CLog::Log(LOGINFO, "WebSocket: No frame expected in the current state");
+    return false;
+  }
+
+  m_receiveBuffer.append(data, length);
+
+  bool success = true;
+  size_t offset = 0;
+  while (success && m_state != WebSocketStateClosed)
+  {
+    uint64_t frameLength;
+    if (!CWebSocketFrame::ReadFrameLength(m_receiveBuffer.c_str() + offset, m_receiveBuffer.size() - offset, frameLength))
+      break;
+
+    // don't wait for a frame which would be dropped anyway
+    if (frameLength > MAX_MESSAGE_SIZE + LENGTH_MAX_HEADER)
+    {
+      CLog::Log(LOGINFO, "WebSocket: Frame exceeding the maximum message size received");
+      success = FailConnection(WebSocketCloseFrameTooLarge, response);
+      break;
+    }
+
+    if (frameLength > m_receiveBuffer.size() - offset)
+      break;
+
+    // the frame unmasks the application data in place
+    CWebSocketFrame *frame = GetFrame(&m_receiveBuffer[offset], frameLength);
+    offset += (size_t)frameLength;
+
+    success = HandleFrame(frame, messages, response);
+    delete frame;
+  }
+
+  m_receiveBuffer.erase(0, offset);
+
+  return success;
+}
+
+bool CWebSocket::Frame(WebSocketFrameOpcode opcode, const char* data, size_t length, std::string &frames)
+{
+  if (opcode != WebSocketTextFrame && opcode != WebSocketBinaryFrame)
+  {
+    CLog::Log(LOGINFO, "WebSocket: Trying to send a message with an invalid opcode %2X", opcode);
+    return false;
+  }
+
+  bool compress = m_deflate.IsEnabled() && length >= MIN_COMPRESSIBLE_SIZE;
+
+  frames.clear();
+  frames.reserve(length + (length / FRAGMENT_SIZE + 1) * LENGTH_MAX_HEADER);
+
+  size_t offset = 0;
+  do
+  {
+    size_t fragmentLength = std::min(length - offset, (size_t)FRAGMENT_SIZE);
+    bool first = offset == 0;
+    bool final = offset + fragmentLength == length;
+
+    const char *payload = data + offset;
+    size_t payloadLength = fragmentLength;
+    if (compress)
+    {
+      if (!m_deflate.Compress(payload, fragmentLength, first, final, m_compressedFragment))
+      {
+        CLog::Log(LOGERROR, "WebSocket: Failed to compress a message");
+        return false;
+      }
+
+      // a message in a single frame which doesn't get smaller is sent uncompressed
+      if (first && final && m_compressedFragment.size() >= length)
+        compress = false;
+      else
+      {
+        payload = m_compressedFragment.c_str();
+        payloadLength = m_compressedFragment.size();
+      }
+    }
+
+    char header[LENGTH_MAX_HEADER];
+    size_t headerLength = CWebSocketFrame::WriteHeader(header, first ? opcode : WebSocketContinuationFrame, payloadLength, final,
+                                                       false, 0, first && compress ? WEBSOCKET_EXTENSION_DEFLATE : 0);
+    frames.append(header, headerLength);
+    if (payloadLength > 0)
+      frames.append(payload, payloadLength);
+
+    offset += fragmentLength;
+  } while (offset < length);
+
+  return true;
+}
+
+bool CWebSocket::HandleFrame(const CWebSocketFrame *frame, std::vector<std::string> &messages, std::string &response)
+{
+  if (!frame->IsValid())
+  {
+    CLog::Log(LOGINFO, "WebSocket: Invalid frame received");
+    return FailConnection(WebSocketCloseProtocolError, response);
+  }
+
+  if (m_state == WebSocketStateClosing)
+  {
+    // only the closing handshake of the client is expected
+    if (frame->GetOpcode() == WebSocketConnectionClose)
+      m_state = WebSocketStateClosed;
+    return true;
+  }
+
+  if (frame->IsControlFrame())
+  {
+    if (frame->GetExtension() != 0)
+    {
+      CLog::Log(LOGINFO, "WebSocket: Control frame with extension bits received");
+      return FailConnection(WebSocketCloseProtocolError, response);
+    }
+
+    const CWebSocketFrame *reply = NULL;
+    switch (frame->GetOpcode())
+    {
+      case WebSocketPing:
+        // a pong echoes the application data of the ping
+        reply = GetFrame(WebSocketPong, frame->GetApplicationData(), (uint32_t)frame->GetLength());
+        break;
+
+      case WebSocketConnectionClose:
+        CLog::Log(LOGINFO, "WebSocket: connection closed by client");
+        reply = Close();
+        m_state = WebSocketStateClosed;
+        break;
+
+      default:
+        break;
+    }
+
+    if (reply != NULL)
+    {
+      if (reply->IsValid())
+        response.append(reply->GetFrameData(), (size_t)reply->GetFrameLength());
+      delete reply;
+    }
+
+    return true;
+  }
+
+  int8_t extension = frame->GetExtension();
+  if (frame->GetOpcode() == WebSocketContinuationFrame)
+  {
+    if (m_messageOpcode == WebSocketUnknownFrame || extension != 0)
+    {
+      CLog::Log(LOGINFO, "WebSocket: Unexpected continuation frame received");
+      return FailConnection(WebSocketCloseProtocolError, response);
+    }
+  }
+  else
+  {
+    if (m_messageOpcode != WebSocketUnknownFrame)
+    {
+      CLog::Log(LOGINFO, "WebSocket: New message received before the previous one was complete");
+      return FailConnection(WebSocketCloseProtocolError, response);
+    }
+
+    if (extension != 0 && (extension != WEBSOCKET_EXTENSION_DEFLATE || !m_deflate.IsEnabled()))
+    {
+      CLog::Log(LOGINFO, "WebSocket: Frame with unnegotiated extension bits received");
+      return FailConnection(WebSocketCloseProtocolError, response);
+    }
+
+    m_messageOpcode = frame->GetOpcode();
+    m_messageCompressed = extension != 0;
+    m_messageData.clear();
+  }
+
+  if (m_messageData.size() + frame->GetLength() > MAX_MESSAGE_SIZE)
+  {
+    CLog::Log(LOGINFO, "WebSocket: Message exceeding the maximum message size received");
+    return FailConnection(WebSocketCloseFrameTooLarge, response);
+  }
+
+  if (frame->GetLength() > 0)
+    m_messageData.append(frame->GetApplicationData(), (size_t)frame->GetLength());
+
+  if (!frame->IsFinal())
+    return true;
+
+  m_messageOpcode = WebSocketUnknownFrame;
+  if (!m_messageCompressed)
+  {
+    messages.push_back(m_messageData);
+    return true;
+  }
+
+  messages.push_back(std::string());
+  if (!m_deflate.Decompress(m_messageData.c_str(), m_messageData.size(), MAX_MESSAGE_SIZE, messages.back()))
+  {
+    messages.pop_back();
+    return FailConnection(WebSocketCloseProtocolError, response);
+  }
+
+  return true;
+}
+
+bool CWebSocket::FailConnection(WebSocketCloseReason reason, std::string &response)
+{
+  const CWebSocketFrame *frame = Close(reason);
+  if (frame != NULL)
+  {
+    if (frame->IsValid())
+      response.append(frame->GetFrameData(), (size_t)frame->GetFrameLength());
+    delete frame;
+  }
+
+  Fail();
+  return false;
+}
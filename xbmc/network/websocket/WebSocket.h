@@ -20,8 +20,14 @@
 #pragma once
  
 #include <stdint.h>
+#include <string>
 #include <vector>
 
+#include "WebSocketDeflate.h"
+
+// RSV1 marks compressed messages of the permessage-deflate extension (RFC 7692)
+#define WEBSOCKET_EXTENSION_DEFLATE 0x04
+
 enum WebSocketFrameOpcode
 {
   WebSocketContinuationFrame  = 0x00,
@@ -75,6 +81,22 @@ public:
   virtual const char* GetFrameData() const { return m_data; }
   virtual const char* GetApplicationData() const { return m_applicationData; }
 
+  /*!
+   * \brief Writes the header of a frame.
+   *
+   * \param header Buffer of at least 14 bytes
+   * \return Length of the header.
+   */
+  static size_t WriteHeader(char *header, WebSocketFrameOpcode opcode, uint64_t length, bool final = true, bool masked = false, int32_t mask = 0, int8_t extension = 0);
+
+  /*!
+   * \brief Reads the length of the frame at the beginning of the data.
+   *
+   * \param frameLength Set to the length of the whole frame, which may exceed the given data
+   * \return False if the data doesn't contain the complete frame header.
+   */
+  static bool ReadFrameLength(const char* data, uint64_t length, uint64_t &frameLength);
+
 protected:
   bool m_free;
   const char *m_data;
@@ -117,7 +139,7 @@ protected:
 class CWebSocket
 {
 public:
-  CWebSocket() { m_state = WebSocketStateNotConnected; m_message = NULL; }
+  CWebSocket() { m_state = WebSocketStateNotConnected; m_message = NULL; m_messageOpcode = WebSocketUnknownFrame; m_messageCompressed = false; }
   virtual ~CWebSocket() { if (m_message) delete m_message; };
 
   int GetVersion() { return m_version; }
@@ -126,6 +148,37 @@ public:
   virtual bool Handshake(const char* data, size_t length, std::string &response) = 0;
   virtual const CWebSocketMessage* Handle(const char* &buffer, size_t &length, bool &send);
   virtual const CWebSocketMessage* Send(WebSocketFrameOpcode opcode, const char* data = NULL, uint32_t length = 0);
+
+  /*!
+   * \brief Handles received data, which doesn't have to end at a frame boundary.
+   *
+   * \details Incomplete frames and fragments of messages are kept until the
+   * rest of them is received. Compressed messages are decompressed.
+   *
+   * \param data Received data
+   * \param length Length of the received data
+   * \param messages Receives the payload of every completely received message
+   * \param response Receives the frames to send back, like pong and close frames
+   * \return False if the connection failed, otherwise true.
+   */
+  bool Receive(const char* data, size_t length, std::vector<std::string> &messages, std::string &response);
+
+  /*!
+   * \brief Frames a text or binary message for sending.
+   *
+   * \details Large messages are split into fragments, so the client can start
+   * processing them early. If permessage-deflate was negotiated the fragments
+   * are compressed one after the other. Server frames aren't masked and don't
+   * depend on earlier messages, so the result can be sent to every client with
+   * the same IsCompressing() value.
+   *
+   * \param frames Set to the frames of the message
+   * \return False if the message couldn't be framed.
+   */
+  bool Frame(WebSocketFrameOpcode opcode, const char* data, size_t length, std::string &frames);
+
+  bool IsCompressing() const { return m_deflate.IsEnabled(); }
+
   virtual const CWebSocketFrame* Ping(const char* data = NULL) const = 0;
   virtual const CWebSocketFrame* Pong(const char* data = NULL) const = 0;
   virtual const CWebSocketFrame* Close(WebSocketCloseReason reason = WebSocketCloseNormal, const std::string &message = "") = 0;
@@ -135,8 +188,20 @@ protected:
   int m_version;
   WebSocketState m_state;
   CWebSocketMessage *m_message;
+  CWebSocketDeflate m_deflate;
 
   virtual CWebSocketFrame* GetFrame(const char* data, uint64_t length) = 0;
   virtual CWebSocketFrame* GetFrame(WebSocketFrameOpcode opcode, const char* data = NULL, uint32_t length = 0, bool final = true, bool masked = false, int32_t mask = 0, int8_t extension = 0) = 0;
   virtual CWebSocketMessage* GetMessage() = 0;
+
+private:
+  bool HandleFrame(const CWebSocketFrame *frame, std::vector<std::string> &messages, std::string &response);
+  bool FailConnection(WebSocketCloseReason reason, std::string &response);
+
+  // the buffers keep their memory for the whole connection
+  std::string m_receiveBuffer;          // received data which doesn't form a complete frame yet
+  std::string m_messageData;            // payload of the fragments of the message being received
+  std::string m_compressedFragment;     // the fragment of the message being sent, compressed
+  WebSocketFrameOpcode m_messageOpcode; // opcode of the message being received, WebSocketUnknownFrame if none
+  bool m_messageCompressed;
 };
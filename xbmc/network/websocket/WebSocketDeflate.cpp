@@ -0,0 +1,250 @@
+/*
+ *      Copyright (C) 2017 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "WebSocketDeflate.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <vector>
+
+#include <zlib.h>
+
+#include "utils/StringUtils.h"
+#include "utils/log.h"
+
+#define WS_EXTENSION_DEFLATE                "permessage-deflate"
+#define WS_PARAM_SERVER_NO_CONTEXT_TAKEOVER "server_no_context_takeover"
+#define WS_PARAM_CLIENT_NO_CONTEXT_TAKEOVER "client_no_context_takeover"
+#define WS_PARAM_SERVER_MAX_WINDOW_BITS     "server_max_window_bits"
+#define WS_PARAM_CLIENT_MAX_WINDOW_BITS     "client_max_window_bits"
+
+#define INFLATE_CHUNK_SIZE                  16384
+
+// every compressed message ends with an empty stored block which isn't sent (RFC 7692 7.2.1)
+static const char DeflateTail[] = { '\x00', '\x00', '\xff', '\xff' };
+
+CWebSocketDeflate::CWebSocketDeflate()
+  : m_enabled(false)
+{ }
+
+CWebSocketDeflate::~CWebSocketDeflate()
+{
+  if (m_deflateStream)
+    deflateEnd(m_deflateStream.get());
+  if (m_inflateStream)
+    inflateEnd(m_inflateStream.get());
+}
+
+bool CWebSocketDeflate::Negotiate(const std::string &offers, std::string &response)
+{
+  m_enabled = false;
+  response.clear();
+
+  std::vector<std::string> extensions = StringUtils::Split(offers, ",");
+  for (std::vector<std::string>::const_iterator extension = extensions.begin(); extension != extensions.end(); ++extension)
+  {
+    if (AcceptOffer(*extension, response))
+    {
+      m_enabled = true;
+      return true;
+    }
+  }
+
+  return false;
+}
+
+bool CWebSocketDeflate::AcceptOffer(const std::string &offer, std::string &response)
+{
+  std::vector<std::string> parameters = StringUtils::Split(offer, ";");
+  if (parameters.empty() || !StringUtils::EqualsNoCase(StringUtils::Trim(parameters.front()), WS_EXTENSION_DEFLATE))
+    return false;
+
+  // the server never uses context takeover, see the class description
+  response = WS_EXTENSION_DEFLATE "; " WS_PARAM_SERVER_NO_CONTEXT_TAKEOVER;
+
+  std::vector<std::string> names;
+  for (std::vector<std::string>::iterator parameter = parameters.begin() + 1; parameter != parameters.end(); ++parameter)
+  {
+    std::string name = *parameter, value;
+    size_t pos = name.find('=');
+    if (pos != std::string::npos)
+    {
+      value = name.substr(pos + 1);
+      name.erase(pos);
+      StringUtils::Trim(value);
+      StringUtils::Trim(value, "\"");
+    }
+    StringUtils::Trim(name);
+    StringUtils::ToLower(name);
+
+    // every parameter may only be offered once
+    if (std::find(names.begin(), names.end(), name) != names.end())
+      return false;
+    names.push_back(name);
+
+    if (name == WS_PARAM_SERVER_NO_CONTEXT_TAKEOVER && value.empty())
+      continue;
+
+    if (name == WS_PARAM_CLIENT_NO_CONTEXT_TAKEOVER && value.empty())
+    {
+      response += "; " WS_PARAM_CLIENT_NO_CONTEXT_TAKEOVER;
+      continue;
+    }
+
+    // inflating with the largest window works for every window size of the client
+    if (name == WS_PARAM_CLIENT_MAX_WINDOW_BITS &&
+        (value.empty() || (StringUtils::IsNaturalNumber(value) && atoi(value.c_str()) >= 8 && atoi(value.c_str()) <= 15)))
+      continue;
+
+    // all clients share the compressed messages so the window can't be reduced for some of them.
+    // a parameter the client offered with a value has to be answered (RFC 7692 7.1.2.1)
+    if (name == WS_PARAM_SERVER_MAX_WINDOW_BITS && value == "15")
+    {
+      response += "; " WS_PARAM_SERVER_MAX_WINDOW_BITS "=15";
+      continue;
+    }
+
+    CLog::Log(LOGDEBUG, "WebSocket: declining %s offer with parameter %s", WS_EXTENSION_DEFLATE, name.c_str());
+    return false;
+  }
+
+  return true;
+}
+
+bool CWebSocketDeflate::Compress(const char *data, size_t length, bool first, bool final, std::string &compressed)
+{
+  if (!m_enabled)
+    return false;
+
+  if (!m_deflateStream)
+  {
+    m_deflateStream.reset(new z_stream());
+    if (deflateInit2(m_deflateStream.get(), Z_DEFAULT_COMPRESSION, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+    {
+      CLog::Log(LOGERROR, "WebSocket: failed to initialize the deflate stream");
+      m_deflateStream.reset();
+      m_enabled = false;
+      return false;
+    }
+  }
+  else if (first)
+    deflateReset(m_deflateStream.get());
+
+  z_stream *stream = m_deflateStream.get();
+  stream->next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data));
+  stream->avail_in = static_cast<uInt>(length);
+
+  // the buffer keeps its capacity, so it is only allocated for the largest fragment
+  size_t size = 0;
+  compressed.resize(deflateBound(stream, length) + sizeof(DeflateTail) * 2);
+  do
+  {
+    if (size == compressed.size())
+      compressed.resize(compressed.size() * 2);
+
+    stream->next_out = reinterpret_cast<Bytef*>(&compressed[size]);
+    stream->avail_out = static_cast<uInt>(compressed.size() - size);
+
+    int result = deflate(stream, Z_SYNC_FLUSH);
+    size = compressed.size() - stream->avail_out;
+    if (result != Z_OK && result != Z_BUF_ERROR)
+      return false;
+  } while (stream->avail_out == 0);
+
+  // every fragment ends on a byte boundary, only the tail of the whole message is removed
+  if (final && size >= sizeof(DeflateTail) && compressed.compare(size - sizeof(DeflateTail), sizeof(DeflateTail), DeflateTail, sizeof(DeflateTail)) == 0)
+    size -= sizeof(DeflateTail);
+
+  compressed.resize(size);
+  return true;
+}
+
+bool CWebSocketDeflate::Decompress(const char *data, size_t length, size_t maximumSize, std::string &decompressed)
+{
+  if (!m_enabled)
+    return false;
+
+  if (!m_inflateStream)
+  {
+    m_inflateStream.reset(new z_stream());
+    if (inflateInit2(m_inflateStream.get(), -MAX_WBITS) != Z_OK)
+    {
+      CLog::Log(LOGERROR, "WebSocket: failed to initialize the inflate stream");
+      m_inflateStream.reset();
+      return false;
+    }
+  }
+
+  size_t size = 0;
+  bool ended = false;
+  decompressed.clear();
+  if (!Inflate(data, length, maximumSize, decompressed, size, ended) ||
+      (!ended && !Inflate(DeflateTail, sizeof(DeflateTail), maximumSize, decompressed, size, ended)))
+    return false;
+
+  decompressed.resize(size);
+  return true;
+}
+
+bool CWebSocketDeflate::Inflate(const char *data, size_t length, size_t maximumSize, std::string &decompressed, size_t &size, bool &ended)
+{
+  z_stream *stream = m_inflateStream.get();
+  stream->next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data));
+  stream->avail_in = static_cast<uInt>(length);
+
+  do
+  {
+    if (size == decompressed.size())
+    {
+      if (size >= maximumSize)
+      {
+        CLog::Log(LOGINFO, "WebSocket: decompressed message exceeds %u bytes", static_cast<unsigned int>(maximumSize));
+        return false;
+      }
+      decompressed.resize(std::min(std::max<size_t>(size * 2, INFLATE_CHUNK_SIZE), maximumSize));
+    }
+
+    stream->next_out = reinterpret_cast<Bytef*>(&decompressed[size]);
+    stream->avail_out = static_cast<uInt>(decompressed.size() - size);
+
+    int result = inflate(stream, Z_SYNC_FLUSH);
+    size = decompressed.size() - stream->avail_out;
+
+    // the client ended the message with a final block, the next message starts a new stream
+    if (result == Z_STREAM_END)
+    {
+      inflateReset(stream);
+      ended = true;
+      return true;
+    }
+
+    if (result == Z_BUF_ERROR && stream->avail_in == 0)
+      break;
+
+    if (result != Z_OK && result != Z_BUF_ERROR)
+    {
+      CLog::Log(LOGINFO, "WebSocket: invalid compressed message received");
+      inflateReset(stream);
+      return false;
+    }
+  } while (stream->avail_in > 0 || stream->avail_out == 0);
+
+  return true;
+}
@@ -0,0 +1,85 @@
+#pragma once
+/*
+ *      Copyright (C) 2017 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <memory>
+#include <string>
+
+struct z_stream_s;
+
+/*!
+ * \brief The permessage-deflate extension of WebSocket connections (RFC 7692).
+ *
+ * \details Messages sent by the server are always compressed without context
+ * takeover, so a compressed message can be sent to every client which
+ * negotiated the extension. Messages received from the client are
+ * decompressed by a single inflate stream for the whole connection, which
+ * works whether the client uses context takeover or not.
+ */
+class CWebSocketDeflate
+{
+public:
+  CWebSocketDeflate();
+  ~CWebSocketDeflate();
+
+  /*!
+   * \brief Accepts the first permessage-deflate offer the server supports.
+   *
+   * \param offers Value of the Sec-WebSocket-Extensions header of the handshake
+   * \param response Set to the value of the Sec-WebSocket-Extensions header of the handshake response
+   * \return True if the extension was negotiated, otherwise false.
+   */
+  bool Negotiate(const std::string &offers, std::string &response);
+  bool IsEnabled() const { return m_enabled; }
+
+  /*!
+   * \brief Compresses the next fragment of a message.
+   *
+   * \param data Data of the fragment
+   * \param length Length of the data
+   * \param first Whether this is the first fragment of the message
+   * \param final Whether this is the last fragment of the message
+   * \param compressed Set to the compressed fragment, its memory is reused
+   * \return True if the data was compressed, otherwise false.
+   */
+  bool Compress(const char *data, size_t length, bool first, bool final, std::string &compressed);
+
+  /*!
+   * \brief Decompresses a complete message.
+   *
+   * \param data Payload of all frames of the message
+   * \param length Length of the payload
+   * \param maximumSize Maximum size of the decompressed message
+   * \param decompressed Set to the decompressed message
+   * \return True if the message was decompressed, otherwise false.
+   */
+  bool Decompress(const char *data, size_t length, size_t maximumSize, std::string &decompressed);
+
+private:
+  CWebSocketDeflate(const CWebSocketDeflate&) = delete;
+  CWebSocketDeflate& operator=(const CWebSocketDeflate&) = delete;
+
+  static bool AcceptOffer(const std::string &offer, std::string &response);
+  bool Inflate(const char *data, size_t length, size_t maximumSize, std::string &decompressed, size_t &size, bool &ended);
+
+  bool m_enabled;
+  std::unique_ptr<z_stream_s> m_deflateStream; // created on first use
+  std::unique_ptr<z_stream_s> m_inflateStream; // created on first use
+};
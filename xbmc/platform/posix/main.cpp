@@ -80,6 +80,16 @@ void XBMC_POSIX_HandleSignal(int sig)
   thread->Create(true);
 }
 
+void XBMC_POSIX_HandleCrash(int sig)
+{
+  // the log is written by a background thread, write what it didn't take yet.
+  // this only uses async-signal-safe calls, the messages are already formatted.
+  // the handler was reset to the default action on entry, raising the signal
+  // again terminates the process
+  CLog::WriteQueuedOnCrash();
+  raise(sig);
+}
+
 }
 
 }
@@ -105,6 +115,14 @@ int main(int argc, char* argv[])
   sigaction(SIGINT, &signalHandler, nullptr);
   sigaction(SIGTERM, &signalHandler, nullptr);
 
+  // Write queued log messages on crashes
+  struct sigaction crashHandler;
+  std::memset(&crashHandler, 0, sizeof(crashHandler));
+  crashHandler.sa_handler = &XBMC_POSIX_HandleCrash;
+  crashHandler.sa_flags = SA_RESETHAND;
+  for (int sig : { SIGSEGV, SIGBUS, SIGFPE, SIGILL, SIGABRT })
+    sigaction(sig, &crashHandler, nullptr);
+
   setlocale(LC_NUMERIC, "C");
  
   // Initialize before CAppParamParser so it can set the log level
@@ -118,5 +118,8 @@ extern "C" int XBMC_Run(bool renderGUI, const CAppParamParser &params)
   CXBMCApp::get()->Deinitialize();
 #endif
 
+  // write the messages still queued for the log file before the process exits
+  CLog::Flush();
+
   return status;
 }
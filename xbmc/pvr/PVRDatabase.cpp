@@ -286,6 +286,7 @@ int CPVRDatabase::Get(CPVRChannelGroup &results, bool bCompressDB)
         PVRChannelGroupMember newMember = { channel, static_cast<unsigned int>(m_pDS->fv("iChannelNumber").get_asInt()) };
         results.m_sortedMembers.emplace_back(newMember);
         results.m_members.insert(std::make_pair(channel->StorageId(), newMember));
+        results.InvalidateMemberIndex();
 
         m_pDS->next();
         ++iReturn;
@@ -588,6 +589,7 @@ int CPVRDatabase::Get(CPVRChannelGroup &group, const CPVRChannelGroup &allGroup)
           PVRChannelGroupMember newMember = { channel->second, static_cast<unsigned int>(m_pDS->fv("iChannelNumber").get_asInt()) };
           group.m_sortedMembers.emplace_back(newMember);
           group.m_members.insert(std::make_pair(channel->second->StorageId(), newMember));
+          group.InvalidateMemberIndex();
           ++iReturn;
         }
         else
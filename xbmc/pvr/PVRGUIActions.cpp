@@ -36,6 +36,7 @@
 #include "messaging/ApplicationMessenger.h"
 #include "settings/MediaSettings.h"
 #include "settings/Settings.h"
+#include "threads/SystemClock.h"
 #include "threads/Thread.h"
 #include "utils/StringUtils.h"
 #include "utils/URIUtils.h"
@@ -1000,6 +1001,10 @@ namespace PVR
 
   void CPVRGUIActions::StartPlayback(CFileItem *item, bool bFullscreen) const
   {
+    // stamp channel switches, the player logs the time it took until the first frame
+    if (item->IsPVRChannel())
+      item->SetProperty("zapstarttime", XbmcThreads::SystemClockMillis());
+
     // Obtain dynamic playback url and properties from the respective pvr client
     CServiceBroker::GetPVRManager().FillStreamFileItem(*item);
 
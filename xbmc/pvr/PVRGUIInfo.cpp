@@ -66,6 +66,7 @@ void CPVRGUIInfo::ResetProperties(void)
   m_strBackendRecordings        .clear();
   m_strBackendDeletedRecordings .clear();
   m_strBackendChannels          .clear();
+  m_strBackendResponseTime      .clear();
   m_iBackendDiskTotal           = 0;
   m_iBackendDiskUsed            = 0;
   m_iDuration                   = 0;
@@ -411,6 +412,9 @@ bool CPVRGUIInfo::TranslateCharInfo(DWORD dwInfo, std::string &strValue) const
   case PVR_BACKEND_NUMBER:
     CharInfoBackendNumber(strValue);
     break;
+  case PVR_BACKEND_RESPONSE_TIME:
+    CharInfoBackendResponseTime(strValue);
+    break;
   case PVR_TOTAL_DISKSPACE:
     CharInfoTotalDiskSpace(strValue);
     break;
@@ -964,6 +968,12 @@ void CPVRGUIInfo::CharInfoBackendDeletedRecordings(std::string &strValue) const
   strValue = m_strBackendDeletedRecordings;
 }
 
+void CPVRGUIInfo::CharInfoBackendResponseTime(std::string &strValue) const
+{
+  m_updateBackendCacheRequested = true;
+  strValue = m_strBackendResponseTime;
+}
+
 void CPVRGUIInfo::CharInfoPlayingClientName(std::string &strValue) const
 {
   if (m_strPlayingClientName.empty())
@@ -1043,6 +1053,7 @@ void CPVRGUIInfo::UpdateBackendCache(void)
   m_strBackendTimers = g_localizeStrings.Get(13205);
   m_strBackendRecordings = g_localizeStrings.Get(13205);
   m_strBackendDeletedRecordings = g_localizeStrings.Get(13205);
+  m_strBackendResponseTime = g_localizeStrings.Get(13205);
   m_iBackendDiskTotal = 0;
   m_iBackendDiskUsed = 0;
 
@@ -1067,6 +1078,9 @@ void CPVRGUIInfo::UpdateBackendCache(void)
     if (backend.numDeletedRecordings >= 0)
       m_strBackendDeletedRecordings = StringUtils::Format("%i", backend.numDeletedRecordings);
 
+    if (backend.responseTime > 0)
+      m_strBackendResponseTime = StringUtils::Format("%u ms", backend.responseTime);
+
     m_iBackendDiskTotal = backend.diskTotal;
     m_iBackendDiskUsed = backend.diskUsed;
   }
@@ -212,6 +212,7 @@ namespace PVR
     void CharInfoBackendTimers(std::string &strValue) const;
     void CharInfoBackendRecordings(std::string &strValue) const;
     void CharInfoBackendDeletedRecordings(std::string &strValue) const;
+    void CharInfoBackendResponseTime(std::string &strValue) const;
     void CharInfoPlayingClientName(std::string &strValue) const;
     void CharInfoEncryption(std::string &strValue) const;
     void CharInfoService(std::string &strValue) const;
@@ -238,6 +239,7 @@ namespace PVR
     std::string                     m_strBackendRecordings;
     std::string                     m_strBackendDeletedRecordings;
     std::string                     m_strBackendChannels;
+    std::string                     m_strBackendResponseTime;
     long long                       m_iBackendDiskTotal;
     long long                       m_iBackendDiskUsed;
     unsigned int                    m_iDuration;
@@ -148,11 +148,22 @@ bool CPVRRecordingsUpdateJob::DoWork(void)
   return true;
 }
 
+bool CPVRRecordingEntriesUpdateJob::DoWork(void)
+{
+  CServiceBroker::GetPVRManager().Recordings()->ProcessEntryChanges();
+  return true;
+}
+
 bool CPVRTimersUpdateJob::DoWork(void)
 {
   return CServiceBroker::GetPVRManager().Timers()->Update();
 }
 
+bool CPVRTimerEntriesUpdateJob::DoWork(void)
+{
+  return CServiceBroker::GetPVRManager().Timers()->ProcessEntryChanges();
+}
+
 bool CPVRChannelsUpdateJob::DoWork(void)
 {
   return CServiceBroker::GetPVRManager().ChannelGroups()->Update(true);
@@ -152,6 +152,16 @@ namespace PVR
     bool DoWork() override;
   };
 
+  class CPVRRecordingEntriesUpdateJob : public CJob
+  {
+  public:
+    CPVRRecordingEntriesUpdateJob(void) = default;
+    ~CPVRRecordingEntriesUpdateJob() override = default;
+    const char *GetType() const override { return "pvr-update-recording-entries"; }
+
+    bool DoWork() override;
+  };
+
   class CPVRTimersUpdateJob : public CJob
   {
   public:
@@ -162,6 +172,16 @@ namespace PVR
     bool DoWork() override;
   };
 
+  class CPVRTimerEntriesUpdateJob : public CJob
+  {
+  public:
+    CPVRTimerEntriesUpdateJob(void) = default;
+    ~CPVRTimerEntriesUpdateJob() override = default;
+    const char *GetType() const override { return "pvr-update-timer-entries"; }
+
+    bool DoWork() override;
+  };
+
   class CPVRChannelsUpdateJob : public CJob
   {
   public:
@@ -1055,11 +1055,21 @@ void CPVRManager::TriggerRecordingsUpdate(void)
   m_pendingUpdates.AppendJob(new CPVRRecordingsUpdateJob());
 }
 
+void CPVRManager::TriggerRecordingEntriesUpdate(void)
+{
+  m_pendingUpdates.AppendJob(new CPVRRecordingEntriesUpdateJob());
+}
+
 void CPVRManager::TriggerTimersUpdate(void)
 {
   m_pendingUpdates.AppendJob(new CPVRTimersUpdateJob());
 }
 
+void CPVRManager::TriggerTimerEntriesUpdate(void)
+{
+  m_pendingUpdates.AppendJob(new CPVRTimerEntriesUpdateJob());
+}
+
 void CPVRManager::TriggerChannelsUpdate(void)
 {
   m_pendingUpdates.AppendJob(new CPVRChannelsUpdateJob());
@@ -373,11 +373,21 @@ namespace PVR
      */
     void TriggerRecordingsUpdate(void);
 
+    /*!
+     * @brief Let the background thread apply the recording changes announced by the clients.
+     */
+    void TriggerRecordingEntriesUpdate(void);
+
     /*!
      * @brief Let the background thread update the timer list.
      */
     void TriggerTimersUpdate(void);
 
+    /*!
+     * @brief Let the background thread apply the timer changes announced by the clients.
+     */
+    void TriggerTimerEntriesUpdate(void);
+
     /*!
      * @brief Let the background thread update the channel list.
      */
@@ -28,6 +28,8 @@
 #include "addons/BinaryAddonCache.h"
 #include "guilib/LocalizeStrings.h"
 #include "messaging/ApplicationMessenger.h"
+#include "threads/SystemClock.h"
+#include "utils/JobManager.h"
 #include "utils/log.h"
 
 #include "pvr/PVRJobs.h"
@@ -42,8 +44,23 @@ using namespace ADDON;
 using namespace PVR;
 using namespace KODI::MESSAGING;
 
+namespace PVR
+{
+  struct SPVRClientCall
+  {
+    explicit SPVRClientCall(const std::function<PVR_ERROR(void)> &clientFunction) : function(clientFunction), done(true) {}
+
+    std::function<PVR_ERROR(void)> function;
+    PVR_ERROR error = PVR_ERROR_SERVER_ERROR;
+    unsigned int iDuration = 0; /*!< time in ms the client took to answer */
+    CEvent done;
+  };
+}
+
 namespace
 {
+  const unsigned int CLIENT_CALL_TIMEOUT = 60000; /*!< time in ms to wait for a client to answer */
+
   int ClientIdFromAddonId(const std::string &strID)
   {
     std::hash<std::string> hasher;
@@ -53,6 +70,42 @@ namespace
     return iClientId;
   }
 
+  class CPVRClientCallJob : public CJob
+  {
+  public:
+    explicit CPVRClientCallJob(const std::shared_ptr<SPVRClientCall> &call) : m_call(call) {}
+    ~CPVRClientCallJob(void) override { m_call->done.Set(); } // also reached if the job is cancelled before it ran
+
+    bool DoWork(void) override
+    {
+      const unsigned int iStartTime = XbmcThreads::SystemClockMillis();
+      m_call->error = m_call->function();
+      m_call->iDuration = XbmcThreads::SystemClockMillis() - iStartTime;
+      return true;
+    }
+
+    const char *GetType(void) const override { return "pvr-client-call"; }
+
+  private:
+    std::shared_ptr<SPVRClientCall> m_call;
+  };
+
+  /* collects the group members transferred by a single client */
+  class CPVRChannelGroupMembersCollector : public CPVRChannelGroup
+  {
+  public:
+    explicit CPVRChannelGroupMembersCollector(const CPVRChannelGroup &group) :
+      CPVRChannelGroup(group.IsRadio(), group.GroupID(), group.GroupName()) {}
+
+    bool AddToGroup(const CPVRChannelPtr &channel, int iChannelNumber = 0) override
+    {
+      m_transferredMembers.emplace_back(channel, iChannelNumber);
+      return true;
+    }
+
+    std::vector<std::pair<CPVRChannelPtr, int> > m_transferredMembers;
+  };
+
 } // unnamed namespace
 
 CPVRClients::CPVRClients(void) :
@@ -147,6 +200,8 @@ bool CPVRClients::RequestRestart(AddonPtr addon, bool bDataChanged)
 
 void CPVRClients::Unload(void)
 {
+  WaitForTimedOutCalls();
+
   CSingleLock lock(m_critSection);
 
   /* reset class properties */
@@ -195,6 +250,8 @@ bool CPVRClients::StopClient(const AddonPtr &client, bool bRestart)
   if (IsPlaying())
     CApplicationMessenger::GetInstance().SendMsg(TMSG_MEDIA_STOP);
 
+  WaitForTimedOutCalls();
+
   CSingleLock lock(m_critSection);
   int iId = GetClientId(client);
   CPVRClientPtr mappedClient;
@@ -309,6 +366,13 @@ std::vector<SBackend> CPVRClients::GetBackendProperties() const
     properties.version = client->GetBackendVersion();
     properties.host = client->GetConnectionString();
 
+    {
+      CSingleLock lock(m_critSection);
+      auto duration = m_callDurations.find(client->GetID());
+      if (duration != m_callDurations.end())
+        properties.responseTime = duration->second;
+    }
+
     backendProperties.push_back(properties);
   }
 
@@ -630,11 +694,12 @@ PVR_ERROR CPVRClients::GetTimerTypes(CPVRTimerTypes& results, int iClientId) con
   return error;
 }
 
-PVR_ERROR CPVRClients::GetRecordings(CPVRRecordings *recordings, bool deleted)
+PVR_ERROR CPVRClients::GetRecordings(CPVRRecordings *recordings, bool deleted, std::vector<int> &failedClients)
 {
-  PVR_ERROR error(PVR_ERROR_NO_ERROR);
   CPVRClientMap clients;
-  GetCreatedClients(clients);
+  std::vector<int> clientsNotReady;
+  PVR_ERROR error = GetCreatedClients(clients, clientsNotReady);
+  failedClients.insert(failedClients.end(), clientsNotReady.begin(), clientsNotReady.end());
 
   for (const auto &client : clients)
   {
@@ -644,6 +709,7 @@ PVR_ERROR CPVRClients::GetRecordings(CPVRRecordings *recordings, bool deleted)
     {
       CLog::Log(LOGERROR, "PVR - %s - cannot get recordings from client '%d': %s",__FUNCTION__, client.first, CPVRClient::ToString(currentError));
       error = currentError;
+      failedClients.push_back(client.first);
     }
   }
 
@@ -820,7 +886,23 @@ PVR_ERROR CPVRClients::GetEPGForChannel(const CPVRChannelPtr &channel, CPVREpg *
   PVR_ERROR error(PVR_ERROR_UNKNOWN);
   CPVRClientPtr client;
   if (GetCreatedClient(channel->ClientID(), client))
+  {
+    /* called one channel at a time by the epg update thread, so the call runs right here. just don't
+       pile up calls on a client that is still busy with one that timed out */
+    if (HasTimedOutCall(channel->ClientID()))
+    {
+      CLog::Log(LOGERROR, "PVR - %s - client '%d' is still busy with a call that timed out", __FUNCTION__, channel->ClientID());
+      return PVR_ERROR_SERVER_ERROR;
+    }
+
+    unsigned int iStartTime = XbmcThreads::SystemClockMillis();
     error = client->GetEPGForChannel(channel, epg, start, end);
+    unsigned int iDuration = XbmcThreads::SystemClockMillis() - iStartTime;
+    SetCallDuration(channel->ClientID(), iDuration);
+
+    if (iDuration > CLIENT_CALL_TIMEOUT)
+      CLog::Log(LOGWARNING, "PVR - %s - client '%d' took %u ms to answer", __FUNCTION__, channel->ClientID(), iDuration);
+  }
 
   if (error != PVR_ERROR_NO_ERROR)
     CLog::Log(LOGERROR, "PVR - %s - cannot get EPG for channel '%s' from client '%d': %s",__FUNCTION__, channel->ChannelName().c_str(), channel->ClientID(), CPVRClient::ToString(error));
@@ -890,17 +972,39 @@ PVR_ERROR CPVRClients::GetChannels(CPVRChannelGroupInternal *group, std::vector<
   CPVRClientMap clients;
   PVR_ERROR error = GetCreatedClients(clients, failedClients);
 
-  /* get the channel list from each client */
+  /* get the channel list from each client. every client transfers its channels into a group of its own,
+     which are merged in client order, so the channel numbers don't depend on which client answered first */
+  const bool bRadio = group->IsRadio();
+  std::map<int, std::shared_ptr<CPVRChannelGroupInternal> > clientChannels;
+  std::map<int, std::function<PVR_ERROR(void)> > calls;
   for (const auto &client : clients)
   {
-    PVR_ERROR currentError = client.second->GetChannels(*group, group->IsRadio());
+    std::shared_ptr<CPVRChannelGroupInternal> channels(new CPVRChannelGroupInternal(bRadio));
+    channels->SetPreventSortAndRenumber();
+    clientChannels.insert(std::make_pair(client.first, channels));
+
+    const CPVRClientPtr pvrClient(client.second);
+    calls.insert(std::make_pair(client.first, [pvrClient, channels, bRadio]() { return pvrClient->GetChannels(*channels, bRadio); }));
+  }
+
+  std::map<int, PVR_ERROR> results;
+  CallClientsConcurrently(__FUNCTION__, calls, results);
+
+  for (const auto &result : results)
+  {
+    PVR_ERROR currentError = result.second;
     if (currentError != PVR_ERROR_NOT_IMPLEMENTED &&
         currentError != PVR_ERROR_NO_ERROR)
     {
       error = currentError;
-      CLog::Log(LOGERROR, "PVR - %s - cannot get channels from client '%d': %s",__FUNCTION__, client.first, CPVRClient::ToString(error));
-      failedClients.emplace_back(client.first);
+      CLog::Log(LOGERROR, "PVR - %s - cannot get channels from client '%d': %s",__FUNCTION__, result.first, CPVRClient::ToString(error));
+      failedClients.emplace_back(result.first);
+      continue;
     }
+
+    const std::shared_ptr<CPVRChannelGroup> channels(clientChannels[result.first]);
+    for (const auto &member : channels->GetMembers())
+      group->UpdateFromClient(member.channel);
   }
 
   return error;
@@ -932,22 +1036,116 @@ PVR_ERROR CPVRClients::GetChannelGroupMembers(CPVRChannelGroup *group, std::vect
   CPVRClientMap clients;
   PVR_ERROR error = GetCreatedClients(clients, failedClients);
 
-  /* get the member list from each client */
+  /* get the member list from each client. the members are collected per client and added in client order */
+  std::map<int, std::shared_ptr<CPVRChannelGroupMembersCollector> > clientMembers;
+  std::map<int, std::function<PVR_ERROR(void)> > calls;
   for (const auto &client : clients)
   {
-    PVR_ERROR currentError = client.second->GetChannelGroupMembers(group);
+    std::shared_ptr<CPVRChannelGroupMembersCollector> members(new CPVRChannelGroupMembersCollector(*group));
+    clientMembers.insert(std::make_pair(client.first, members));
+
+    const CPVRClientPtr pvrClient(client.second);
+    calls.insert(std::make_pair(client.first, [pvrClient, members]() { return pvrClient->GetChannelGroupMembers(members.get()); }));
+  }
+
+  std::map<int, PVR_ERROR> results;
+  CallClientsConcurrently(__FUNCTION__, calls, results);
+
+  for (const auto &result : results)
+  {
+    PVR_ERROR currentError = result.second;
     if (currentError != PVR_ERROR_NOT_IMPLEMENTED &&
         currentError != PVR_ERROR_NO_ERROR)
     {
       error = currentError;
-      CLog::Log(LOGERROR, "PVR - %s - cannot get group members from client '%d': %s",__FUNCTION__, client.first, CPVRClient::ToString(error));
-      failedClients.emplace_back(client.first);
+      CLog::Log(LOGERROR, "PVR - %s - cannot get group members from client '%d': %s",__FUNCTION__, result.first, CPVRClient::ToString(error));
+      failedClients.emplace_back(result.first);
+      continue;
     }
+
+    for (const auto &member : clientMembers[result.first]->m_transferredMembers)
+      group->AddToGroup(member.first, member.second);
   }
 
   return error;
 }
 
+void CPVRClients::CallClientsConcurrently(const char *strFunctionName, const std::map<int, std::function<PVR_ERROR(void)> > &calls, std::map<int, PVR_ERROR> &results)
+{
+  std::map<int, std::shared_ptr<SPVRClientCall> > pendingCalls;
+  for (const auto &call : calls)
+  {
+    /* don't pile up calls on a client that is stuck */
+    if (HasTimedOutCall(call.first))
+    {
+      CLog::Log(LOGERROR, "PVR - %s - client '%d' is still busy with a call that timed out", strFunctionName, call.first);
+      results[call.first] = PVR_ERROR_SERVER_ERROR;
+      continue;
+    }
+
+    std::shared_ptr<SPVRClientCall> clientCall(new SPVRClientCall(call.second));
+    pendingCalls.insert(std::make_pair(call.first, clientCall));
+
+    /* dedicated, so the calls don't wait for other jobs. the caller may be a job itself */
+    CJobManager::GetInstance().AddJob(new CPVRClientCallJob(clientCall), nullptr, CJob::PRIORITY_DEDICATED);
+  }
+
+  XbmcThreads::EndTime timeout(CLIENT_CALL_TIMEOUT);
+  for (const auto &call : pendingCalls)
+  {
+    if (call.second->done.WaitMSec(timeout.MillisLeft()))
+    {
+      CLog::Log(LOGDEBUG, "PVR - %s - client '%d' answered in %u ms", strFunctionName, call.first, call.second->iDuration);
+      results[call.first] = call.second->error;
+      SetCallDuration(call.first, call.second->iDuration);
+    }
+    else
+    {
+      /* the client still writes into the data of the call, so the results are dropped */
+      CLog::Log(LOGERROR, "PVR - %s - client '%d' did not answer within %u ms", strFunctionName, call.first, CLIENT_CALL_TIMEOUT);
+      results[call.first] = PVR_ERROR_SERVER_ERROR;
+      SetCallDuration(call.first, CLIENT_CALL_TIMEOUT);
+
+      CSingleLock lock(m_critSection);
+      m_timedOutCalls.insert(std::make_pair(call.first, call.second));
+    }
+  }
+}
+
+bool CPVRClients::HasTimedOutCall(int iClientId)
+{
+  CSingleLock lock(m_critSection);
+  auto range = m_timedOutCalls.equal_range(iClientId);
+  for (auto it = range.first; it != range.second;)
+  {
+    if (it->second->done.WaitMSec(0))
+      it = m_timedOutCalls.erase(it);
+    else
+      return true;
+  }
+
+  return false;
+}
+
+void CPVRClients::SetCallDuration(int iClientId, unsigned int iDuration)
+{
+  CSingleLock lock(m_critSection);
+  m_callDurations[iClientId] = iDuration;
+}
+
+void CPVRClients::WaitForTimedOutCalls(void)
+{
+  std::multimap<int, std::shared_ptr<SPVRClientCall> > calls;
+  {
+    CSingleLock lock(m_critSection);
+    calls.swap(m_timedOutCalls);
+  }
+
+  /* don't destroy clients while they are still being called */
+  for (const auto &call : calls)
+    call.second->done.Wait();
+}
+
 bool CPVRClients::HasMenuHooks(int iClientID, PVR_MENUHOOK_CAT cat)
 {
   if (iClientID < 0)
@@ -20,6 +20,8 @@
  */
 
 #include <deque>
+#include <functional>
+#include <memory>
 #include <vector>
 
 #include "addons/PVRClient.h"
@@ -38,6 +40,7 @@ namespace ADDON
 namespace PVR
 {
   class CPVREpg;
+  struct SPVRClientCall;
 
   typedef std::map<int, CPVRClientPtr> CPVRClientMap;
   typedef std::map<int, PVR_STREAM_PROPERTIES> STREAMPROPS;
@@ -56,6 +59,7 @@ namespace PVR
     int         numChannels = 0;
     long long   diskUsed = 0;
     long long   diskTotal = 0;
+    unsigned int responseTime = 0; /*!< time in ms the backend took to answer the last timed call, 0 if unknown */
   };
 
   class CPVRClients : public ADDON::IAddonMgrCallback
@@ -423,9 +427,10 @@ namespace PVR
      * @brief Get all recordings from clients
      * @param recordings Store the recordings in this container.
      * @param deleted Return deleted recordings
-     * @return The amount of recordings that were added.
+     * @param failedClients Will be extended by the ids of the clients for which the recordings could not be obtained.
+     * @return PVR_ERROR_NO_ERROR on success for all clients, the last error otherwise.
      */
-    PVR_ERROR GetRecordings(CPVRRecordings *recordings, bool deleted);
+    PVR_ERROR GetRecordings(CPVRRecordings *recordings, bool deleted, std::vector<int> &failedClients);
 
     /*!
      * @brief Rename a recordings on the backend.
@@ -729,6 +734,34 @@ namespace PVR
 
     int GetClientId(const ADDON::AddonPtr &client) const;
 
+    /*!
+     * @brief Call a function for each of the given clients. The calls run concurrently, so a slow backend doesn't delay the others.
+     * @param strFunctionName The name of the calling function, used for logging.
+     * @param calls The function to call for each client, by client id.
+     * @param results The result of each call, by client id. Calls that didn't return in time result in PVR_ERROR_SERVER_ERROR,
+     *                as do clients that are still running a call that timed out before. These clients aren't called again.
+     */
+    void CallClientsConcurrently(const char *strFunctionName, const std::map<int, std::function<PVR_ERROR(void)> > &calls, std::map<int, PVR_ERROR> &results);
+
+    /*!
+     * @brief Check whether a client is still running a call that didn't return in time.
+     * @param iClientId The client to check.
+     * @return True if the client is busy with a timed out call, false otherwise.
+     */
+    bool HasTimedOutCall(int iClientId);
+
+    /*!
+     * @brief Remember how long a client took to answer a call.
+     * @param iClientId The client.
+     * @param iDuration The time in ms the client took to answer.
+     */
+    void SetCallDuration(int iClientId, unsigned int iDuration);
+
+    /*!
+     * @brief Wait for calls that didn't return in time but are still running.
+     */
+    void WaitForTimedOutCalls(void);
+
     int                   m_playingClientId;          /*!< the ID of the client that is currently playing */
     bool                  m_bIsPlayingLiveTV;
     bool                  m_bIsPlayingRecording;
@@ -737,5 +770,7 @@ namespace PVR
     CPVRClientMap         m_clientMap;                /*!< a map of all known clients */
     CCriticalSection      m_critSection;
     std::map<std::string, int> m_addonNameIds; /*!< map add-on names to IDs */
+    std::multimap<int, std::shared_ptr<SPVRClientCall> > m_timedOutCalls; /*!< client calls that are still running after they timed out, by client id */
+    std::map<int, unsigned int> m_callDurations; /*!< time in ms each client took to answer its last timed call, by client id */
   };
 }
@@ -23,6 +23,7 @@
 #include "PVRChannelGroup.h"
 
 #include <algorithm>
+#include <numeric>
 
 #include "ServiceBroker.h"
 #include "Util.h"
@@ -45,6 +46,72 @@
 
 using namespace PVR;
 
+namespace
+{
+  bool IsIndexKey(int iKey)
+  {
+    return iKey > 0;
+  }
+
+  bool IsIndexKey(const std::string &strKey)
+  {
+    return !strKey.empty();
+  }
+
+  /*!
+   * @brief Look up a channel in one of the member indices.
+   * @param index The index to search.
+   * @param pending The members that had no key when the index was built. Members that got a key since then are moved into the index on a miss.
+   * @param key The key to look up.
+   * @param getKey Returns the current key of a channel.
+   * @param bOutdated Set to true if the key of the indexed channel changed since the index was built.
+   * @return The channel or NULL if it wasn't found.
+   */
+  template<typename KEY, typename GETKEY>
+  CPVRChannelPtr FindInIndex(std::unordered_map<KEY, CPVRChannelPtr> &index, std::vector<CPVRChannelPtr> &pending, const KEY &key, GETKEY getKey, bool &bOutdated)
+  {
+    auto it = index.find(key);
+    if (it == index.end() && !pending.empty())
+    {
+      pending.erase(std::remove_if(pending.begin(), pending.end(), [&index, &getKey](const CPVRChannelPtr &channel) {
+        KEY channelKey(getKey(channel));
+        if (!IsIndexKey(channelKey))
+          return false;
+
+        index.emplace(channelKey, channel);
+        return true;
+      }), pending.end());
+      it = index.find(key);
+    }
+
+    if (it == index.end())
+      return CPVRChannelPtr();
+
+    if (getKey(it->second) != key)
+    {
+      bOutdated = true;
+      return CPVRChannelPtr();
+    }
+
+    return it->second;
+  }
+
+  int GetChannelIdKey(const CPVRChannelPtr &channel)
+  {
+    return channel->ChannelID();
+  }
+
+  int GetEpgIdKey(const CPVRChannelPtr &channel)
+  {
+    return channel->EpgID();
+  }
+
+  std::string GetPathKey(const CPVRChannelPtr &channel)
+  {
+    return channel->Path();
+  }
+}
+
 CPVRChannelGroup::CPVRChannelGroup(void) :
     m_bRadio(false),
     m_iGroupType(PVR_GROUP_TYPE_DEFAULT),
@@ -57,7 +124,8 @@ CPVRChannelGroup::CPVRChannelGroup(void) :
     m_bPreventSortAndRenumber(false),
     m_iLastWatched(0),
     m_bHidden(false),
-    m_iPosition(0)
+    m_iPosition(0),
+    m_bMemberIndexValid(false)
 {
   OnInit();
 }
@@ -75,7 +143,8 @@ CPVRChannelGroup::CPVRChannelGroup(bool bRadio, unsigned int iGroupId, const std
     m_bPreventSortAndRenumber(false),
     m_iLastWatched(0),
     m_bHidden(false),
-    m_iPosition(0)
+    m_iPosition(0),
+    m_bMemberIndexValid(false)
 {
   OnInit();
 }
@@ -93,13 +162,15 @@ CPVRChannelGroup::CPVRChannelGroup(const PVR_CHANNEL_GROUP &group) :
     m_bPreventSortAndRenumber(false),
     m_iLastWatched(0),
     m_bHidden(false),
-    m_iPosition(group.iPosition)
+    m_iPosition(group.iPosition),
+    m_bMemberIndexValid(false)
 {
   OnInit();
 }
 
 CPVRChannelGroup::CPVRChannelGroup(const CPVRChannelGroup &group) :
-    m_strGroupName(group.m_strGroupName)
+    m_strGroupName(group.m_strGroupName),
+    m_bMemberIndexValid(false)
 {
   m_bRadio                      = group.m_bRadio;
   m_iGroupType                  = group.m_iGroupType;
@@ -186,6 +257,7 @@ void CPVRChannelGroup::Unload(void)
   CSingleLock lock(m_critSection);
   m_sortedMembers.clear();
   m_members.clear();
+  InvalidateMemberIndex();
   m_failedClientsForChannels.clear();
   m_failedClientsForChannelGroupMembers.clear();
 }
@@ -221,6 +293,7 @@ bool CPVRChannelGroup::SetChannelNumber(const CPVRChannelPtr &channel, unsigned
         bReturn = true;
         member.iChannelNumber    = iChannelNumber;
         member.iSubChannelNumber = iSubChannelNumber;
+        InvalidateMemberIndex();
       }
       break;
     }
@@ -255,6 +328,7 @@ bool CPVRChannelGroup::MoveChannel(unsigned int iOldChannelNumber, unsigned int
   PVRChannelGroupMember entry = m_sortedMembers.at(iOldChannelNumber - 1);
   m_sortedMembers.erase(m_sortedMembers.begin() + iOldChannelNumber - 1);
   m_sortedMembers.insert(m_sortedMembers.begin() + iNewChannelNumber - 1, entry);
+  InvalidateMemberIndex();
 
   /* renumber the list */
   Renumber();
@@ -341,20 +415,31 @@ void CPVRChannelGroup::SearchAndSetChannelIcons(bool bUpdateDb /* = false */)
 
 /********** sort methods **********/
 
+/*!
+ * The channel properties sortByClientChannelNumber compares, fetched once per member instead of once per comparison.
+ */
+struct clientChannelNumberSortKey
+{
+  int iClientPriority;
+  unsigned int iClientChannelNumber;
+  unsigned int iClientSubChannelNumber;
+  std::string strChannelName;
+};
+
 struct sortByClientChannelNumber
 {
-  bool operator()(const PVRChannelGroupMember &channel1, const PVRChannelGroupMember &channel2) const
+  bool operator()(const clientChannelNumberSortKey &channel1, const clientChannelNumberSortKey &channel2) const
   {
     if (channel1.iClientPriority == channel2.iClientPriority)
     {
-      if (channel1.channel->ClientChannelNumber() == channel2.channel->ClientChannelNumber())
+      if (channel1.iClientChannelNumber == channel2.iClientChannelNumber)
       {
-        if (channel1.channel->ClientSubChannelNumber() > 0 || channel2.channel->ClientSubChannelNumber() > 0)
-          return channel1.channel->ClientSubChannelNumber() < channel2.channel->ClientSubChannelNumber();
+        if (channel1.iClientSubChannelNumber > 0 || channel2.iClientSubChannelNumber > 0)
+          return channel1.iClientSubChannelNumber < channel2.iClientSubChannelNumber;
         else
-          return channel1.channel->ChannelName() < channel2.channel->ChannelName();
+          return channel1.strChannelName < channel2.strChannelName;
       }
-      return channel1.channel->ClientChannelNumber() < channel2.channel->ClientChannelNumber();
+      return channel1.iClientChannelNumber < channel2.iClientChannelNumber;
     }
     else
       return channel1.iClientPriority > channel2.iClientPriority;
@@ -371,6 +456,25 @@ struct sortByChannelNumber
   }
 };
 
+/*!
+ * Sort a permutation of the positions in members and move every member to its final position once,
+ * instead of swapping the members (and their channel references) around while sorting.
+ */
+template<typename COMPARE>
+void SortMembersByPermutation(PVR_CHANNEL_GROUP_SORTED_MEMBERS &members, COMPARE compare)
+{
+  std::vector<size_t> order(members.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::sort(order.begin(), order.end(), compare);
+
+  PVR_CHANNEL_GROUP_SORTED_MEMBERS sortedMembers;
+  sortedMembers.reserve(members.size());
+  for (size_t iPosition : order)
+    sortedMembers.emplace_back(std::move(members[iPosition]));
+
+  members.swap(sortedMembers);
+}
+
 bool CPVRChannelGroup::SortAndRenumber(void)
 {
   if (PreventSortAndRenumber())
@@ -390,15 +494,32 @@ bool CPVRChannelGroup::SortAndRenumber(void)
 void CPVRChannelGroup::SortByClientChannelNumber(void)
 {
   CSingleLock lock(m_critSection);
-  if (!PreventSortAndRenumber())
-    sort(m_sortedMembers.begin(), m_sortedMembers.end(), sortByClientChannelNumber());
+  if (PreventSortAndRenumber())
+    return;
+
+  std::vector<clientChannelNumberSortKey> keys;
+  keys.reserve(m_sortedMembers.size());
+  for (const auto& member : m_sortedMembers)
+    keys.push_back({ member.iClientPriority, member.channel->ClientChannelNumber(), member.channel->ClientSubChannelNumber(), member.channel->ChannelName() });
+
+  const sortByClientChannelNumber compare;
+  SortMembersByPermutation(m_sortedMembers, [&keys, &compare](size_t iPosition1, size_t iPosition2) {
+    return compare(keys[iPosition1], keys[iPosition2]);
+  });
+  InvalidateMemberIndex();
 }
 
 void CPVRChannelGroup::SortByChannelNumber(void)
 {
   CSingleLock lock(m_critSection);
-  if (!PreventSortAndRenumber())
-    sort(m_sortedMembers.begin(), m_sortedMembers.end(), sortByChannelNumber());
+  if (PreventSortAndRenumber())
+    return;
+
+  const sortByChannelNumber compare;
+  SortMembersByPermutation(m_sortedMembers, [this, &compare](size_t iPosition1, size_t iPosition2) {
+    return compare(m_sortedMembers[iPosition1], m_sortedMembers[iPosition2]);
+  });
+  InvalidateMemberIndex();
 }
 
 bool CPVRChannelGroup::UpdateClientPriorities()
@@ -447,32 +568,132 @@ CPVRChannelPtr CPVRChannelGroup::GetByUniqueID(int iUniqueChannelId, int iClient
   return GetByUniqueID(std::make_pair(iClientID, iUniqueChannelId)).channel;
 }
 
+void CPVRChannelGroup::InvalidateMemberIndex(void)
+{
+  CSingleLock lock(m_critSection);
+  m_bMemberIndexValid = false;
+}
+
+void CPVRChannelGroup::UpdateMemberIndex(void) const
+{
+  CSingleLock lock(m_critSection);
+  if (m_bMemberIndexValid)
+    return;
+
+  m_channelIdIndex.clear();
+  m_epgIdIndex.clear();
+  m_channelNumberIndex.clear();
+  m_subChannelNumberIndex.clear();
+  m_sortedPositionIndex.clear();
+  m_pathIndex.clear();
+  m_membersWithoutChannelId.clear();
+  m_membersWithoutEpgId.clear();
+  m_membersWithoutPath.clear();
+
+  for (size_t iPosition = 0; iPosition < m_sortedMembers.size(); ++iPosition)
+  {
+    const PVRChannelGroupMember& member(m_sortedMembers[iPosition]);
+    if (!member.channel)
+      continue;
+
+    /* channel and epg ids are assigned when the channel is persisted and when its epg is created, so they may be set after the index was built */
+    int iChannelId = member.channel->ChannelID();
+    if (IsIndexKey(iChannelId))
+      m_channelIdIndex.emplace(iChannelId, member.channel);
+    else
+      m_membersWithoutChannelId.push_back(member.channel);
+
+    int iEpgId = member.channel->EpgID();
+    if (IsIndexKey(iEpgId))
+      m_epgIdIndex.emplace(iEpgId, member.channel);
+    else
+      m_membersWithoutEpgId.push_back(member.channel);
+
+    const std::string strPath(member.channel->Path());
+    if (IsIndexKey(strPath))
+      m_pathIndex.emplace(strPath, member.channel);
+    else
+      m_membersWithoutPath.push_back(member.channel);
+
+    /* emplace() keeps the first entry, like the linear search over the sorted members did */
+    m_channelNumberIndex.emplace(member.iChannelNumber, iPosition);
+    m_subChannelNumberIndex.emplace((static_cast<uint64_t>(member.iChannelNumber) << 32) | member.iSubChannelNumber, iPosition);
+    m_sortedPositionIndex.emplace(member.channel.get(), iPosition);
+  }
+
+  m_bMemberIndexValid = true;
+}
+
+bool CPVRChannelGroup::GetSortedPosition(const CPVRChannelPtr &channel, size_t &iPosition) const
+{
+  CSingleLock lock(m_critSection);
+  UpdateMemberIndex();
+
+  auto it = m_sortedPositionIndex.find(channel.get());
+  if (it == m_sortedPositionIndex.end())
+    return false;
+
+  iPosition = it->second;
+  if (iPosition < m_sortedMembers.size() && m_sortedMembers[iPosition].channel == channel)
+    return true;
+
+  /* members were modified without updating the index */
+  m_bMemberIndexValid = false;
+  return GetSortedPosition(channel, iPosition);
+}
+
 CPVRChannelPtr CPVRChannelGroup::GetByChannelID(int iChannelID) const
 {
-  CPVRChannelPtr retval;
   CSingleLock lock(m_critSection);
+  UpdateMemberIndex();
 
-  for (PVR_CHANNEL_GROUP_MEMBERS::const_iterator it = m_members.begin(); !retval && it != m_members.end(); ++it)
+  bool bOutdated(false);
+  CPVRChannelPtr channel(FindInIndex(m_channelIdIndex, m_membersWithoutChannelId, iChannelID, GetChannelIdKey, bOutdated));
+  if (bOutdated)
   {
-    if (it->second.channel->ChannelID() == iChannelID)
-      retval = it->second.channel;
+    /* the id of a member changed since the index was built */
+    m_bMemberIndexValid = false;
+    UpdateMemberIndex();
+    channel = FindInIndex(m_channelIdIndex, m_membersWithoutChannelId, iChannelID, GetChannelIdKey, bOutdated);
   }
 
-  return retval;
+  return channel;
 }
 
 CPVRChannelPtr CPVRChannelGroup::GetByChannelEpgID(int iEpgID) const
 {
-  CPVRChannelPtr retval;
   CSingleLock lock(m_critSection);
+  UpdateMemberIndex();
 
-  for (PVR_CHANNEL_GROUP_MEMBERS::const_iterator it = m_members.begin(); !retval && it != m_members.end(); ++it)
+  bool bOutdated(false);
+  CPVRChannelPtr channel(FindInIndex(m_epgIdIndex, m_membersWithoutEpgId, iEpgID, GetEpgIdKey, bOutdated));
+  if (bOutdated)
   {
-    if (it->second.channel->EpgID() == iEpgID)
-      retval = it->second.channel;
+    /* the epg id of a member changed since the index was built */
+    m_bMemberIndexValid = false;
+    UpdateMemberIndex();
+    channel = FindInIndex(m_epgIdIndex, m_membersWithoutEpgId, iEpgID, GetEpgIdKey, bOutdated);
   }
 
-  return retval;
+  return channel;
+}
+
+CPVRChannelPtr CPVRChannelGroup::GetByPath(const std::string &strPath) const
+{
+  CSingleLock lock(m_critSection);
+  UpdateMemberIndex();
+
+  bool bOutdated(false);
+  CPVRChannelPtr channel(FindInIndex(m_pathIndex, m_membersWithoutPath, strPath, GetPathKey, bOutdated));
+  if (bOutdated)
+  {
+    /* the path of a member changed since the index was built */
+    m_bMemberIndexValid = false;
+    UpdateMemberIndex();
+    channel = FindInIndex(m_pathIndex, m_membersWithoutPath, strPath, GetPathKey, bOutdated);
+  }
+
+  return channel;
 }
 
 CFileItemPtr CPVRChannelGroup::GetLastPlayedChannel(int iCurrentChannel /* = -1 */) const
@@ -514,15 +735,36 @@ CFileItemPtr CPVRChannelGroup::GetByChannelNumber(unsigned int iChannelNumber, u
 {
   CFileItemPtr retval;
   CSingleLock lock(m_critSection);
+  UpdateMemberIndex();
 
-  for (PVR_CHANNEL_GROUP_SORTED_MEMBERS::const_iterator it = m_sortedMembers.begin(); !retval && it != m_sortedMembers.end(); ++it)
+  size_t iPosition = m_sortedMembers.size();
+  if (iSubChannelNumber == 0)
   {
-    if ((*it).iChannelNumber == iChannelNumber &&
-        (iSubChannelNumber == 0 || iSubChannelNumber == (*it).iSubChannelNumber))
-      retval = CFileItemPtr(new CFileItem((*it).channel));
+    auto it = m_channelNumberIndex.find(iChannelNumber);
+    if (it != m_channelNumberIndex.end())
+      iPosition = it->second;
   }
+  else
+  {
+    auto it = m_subChannelNumberIndex.find((static_cast<uint64_t>(iChannelNumber) << 32) | iSubChannelNumber);
+    if (it != m_subChannelNumberIndex.end())
+      iPosition = it->second;
+  }
+
+  if (iPosition < m_sortedMembers.size())
+  {
+    const PVRChannelGroupMember& member(m_sortedMembers[iPosition]);
+    if (member.iChannelNumber != iChannelNumber ||
+        (iSubChannelNumber != 0 && member.iSubChannelNumber != iSubChannelNumber))
+    {
+      /* members were renumbered without updating the index */
+      m_bMemberIndexValid = false;
+      return GetByChannelNumber(iChannelNumber, iSubChannelNumber);
+    }
 
-  if (!retval)
+    retval = CFileItemPtr(new CFileItem(member.channel));
+  }
+  else
     retval = CFileItemPtr(new CFileItem);
   return retval;
 }
@@ -534,21 +776,20 @@ CFileItemPtr CPVRChannelGroup::GetNextChannel(const CPVRChannelPtr &channel) con
   if (channel)
   {
     CSingleLock lock(m_critSection);
-    for (PVR_CHANNEL_GROUP_SORTED_MEMBERS::const_iterator it = m_sortedMembers.begin(); !retval && it != m_sortedMembers.end(); ++it)
+    size_t iPosition;
+    if (GetSortedPosition(channel, iPosition))
     {
-      if ((*it).channel == channel)
+      do
       {
-        do
-        {
-          if ((++it) == m_sortedMembers.end())
-            it = m_sortedMembers.begin();
-          if ((*it).channel && !(*it).channel->IsHidden())
-            retval = std::make_shared<CFileItem>((*it).channel);
-        } while (!retval && (*it).channel != channel);
-
-        if (!retval)
-          retval = std::make_shared<CFileItem>();
-      }
+        if ((++iPosition) == m_sortedMembers.size())
+          iPosition = 0;
+        const CPVRChannelPtr &member = m_sortedMembers[iPosition].channel;
+        if (member && !member->IsHidden())
+          retval = std::make_shared<CFileItem>(member);
+      } while (!retval && m_sortedMembers[iPosition].channel != channel);
+
+      if (!retval)
+        retval = std::make_shared<CFileItem>();
     }
   }
 
@@ -562,21 +803,20 @@ CFileItemPtr CPVRChannelGroup::GetPreviousChannel(const CPVRChannelPtr &channel)
   if (channel)
   {
     CSingleLock lock(m_critSection);
-    for (PVR_CHANNEL_GROUP_SORTED_MEMBERS::const_reverse_iterator it = m_sortedMembers.rbegin(); !retval && it != m_sortedMembers.rend(); ++it)
+    size_t iPosition;
+    if (GetSortedPosition(channel, iPosition))
     {
-      if ((*it).channel == channel)
+      do
       {
-        do
-        {
-          if ((++it) == m_sortedMembers.rend())
-            it = m_sortedMembers.rbegin();
-          if ((*it).channel && !(*it).channel->IsHidden())
-            retval = std::make_shared<CFileItem>((*it).channel);
-        } while (!retval && (*it).channel != channel);
-
-        if (!retval)
-          retval = std::make_shared<CFileItem>();
-      }
+        if (iPosition == 0)
+          iPosition = m_sortedMembers.size();
+        const CPVRChannelPtr &member = m_sortedMembers[--iPosition].channel;
+        if (member && !member->IsHidden())
+          retval = std::make_shared<CFileItem>(member);
+      } while (!retval && m_sortedMembers[iPosition].channel != channel);
+
+      if (!retval)
+        retval = std::make_shared<CFileItem>();
     }
   }
   return retval;
@@ -738,6 +978,7 @@ bool CPVRChannelGroup::RemoveDeletedChannels(const CPVRChannelGroup &channels)
 
       if (possiblyRemovedGroup != m_sortedMembers.end())
         m_sortedMembers.erase(possiblyRemovedGroup);
+      InvalidateMemberIndex();
       
       //We have to start over from the beginning, list can have been modified and
       //resorted, there's no safe way to continue where we left of
@@ -802,6 +1043,7 @@ bool CPVRChannelGroup::RemoveFromGroup(const CPVRChannelPtr &channel)
       //! @todo notify observers
       m_members.erase((*it).channel->StorageId());
       it = m_sortedMembers.erase(it);
+      InvalidateMemberIndex();
       bReturn = true;
       m_bChanged = true;
       break;
@@ -842,6 +1084,7 @@ bool CPVRChannelGroup::AddToGroup(const CPVRChannelPtr &channel, int iChannelNum
       newMember.iChannelNumber = (unsigned int)iChannelNumber;
       m_sortedMembers.push_back(newMember);
       m_members.insert(std::make_pair(realChannel.channel->StorageId(), newMember));
+      InvalidateMemberIndex();
       m_bChanged = true;
 
       SortAndRenumber();
@@ -964,6 +1207,7 @@ bool CPVRChannelGroup::Renumber(void)
     (*it).iChannelNumber    = iCurrentChannelNumber;
     (*it).iSubChannelNumber = iSubChannelNumber;
   }
+  InvalidateMemberIndex();
 
   SortByChannelNumber();
   ResetChannelNumberCache();
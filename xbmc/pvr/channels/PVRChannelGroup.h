@@ -19,8 +19,11 @@
  *
  */
 
+#include <cstdint>
 #include <map>
 #include <memory>
+#include <string>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
@@ -327,6 +330,13 @@ namespace PVR
      */
     CPVRChannelPtr GetByChannelID(int iChannelID) const;
 
+    /*!
+     * @brief Get a channel given it's path.
+     * @param strPath The path of the channel.
+     * @return The channel or NULL if it wasn't found.
+     */
+    CPVRChannelPtr GetByPath(const std::string &strPath) const;
+
     /*!
      * Get the current members of this group
      * @return The group members
@@ -516,6 +526,11 @@ namespace PVR
      */
     bool UpdateClientPriorities();
 
+    /*!
+     * @brief Mark the lookup indices of this group as outdated. Must be called after adding, removing, moving or renumbering members.
+     */
+    void InvalidateMemberIndex(void);
+
     bool             m_bRadio;                      /*!< true if this container holds radio channels, false if it holds TV channels */
     int              m_iGroupType;                  /*!< The type of this group */
     int              m_iGroupId;                    /*!< The ID of this group in the database */
@@ -536,6 +551,30 @@ namespace PVR
     std::vector<int> m_failedClientsForChannelGroupMembers;
 
   private:
+    /*!
+     * @brief Rebuild the lookup indices from m_sortedMembers if they are outdated.
+     */
+    void UpdateMemberIndex(void) const;
+
+    /*!
+     * @brief Get the position of the given channel in m_sortedMembers.
+     * @param channel The channel to look up.
+     * @param iPosition The position of the channel.
+     * @return True if the channel is a member of this group, false otherwise.
+     */
+    bool GetSortedPosition(const CPVRChannelPtr &channel, size_t &iPosition) const;
+
+    mutable bool m_bMemberIndexValid;            /*!< false if the lookup indices have to be rebuilt before use */
+    mutable std::unordered_map<int, CPVRChannelPtr> m_channelIdIndex;              /*!< members by channel id */
+    mutable std::unordered_map<int, CPVRChannelPtr> m_epgIdIndex;                  /*!< members by epg id */
+    mutable std::unordered_map<std::string, CPVRChannelPtr> m_pathIndex;          /*!< members by path */
+    mutable std::vector<CPVRChannelPtr> m_membersWithoutChannelId;                 /*!< members that had no channel id yet when the indices were built */
+    mutable std::vector<CPVRChannelPtr> m_membersWithoutEpgId;                     /*!< members that had no epg id yet when the indices were built */
+    mutable std::vector<CPVRChannelPtr> m_membersWithoutPath;                      /*!< members that had no path yet when the indices were built */
+    mutable std::unordered_map<unsigned int, size_t> m_channelNumberIndex;         /*!< first position in m_sortedMembers by channel number */
+    mutable std::unordered_map<uint64_t, size_t> m_subChannelNumberIndex;          /*!< position in m_sortedMembers by channel and sub channel number */
+    mutable std::unordered_map<const CPVRChannel*, size_t> m_sortedPositionIndex;  /*!< position in m_sortedMembers by channel */
+
     CDateTime GetEPGDate(EpgDateType epgDateType) const;
     /*!
      * @brief Get all entries that will be active next.
@@ -97,6 +97,7 @@ void CPVRChannelGroupInternal::UpdateChannelPaths(void)
     else
       it->second.channel->UpdatePath(this);
   }
+  InvalidateMemberIndex();
 }
 
 CPVRChannelPtr CPVRChannelGroupInternal::UpdateFromClient(const CPVRChannelPtr &channel, unsigned int iChannelNumber /* = 0 */)
@@ -114,6 +115,7 @@ CPVRChannelPtr CPVRChannelGroupInternal::UpdateFromClient(const CPVRChannelPtr &
     channel->UpdatePath(this);
     m_sortedMembers.push_back(newMember);
     m_members.insert(std::make_pair(channel->StorageId(), newMember));
+    InvalidateMemberIndex();
     m_bChanged = true;
 
     SortAndRenumber();
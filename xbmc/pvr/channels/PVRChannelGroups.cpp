@@ -147,11 +147,16 @@ CFileItemPtr CPVRChannelGroups::GetByPath(const std::string &strPath) const
     strCheckPath = StringUtils::Format("channels/%s/%s/", (*it)->IsRadio() ? "radio" : "tv", (*it)->GroupName().c_str());
     if (URIUtils::PathHasParent(strFileName, strCheckPath))
     {
+      CPVRChannelPtr channel((*it)->GetByPath(strPath));
+      if (channel)
+        return CFileItemPtr(new CFileItem(channel));
+
+      /* not the path the channel was stored with, find it by client and unique id */
       strFileName.erase(0, strCheckPath.length());
       std::vector<std::string> split(StringUtils::Split(strFileName, '_', 2));
       if (split.size() == 2)
       {
-        CPVRChannelPtr channel((*it)->GetByUniqueID(atoi(split[1].c_str()), CServiceBroker::GetPVRManager().Clients()->GetClientId(split[0])));
+        channel = (*it)->GetByUniqueID(atoi(split[1].c_str()), CServiceBroker::GetPVRManager().Clients()->GetClientId(split[0]));
         if (channel)
           return CFileItemPtr(new CFileItem(channel));
       }
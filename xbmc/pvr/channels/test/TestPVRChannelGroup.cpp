@@ -0,0 +1,171 @@
+/*
+ *      Copyright (C) 2017 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "FileItem.h"
+#include "pvr/channels/PVRChannel.h"
+#include "pvr/channels/PVRChannelGroupInternal.h"
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+using namespace PVR;
+
+namespace
+{
+  const int TEST_CLIENT_ID = 1;
+
+  CPVRChannelPtr CreateChannel(unsigned int iUniqueId)
+  {
+    PVR_CHANNEL channel;
+    memset(&channel, 0, sizeof(channel));
+    channel.iUniqueId = iUniqueId;
+    channel.iChannelNumber = iUniqueId;
+    snprintf(channel.strChannelName, sizeof(channel.strChannelName), "Channel %u", iUniqueId);
+    return CPVRChannelPtr(new CPVRChannel(channel, TEST_CLIENT_ID));
+  }
+
+  CPVRChannelPtr ChannelOf(const CFileItemPtr &item)
+  {
+    return item ? item->GetPVRChannelInfoTag() : CPVRChannelPtr();
+  }
+}
+
+/*!
+ * The lookups are answered from indices that are rebuilt lazily, so every
+ * test first does a lookup to build the index, then modifies the group and
+ * checks that the lookups reflect the modification.
+ */
+class TestPVRChannelGroup : public testing::Test
+{
+protected:
+  TestPVRChannelGroup() :
+    m_group(new CPVRChannelGroupInternal(false))
+  {
+  }
+
+  void SetUp() override
+  {
+    for (unsigned int iUniqueId = 1; iUniqueId <= 3; ++iUniqueId)
+    {
+      CPVRChannelPtr channel(CreateChannel(iUniqueId));
+      m_channels.push_back(channel);
+      m_group->UpdateFromClient(channel, iUniqueId);
+    }
+
+    for (unsigned int iChannelNumber = 1; iChannelNumber <= 3; ++iChannelNumber)
+      ASSERT_EQ(m_channels[iChannelNumber - 1], ChannelOf(m_group->GetByChannelNumber(iChannelNumber)));
+  }
+
+  std::shared_ptr<CPVRChannelGroupInternal> m_group;
+  std::vector<CPVRChannelPtr> m_channels;
+};
+
+TEST_F(TestPVRChannelGroup, AddUpdatesIndex)
+{
+  EXPECT_FALSE(ChannelOf(m_group->GetByChannelNumber(4)));
+
+  CPVRChannelPtr channel(CreateChannel(4));
+  m_group->UpdateFromClient(channel, 4);
+
+  EXPECT_EQ(channel, ChannelOf(m_group->GetByChannelNumber(4)));
+  EXPECT_EQ(channel, ChannelOf(m_group->GetNextChannel(m_channels[2])));
+  EXPECT_EQ(channel, m_group->GetByPath(channel->Path()));
+}
+
+TEST_F(TestPVRChannelGroup, RemoveUpdatesIndex)
+{
+  const std::string strPath(m_channels[1]->Path());
+  ASSERT_EQ(m_channels[1], m_group->GetByPath(strPath));
+
+  ASSERT_TRUE(m_group->RemoveFromGroup(m_channels[1]));
+
+  EXPECT_FALSE(m_group->GetByPath(strPath));
+  EXPECT_EQ(m_channels[2], ChannelOf(m_group->GetByChannelNumber(2)));
+  EXPECT_FALSE(ChannelOf(m_group->GetByChannelNumber(3)));
+  EXPECT_EQ(m_channels[2], ChannelOf(m_group->GetNextChannel(m_channels[0])));
+}
+
+TEST_F(TestPVRChannelGroup, MoveUpdatesIndex)
+{
+  ASSERT_TRUE(m_group->MoveChannel(1, 3, false));
+
+  EXPECT_EQ(m_channels[1], ChannelOf(m_group->GetByChannelNumber(1)));
+  EXPECT_EQ(m_channels[2], ChannelOf(m_group->GetByChannelNumber(2)));
+  EXPECT_EQ(m_channels[0], ChannelOf(m_group->GetByChannelNumber(3)));
+  EXPECT_EQ(m_channels[0], ChannelOf(m_group->GetNextChannel(m_channels[2])));
+  EXPECT_EQ(m_channels[2], ChannelOf(m_group->GetPreviousChannel(m_channels[0])));
+}
+
+TEST_F(TestPVRChannelGroup, RenumberUpdatesIndex)
+{
+  ASSERT_TRUE(m_group->SetChannelNumber(m_channels[0], 10));
+  EXPECT_EQ(m_channels[0], ChannelOf(m_group->GetByChannelNumber(10)));
+  EXPECT_FALSE(ChannelOf(m_group->GetByChannelNumber(1)));
+
+  m_group->Renumber();
+
+  EXPECT_EQ(m_channels[0], ChannelOf(m_group->GetByChannelNumber(1)));
+  EXPECT_FALSE(ChannelOf(m_group->GetByChannelNumber(10)));
+}
+
+TEST_F(TestPVRChannelGroup, SortUpdatesIndex)
+{
+  ASSERT_TRUE(m_group->SetChannelNumber(m_channels[0], 10));
+
+  /* sorts channel 1 behind the others, then numbers them 1 to 3 again */
+  m_group->SortAndRenumber();
+
+  EXPECT_EQ(m_channels[1], ChannelOf(m_group->GetByChannelNumber(1)));
+  EXPECT_EQ(m_channels[2], ChannelOf(m_group->GetByChannelNumber(2)));
+  EXPECT_EQ(m_channels[0], ChannelOf(m_group->GetByChannelNumber(3)));
+  EXPECT_EQ(m_channels[2], ChannelOf(m_group->GetNextChannel(m_channels[1])));
+  EXPECT_EQ(m_channels[0], ChannelOf(m_group->GetNextChannel(m_channels[2])));
+}
+
+TEST_F(TestPVRChannelGroup, IdsAssignedAfterIndexWasBuilt)
+{
+  /* the channels were not persisted yet, so the index has no ids */
+  EXPECT_FALSE(m_group->GetByChannelID(42));
+  EXPECT_FALSE(m_group->GetByChannelEpgID(43));
+
+  m_channels[1]->SetChannelID(42);
+  m_channels[1]->SetEpgID(43);
+
+  EXPECT_EQ(m_channels[1], m_group->GetByChannelID(42));
+  EXPECT_EQ(m_channels[1], m_group->GetByChannelEpgID(43));
+
+  /* an id that changed after it was indexed */
+  m_channels[1]->SetChannelID(44);
+  EXPECT_FALSE(m_group->GetByChannelID(42));
+  EXPECT_EQ(m_channels[1], m_group->GetByChannelID(44));
+}
+
+TEST_F(TestPVRChannelGroup, GetByPath)
+{
+  for (const auto &channel : m_channels)
+    EXPECT_EQ(channel, m_group->GetByPath(channel->Path()));
+
+  EXPECT_FALSE(m_group->GetByPath(""));
+  EXPECT_FALSE(m_group->GetByPath("pvr://channels/tv/unknown/_4.pvr"));
+}
@@ -20,6 +20,8 @@
 
 #include "Epg.h"
 
+#include <algorithm>
+#include <iterator>
 #include <utility>
 
 #include "addons/kodi-addon-dev-kit/include/kodi/xbmc_epg_types.h"
@@ -30,6 +32,7 @@
 #include "settings/AdvancedSettings.h"
 #include "settings/Settings.h"
 #include "threads/SingleLock.h"
+#include "utils/TextSearch.h"
 #include "utils/log.h"
 
 #include "pvr/PVRManager.h"
@@ -39,6 +42,16 @@
 
 using namespace PVR;
 
+namespace
+{
+  time_t ToTime(const CDateTime &dateTime)
+  {
+    time_t time = 0;
+    dateTime.GetAsTime(time);
+    return time;
+  }
+}
+
 CPVREpg::CPVREpg(int iEpgID, const std::string &strName /* = "" */, const std::string &strScraperName /* = "" */, bool bLoadedFromDb /* = false */) :
     m_bChanged(!bLoadedFromDb),
     m_bTagsChanged(false),
@@ -88,13 +101,16 @@ CPVREpg &CPVREpg::operator =(const CPVREpg &right)
   m_iEpgID            = right.m_iEpgID;
   m_strName           = right.m_strName;
   m_strScraperName    = right.m_strScraperName;
-  m_nowActiveStart    = right.m_nowActiveStart;
+  m_nowActiveStart    = right.m_nowActiveStart.load();
   m_lastScanTime      = right.m_lastScanTime;
   m_pvrChannel        = right.m_pvrChannel;
 
   for (std::map<CDateTime, CPVREpgInfoTagPtr>::const_iterator it = right.m_tags.begin(); it != right.m_tags.end(); ++it)
     m_tags.insert(make_pair(it->first, it->second));
 
+  InvalidateTagsSnapshot();
+  ResetSearchIndex();
+
   return *this;
 }
 
@@ -141,6 +157,8 @@ void CPVREpg::Clear(void)
 {
   CSingleLock lock(m_critSection);
   m_tags.clear();
+  InvalidateTagsSnapshot();
+  ResetSearchIndex();
 }
 
 void CPVREpg::Cleanup(void)
@@ -157,12 +175,11 @@ void CPVREpg::Cleanup(const CDateTime &Time)
   {
     if (it->second->EndAsUTC() < Time)
     {
-      if (m_nowActiveStart == it->first)
-        m_nowActiveStart.SetValid(false);
-
       it->second->ClearTimer();
       it->second->ClearRecording();
+      SearchIndexTagRemoved(it->second);
       it = m_tags.erase(it);
+      InvalidateTagsSnapshot();
     }
     else
     {
@@ -173,34 +190,50 @@ void CPVREpg::Cleanup(const CDateTime &Time)
 
 CPVREpgInfoTagPtr CPVREpg::GetTagNow(bool bUpdateIfNeeded /* = true */) const
 {
-  CSingleLock lock(m_critSection);
-  if (m_nowActiveStart.IsValid())
+  const TagsSnapshotPtr snapshot(GetTagsSnapshot());
+  if (snapshot->tags.empty())
+    return CPVREpgInfoTagPtr();
+
+  const time_t iNowActiveStart = m_nowActiveStart;
+  if (iNowActiveStart != 0)
   {
-    std::map<CDateTime, CPVREpgInfoTagPtr>::const_iterator it = m_tags.find(m_nowActiveStart);
-    if (it != m_tags.end() && it->second->IsActive())
-      return it->second;
+    const auto it = std::lower_bound(snapshot->starts.begin(), snapshot->starts.end(), iNowActiveStart);
+    if (it != snapshot->starts.end() && *it == iNowActiveStart)
+    {
+      const CPVREpgInfoTagPtr &tag = snapshot->tags[it - snapshot->starts.begin()];
+      if (tag->IsActive())
+        return tag;
+    }
   }
 
   if (bUpdateIfNeeded)
   {
-    CPVREpgInfoTagPtr lastActiveTag;
+    // all tags of a table share the same channel, and therefore the same notion of "now"
+    const time_t iNow = ToTime(snapshot->tags.front()->GetCurrentPlayingTime());
 
-    /* one of the first items will always match if the list is sorted */
-    for (std::map<CDateTime, CPVREpgInfoTagPtr>::const_iterator it = m_tags.begin(); it != m_tags.end(); ++it)
+    // candidates have started already and, unless tags overlap, only the last one of them can still be running
+    const size_t last = std::upper_bound(snapshot->starts.begin(), snapshot->starts.end(), iNow) - snapshot->starts.begin();
+    const size_t first = std::upper_bound(snapshot->maxEnds.begin(), snapshot->maxEnds.begin() + last, iNow) - snapshot->maxEnds.begin();
+    for (size_t i = first; i < last; ++i)
     {
-      if (it->second->IsActive())
+      if (snapshot->tags[i]->IsActive())
       {
-        m_nowActiveStart = it->first;
-        return it->second;
+        m_nowActiveStart = snapshot->starts[i];
+        return snapshot->tags[i];
       }
-      else if (it->second->WasActive())
-        lastActiveTag = it->second;
     }
 
     /* there might be a gap between the last and next event. return the last if found and it ended not more than 5 minutes ago */
-    if (lastActiveTag &&
-        lastActiveTag->EndAsUTC() + CDateTimeSpan(0, 0, 5, 0) >= CDateTime::GetUTCDateTime())
-      return lastActiveTag;
+    for (size_t i = last; i > 0; --i)
+    {
+      const CPVREpgInfoTagPtr &lastActiveTag = snapshot->tags[i - 1];
+      if (lastActiveTag->WasActive())
+      {
+        if (lastActiveTag->EndAsUTC() + CDateTimeSpan(0, 0, 5, 0) >= CDateTime::GetUTCDateTime())
+          return lastActiveTag;
+        break;
+      }
+    }
   }
 
   return CPVREpgInfoTagPtr();
@@ -210,19 +243,18 @@ CPVREpgInfoTagPtr CPVREpg::GetTagNext() const
 {
   CPVREpgInfoTagPtr nowTag(GetTagNow());
   if (nowTag)
+    return GetNextEvent(*nowTag);
+
+  /* return the first event that is in the future */
+  const TagsSnapshotPtr snapshot(GetTagsSnapshot());
+  if (!snapshot->tags.empty())
   {
-    CSingleLock lock(m_critSection);
-    std::map<CDateTime, CPVREpgInfoTagPtr>::const_iterator it = m_tags.find(nowTag->StartAsUTC());
-    if (it != m_tags.end() && ++it != m_tags.end())
-      return it->second;
-  }
-  else if (Size() > 0)
-  {
-    /* return the first event that is in the future */
-    for (std::map<CDateTime, CPVREpgInfoTagPtr>::const_iterator it = m_tags.begin(); it != m_tags.end(); ++it)
+    const time_t iNow = ToTime(snapshot->tags.front()->GetCurrentPlayingTime());
+    const size_t first = std::lower_bound(snapshot->starts.begin(), snapshot->starts.end(), iNow) - snapshot->starts.begin();
+    for (size_t i = first; i < snapshot->tags.size(); ++i)
     {
-      if (it->second->IsUpcoming())
-        return it->second;
+      if (snapshot->tags[i]->IsUpcoming())
+        return snapshot->tags[i];
     }
   }
 
@@ -248,23 +280,25 @@ CPVREpgInfoTagPtr CPVREpg::GetTagByBroadcastId(unsigned int iUniqueBroadcastId)
 {
   if (iUniqueBroadcastId != EPG_TAG_INVALID_UID)
   {
-    CSingleLock lock(m_critSection);
-    for (const auto &infoTag : m_tags)
-    {
-      if (infoTag.second->UniqueBroadcastID() == iUniqueBroadcastId)
-        return infoTag.second;
-    }
+    const TagsSnapshotPtr snapshot(GetTagsSnapshot());
+    const auto it = std::lower_bound(snapshot->broadcastIds.begin(), snapshot->broadcastIds.end(),
+                                     std::make_pair(iUniqueBroadcastId, static_cast<size_t>(0)));
+    if (it != snapshot->broadcastIds.end() && it->first == iUniqueBroadcastId)
+      return snapshot->tags[it->second];
   }
   return CPVREpgInfoTagPtr();
 }
 
 CPVREpgInfoTagPtr CPVREpg::GetTagBetween(const CDateTime &beginTime, const CDateTime &endTime) const
 {
-  CSingleLock lock(m_critSection);
-  for (std::map<CDateTime, CPVREpgInfoTagPtr>::const_iterator it = m_tags.begin(); it != m_tags.end(); ++it)
+  const TagsSnapshotPtr snapshot(GetTagsSnapshot());
+  const time_t iEnd = ToTime(endTime);
+  size_t i = std::lower_bound(snapshot->starts.begin(), snapshot->starts.end(), ToTime(beginTime)) - snapshot->starts.begin();
+  for (; i < snapshot->tags.size() && snapshot->starts[i] <= iEnd; ++i)
   {
-    if (it->second->StartAsUTC() >= beginTime && it->second->EndAsUTC() <= endTime)
-      return it->second;
+    const CPVREpgInfoTagPtr &tag = snapshot->tags[i];
+    if (tag->StartAsUTC() >= beginTime && tag->EndAsUTC() <= endTime)
+      return tag;
   }
 
   return CPVREpgInfoTagPtr();
@@ -274,13 +308,15 @@ std::vector<CPVREpgInfoTagPtr> CPVREpg::GetTagsBetween(const CDateTime &beginTim
 {
   std::vector<CPVREpgInfoTagPtr> epgTags;
 
-  CSingleLock lock(m_critSection);
-  for (const auto &infoTag : m_tags)
+  const TagsSnapshotPtr snapshot(GetTagsSnapshot());
+  size_t i = std::lower_bound(snapshot->starts.begin(), snapshot->starts.end(), ToTime(beginTime)) - snapshot->starts.begin();
+  for (; i < snapshot->tags.size(); ++i)
   {
-    if (infoTag.second->StartAsUTC() >= beginTime)
+    const CPVREpgInfoTagPtr &tag = snapshot->tags[i];
+    if (tag->StartAsUTC() >= beginTime)
     {
-      if (infoTag.second->EndAsUTC() <= endTime)
-        epgTags.emplace_back(infoTag.second);
+      if (tag->EndAsUTC() <= endTime)
+        epgTags.emplace_back(tag);
       else
         break; // done.
     }
@@ -289,6 +325,215 @@ std::vector<CPVREpgInfoTagPtr> CPVREpg::GetTagsBetween(const CDateTime &beginTim
   return epgTags;
 }
 
+CPVREpg::TagsSnapshotPtr CPVREpg::GetTagsSnapshot(void) const
+{
+  TagsSnapshotPtr snapshot(std::atomic_load(&m_tagsSnapshot));
+  if (snapshot && !m_bTagsSnapshotOutdated)
+    return snapshot;
+
+  // don't wait for an update that is in progress if there is a previous snapshot to serve
+  CSingleTryLock lock(m_critSection);
+  if (!lock.IsOwner())
+  {
+    if (snapshot)
+      return snapshot;
+    lock.Enter();
+  }
+
+  snapshot = std::atomic_load(&m_tagsSnapshot);
+  if (snapshot && !m_bTagsSnapshotOutdated)
+    return snapshot;
+
+  std::shared_ptr<TagsSnapshot> newSnapshot(std::make_shared<TagsSnapshot>());
+  newSnapshot->starts.reserve(m_tags.size());
+  newSnapshot->maxEnds.reserve(m_tags.size());
+  newSnapshot->tags.reserve(m_tags.size());
+  newSnapshot->broadcastIds.reserve(m_tags.size());
+
+  time_t iMaxEnd = 0;
+  for (const auto &infoTag : m_tags)
+  {
+    iMaxEnd = std::max(iMaxEnd, ToTime(infoTag.second->EndAsUTC()));
+
+    newSnapshot->broadcastIds.emplace_back(infoTag.second->UniqueBroadcastID(), newSnapshot->tags.size());
+    newSnapshot->starts.emplace_back(ToTime(infoTag.first));
+    newSnapshot->maxEnds.emplace_back(iMaxEnd);
+    newSnapshot->tags.emplace_back(infoTag.second);
+  }
+  std::sort(newSnapshot->broadcastIds.begin(), newSnapshot->broadcastIds.end());
+
+  snapshot = newSnapshot;
+  std::atomic_store(&m_tagsSnapshot, snapshot);
+  m_bTagsSnapshotOutdated = false;
+
+  return snapshot;
+}
+
+void CPVREpg::InvalidateTagsSnapshot(void)
+{
+  m_bTagsSnapshotOutdated = true;
+}
+
+void CPVREpg::SearchIndexTagChanged(const CPVREpgInfoTagPtr &tag)
+{
+  if (m_bSearchIndexActive)
+    m_searchIndexChanges[tag.get()] = tag;
+}
+
+void CPVREpg::SearchIndexTagRemoved(const CPVREpgInfoTagPtr &tag)
+{
+  if (m_bSearchIndexActive)
+    m_searchIndexChanges[tag.get()] = CPVREpgInfoTagPtr();
+}
+
+void CPVREpg::ResetSearchIndex(void)
+{
+  m_bSearchIndexActive = false;
+  m_searchIndexChanges.clear();
+}
+
+void CPVREpg::UpdateSearchIndex(bool bPlots) const
+{
+  std::unordered_map<const CPVREpgInfoTag*, CPVREpgInfoTagPtr> changes;
+  bool bRebuild = false;
+  {
+    // don't wait for an update that is in progress if the index can serve the search
+    CSingleTryLock lock(m_critSection);
+    if (!lock.IsOwner())
+    {
+      if (m_searchIndex.bBuilt && (!bPlots || m_searchIndex.bPlotsIndexed))
+        return;
+      lock.Enter();
+    }
+
+    if (!m_bSearchIndexActive)
+    {
+      // index all tags as they are now and record the changes from here on
+      m_bSearchIndexActive = true;
+      bRebuild = true;
+      for (const auto &tag : m_tags)
+        changes.insert(std::make_pair(tag.second.get(), tag.second));
+    }
+    else
+      changes.swap(m_searchIndexChanges);
+  }
+
+  SearchIndex &index = m_searchIndex;
+  if (bRebuild)
+  {
+    index.titles.Clear();
+    index.plots.Clear();
+    index.tags.clear();
+    index.freeEntries.clear();
+    index.entries.clear();
+    index.bPlotsIndexed = false;
+    index.bBuilt = true;
+  }
+
+  if (bPlots && !index.bPlotsIndexed)
+  {
+    for (unsigned int iEntry = 0; iEntry < index.tags.size(); ++iEntry)
+    {
+      if (index.tags[iEntry])
+      {
+        const std::string strPlot(index.tags[iEntry]->Plot(true));
+        index.plots.Set(iEntry, { &strPlot });
+      }
+    }
+    index.bPlotsIndexed = true;
+  }
+
+  for (const auto &change : changes)
+  {
+    auto it = index.entries.find(change.first);
+    if (!change.second)
+    {
+      if (it != index.entries.end())
+      {
+        index.titles.Remove(it->second);
+        index.plots.Remove(it->second);
+        index.tags[it->second].reset();
+        index.freeEntries.emplace_back(it->second);
+        index.entries.erase(it);
+      }
+      continue;
+    }
+
+    unsigned int iEntry;
+    if (it != index.entries.end())
+      iEntry = it->second;
+    else if (!index.freeEntries.empty())
+    {
+      iEntry = index.freeEntries.back();
+      index.freeEntries.pop_back();
+      index.entries.insert(std::make_pair(change.first, iEntry));
+    }
+    else
+    {
+      iEntry = static_cast<unsigned int>(index.tags.size());
+      index.tags.emplace_back();
+      index.entries.insert(std::make_pair(change.first, iEntry));
+    }
+    index.tags[iEntry] = change.second;
+
+    const std::string strTitle(change.second->Title(true));
+    const std::string strPlotOutline(change.second->PlotOutline(true));
+    index.titles.Set(iEntry, { &strTitle, &strPlotOutline });
+
+    if (index.bPlotsIndexed)
+    {
+      const std::string strPlot(change.second->Plot(true));
+      index.plots.Set(iEntry, { &strPlot });
+    }
+  }
+}
+
+bool CPVREpg::GetSearchCandidates(const CPVREpgSearchFilter &filter, std::vector<CPVREpgInfoTagPtr> &candidates) const
+{
+  const CTextSearch *search = filter.GetTextSearch();
+  if (!search)
+    return false;
+
+  // parental locked and empty titles are replaced by these labels, which are not in the index
+  if (search->Search(g_localizeStrings.Get(19266)) || search->Search(g_localizeStrings.Get(19055)))
+    return false;
+
+  CSingleLock lock(m_searchIndexLock);
+  UpdateSearchIndex(filter.ShouldSearchInDescription());
+
+  std::vector<unsigned int> entries;
+  if (!m_searchIndex.titles.GetCandidates(*search, entries))
+    return false;
+
+  if (filter.ShouldSearchInDescription())
+  {
+    std::vector<unsigned int> plotEntries;
+    if (!m_searchIndex.plots.GetCandidates(*search, plotEntries))
+      return false;
+
+    std::vector<unsigned int> allEntries;
+    allEntries.reserve(entries.size() + plotEntries.size());
+    std::set_union(entries.begin(), entries.end(), plotEntries.begin(), plotEntries.end(), std::back_inserter(allEntries));
+    entries.swap(allEntries);
+  }
+
+  std::vector<std::pair<CDateTime, CPVREpgInfoTagPtr> > tags;
+  tags.reserve(entries.size());
+  for (unsigned int iEntry : entries)
+    tags.emplace_back(m_searchIndex.tags[iEntry]->StartAsUTC(), m_searchIndex.tags[iEntry]);
+
+  // the tags are returned in the same order as without the index
+  std::sort(tags.begin(), tags.end(),
+            [](const std::pair<CDateTime, CPVREpgInfoTagPtr> &a, const std::pair<CDateTime, CPVREpgInfoTagPtr> &b) { return a.first < b.first; });
+
+  candidates.clear();
+  candidates.reserve(tags.size());
+  for (auto &tag : tags)
+    candidates.emplace_back(std::move(tag.second));
+
+  return true;
+}
+
 void CPVREpg::AddEntry(const CPVREpgInfoTag &tag)
 {
   CPVREpgInfoTagPtr newTag;
@@ -314,6 +559,10 @@ void CPVREpg::AddEntry(const CPVREpgInfoTag &tag)
     newTag->SetEpg(this);
     newTag->SetTimer(CServiceBroker::GetPVRManager().Timers()->GetTimerForEpgTag(newTag));
     newTag->SetRecording(CServiceBroker::GetPVRManager().Recordings()->GetRecordingForEpgTag(newTag));
+
+    CSingleLock lock(m_critSection);
+    InvalidateTagsSnapshot();
+    SearchIndexTagChanged(newTag);
   }
 }
 
@@ -436,6 +685,9 @@ bool CPVREpg::UpdateEntry(const CPVREpgInfoTagPtr &tag, bool bUpdateDatabase)
 
     if (bUpdateDatabase)
       m_changedTags.insert(std::make_pair(infoTag->UniqueBroadcastID(), infoTag));
+
+    InvalidateTagsSnapshot();
+    SearchIndexTagChanged(infoTag);
   }
 
   infoTag->SetTimer(CServiceBroker::GetPVRManager().Timers()->GetTimerForEpgTag(infoTag));
@@ -480,7 +732,9 @@ bool CPVREpg::UpdateEntry(const CPVREpgInfoTagPtr &tag, EPG_EVENT_STATE newState
 
         it->second->ClearTimer();
         it->second->ClearRecording();
+        SearchIndexTagRemoved(it->second);
         m_tags.erase(it);
+        InvalidateTagsSnapshot();
       }
       else
       {
@@ -559,10 +813,9 @@ int CPVREpg::Get(CFileItemList &results) const
 {
   int iInitialSize = results.Size();
 
-  CSingleLock lock(m_critSection);
-
-  for (std::map<CDateTime, CPVREpgInfoTagPtr>::const_iterator it = m_tags.begin(); it != m_tags.end(); ++it)
-    results.Add(CFileItemPtr(new CFileItem(it->second)));
+  const TagsSnapshotPtr snapshot(GetTagsSnapshot());
+  for (const auto &tag : snapshot->tags)
+    results.Add(CFileItemPtr(new CFileItem(tag)));
 
   return results.Size() - iInitialSize;
 }
@@ -574,12 +827,23 @@ int CPVREpg::Get(CFileItemList &results, const CPVREpgSearchFilter &filter) cons
   if (!HasValidEntries())
     return -1;
 
-  CSingleLock lock(m_critSection);
-
-  for (std::map<CDateTime, CPVREpgInfoTagPtr>::const_iterator it = m_tags.begin(); it != m_tags.end(); ++it)
+  std::vector<CPVREpgInfoTagPtr> candidates;
+  if (GetSearchCandidates(filter, candidates))
+  {
+    for (const auto &tag : candidates)
+    {
+      if (filter.FilterEntry(tag))
+        results.Add(CFileItemPtr(new CFileItem(tag)));
+    }
+  }
+  else
   {
-    if (filter.FilterEntry(it->second))
-      results.Add(CFileItemPtr(new CFileItem(it->second)));
+    const TagsSnapshotPtr snapshot(GetTagsSnapshot());
+    for (const auto &tag : snapshot->tags)
+    {
+      if (filter.FilterEntry(tag))
+        results.Add(CFileItemPtr(new CFileItem(tag)));
+    }
   }
 
   return results.Size() - iInitialSize;
@@ -601,34 +865,41 @@ bool CPVREpg::Persist(void)
     return false;
   }
 
+  /* lock the table before the database, the same order as Load() */
+  CSingleLock lock(m_critSection);
   database->Lock();
 
+  if (m_iEpgID <= 0 || m_bChanged)
   {
-    CSingleLock lock(m_critSection);
-    if (m_iEpgID <= 0 || m_bChanged)
-    {
-      int iId = database->Persist(*this, m_iEpgID > 0);
-      if (iId > 0)
-        m_iEpgID = iId;
-    }
+    int iId = database->Persist(*this, m_iEpgID > 0);
+    if (iId > 0)
+      m_iEpgID = iId;
+  }
 
-    for (std::map<int, CPVREpgInfoTagPtr>::iterator it = m_deletedTags.begin(); it != m_deletedTags.end(); ++it)
-      database->Delete(*it->second);
+  if (!m_deletedTags.empty())
+  {
+    std::vector<CPVREpgInfoTagPtr> deletedTags;
+    deletedTags.reserve(m_deletedTags.size());
+    for (const auto &deletedTag : m_deletedTags)
+      deletedTags.emplace_back(deletedTag.second);
 
-    for (std::map<int, CPVREpgInfoTagPtr>::iterator it = m_changedTags.begin(); it != m_changedTags.end(); ++it)
-      it->second->Persist(false);
+    database->QueueDelete(deletedTags);
+  }
 
-    if (m_bUpdateLastScanTime)
-      database->PersistLastEpgScanTime(m_iEpgID, true);
+  for (std::map<int, CPVREpgInfoTagPtr>::iterator it = m_changedTags.begin(); it != m_changedTags.end(); ++it)
+    database->Persist(*it->second, false);
 
-    m_deletedTags.clear();
-    m_changedTags.clear();
-    m_bChanged            = false;
-    m_bTagsChanged        = false;
-    m_bUpdateLastScanTime = false;
-  }
+  if (m_bUpdateLastScanTime)
+    database->PersistLastEpgScanTime(m_iEpgID, true);
 
-  bool bRet = database->CommitInsertQueries();
+  m_deletedTags.clear();
+  m_changedTags.clear();
+  m_bChanged            = false;
+  m_bTagsChanged        = false;
+  m_bUpdateLastScanTime = false;
+
+  lock.Leave();
+  bool bRet = database->CommitQueuedWrites();
 
   database->Unlock();
   return bRet;
@@ -638,9 +909,9 @@ CDateTime CPVREpg::GetFirstDate(void) const
 {
   CDateTime first;
 
-  CSingleLock lock(m_critSection);
-  if (!m_tags.empty())
-    first = m_tags.begin()->second->StartAsUTC();
+  const TagsSnapshotPtr snapshot(GetTagsSnapshot());
+  if (!snapshot->tags.empty())
+    first = snapshot->tags.front()->StartAsUTC();
 
   return first;
 }
@@ -649,9 +920,9 @@ CDateTime CPVREpg::GetLastDate(void) const
 {
   CDateTime last;
 
-  CSingleLock lock(m_critSection);
-  if (!m_tags.empty())
-    last = m_tags.rbegin()->second->StartAsUTC();
+  const TagsSnapshotPtr snapshot(GetTagsSnapshot());
+  if (!snapshot->tags.empty())
+    last = snapshot->tags.back()->StartAsUTC();
 
   return last;
 }
@@ -681,16 +952,16 @@ bool CPVREpg::FixOverlappingEvents(bool bUpdateDb /* = false */)
       if (bUpdateDb)
         m_deletedTags.insert(make_pair(currentTag->UniqueBroadcastID(), currentTag));
 
-      if (m_nowActiveStart == it->first)
-        m_nowActiveStart.SetValid(false);
-
       it->second->ClearTimer();
       it->second->ClearRecording();
+      SearchIndexTagRemoved(it->second);
       m_tags.erase(it++);
+      InvalidateTagsSnapshot();
     }
     else if (previousTag->EndAsUTC() > currentTag->StartAsUTC())
     {
       previousTag->SetEndFromUTC(currentTag->StartAsUTC());
+      InvalidateTagsSnapshot();
       if (bUpdateDb)
         m_changedTags.insert(make_pair(previousTag->UniqueBroadcastID(), previousTag));
 
@@ -823,10 +1094,11 @@ bool CPVREpg::LoadFromClients(time_t start, time_t end)
 
 CPVREpgInfoTagPtr CPVREpg::GetNextEvent(const CPVREpgInfoTag& tag) const
 {
-  CSingleLock lock(m_critSection);
-  std::map<CDateTime, CPVREpgInfoTagPtr>::const_iterator it = m_tags.find(tag.StartAsUTC());
-  if (it != m_tags.end() && ++it != m_tags.end())
-    return it->second;
+  const TagsSnapshotPtr snapshot(GetTagsSnapshot());
+  const time_t iStart = ToTime(tag.StartAsUTC());
+  const auto it = std::lower_bound(snapshot->starts.begin(), snapshot->starts.end(), iStart);
+  if (it != snapshot->starts.end() && *it == iStart && it + 1 != snapshot->starts.end())
+    return snapshot->tags[it - snapshot->starts.begin() + 1];
 
   CPVREpgInfoTagPtr retVal;
   return retVal;
@@ -19,8 +19,12 @@
  *
  */
 
+#include <atomic>
+#include <ctime>
 #include <map>
+#include <memory>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include "FileItem.h"
@@ -31,6 +35,7 @@
 #include "pvr/channels/PVRChannel.h"
 #include "pvr/epg/EpgInfoTag.h"
 #include "pvr/epg/EpgSearchFilter.h"
+#include "pvr/epg/EpgSearchIndex.h"
 
 /** EPG container for CPVREpgInfoTag instances */
 namespace PVR
@@ -284,8 +289,76 @@ namespace PVR
     bool IsValid(void) const;
 
   private:
+    /*!
+     * @brief Immutable copy of the tags of this table, sorted by start time. Readers work on a
+     *        snapshot without taking the table's lock; any change to the tags publishes a new one.
+     */
+    struct TagsSnapshot
+    {
+      std::vector<time_t> starts;                                   /*!< start time of each tag in UTC */
+      std::vector<time_t> maxEnds;                                  /*!< latest end time in UTC of all tags up to and including this one */
+      std::vector<CPVREpgInfoTagPtr> tags;
+      std::vector<std::pair<unsigned int, size_t> > broadcastIds;  /*!< unique broadcast id and tag index, sorted by id */
+    };
+    typedef std::shared_ptr<const TagsSnapshot> TagsSnapshotPtr;
+
     CPVREpg(void);
 
+    /*!
+     * @brief Get the current snapshot of the tags, rebuilding it if the tags changed.
+     * @return The snapshot. Never NULL.
+     */
+    TagsSnapshotPtr GetTagsSnapshot(void) const;
+
+    /*!
+     * @brief Mark the snapshot outdated. Must be called with m_critSection held after changing m_tags or any of its tags.
+     */
+    void InvalidateTagsSnapshot(void);
+
+    /*!
+     * @brief Search indices of the tags of this table. Built on the first search and then updated with the
+     *        tags that were added, changed or removed since the previous search.
+     */
+    struct SearchIndex
+    {
+      bool bBuilt = false;
+      bool bPlotsIndexed = false;
+      CPVREpgSearchIndex titles;                                         /*!< words of the titles and plot outlines */
+      CPVREpgSearchIndex plots;                                          /*!< words of the plots, indexed on first search in descriptions */
+      std::vector<CPVREpgInfoTagPtr> tags;                               /*!< the indexed tags by index entry, NULL for unused entries */
+      std::vector<unsigned int> freeEntries;                             /*!< unused index entries */
+      std::unordered_map<const CPVREpgInfoTag*, unsigned int> entries;  /*!< the index entry of each indexed tag */
+    };
+
+    /*!
+     * @brief Use the search indices to find the tags that may match a filter's search term.
+     * @param filter The filter to apply.
+     * @param candidates Set to the tags that have to be checked against the filter, sorted by start time.
+     * @return False if all tags have to be checked, true otherwise.
+     */
+    bool GetSearchCandidates(const CPVREpgSearchFilter &filter, std::vector<CPVREpgInfoTagPtr> &candidates) const;
+
+    /*!
+     * @brief Bring the search indices up to date with the tags. Must be called with m_searchIndexLock held.
+     * @param bPlots True to also index the plots, false otherwise.
+     */
+    void UpdateSearchIndex(bool bPlots) const;
+
+    /*!
+     * @brief Record a new or changed tag for the search index. Must be called with m_critSection held.
+     */
+    void SearchIndexTagChanged(const CPVREpgInfoTagPtr &tag);
+
+    /*!
+     * @brief Record a removed tag for the search index. Must be called with m_critSection held.
+     */
+    void SearchIndexTagRemoved(const CPVREpgInfoTagPtr &tag);
+
+    /*!
+     * @brief Rebuild the search index from all tags on the next search. Must be called with m_critSection held.
+     */
+    void ResetSearchIndex(void);
+
     /*!
      * @brief Update the EPG from a scraper set in the channel tag.
      * @todo not implemented yet for non-pvr EPGs
@@ -334,13 +407,19 @@ namespace PVR
     int                                 m_iEpgID;          /*!< the database ID of this table */
     std::string                         m_strName;         /*!< the name of this table */
     std::string                         m_strScraperName;  /*!< the name of the scraper to use */
-    mutable CDateTime                   m_nowActiveStart;  /*!< the start time of the tag that is currently active */
+    mutable std::atomic<time_t>         m_nowActiveStart{0}; /*!< the start time in UTC of the tag that is currently active, 0 if unknown */
 
     CDateTime                           m_lastScanTime;    /*!< the last time the EPG has been updated */
 
     PVR::CPVRChannelPtr                 m_pvrChannel;      /*!< the channel this EPG belongs to */
 
     CCriticalSection                    m_critSection;     /*!< critical section for changes in this table */
+    mutable TagsSnapshotPtr             m_tagsSnapshot;    /*!< the last published snapshot of m_tags, only accessed atomically */
+    mutable std::atomic<bool>           m_bTagsSnapshotOutdated{true}; /*!< true if m_tags changed since m_tagsSnapshot was built */
+    mutable CCriticalSection            m_searchIndexLock; /*!< guards m_searchIndex, taken before m_critSection */
+    mutable SearchIndex                 m_searchIndex;
+    mutable bool                        m_bSearchIndexActive = false; /*!< true if changes of the tags are recorded for the search index */
+    mutable std::unordered_map<const CPVREpgInfoTag*, CPVREpgInfoTagPtr> m_searchIndexChanges; /*!< tags changed since the last search, NULL if removed */
     bool                                m_bUpdateLastScanTime;
   };
 }
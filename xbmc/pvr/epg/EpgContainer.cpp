@@ -20,6 +20,10 @@
 
 #include "EpgContainer.h"
 
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <memory>
 #include <utility>
 
 #include "Application.h"
@@ -114,6 +118,7 @@ void CEpgTagStateChange::Deliver()
 CPVREpgContainer::CPVREpgContainer(void) :
   CThread("EPGUpdater"),
   m_database(new CPVREpgDatabase),
+  m_persistDone(true, true),
   m_bUpdateNotificationPending(false),
   m_settings({
     CSettings::SETTING_EPG_IGNOREDBFORCLIENT,
@@ -275,6 +280,9 @@ bool CPVREpgContainer::Stop(void)
 {
   StopThread();
 
+  /* a running persist job stops after the current table once the thread is stopped */
+  m_persistDone.Wait();
+
   m_database->Close();
 
   CSingleLock lock(m_critSection);
@@ -341,18 +349,77 @@ bool CPVREpgContainer::PersistAll(void)
   auto copy = m_epgs;
   m_critSection.unlock();
 
+  unsigned int iPersisted = 0;
+  const unsigned int iStartTime = XbmcThreads::SystemClockMillis();
+
   for (EPGMAP::const_iterator it = copy.begin(); it != copy.end() && !m_bStop; ++it)
   {
     CPVREpgPtr epg = it->second;
     if (epg && epg->NeedsSave())
     {
       bReturn &= epg->Persist();
+      ++iPersisted;
     }
   }
 
+  if (iPersisted > 0)
+    CLog::Log(LOGDEBUG, "EpgContainer - %s - persisted %u tables in %u ms", __FUNCTION__, iPersisted, XbmcThreads::SystemClockMillis() - iStartTime);
+
   return bReturn;
 }
 
+namespace
+{
+  const size_t EPG_UPDATE_MAX_CONCURRENT_TABLES = 4; /*!< maximum number of tables that are fetched from the clients at the same time */
+}
+
+class CPVREpgContainerUpdateJob : public CJob
+{
+public:
+  CPVREpgContainerUpdateJob(const std::function<void(void)> &update, CEvent &done) : m_update(update), m_done(done) {}
+  ~CPVREpgContainerUpdateJob(void) override { m_done.Set(); } // also reached if the job is cancelled before it ran
+
+  bool DoWork(void) override
+  {
+    m_update();
+    return true;
+  }
+
+  const char *GetType() const override { return "pvr-epg-update"; }
+
+private:
+  std::function<void(void)> m_update;
+  CEvent &m_done;
+};
+
+class CPVREpgContainerPersistJob : public CJob
+{
+public:
+  CPVREpgContainerPersistJob(CPVREpgContainer &container, CEvent &done) : m_container(container), m_done(done) {}
+  ~CPVREpgContainerPersistJob(void) override { m_done.Set(); } // also reached if the job is cancelled before it ran
+
+  bool DoWork(void) override
+  {
+    return m_container.PersistAll();
+  }
+
+  const char *GetType() const override { return "pvr-epg-persist"; }
+
+private:
+  CPVREpgContainer &m_container;
+  CEvent &m_done;
+};
+
+void CPVREpgContainer::QueuePersistAll(void)
+{
+  /* changes made while a job is running are collected by the tables and written by the next job */
+  if (!m_persistDone.WaitMSec(0))
+    return;
+
+  m_persistDone.Reset();
+  CJobManager::GetInstance().AddJob(new CPVREpgContainerPersistJob(*this, m_persistDone), NULL, CJob::PRIORITY_LOW);
+}
+
 void CPVREpgContainer::Process(void)
 {
   time_t iNow(0), iLastSave(0);
@@ -454,10 +521,11 @@ void CPVREpgContainer::Process(void)
       }
     }
 
-    /* check for changes that need to be saved every 60 seconds */
+    /* check for changes that need to be saved every 60 seconds. the writes are done in the background,
+       so this thread keeps delivering updates while a large guide is persisted */
     if (iNow - iLastSave > 60)
     {
-      PersistAll();
+      QueuePersistAll();
       iLastSave = iNow;
     }
 
@@ -680,42 +748,81 @@ bool CPVREpgContainer::UpdateEPG(bool bOnlyPending /* = false */)
   if (bShowProgress && !bOnlyPending)
     progressHandler = new CPVRGUIProgressHandler(g_localizeStrings.Get(19004)); // Importing guide from clients
 
-  /* load or update all EPG tables */
-  unsigned int iCounter(0);
-  for (const auto &epgEntry : m_epgs)
+  std::vector<CPVREpgPtr> tables;
   {
-    if (InterruptUpdate())
+    CSingleLock lock(m_critSection);
+    tables.reserve(m_epgs.size());
+    for (const auto &epgEntry : m_epgs)
     {
-      bInterrupted = true;
-      break;
+      if (epgEntry.second)
+        tables.emplace_back(epgEntry.second);
     }
+  }
+
+  /* load or update all EPG tables. up to EPG_UPDATE_MAX_CONCURRENT_TABLES tables are updated at the same time,
+     each worker takes the next table that wasn't started yet */
+  const int iUpdateTime = m_settings.GetIntValue(CSettings::SETTING_EPG_EPGUPDATE) * 60;
+  std::atomic<size_t> iNextTable(0);
+  std::atomic<bool> bTablesInterrupted(false);
+  CCriticalSection resultsLock;
+
+  const std::function<void(void)> updateTables = [&]()
+  {
+    for (size_t iTable = iNextTable++; iTable < tables.size(); iTable = iNextTable++)
+    {
+      if (InterruptUpdate())
+      {
+        bTablesInterrupted = true;
+        break;
+      }
 
-    CPVREpgPtr epg = epgEntry.second;
-    if (!epg)
-      continue;
+      const CPVREpgPtr &epg = tables[iTable];
 
-    if (bShowProgress && !bOnlyPending)
-      progressHandler->UpdateProgress(epg->Name(), ++iCounter, m_epgs.size());
+      if (bShowProgress && !bOnlyPending)
+        progressHandler->UpdateProgress(epg->Name(), iTable + 1, tables.size());
 
-    // we currently only support update via pvr add-ons. skip update when the pvr manager isn't started
-    if (!CServiceBroker::GetPVRManager().IsStarted())
-      continue;
+      // we currently only support update via pvr add-ons. skip update when the pvr manager isn't started
+      if (!CServiceBroker::GetPVRManager().IsStarted())
+        continue;
 
-    // check the pvr manager when the channel pointer isn't set
-    if (!epg->Channel())
-    {
-      CPVRChannelPtr channel = CServiceBroker::GetPVRManager().ChannelGroups()->GetChannelByEpgId(epg->EpgID());
-      if (channel)
-        epg->SetChannel(channel);
+      // check the pvr manager when the channel pointer isn't set
+      if (!epg->Channel())
+      {
+        CPVRChannelPtr channel = CServiceBroker::GetPVRManager().ChannelGroups()->GetChannelByEpgId(epg->EpgID());
+        if (channel)
+          epg->SetChannel(channel);
+      }
+
+      if ((!bOnlyPending || epg->UpdatePending()) &&
+          epg->Update(start, end, iUpdateTime, bOnlyPending))
+      {
+        CSingleLock lock(resultsLock);
+        iUpdatedTables++;
+      }
+      else if (!epg->IsValid())
+      {
+        CSingleLock lock(resultsLock);
+        invalidTables.push_back(epg);
+      }
     }
+  };
 
-    if ((!bOnlyPending || epg->UpdatePending()) &&
-        epg->Update(start, end, m_settings.GetIntValue(CSettings::SETTING_EPG_EPGUPDATE) * 60, bOnlyPending))
-      iUpdatedTables++;
-    else if (!epg->IsValid())
-      invalidTables.push_back(epg);
+  const size_t iWorkers = std::min(EPG_UPDATE_MAX_CONCURRENT_TABLES, tables.size());
+  std::vector<std::unique_ptr<CEvent> > workersDone;
+  for (size_t iWorker = 1; iWorker < iWorkers; ++iWorker)
+  {
+    workersDone.emplace_back(new CEvent(true));
+    CJobManager::GetInstance().AddJob(new CPVREpgContainerUpdateJob(updateTables, *workersDone.back()), nullptr, CJob::PRIORITY_DEDICATED);
   }
 
+  /* this thread is the first worker */
+  updateTables();
+
+  for (const auto &done : workersDone)
+    done->Wait();
+
+  bInterrupted = bTablesInterrupted;
+
   if (bShowProgress && !bOnlyPending)
     progressHandler->DestroyProgress();
 
@@ -791,13 +898,18 @@ int CPVREpgContainer::GetEPGSearch(CFileItemList &results, const CPVREpgSearchFi
 {
   int iInitialSize = results.Size();
 
-  /* get filtered results from all tables */
+  /* get filtered results from all tables, the tables are searched without holding the container lock */
+  std::vector<CPVREpgPtr> epgs;
   {
     CSingleLock lock(m_critSection);
+    epgs.reserve(m_epgs.size());
     for (const auto &epgEntry : m_epgs)
-      epgEntry.second->Get(results, filter);
+      epgs.emplace_back(epgEntry.second);
   }
 
+  for (const auto &epg : epgs)
+    epg->Get(results, filter);
+
   /* remove duplicate entries */
   if (filter.ShouldRemoveDuplicates())
     filter.RemoveDuplicates(results);
@@ -193,6 +193,11 @@ namespace PVR
      */
     bool PersistAll(void);
 
+    /*!
+     * @brief Call PersistAll() from a background job, unless such a job is still queued or running.
+     */
+    void QueuePersistAll(void);
+
     /*!
      * @brief A client triggered an epg update request for a channel
      * @param iClientID The id of the client which triggered the update request
@@ -275,6 +280,7 @@ namespace PVR
 
     CCriticalSection               m_critSection;    /*!< a critical section for changes to this container */
     CEvent                         m_updateEvent;    /*!< trigger when an update finishes */
+    CEvent                         m_persistDone;    /*!< set while no persist job is queued or running */
 
     std::list<CEpgUpdateRequest> m_updateRequests; /*!< list of update requests triggered by addon */
     CCriticalSection m_updateRequestsLock;         /*!< protect update requests */
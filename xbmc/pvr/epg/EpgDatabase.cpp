@@ -34,6 +34,19 @@
 using namespace dbiplus;
 using namespace PVR;
 
+namespace
+{
+  const std::string TAGS_REPLACE_QUERY =
+      "REPLACE INTO epgtags (idEpg, iStartTime, "
+      "iEndTime, sTitle, sPlotOutline, sPlot, sOriginalTitle, sCast, sDirector, sWriter, iYear, sIMDBNumber, "
+      "sIconPath, iGenreType, iGenreSubType, sGenre, iFirstAired, iParentalRating, iStarRating, bNotify, iSeriesId, "
+      "iEpisodeId, iEpisodePart, sEpisodeName, iFlags, iBroadcastUid, idBroadcast) VALUES ";
+
+  /* keep multi row queries below the compound select limit of older sqlite versions and mysql's max_allowed_packet */
+  const unsigned int TAGS_BATCH_MAX_ROWS = 250;
+  const size_t TAGS_BATCH_MAX_SIZE = 512 * 1024;
+}
+
 bool CPVREpgDatabase::Open()
 {
   CSingleLock lock(m_critSection);
@@ -43,6 +56,8 @@ bool CPVREpgDatabase::Open()
 void CPVREpgDatabase::Close()
 {
   CSingleLock lock(m_critSection);
+  m_strTagsBatch.clear();
+  m_iTagsBatchRows = 0;
   CDatabase::Close();
 }
 
@@ -377,58 +392,96 @@ int CPVREpgDatabase::Persist(const CPVREpgInfoTag &tag, bool bSingleUpdate /* =
   tag.FirstAiredAsUTC().GetAsTime(iFirstAired);
 
   int iBroadcastId = tag.BroadcastId();
-  std::string strQuery;
 
   /* Only store the genre string when needed */
   std::string strGenre = (tag.GenreType() == EPG_GENRE_USE_STRING) ? StringUtils::Join(tag.Genre(), g_advancedSettings.m_videoItemSeparator) : "";
 
+  /* new tags get their id from the database */
+  const std::string strBroadcastId = iBroadcastId < 0 ? "NULL" : StringUtils::Format("%i", iBroadcastId);
+
   CSingleLock lock(m_critSection);
 
-  if (iBroadcastId < 0)
-  {
-    strQuery = PrepareSQL("REPLACE INTO epgtags (idEpg, iStartTime, "
-        "iEndTime, sTitle, sPlotOutline, sPlot, sOriginalTitle, sCast, sDirector, sWriter, iYear, sIMDBNumber, "
-        "sIconPath, iGenreType, iGenreSubType, sGenre, iFirstAired, iParentalRating, iStarRating, bNotify, iSeriesId, "
-        "iEpisodeId, iEpisodePart, sEpisodeName, iFlags, iBroadcastUid) "
-        "VALUES (%u, %u, %u, '%s', '%s', '%s', '%s', '%s', '%s', '%s', %i, '%s', '%s', %i, %i, '%s', %u, %i, %i, %i, %i, %i, %i, '%s', %i, %i);",
-        tag.EpgID(), static_cast<unsigned int>(iStartTime), static_cast<unsigned int>(iEndTime),
-        tag.Title(true).c_str(), tag.PlotOutline(true).c_str(), tag.Plot(true).c_str(),
-        tag.OriginalTitle(true).c_str(), tag.Cast().c_str(), tag.Director().c_str(), tag.Writer().c_str(), tag.Year(), tag.IMDBNumber().c_str(),
-        tag.Icon().c_str(), tag.GenreType(), tag.GenreSubType(), strGenre.c_str(),
-        static_cast<unsigned int>(iFirstAired), tag.ParentalRating(), tag.StarRating(), tag.Notify(),
-        tag.SeriesNumber(), tag.EpisodeNumber(), tag.EpisodePart(), tag.EpisodeName().c_str(), tag.Flags(),
-        tag.UniqueBroadcastID());
-  }
-  else
-  {
-    strQuery = PrepareSQL("REPLACE INTO epgtags (idEpg, iStartTime, "
-        "iEndTime, sTitle, sPlotOutline, sPlot, sOriginalTitle, sCast, sDirector, sWriter, iYear, sIMDBNumber, "
-        "sIconPath, iGenreType, iGenreSubType, sGenre, iFirstAired, iParentalRating, iStarRating, bNotify, iSeriesId, "
-        "iEpisodeId, iEpisodePart, sEpisodeName, iFlags, iBroadcastUid, idBroadcast) "
-        "VALUES (%u, %u, %u, '%s', '%s', '%s', '%s', '%s', '%s', '%s', %i, '%s', '%s', %i, %i, '%s', %u, %i, %i, %i, %i, %i, %i, '%s', %i, %i, %i);",
-        tag.EpgID(), static_cast<unsigned int>(iStartTime), static_cast<unsigned int>(iEndTime),
-        tag.Title(true).c_str(), tag.PlotOutline(true).c_str(), tag.Plot(true).c_str(),
-        tag.OriginalTitle(true).c_str(), tag.Cast().c_str(), tag.Director().c_str(), tag.Writer().c_str(), tag.Year(), tag.IMDBNumber().c_str(),
-        tag.Icon().c_str(), tag.GenreType(), tag.GenreSubType(), strGenre.c_str(),
-        static_cast<unsigned int>(iFirstAired), tag.ParentalRating(), tag.StarRating(), tag.Notify(),
-        tag.SeriesNumber(), tag.EpisodeNumber(), tag.EpisodePart(), tag.EpisodeName().c_str(), tag.Flags(),
-        tag.UniqueBroadcastID(), iBroadcastId);
-  }
+  const std::string strValues = PrepareSQL("(%u, %u, %u, '%s', '%s', '%s', '%s', '%s', '%s', '%s', %i, '%s', '%s', %i, %i, '%s', %u, %i, %i, %i, %i, %i, %i, '%s', %i, %i, %s)",
+      tag.EpgID(), static_cast<unsigned int>(iStartTime), static_cast<unsigned int>(iEndTime),
+      tag.Title(true).c_str(), tag.PlotOutline(true).c_str(), tag.Plot(true).c_str(),
+      tag.OriginalTitle(true).c_str(), tag.Cast().c_str(), tag.Director().c_str(), tag.Writer().c_str(), tag.Year(), tag.IMDBNumber().c_str(),
+      tag.Icon().c_str(), tag.GenreType(), tag.GenreSubType(), strGenre.c_str(),
+      static_cast<unsigned int>(iFirstAired), tag.ParentalRating(), tag.StarRating(), tag.Notify(),
+      tag.SeriesNumber(), tag.EpisodeNumber(), tag.EpisodePart(), tag.EpisodeName().c_str(), tag.Flags(),
+      tag.UniqueBroadcastID(), strBroadcastId.c_str());
 
   if (bSingleUpdate)
   {
-    if (ExecuteQuery(strQuery))
+    if (ExecuteQuery(TAGS_REPLACE_QUERY + strValues + ";"))
       iReturn = (int) m_pDS->lastinsertid();
   }
   else
   {
-    QueueInsertQuery(strQuery);
+    /* collect the rows in a multi row query, which is queued when it's full or the writes are committed */
+    if (m_strTagsBatch.empty())
+      m_strTagsBatch = TAGS_REPLACE_QUERY;
+    else
+      m_strTagsBatch.append(", ");
+    m_strTagsBatch.append(strValues);
+
+    if (++m_iTagsBatchRows >= TAGS_BATCH_MAX_ROWS || m_strTagsBatch.size() >= TAGS_BATCH_MAX_SIZE)
+      QueueTagsBatch();
+
     iReturn = 0;
   }
 
   return iReturn;
 }
 
+bool CPVREpgDatabase::QueueDelete(const std::vector<CPVREpgInfoTagPtr> &tags)
+{
+  bool bReturn = true;
+  std::string strIds;
+  unsigned int iIds = 0;
+
+  CSingleLock lock(m_critSection);
+  for (auto it = tags.begin(); it != tags.end(); ++it)
+  {
+    /* tag without a database ID was not persisted */
+    if ((*it)->BroadcastId() > 0)
+    {
+      if (!strIds.empty())
+        strIds.append(",");
+      strIds.append(StringUtils::Format("%i", (*it)->BroadcastId()));
+      ++iIds;
+    }
+
+    if (!strIds.empty() && (iIds >= TAGS_BATCH_MAX_ROWS || it + 1 == tags.end()))
+    {
+      bReturn &= QueueInsertQuery(PrepareSQL("DELETE FROM epgtags WHERE idBroadcast IN (%s);", strIds.c_str()));
+      strIds.clear();
+      iIds = 0;
+    }
+  }
+
+  return bReturn;
+}
+
+bool CPVREpgDatabase::QueueTagsBatch(void)
+{
+  if (m_strTagsBatch.empty())
+    return true;
+
+  m_strTagsBatch.append(";");
+  bool bReturn = QueueInsertQuery(m_strTagsBatch);
+
+  m_strTagsBatch.clear();
+  m_iTagsBatchRows = 0;
+  return bReturn;
+}
+
+bool CPVREpgDatabase::CommitQueuedWrites(void)
+{
+  CSingleLock lock(m_critSection);
+  bool bReturn = QueueTagsBatch();
+  return CommitInsertQueries() && bReturn;
+}
+
 int CPVREpgDatabase::GetLastEPGId(void)
 {
   CSingleLock lock(m_critSection);
@@ -19,6 +19,9 @@
  *
  */
 
+#include <string>
+#include <vector>
+
 #include "XBDateTime.h"
 #include "dbwrappers/Database.h"
 #include "threads/CriticalSection.h"
@@ -150,10 +153,24 @@ namespace PVR
      * @brief Persist an infotag.
      * @param tag The tag to persist.
      * @param bSingleUpdate If true, this is a single update and the query will be executed immediately.
+     *                      Otherwise the tag is added to a multi row query that is executed by CommitQueuedWrites().
      * @return The database ID of this entry or 0 if bSingleUpdate is false and the query was queued.
      */
     int Persist(const CPVREpgInfoTag &tag, bool bSingleUpdate = true);
 
+    /*!
+     * @brief Queue the removal of infotags.
+     * @param tags The tags to remove. Tags that were never persisted are ignored.
+     * @return True if the queries were queued successfully, false otherwise.
+     */
+    bool QueueDelete(const std::vector<CPVREpgInfoTagPtr> &tags);
+
+    /*!
+     * @brief Execute all queued queries in a single transaction.
+     * @return True if the queries were executed successfully, false otherwise.
+     */
+    bool CommitQueuedWrites(void);
+
     /*!
      * @return Last EPG id in the database
      */
@@ -178,8 +195,16 @@ namespace PVR
      */
     void UpdateTables(int version) override;
 
+    /*!
+     * @brief Queue the multi row query collected by Persist(tag, false).
+     * @return True if the query was queued successfully or there was nothing to queue, false otherwise.
+     */
+    bool QueueTagsBatch(void);
+
     int GetMinSchemaVersion() const override { return 4; }
 
     CCriticalSection m_critSection;
+    std::string m_strTagsBatch;         /*!< multi row query with the persisted tags that were not queued yet */
+    unsigned int m_iTagsBatchRows = 0;  /*!< number of rows in m_strTagsBatch */
   };
 }
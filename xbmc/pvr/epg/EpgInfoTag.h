@@ -101,6 +101,12 @@ namespace PVR
      */
     bool IsUpcoming(void) const;
 
+    /*!
+     * @brief Get current time, taking timeshifting into account.
+     * @return The time in UTC that IsActive(), WasActive() and IsUpcoming() compare against.
+     */
+    CDateTime GetCurrentPlayingTime(void) const;
+
     /*!
      * @return The current progress of this tag.
      */
@@ -454,11 +460,6 @@ namespace PVR
      */
     void UpdatePath(void);
 
-    /*!
-     * @brief Get current time, taking timeshifting into account.
-     */
-    CDateTime GetCurrentPlayingTime(void) const;
-
     bool                     m_bNotify;            /*!< notify on start */
     int                      m_iClientId;          /*!< client id */
     int                      m_iBroadcastId;       /*!< database ID */
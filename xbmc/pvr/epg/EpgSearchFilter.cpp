@@ -42,6 +42,7 @@ CPVREpgSearchFilter::CPVREpgSearchFilter()
 void CPVREpgSearchFilter::Reset()
 {
   m_strSearchTerm.clear();
+  m_textSearch.reset();
   m_bIsCaseSensitive         = false;
   m_bSearchInDescription     = false;
   m_iGenreType               = EPG_SEARCH_UNSET;
@@ -108,18 +109,30 @@ void CPVREpgSearchFilter::SetSearchPhrase(const std::string &strSearchPhrase)
   m_strSearchTerm = "\"";
   m_strSearchTerm.append(strSearchPhrase);
   m_strSearchTerm.append("\"");
+  m_textSearch.reset();
+}
+
+const CTextSearch *CPVREpgSearchFilter::GetTextSearch() const
+{
+  if (m_strSearchTerm.empty())
+    return nullptr;
+
+  if (!m_textSearch)
+    m_textSearch.reset(new CTextSearch(m_strSearchTerm, m_bIsCaseSensitive, SEARCH_DEFAULT_OR));
+
+  return m_textSearch.get();
 }
 
 bool CPVREpgSearchFilter::MatchSearchTerm(const CPVREpgInfoTagPtr &tag) const
 {
   bool bReturn(true);
 
-  if (!m_strSearchTerm.empty())
+  const CTextSearch *search = GetTextSearch();
+  if (search)
   {
-    CTextSearch search(m_strSearchTerm, m_bIsCaseSensitive, SEARCH_DEFAULT_OR);
-    bReturn = search.Search(tag->Title()) ||
-              search.Search(tag->PlotOutline()) ||
-              (m_bSearchInDescription && search.Search(tag->Plot()));
+    bReturn = search->Search(tag->Title()) ||
+              search->Search(tag->PlotOutline()) ||
+              (m_bSearchInDescription && search->Search(tag->Plot()));
   }
 
   return bReturn;
@@ -19,11 +19,14 @@
  *
  */
 
+#include <memory>
+
 #include "XBDateTime.h"
 
 #include "pvr/PVRTypes.h"
 
 class CFileItemList;
+class CTextSearch;
 
 namespace PVR
 {
@@ -56,11 +59,11 @@ namespace PVR
     static int RemoveDuplicates(CFileItemList &results);
 
     const std::string &GetSearchTerm() const { return m_strSearchTerm; }
-    void SetSearchTerm(const std::string &strSearchTerm) { m_strSearchTerm = strSearchTerm; }
+    void SetSearchTerm(const std::string &strSearchTerm) { m_strSearchTerm = strSearchTerm; m_textSearch.reset(); }
     void SetSearchPhrase(const std::string &strSearchPhrase);
 
     bool IsCaseSensitive() const { return m_bIsCaseSensitive; }
-    void SetCaseSensitive(bool bIsCaseSensitive) { m_bIsCaseSensitive = bIsCaseSensitive; }
+    void SetCaseSensitive(bool bIsCaseSensitive) { m_bIsCaseSensitive = bIsCaseSensitive; m_textSearch.reset(); }
 
     bool ShouldSearchInDescription() const { return m_bSearchInDescription; }
     void SetSearchInDescription(bool bSearchInDescription) {m_bSearchInDescription = bSearchInDescription; }
@@ -110,6 +113,12 @@ namespace PVR
     unsigned int GetUniqueBroadcastId() const { return m_iUniqueBroadcastId; }
     void SetUniqueBroadcastId(unsigned int iUniqueBroadcastId) { m_iUniqueBroadcastId = iUniqueBroadcastId; }
 
+    /*!
+     * @brief Get the parsed search term.
+     * @return The search, or NULL if no search term is set.
+     */
+    const CTextSearch *GetTextSearch() const;
+
   private:
     bool MatchGenre(const CPVREpgInfoTagPtr &tag) const;
     bool MatchDuration(const CPVREpgInfoTagPtr &tag) const;
@@ -124,6 +133,7 @@ namespace PVR
     bool MatchRecordings(const CPVREpgInfoTagPtr &tag) const;
 
     std::string   m_strSearchTerm;            /*!< The term to search for */
+    mutable std::shared_ptr<const CTextSearch> m_textSearch; /*!< m_strSearchTerm parsed on first use */
     bool          m_bIsCaseSensitive;         /*!< Do a case sensitive search */
     bool          m_bSearchInDescription;     /*!< Search for strSearchTerm in the description too */
     int           m_iGenreType;               /*!< The genre type for an entry */
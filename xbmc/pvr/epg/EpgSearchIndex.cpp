@@ -0,0 +1,350 @@
+/*
+ *      Copyright (C) 2017 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "EpgSearchIndex.h"
+
+#include <algorithm>
+#include <cctype>
+#include <iterator>
+
+#include "utils/StringUtils.h"
+#include "utils/TextSearch.h"
+
+using namespace PVR;
+
+namespace
+{
+  bool IsSeparator(char c)
+  {
+    // multi byte UTF-8 sequences are always treated as part of a word
+    return static_cast<unsigned char>(c) < 0x80 && !isalnum(static_cast<unsigned char>(c));
+  }
+
+  void InsertSorted(std::vector<unsigned int> &values, unsigned int value)
+  {
+    auto it = std::lower_bound(values.begin(), values.end(), value);
+    if (it == values.end() || *it != value)
+      values.insert(it, value);
+  }
+
+  void EraseSorted(std::vector<unsigned int> &values, unsigned int value)
+  {
+    auto it = std::lower_bound(values.begin(), values.end(), value);
+    if (it != values.end() && *it == value)
+      values.erase(it);
+  }
+
+  void Intersect(std::vector<unsigned int> &values, const std::vector<unsigned int> &other)
+  {
+    std::vector<unsigned int> result;
+    std::set_intersection(values.begin(), values.end(), other.begin(), other.end(), std::back_inserter(result));
+    values.swap(result);
+  }
+
+  void Unite(std::vector<unsigned int> &values, const std::vector<unsigned int> &other)
+  {
+    std::vector<unsigned int> result;
+    result.reserve(values.size() + other.size());
+    std::set_union(values.begin(), values.end(), other.begin(), other.end(), std::back_inserter(result));
+    values.swap(result);
+  }
+}
+
+void CPVREpgSearchIndex::Tokenize(const std::string &text, std::vector<std::string> &words)
+{
+  std::string lowerText(text);
+  StringUtils::ToLower(lowerText);
+
+  size_t start = 0;
+  while (start < lowerText.size())
+  {
+    while (start < lowerText.size() && IsSeparator(lowerText[start]))
+      ++start;
+
+    size_t end = start;
+    while (end < lowerText.size() && !IsSeparator(lowerText[end]))
+      ++end;
+
+    if (end > start)
+      words.emplace_back(lowerText, start, end - start);
+
+    start = end;
+  }
+}
+
+CPVREpgSearchIndex::Gram CPVREpgSearchIndex::GetGram(const std::string &text, size_t pos, size_t length)
+{
+  // the length is part of the key, so "a" and "a\0\0" are different grams
+  Gram gram = static_cast<Gram>(length) << 24;
+  for (size_t i = 0; i < length; ++i)
+    gram |= static_cast<Gram>(static_cast<unsigned char>(text[pos + i])) << (8 * (2 - i));
+  return gram;
+}
+
+void CPVREpgSearchIndex::GetGrams(const std::string &word, std::vector<Gram> &grams)
+{
+  grams.clear();
+  for (size_t length = 1; length <= 3; ++length)
+  {
+    for (size_t pos = 0; pos + length <= word.size(); ++pos)
+      grams.emplace_back(GetGram(word, pos, length));
+  }
+
+  std::sort(grams.begin(), grams.end());
+  grams.erase(std::unique(grams.begin(), grams.end()), grams.end());
+}
+
+unsigned int CPVREpgSearchIndex::AddWord(const std::string &word)
+{
+  auto it = m_wordIds.find(word);
+  if (it != m_wordIds.end())
+    return it->second;
+
+  unsigned int iWord;
+  if (!m_freeWords.empty())
+  {
+    iWord = m_freeWords.back();
+    m_freeWords.pop_back();
+  }
+  else
+  {
+    iWord = static_cast<unsigned int>(m_words.size());
+    m_words.emplace_back();
+  }
+
+  m_words[iWord].text = word;
+  m_wordIds.insert(std::make_pair(word, iWord));
+
+  std::vector<Gram> grams;
+  GetGrams(word, grams);
+  for (Gram gram : grams)
+    InsertSorted(m_grams[gram], iWord);
+
+  return iWord;
+}
+
+void CPVREpgSearchIndex::RemoveWord(unsigned int iWord)
+{
+  Word &word = m_words[iWord];
+
+  std::vector<Gram> grams;
+  GetGrams(word.text, grams);
+  for (Gram gram : grams)
+  {
+    auto it = m_grams.find(gram);
+    if (it == m_grams.end())
+      continue;
+
+    EraseSorted(it->second, iWord);
+    if (it->second.empty())
+      m_grams.erase(it);
+  }
+
+  m_wordIds.erase(word.text);
+  word.text.clear();
+  std::vector<unsigned int>().swap(word.entries);
+  m_freeWords.emplace_back(iWord);
+}
+
+void CPVREpgSearchIndex::Set(unsigned int iEntry, const std::vector<const std::string*> &texts)
+{
+  std::vector<std::string> tokens;
+  for (const auto &text : texts)
+    Tokenize(*text, tokens);
+
+  std::vector<unsigned int> words;
+  words.reserve(tokens.size());
+  for (const auto &token : tokens)
+    words.emplace_back(AddWord(token));
+
+  std::sort(words.begin(), words.end());
+  words.erase(std::unique(words.begin(), words.end()), words.end());
+
+  // only the words the entry doesn't contain anymore are removed from it
+  auto it = m_entryWords.find(iEntry);
+  if (it != m_entryWords.end())
+  {
+    for (unsigned int iWord : it->second)
+    {
+      if (std::binary_search(words.begin(), words.end(), iWord))
+        continue;
+
+      EraseSorted(m_words[iWord].entries, iEntry);
+      if (m_words[iWord].entries.empty())
+        RemoveWord(iWord);
+    }
+  }
+
+  for (unsigned int iWord : words)
+    InsertSorted(m_words[iWord].entries, iEntry);
+
+  if (words.empty())
+  {
+    if (it != m_entryWords.end())
+      m_entryWords.erase(it);
+  }
+  else if (it != m_entryWords.end())
+    it->second.swap(words);
+  else
+    m_entryWords.insert(std::make_pair(iEntry, std::move(words)));
+}
+
+void CPVREpgSearchIndex::Remove(unsigned int iEntry)
+{
+  auto it = m_entryWords.find(iEntry);
+  if (it == m_entryWords.end())
+    return;
+
+  for (unsigned int iWord : it->second)
+  {
+    EraseSorted(m_words[iWord].entries, iEntry);
+    if (m_words[iWord].entries.empty())
+      RemoveWord(iWord);
+  }
+
+  m_entryWords.erase(it);
+}
+
+void CPVREpgSearchIndex::Clear()
+{
+  m_words.clear();
+  m_freeWords.clear();
+  m_wordIds.clear();
+  m_grams.clear();
+  m_entryWords.clear();
+}
+
+void CPVREpgSearchIndex::GetPartMatches(const std::string &part, std::vector<unsigned int> &entries) const
+{
+  entries.clear();
+
+  std::vector<unsigned int> words;
+  if (part.size() <= 3)
+  {
+    // all words containing a short part are listed under its gram
+    auto it = m_grams.find(GetGram(part, 0, part.size()));
+    if (it == m_grams.end())
+      return;
+
+    words = it->second;
+  }
+  else
+  {
+    // the words containing all trigrams of the part, starting with the rarest one
+    std::vector<const std::vector<unsigned int>*> trigramWords;
+    for (size_t pos = 0; pos + 3 <= part.size(); ++pos)
+    {
+      auto it = m_grams.find(GetGram(part, pos, 3));
+      if (it == m_grams.end())
+        return;
+
+      trigramWords.emplace_back(&it->second);
+    }
+
+    std::sort(trigramWords.begin(), trigramWords.end(),
+              [](const std::vector<unsigned int> *a, const std::vector<unsigned int> *b) { return a->size() < b->size(); });
+
+    words = *trigramWords.front();
+    for (size_t i = 1; i < trigramWords.size() && !words.empty(); ++i)
+      Intersect(words, *trigramWords[i]);
+
+    // the trigrams may occur in a different order, so the remaining words are checked
+    words.erase(std::remove_if(words.begin(), words.end(),
+                               [this, &part](unsigned int iWord) { return m_words[iWord].text.find(part) == std::string::npos; }),
+                words.end());
+  }
+
+  for (unsigned int iWord : words)
+    entries.insert(entries.end(), m_words[iWord].entries.begin(), m_words[iWord].entries.end());
+
+  std::sort(entries.begin(), entries.end());
+  entries.erase(std::unique(entries.begin(), entries.end()), entries.end());
+}
+
+bool CPVREpgSearchIndex::GetTermMatches(const std::string &term, std::vector<unsigned int> &entries) const
+{
+  std::vector<std::string> parts;
+  Tokenize(term, parts);
+  if (parts.empty())
+    return false;
+
+  std::vector<unsigned int> partEntries;
+  for (size_t i = 0; i < parts.size(); ++i)
+  {
+    GetPartMatches(parts[i], partEntries);
+    if (i == 0)
+      entries.swap(partEntries);
+    else
+      Intersect(entries, partEntries);
+
+    if (entries.empty())
+      break;
+  }
+
+  return true;
+}
+
+bool CPVREpgSearchIndex::GetCandidates(const CTextSearch &search, std::vector<unsigned int> &candidates) const
+{
+  // NOT terms can only remove entries, so they are left to CTextSearch
+  std::vector<unsigned int> result;
+  bool bNarrowed = false;
+
+  std::vector<unsigned int> termMatches;
+  if (!search.GetOrTerms().empty())
+  {
+    std::vector<unsigned int> anyMatches;
+    bool bAllMatch = false;
+    for (const auto &term : search.GetOrTerms())
+    {
+      if (!GetTermMatches(term, termMatches))
+      {
+        bAllMatch = true;
+        break;
+      }
+
+      Unite(anyMatches, termMatches);
+    }
+
+    if (!bAllMatch)
+    {
+      result.swap(anyMatches);
+      bNarrowed = true;
+    }
+  }
+
+  for (const auto &term : search.GetAndTerms())
+  {
+    if (GetTermMatches(term, termMatches))
+    {
+      if (bNarrowed)
+        Intersect(result, termMatches);
+      else
+        result.swap(termMatches);
+      bNarrowed = true;
+    }
+  }
+
+  if (!bNarrowed)
+    return false;
+
+  candidates.swap(result);
+  return true;
+}
@@ -0,0 +1,105 @@
+#pragma once
+/*
+ *      Copyright (C) 2017 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <stdint.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class CTextSearch;
+
+namespace PVR
+{
+  /*!
+   * @brief Inverted index of the words in a set of EPG entries, used to narrow down the
+   *        entries that CTextSearch has to look at.
+   *
+   * CTextSearch matches substrings, not words. Every separator free part of a search term must
+   * therefore be contained in some indexed word of a matching text, and the index returns all
+   * entries for which that holds. The result is a superset of the real matches and has to be
+   * checked with CTextSearch::Search afterwards.
+   *
+   * The words containing a part are looked up through an index of all 1, 2 and 3 byte grams of
+   * the vocabulary, so a search only visits the words sharing the grams of its parts. Entries
+   * are added, changed and removed one at a time; words no longer used by any entry are dropped.
+   */
+  class CPVREpgSearchIndex
+  {
+  public:
+    CPVREpgSearchIndex() = default;
+
+    /*!
+     * @brief Index the texts of an entry, replacing the texts it was indexed with before.
+     * @param iEntry The entry. Any number chosen by the caller.
+     * @param texts The texts of this entry.
+     */
+    void Set(unsigned int iEntry, const std::vector<const std::string*> &texts);
+
+    /*!
+     * @brief Remove an entry from the index.
+     * @param iEntry The entry.
+     */
+    void Remove(unsigned int iEntry);
+
+    /*!
+     * @brief Remove all entries from the index.
+     */
+    void Clear();
+
+    /*!
+     * @brief Get the entries that may match the given search.
+     * @param search The search to look up.
+     * @param candidates Set to the ascending entries that may match.
+     * @return False if the search can't be narrowed down with this index, true otherwise.
+     */
+    bool GetCandidates(const CTextSearch &search, std::vector<unsigned int> &candidates) const;
+
+    /*!
+     * @brief Split a text into lower case words.
+     * @param text The text to split.
+     * @param words The words found in the text, in order of occurrence.
+     */
+    static void Tokenize(const std::string &text, std::vector<std::string> &words);
+
+  private:
+    typedef uint32_t Gram;
+
+    struct Word
+    {
+      std::string text;                   /*!< the word, empty for unused ids */
+      std::vector<unsigned int> entries;  /*!< ascending entries containing the word */
+    };
+
+    static Gram GetGram(const std::string &text, size_t pos, size_t length);
+    static void GetGrams(const std::string &word, std::vector<Gram> &grams);
+
+    unsigned int AddWord(const std::string &word);
+    void RemoveWord(unsigned int iWord);
+    void GetPartMatches(const std::string &part, std::vector<unsigned int> &entries) const;
+    bool GetTermMatches(const std::string &term, std::vector<unsigned int> &entries) const;
+
+    std::vector<Word> m_words;                                                 /*!< the vocabulary by word id */
+    std::vector<unsigned int> m_freeWords;                                     /*!< ids of removed words, reused for new ones */
+    std::unordered_map<std::string, unsigned int> m_wordIds;                   /*!< id of each word of the vocabulary */
+    std::unordered_map<Gram, std::vector<unsigned int> > m_grams;              /*!< ascending ids of the words containing each gram */
+    std::unordered_map<unsigned int, std::vector<unsigned int> > m_entryWords; /*!< ids of the distinct words of each entry */
+  };
+}
@@ -0,0 +1,224 @@
+/*
+ *      Copyright (C) 2017 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "pvr/epg/EpgSearchIndex.h"
+#include "utils/TextSearch.h"
+
+#include <algorithm>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+using namespace PVR;
+
+namespace
+{
+  const char *TEXTS[] =
+  {
+    "Tagesschau",
+    "The Late Night Show",
+    "Doctor Who: The Day of the Doctor",
+    "Football - Champions League, Live",
+    "NEWS24 weather",
+    "Éclair au chocolat",
+    "documentary: deep sea",
+    "",
+  };
+
+  const char *SEARCHES[] =
+  {
+    "news", "NEWS", "doc", "o", "tor who", "late night", "ws2", "éclair", "ÉCLAIR", "zzz",
+    "the -news", "doc | show", "footb", "eather", "champions,", "+doctor +day", "who -day", ": the",
+  };
+
+  class CTestIndex
+  {
+  public:
+    void Set(unsigned int iEntry, const std::string &text)
+    {
+      m_texts[iEntry] = text;
+      m_index.Set(iEntry, { &m_texts[iEntry] });
+    }
+
+    void Remove(unsigned int iEntry)
+    {
+      m_texts.erase(iEntry);
+      m_index.Remove(iEntry);
+    }
+
+    /* the entries found with the index, checked with CTextSearch like the epg does */
+    std::vector<unsigned int> Search(const CTextSearch &search) const
+    {
+      std::vector<unsigned int> candidates;
+      if (!m_index.GetCandidates(search, candidates))
+        return SearchLinear(search);
+
+      std::vector<unsigned int> matches;
+      for (unsigned int iEntry : candidates)
+      {
+        auto it = m_texts.find(iEntry);
+        if (it != m_texts.end() && search.Search(it->second))
+          matches.push_back(iEntry);
+      }
+      return matches;
+    }
+
+    /* the old filter, which checked every entry */
+    std::vector<unsigned int> SearchLinear(const CTextSearch &search) const
+    {
+      std::vector<unsigned int> matches;
+      for (const auto &text : m_texts)
+      {
+        if (search.Search(text.second))
+          matches.push_back(text.first);
+      }
+      return matches;
+    }
+
+    /* all candidates must still be indexed */
+    bool HasStaleCandidates(const CTextSearch &search) const
+    {
+      std::vector<unsigned int> candidates;
+      m_index.GetCandidates(search, candidates);
+      return std::any_of(candidates.begin(), candidates.end(), [this](unsigned int iEntry) { return m_texts.count(iEntry) == 0; });
+    }
+
+  private:
+    std::map<unsigned int, std::string> m_texts;
+    CPVREpgSearchIndex m_index;
+  };
+
+  std::vector<unsigned int> Entries(std::initializer_list<unsigned int> entries)
+  {
+    return std::vector<unsigned int>(entries);
+  }
+}
+
+TEST(TestEpgSearchIndex, Tokenize)
+{
+  std::vector<std::string> words;
+  CPVREpgSearchIndex::Tokenize("Doctor Who: The DAY of the Doctor", words);
+  EXPECT_EQ(std::vector<std::string>({ "doctor", "who", "the", "day", "of", "the", "doctor" }), words);
+
+  /* multi byte characters are part of the words */
+  words.clear();
+  CPVREpgSearchIndex::Tokenize("--Éclair,au chocolat!", words);
+  ASSERT_EQ(3u, words.size());
+  EXPECT_EQ("chocolat", words[2]);
+  EXPECT_EQ(std::string::npos, words[0].find('-'));
+
+  words.clear();
+  CPVREpgSearchIndex::Tokenize(" - ", words);
+  EXPECT_TRUE(words.empty());
+}
+
+TEST(TestEpgSearchIndex, AddUpdateRemove)
+{
+  CTestIndex index;
+  index.Set(1, "Tagesschau");
+  index.Set(2, "The Late Night Show");
+  index.Set(3, "Late News");
+
+  CTextSearch late("late");
+  EXPECT_EQ(Entries({ 2, 3 }), index.Search(late));
+
+  /* words the entry doesn't contain anymore are no longer found */
+  index.Set(3, "Early News");
+  EXPECT_EQ(Entries({ 2 }), index.Search(late));
+  EXPECT_EQ(Entries({ 3 }), index.Search(CTextSearch("early")));
+  EXPECT_FALSE(index.HasStaleCandidates(late));
+
+  /* an entry without any words is removed from all words */
+  index.Set(2, "");
+  EXPECT_TRUE(index.Search(late).empty());
+  EXPECT_FALSE(index.HasStaleCandidates(CTextSearch("show")));
+
+  index.Remove(1);
+  EXPECT_TRUE(index.Search(CTextSearch("schau")).empty());
+  EXPECT_FALSE(index.HasStaleCandidates(CTextSearch("a")));
+
+  /* removed words can be added again */
+  index.Set(1, "Tagesschau");
+  EXPECT_EQ(Entries({ 1 }), index.Search(CTextSearch("schau")));
+
+  index.Remove(42);
+  EXPECT_EQ(Entries({ 3 }), index.Search(CTextSearch("news")));
+}
+
+TEST(TestEpgSearchIndex, Clear)
+{
+  CPVREpgSearchIndex index;
+  const std::string text("Tagesschau");
+  index.Set(1, { &text });
+  index.Clear();
+
+  std::vector<unsigned int> candidates;
+  ASSERT_TRUE(index.GetCandidates(CTextSearch("schau"), candidates));
+  EXPECT_TRUE(candidates.empty());
+}
+
+TEST(TestEpgSearchIndex, MatchesLinearFilter)
+{
+  CTestIndex index;
+  for (unsigned int i = 0; i < sizeof(TEXTS) / sizeof(TEXTS[0]); ++i)
+    index.Set(i, TEXTS[i]);
+
+  for (const char *search : SEARCHES)
+  {
+    for (bool bCaseSensitive : { false, true })
+    {
+      CTextSearch textSearch(search, bCaseSensitive);
+      EXPECT_EQ(index.SearchLinear(textSearch), index.Search(textSearch)) << "search '" << search << "', case sensitive " << bCaseSensitive;
+    }
+  }
+
+  EXPECT_EQ(Entries({ 2, 6 }), index.Search(CTextSearch("doc")));
+  EXPECT_EQ(Entries({ 4 }), index.Search(CTextSearch("News")));
+  EXPECT_TRUE(index.Search(CTextSearch("News", true)).empty());
+}
+
+TEST(TestEpgSearchIndex, MatchesLinearFilterWhileChanging)
+{
+  std::mt19937 random(1);
+  const unsigned int textCount = sizeof(TEXTS) / sizeof(TEXTS[0]);
+
+  CTestIndex index;
+  for (int round = 0; round < 2000; ++round)
+  {
+    unsigned int iEntry = random() % 100;
+    if (random() % 4 == 0)
+      index.Remove(iEntry);
+    else
+      index.Set(iEntry, std::string(TEXTS[random() % textCount]) + " " + TEXTS[random() % textCount]);
+
+    if (round % 100 != 0)
+      continue;
+
+    for (const char *search : SEARCHES)
+    {
+      CTextSearch textSearch(search);
+      ASSERT_EQ(index.SearchLinear(textSearch), index.Search(textSearch)) << "search '" << search << "' in round " << round;
+      ASSERT_FALSE(index.HasStaleCandidates(textSearch));
+    }
+  }
+}
@@ -20,6 +20,8 @@
 
 #include "PVRRecordings.h"
 
+#include <algorithm>
+#include <set>
 #include <utility>
 
 #include "FileItem.h"
@@ -28,6 +30,7 @@
 #include "filesystem/Directory.h"
 #include "settings/Settings.h"
 #include "threads/SingleLock.h"
+#include "threads/SystemClock.h"
 #include "utils/StringUtils.h"
 #include "utils/URIUtils.h"
 #include "utils/log.h"
@@ -42,6 +45,18 @@
 
 using namespace PVR;
 
+namespace
+{
+  /* copy a recording transferred by a client. the copy derives path and titles the same way
+     as the known recordings, so that both can be compared */
+  CPVRRecordingPtr CopyTransferredRecording(const CPVRRecordingPtr &tag)
+  {
+    CPVRRecordingPtr newTag(new CPVRRecording);
+    newTag->Update(*tag);
+    return newTag;
+  }
+}
+
 CPVRRecordings::CPVRRecordings(void) :
     m_bIsUpdating(false),
     m_iLastId(0),
@@ -59,12 +74,35 @@ CPVRRecordings::~CPVRRecordings()
     m_database.Close();
 }
 
-void CPVRRecordings::UpdateFromClients(void)
+void CPVRRecordings::UpdateFromClients(CEntryChanges &changes)
 {
+  /* the lock is not held while the clients transfer their recordings, which may take a while */
+  std::vector<int> failedClients;
+  CServiceBroker::GetPVRManager().Clients()->GetRecordings(this, false, failedClients);
+  CServiceBroker::GetPVRManager().Clients()->GetRecordings(this, true, failedClients);
+
   CSingleLock lock(m_critSection);
-  Unload();
-  CServiceBroker::GetPVRManager().Clients()->GetRecordings(this, false);
-  CServiceBroker::GetPVRManager().Clients()->GetRecordings(this, true);
+  std::vector<CPVRRecordingPtr> fetchedRecordings;
+  fetchedRecordings.swap(m_fetchedRecordings);
+
+  std::set<CPVRRecordingUid> fetchedUids;
+  for (const auto &recording : fetchedRecordings)
+  {
+    UpdateEntry(recording, changes);
+    fetchedUids.insert(CPVRRecordingUid(recording->m_iClientId, recording->m_strRecordingId));
+  }
+
+  /* remove the recordings no longer reported by their client */
+  for (PVR_RECORDINGMAP_ITR it = m_recordings.begin(); it != m_recordings.end();)
+  {
+    if (fetchedUids.find(it->first) == fetchedUids.end() &&
+        std::find(failedClients.begin(), failedClients.end(), it->second->m_iClientId) == failedClients.end())
+      RemoveEntry(it++, changes);
+    else
+      ++it;
+  }
+
+  UpdateCounters();
 }
 
 std::string CPVRRecordings::TrimSlashes(const std::string &strOrig) const
@@ -172,14 +210,77 @@ void CPVRRecordings::Update(void)
   lock.Leave();
 
   CLog::Log(LOGDEBUG, "CPVRRecordings - %s - updating recordings", __FUNCTION__);
-  UpdateFromClients();
+  unsigned int iStartTime = XbmcThreads::SystemClockMillis();
+  CEntryChanges changes;
+  UpdateFromClients(changes);
 
   lock.Enter();
   m_bIsUpdating = false;
   lock.Leave();
 
+  CLog::Log(LOGDEBUG, "CPVRRecordings - %s - updated recordings in %u ms: %u added, %u updated, %u removed",
+      __FUNCTION__, XbmcThreads::SystemClockMillis() - iStartTime, changes.iAdded, changes.iUpdated, changes.iRemoved);
+
+  NotifyChanges(changes);
+}
+
+void CPVRRecordings::QueueEntryChange(const CPVRRecordingPtr &tag, PVR_ENTRY_STATE eNewState)
+{
+  const CPVRRecordingPtr newTag(eNewState == PVR_ENTRY_DELETED ? tag : CopyTransferredRecording(tag));
+
+  CSingleLock lock(m_entryChangesLock);
+  m_entryChanges.emplace_back(newTag, eNewState);
+}
+
+void CPVRRecordings::ProcessEntryChanges(void)
+{
+  PVR_RECORDING_CHANGES entryChanges;
+  {
+    CSingleLock lock(m_entryChangesLock);
+    entryChanges.swap(m_entryChanges);
+  }
+
+  if (entryChanges.empty())
+    return;
+
+  CEntryChanges changes;
+  {
+    CSingleLock lock(m_critSection);
+    for (const auto &entryChange : entryChanges)
+    {
+      const CPVRRecordingPtr &tag = entryChange.first;
+      if (entryChange.second == PVR_ENTRY_DELETED)
+      {
+        PVR_RECORDINGMAP_ITR it = m_recordings.find(CPVRRecordingUid(tag->m_iClientId, tag->m_strRecordingId));
+        if (it != m_recordings.end())
+          RemoveEntry(it, changes);
+      }
+      else
+      {
+        UpdateEntry(tag, changes);
+      }
+    }
+
+    UpdateCounters();
+  }
+
+  CLog::Log(LOGDEBUG, "CPVRRecordings - %s - applied %d recording changes: %u added, %u updated, %u removed",
+      __FUNCTION__, static_cast<int>(entryChanges.size()), changes.iAdded, changes.iUpdated, changes.iRemoved);
+
+  NotifyChanges(changes);
+}
+
+void CPVRRecordings::NotifyChanges(const CEntryChanges &changes)
+{
+  if (changes.iAdded == 0 && changes.iUpdated == 0 && changes.iRemoved == 0)
+    return;
+
+  /* the views only need to be rebuilt if the set of items or their paths changed. otherwise the
+     recordings were updated in place and the items pointing to them just need to be redrawn */
+  bool bReset = changes.iAdded > 0 || changes.iRemoved > 0 || changes.bPathChanged;
+
   CServiceBroker::GetPVRManager().SetChanged();
-  CServiceBroker::GetPVRManager().NotifyObservers(ObservableMessageRecordings);
+  CServiceBroker::GetPVRManager().NotifyObservers(bReset ? ObservableMessageRecordingsReset : ObservableMessageRecordings);
   CServiceBroker::GetPVRManager().PublishEvent(RecordingsInvalidated);
 }
 
@@ -430,41 +531,81 @@ CPVRRecordingPtr CPVRRecordings::GetById(int iClientId, const std::string &strRe
 
 void CPVRRecordings::UpdateFromClient(const CPVRRecordingPtr &tag)
 {
+  const CPVRRecordingPtr newTag(CopyTransferredRecording(tag));
+
   CSingleLock lock(m_critSection);
+  m_fetchedRecordings.push_back(newTag);
+}
 
-  if (tag->IsDeleted())
+void CPVRRecordings::UpdateEntry(const CPVRRecordingPtr &tag, CEntryChanges &changes)
+{
+  PVR_RECORDINGMAP_ITR it = m_recordings.find(CPVRRecordingUid(tag->m_iClientId, tag->m_strRecordingId));
+  if (it != m_recordings.end())
   {
-    if (tag->IsRadio())
-      m_bDeletedRadioRecordings = true;
-    else
-      m_bDeletedTVRecordings = true;
-  }
+    const CPVRRecordingPtr existingTag(it->second);
+    tag->m_iRecordingId = existingTag->m_iRecordingId;
 
-  CPVRRecordingPtr newTag = GetById(tag->m_iClientId, tag->m_strRecordingId);
-  if (newTag)
-  {
-    newTag->Update(*tag);
+    /* play count and resume point are only compared if they are managed by the client, the local values are read from the video database */
+    const CPVRClientCapabilities capabilities(CServiceBroker::GetPVRManager().Clients()->GetClientCapabilities(tag->m_iClientId));
+    bool bPlayStateChanged =
+      (capabilities.SupportsRecordingsPlayCount() && existingTag->GetLocalPlayCount() != tag->GetLocalPlayCount()) ||
+      (capabilities.SupportsRecordingsLastPlayedPosition() && existingTag->GetLocalResumePoint().timeInSeconds != tag->GetLocalResumePoint().timeInSeconds);
+
+    if (*existingTag == *tag && !bPlayStateChanged)
+      return;
+
+    if (existingTag->m_strFileNameAndPath != tag->m_strFileNameAndPath)
+      changes.bPathChanged = true;
+
+    existingTag->Update(*tag);
+    ++changes.iUpdated;
   }
   else
   {
-    newTag = CPVRRecordingPtr(new CPVRRecording);
-    newTag->Update(*tag);
-    if (newTag->BroadcastUid() != EPG_TAG_INVALID_UID)
+    if (tag->BroadcastUid() != EPG_TAG_INVALID_UID)
     {
-      const CPVRChannelPtr channel(newTag->Channel());
+      const CPVRChannelPtr channel(tag->Channel());
       if (channel)
       {
-        const CPVREpgInfoTagPtr epgTag = CServiceBroker::GetPVRManager().EpgContainer().GetTagById(channel, newTag->BroadcastUid());
+        const CPVREpgInfoTagPtr epgTag = CServiceBroker::GetPVRManager().EpgContainer().GetTagById(channel, tag->BroadcastUid());
         if (epgTag)
-          epgTag->SetRecording(newTag);
+          epgTag->SetRecording(tag);
       }
     }
-    newTag->m_iRecordingId = ++m_iLastId;
-    m_recordings.insert(std::make_pair(CPVRRecordingUid(newTag->m_iClientId, newTag->m_strRecordingId), newTag));
-    if (newTag->IsRadio())
+    tag->m_iRecordingId = ++m_iLastId;
+    m_recordings.insert(std::make_pair(CPVRRecordingUid(tag->m_iClientId, tag->m_strRecordingId), tag));
+    ++changes.iAdded;
+  }
+}
+
+void CPVRRecordings::RemoveEntry(PVR_RECORDINGMAP_ITR it, CEntryChanges &changes)
+{
+  it->second->OnDelete();
+  m_recordings.erase(it);
+  ++changes.iRemoved;
+}
+
+void CPVRRecordings::UpdateCounters(void)
+{
+  m_bDeletedTVRecordings = false;
+  m_bDeletedRadioRecordings = false;
+  m_iTVRecordings = 0;
+  m_iRadioRecordings = 0;
+
+  for (const auto &recording : m_recordings)
+  {
+    if (recording.second->IsRadio())
+    {
       ++m_iRadioRecordings;
+      if (recording.second->IsDeleted())
+        m_bDeletedRadioRecordings = true;
+    }
     else
+    {
       ++m_iTVRecordings;
+      if (recording.second->IsDeleted())
+        m_bDeletedTVRecordings = true;
+    }
   }
 }
 
@@ -20,8 +20,11 @@
  */
 
 #include <map>
+#include <utility>
+#include <vector>
 
 #include "FileItem.h"
+#include "threads/CriticalSection.h"
 #include "video/VideoDatabase.h"
 
 #include "pvr/PVRTypes.h"
@@ -48,13 +51,33 @@ namespace PVR
      */
     void Unload();
 
+    /**
+     * @brief add a recording transferred by a client while the recordings list is refreshed.
+     * @param tag the recording.
+     */
     void UpdateFromClient(const CPVRRecordingPtr &tag);
 
     /**
      * @brief refresh the recordings list from the clients.
+     *
+     * Recordings that are already known are updated in place and keep their id, recordings
+     * no longer reported by a client are removed. Recordings of clients that failed to
+     * report their recordings are kept.
      */
     void Update(void);
 
+    /**
+     * @brief queue a change of a single recording announced by a client.
+     * @param tag the recording. for PVR_ENTRY_DELETED, only client id and recording id are used.
+     * @param eNewState the new state of the recording.
+     */
+    void QueueEntryChange(const CPVRRecordingPtr &tag, PVR_ENTRY_STATE eNewState);
+
+    /**
+     * @brief apply the recording changes queued since the last call, without refreshing the complete list.
+     */
+    void ProcessEntryChanges(void);
+
     int GetNumTVRecordings() const;
     bool HasDeletedTVRecordings() const;
     int GetNumRadioRecordings() const;
@@ -98,10 +121,25 @@ namespace PVR
     typedef std::map<CPVRRecordingUid, CPVRRecordingPtr> PVR_RECORDINGMAP;
     typedef PVR_RECORDINGMAP::iterator PVR_RECORDINGMAP_ITR;
     typedef PVR_RECORDINGMAP::const_iterator PVR_RECORDINGMAP_CITR;
+    typedef std::vector<std::pair<CPVRRecordingPtr, PVR_ENTRY_STATE>> PVR_RECORDING_CHANGES;
+
+    /**
+     * @brief the changes made by a refresh, deciding which observers to notify.
+     */
+    struct CEntryChanges
+    {
+      unsigned int iAdded = 0;
+      unsigned int iUpdated = 0;
+      unsigned int iRemoved = 0;
+      bool bPathChanged = false; /*!< at least one updated recording moved to another directory or the trash */
+    };
 
     CCriticalSection m_critSection;
     bool m_bIsUpdating;
     PVR_RECORDINGMAP m_recordings;
+    std::vector<CPVRRecordingPtr> m_fetchedRecordings; /*!< recordings transferred by the clients during a refresh */
+    PVR_RECORDING_CHANGES m_entryChanges;                /*!< recording changes announced by the clients */
+    CCriticalSection m_entryChangesLock;
     unsigned int m_iLastId;
     CVideoDatabase m_database;
     bool m_bDeletedTVRecordings;
@@ -109,7 +147,11 @@ namespace PVR
     unsigned int m_iTVRecordings;
     unsigned int m_iRadioRecordings;
 
-    void UpdateFromClients(void);
+    void UpdateFromClients(CEntryChanges &changes);
+    void UpdateEntry(const CPVRRecordingPtr &tag, CEntryChanges &changes);
+    void RemoveEntry(PVR_RECORDINGMAP_ITR it, CEntryChanges &changes);
+    void UpdateCounters(void);
+    void NotifyChanges(const CEntryChanges &changes);
     std::string TrimSlashes(const std::string &strOrig) const;
     bool IsDirectoryMember(const std::string &strDirectory, const std::string &strEntryDirectory, bool bGrouped) const;
     void GetSubDirectories(const CPVRRecordingsPath &recParentPath, CFileItemList *results);
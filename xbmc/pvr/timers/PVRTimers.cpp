@@ -20,7 +20,9 @@
 
 #include "PVRTimers.h"
 
+#include <algorithm>
 #include <cstdlib>
+#include <set>
 #include <utility>
 
 #include "FileItem.h"
@@ -28,6 +30,7 @@
 #include "guilib/LocalizeStrings.h"
 #include "settings/Settings.h"
 #include "threads/SingleLock.h"
+#include "threads/SystemClock.h"
 #include "utils/StringUtils.h"
 #include "utils/URIUtils.h"
 #include "utils/log.h"
@@ -57,16 +60,10 @@ bool CPVRTimersContainer::UpdateFromClient(const CPVRTimerInfoTagPtr &timer)
 CPVRTimerInfoTagPtr CPVRTimersContainer::GetByClient(int iClientId, unsigned int iClientTimerId) const
 {
   CSingleLock lock(m_critSection);
-  for (const auto startDates : m_tags)
-  {
-    for (const auto timer : startDates.second)
-    {
-      if (timer->m_iClientId == iClientId && timer->m_iClientIndex == iClientTimerId)
-      {
-        return timer;
-      }
-    }
-  }
+
+  MapTagsByClient::const_iterator it = m_tagsByClient.find(TimerClientKey(iClientId, iClientTimerId));
+  if (it != m_tagsByClient.end())
+    return it->second;
 
   return CPVRTimerInfoTagPtr();
 }
@@ -83,6 +80,8 @@ void CPVRTimersContainer::InsertTimer(const CPVRTimerInfoTagPtr &newTimer)
   {
     it->second.emplace_back(newTimer);
   }
+
+  m_tagsByClient[TimerClientKey(newTimer->m_iClientId, newTimer->m_iClientIndex)] = newTimer;
 }
 
 CPVRTimers::CPVRTimers(void)
@@ -122,6 +121,7 @@ void CPVRTimers::Unload()
   // remove all tags
   CSingleLock lock(m_critSection);
   m_tags.clear();
+  m_tagsByClient.clear();
 }
 
 bool CPVRTimers::Update(void)
@@ -134,10 +134,62 @@ bool CPVRTimers::Update(void)
   }
 
   CLog::Log(LOGDEBUG, "CPVRTimers - %s - updating timers", __FUNCTION__);
+  unsigned int iStartTime = XbmcThreads::SystemClockMillis();
   CPVRTimersContainer newTimerList;
   std::vector<int> failedClients;
   CServiceBroker::GetPVRManager().Clients()->GetTimers(&newTimerList, failedClients);
-  return UpdateEntries(newTimerList, failedClients);
+
+  bool bChanged = UpdateEntries(newTimerList, [&newTimerList, &failedClients](const CPVRTimerInfoTagPtr &timer) {
+    /* timers of clients that failed to report their timers are kept */
+    return !newTimerList.GetByClient(timer->m_iClientId, timer->m_iClientIndex) &&
+           std::find(failedClients.begin(), failedClients.end(), timer->m_iClientId) == failedClients.end();
+  });
+
+  {
+    CSingleLock lock(m_critSection);
+    m_bIsUpdating = false;
+  }
+
+  CLog::Log(LOGDEBUG, "CPVRTimers - %s - updated timers in %u ms", __FUNCTION__, XbmcThreads::SystemClockMillis() - iStartTime);
+  return bChanged;
+}
+
+void CPVRTimers::QueueEntryChange(const CPVRTimerInfoTagPtr &timer, PVR_ENTRY_STATE eNewState)
+{
+  CSingleLock lock(m_entryChangesLock);
+  m_entryChanges.emplace_back(timer, eNewState);
+}
+
+bool CPVRTimers::ProcessEntryChanges(void)
+{
+  std::vector<std::pair<CPVRTimerInfoTagPtr, PVR_ENTRY_STATE>> entryChanges;
+  {
+    CSingleLock lock(m_entryChangesLock);
+    entryChanges.swap(m_entryChanges);
+  }
+
+  if (entryChanges.empty())
+    return false;
+
+  /* only the last change announced for a timer counts */
+  std::map<TimerClientKey, std::pair<CPVRTimerInfoTagPtr, PVR_ENTRY_STATE>> lastChanges;
+  for (const auto &entryChange : entryChanges)
+    lastChanges[TimerClientKey(entryChange.first->m_iClientId, entryChange.first->m_iClientIndex)] = entryChange;
+
+  CPVRTimersContainer updatedTimers;
+  std::set<TimerClientKey> deletedTimers;
+  for (const auto &lastChange : lastChanges)
+  {
+    if (lastChange.second.second == PVR_ENTRY_DELETED)
+      deletedTimers.insert(lastChange.first);
+    else
+      updatedTimers.UpdateFromClient(lastChange.second.first);
+  }
+
+  CLog::Log(LOGDEBUG, "CPVRTimers - %s - applying %d timer changes", __FUNCTION__, static_cast<int>(entryChanges.size()));
+  return UpdateEntries(updatedTimers, [&deletedTimers](const CPVRTimerInfoTagPtr &timer) {
+    return deletedTimers.find(TimerClientKey(timer->m_iClientId, timer->m_iClientIndex)) != deletedTimers.end();
+  });
 }
 
 bool CPVRTimers::IsRecording(void) const
@@ -188,7 +240,7 @@ bool CPVRTimers::ClearEpgTagTimer(const CPVRTimerInfoTagPtr &timer)
   return true;
 }
 
-bool CPVRTimers::UpdateEntries(const CPVRTimersContainer &timers, const std::vector<int> &failedClients)
+bool CPVRTimers::UpdateEntries(const CPVRTimersContainer &timers, const std::function<bool(const CPVRTimerInfoTagPtr &timer)> &isRemoved)
 {
   bool bChanged(false);
   bool bAddedOrDeleted(false);
@@ -257,25 +309,8 @@ bool CPVRTimers::UpdateEntries(const CPVRTimersContainer &timers, const std::vec
     for (std::vector<CPVRTimerInfoTagPtr>::iterator it2 = it->second.begin(); it2 != it->second.end();)
     {
       CPVRTimerInfoTagPtr timer(*it2);
-      if (!timers.GetByClient(timer->m_iClientId, timer->m_iClientIndex))
+      if (isRemoved(timer))
       {
-        /* timer was not found */
-        bool bIgnoreTimer(false);
-        for (const auto &failedClient : failedClients)
-        {
-          if (failedClient == timer->m_iClientId)
-          {
-            bIgnoreTimer = true;
-            break;
-          }
-        }
-
-        if (bIgnoreTimer)
-        {
-          ++it2;
-          continue;
-        }
-
         CLog::Log(LOGDEBUG,"PVRTimers - %s - deleted timer %d on client %d",
             __FUNCTION__, timer->m_iClientIndex, timer->m_iClientId);
 
@@ -283,6 +318,7 @@ bool CPVRTimers::UpdateEntries(const CPVRTimersContainer &timers, const std::vec
 
         ClearEpgTagTimer(timer);
 
+        m_tagsByClient.erase(TimerClientKey(timer->m_iClientId, timer->m_iClientIndex));
         it2 = it->second.erase(it2);
 
         bChanged = true;
@@ -338,7 +374,6 @@ bool CPVRTimers::UpdateEntries(const CPVRTimersContainer &timers, const std::vec
     }
   }
 
-  m_bIsUpdating = false;
   if (bChanged)
   {
     UpdateChannels();
@@ -19,8 +19,10 @@
  *
  */
 
+#include <functional>
 #include <map>
 #include <memory>
+#include <utility>
 #include <vector>
 
 #include "XBDateTime.h"
@@ -70,11 +72,15 @@ namespace PVR
     const MapTags& GetTags() const { return m_tags; }
 
   protected:
+    typedef std::pair<int, unsigned int> TimerClientKey; /*!< client id and client timer id */
+    typedef std::map<TimerClientKey, CPVRTimerInfoTagPtr> MapTagsByClient;
+
     void InsertTimer(const CPVRTimerInfoTagPtr &newTimer);
 
     CCriticalSection m_critSection;
     unsigned int m_iLastId;
     MapTags m_tags;
+    MapTagsByClient m_tagsByClient; /*!< index of m_tags, to look up timers reported by the clients */
   };
 
   class CPVRTimers : public CPVRTimersContainer, public Observer
@@ -99,6 +105,19 @@ namespace PVR
      */
     bool Update(void);
 
+    /*!
+     * @brief Queue a change of a single timer announced by a client.
+     * @param timer The timer. For PVR_ENTRY_DELETED, only client id and client index are used.
+     * @param eNewState The new state of the timer.
+     */
+    void QueueEntryChange(const CPVRTimerInfoTagPtr &timer, PVR_ENTRY_STATE eNewState);
+
+    /*!
+     * @brief Apply the timer changes queued since the last call, without refreshing the complete list.
+     * @return True if any timer changed, false otherwise.
+     */
+    bool ProcessEntryChanges(void);
+
     /*!
      * @return The tv or radio timer that will be active next (state scheduled), or an empty fileitemptr if none.
      */
@@ -291,7 +310,13 @@ namespace PVR
     CPVRTimerInfoTagPtr GetById(unsigned int iTimerId) const;
 
   private:
-    bool UpdateEntries(const CPVRTimersContainer &timers, const std::vector<int> &failedClients);
+    /*!
+     * @brief Add or update the given timers and remove the timers matched by isRemoved.
+     * @param timers The new or updated timers.
+     * @param isRemoved Returns true for a timer of this container that is to be removed.
+     * @return True if any timer changed, false otherwise.
+     */
+    bool UpdateEntries(const CPVRTimersContainer &timers, const std::function<bool(const CPVRTimerInfoTagPtr &timer)> &isRemoved);
     bool GetRootDirectory(const CPVRTimersPath &path, CFileItemList &items) const;
     bool GetSubDirectory(const CPVRTimersPath &path, CFileItemList &items) const;
     bool SetEpgTagTimer(const CPVRTimerInfoTagPtr &timer);
@@ -313,6 +338,8 @@ namespace PVR
 
     bool m_bIsUpdating;
     CPVRSettings m_settings;
+    std::vector<std::pair<CPVRTimerInfoTagPtr, PVR_ENTRY_STATE>> m_entryChanges; /*!< timer changes announced by the clients */
+    CCriticalSection m_entryChangesLock;
   };
 
   class CPVRTimersPath
@@ -20,7 +20,9 @@
 
 #include "GUIEPGGridContainerModel.h"
 
+#include <algorithm>
 #include <cmath>
+#include <iterator>
 
 #include "FileItem.h"
 #include "ServiceBroker.h"
@@ -50,14 +52,13 @@ void CGUIEPGGridContainerModel::SetInvalid()
 
 void CGUIEPGGridContainerModel::Reset()
 {
-  for (auto &channel : m_gridIndex)
+  for (const auto &row : m_gridIndex)
   {
-    for (const auto &block : channel)
+    for (const auto &gridItem : row.items)
     {
-      if (block.item)
-        block.item->ClearProperties();
+      if (gridItem.item)
+        gridItem.item->ClearProperties();
     }
-    channel.clear();
   }
   m_gridIndex.clear();
 
@@ -157,7 +158,6 @@ void CGUIEPGGridContainerModel::Refresh(const std::unique_ptr<CFileItemList> &it
 
   ////////////////////////////////////////////////////////////////////////
   // Create epg grid
-  const CDateTimeSpan blockDuration(0, 0, MINSPERBLOCK, 0);
   const CDateTimeSpan gridDuration(m_gridEnd - m_gridStart);
   m_blocks = (gridDuration.GetDays() * 24 * 60 + gridDuration.GetHours() * 60 + gridDuration.GetMinutes()) / MINSPERBLOCK;
   if (m_blocks >= MAXBLOCKS)
@@ -165,118 +165,147 @@ void CGUIEPGGridContainerModel::Refresh(const std::unique_ptr<CFileItemList> &it
   else if (m_blocks < iBlocksPerPage)
     m_blocks = iBlocksPerPage;
 
-  m_gridIndex.reserve(m_channelItems.size());
-  const std::vector<GridItem> blocks(m_blocks);
+  // rows are laid out on demand, see GetGridRow()
+  m_fBlockSize = fBlockSize;
+  m_gridIndex.resize(m_channelItems.size());
+}
+
+int CGUIEPGGridContainerModel::GetFirstBlockFrom(const CDateTime &datetime) const
+{
+  if (datetime <= m_gridStart)
+    return 0;
+
+  // first block whose start time is not before datetime
+  const int blockSeconds = MINSPERBLOCK * 60;
+  const int seconds = (datetime - m_gridStart).GetSecondsTotal();
+  return (seconds + blockSeconds - 1) / blockSeconds;
+}
+
+void CGUIEPGGridContainerModel::BuildGridRow(int iChannel, GridRow &row) const
+{
+  row.valid = true;
+
+  // A block shows the programme running at the block's start time, or a gap
+  // tag if there is none. Each programme therefore covers a run of blocks that
+  // can be computed from its start and end time without visiting every block.
+  unsigned long progIdx = m_epgItemsPtr[iChannel].start;
+  const unsigned long lastIdx = m_epgItemsPtr[iChannel].stop;
+  const int iEpgId = m_programmeItems[progIdx]->GetEPGInfoTag()->EpgID();
 
-  for (size_t channel = 0; channel < m_channelItems.size(); ++channel)
+  int block = 0;
+  while (block < m_blocks)
   {
-    m_gridIndex.emplace_back(blocks);
-
-    CDateTime gridCursor(m_gridStart); //reset cursor for new channel
-    unsigned long progIdx = m_epgItemsPtr[channel].start;
-    unsigned long lastIdx = m_epgItemsPtr[channel].stop;
-    int iEpgId            = m_programmeItems[progIdx]->GetEPGInfoTag()->EpgID();
-    int itemSize          = 1; // size of the programme in blocks
-    int savedBlock        = 0;
+    const CDateTime gridCursor(m_gridStart + CDateTimeSpan(0, 0, block * MINSPERBLOCK, 0));
     CFileItemPtr item;
-    CPVREpgInfoTagPtr tag;
+    int iLastBlock = m_blocks - 1;
 
-    for (int block = 0; block < m_blocks; ++block)
+    while (progIdx <= lastIdx)
     {
-      while (progIdx <= lastIdx)
+      const CPVREpgInfoTagPtr tag(m_programmeItems[progIdx]->GetEPGInfoTag());
+
+      if (tag->EpgID() != iEpgId || m_gridEnd <= tag->StartAsUTC())
+        break;
+
+      if (gridCursor < tag->StartAsUTC())
+      {
+        // gap until the next programme starts
+        iLastBlock = std::min(GetFirstBlockFrom(tag->StartAsUTC()), m_blocks) - 1;
+        break;
+      }
+
+      if (gridCursor < tag->EndAsUTC())
       {
         item = m_programmeItems[progIdx];
-        tag = item->GetEPGInfoTag();
+        iLastBlock = std::min(GetFirstBlockFrom(tag->EndAsUTC()), m_blocks) - 1;
+        break;
+      }
 
-        // Note: Start block of an event is start-time-based calculated block + 1,
-        //       unless start times matches exactly the begin of a block.
+      progIdx++;
+    }
 
-        if (tag->EpgID() != iEpgId || gridCursor < tag->StartAsUTC() || m_gridEnd <= tag->StartAsUTC())
-          break;
+    if (!item && !row.items.empty() && row.items.back().progIndex == INVALID_INDEX)
+    {
+      // extend the previous gap, programmes too short to cover a block start are not shown
+      GridItem &gap = row.items.back();
+      gap.originWidth = gap.width = (iLastBlock - row.startBlocks.back() + 1) * m_fBlockSize;
+      block = iLastBlock + 1;
+      continue;
+    }
 
-        if (gridCursor < tag->EndAsUTC())
-        {
-          m_gridIndex[channel][block].item = item;
-          m_gridIndex[channel][block].progIndex = progIdx;
-          break;
-        }
+    GridItem gridItem;
+    if (item)
+    {
+      item->SetProperty("GenreType", item->GetEPGInfoTag()->GenreType());
+      gridItem.item = item;
+      gridItem.progIndex = progIdx;
+    }
+    else
+    {
+      CPVREpgInfoTagPtr gapTag(CPVREpgInfoTag::CreateDefaultTag());
+      gapTag->SetChannel(m_channelItems[iChannel]->GetPVRChannelInfoTag());
+      gridItem.item.reset(new CFileItem(gapTag));
+    }
+    gridItem.originWidth = gridItem.width = (iLastBlock - block + 1) * m_fBlockSize;
 
-        progIdx++;
-      }
+    row.startBlocks.emplace_back(block);
+    row.items.emplace_back(gridItem);
+    block = iLastBlock + 1;
+  }
+}
 
-      gridCursor += blockDuration;
+CGUIEPGGridContainerModel::GridRow &CGUIEPGGridContainerModel::GetGridRow(int iChannel) const
+{
+  GridRow &row = m_gridIndex[iChannel];
+  if (!row.valid)
+    BuildGridRow(iChannel, row);
 
-      if (block == 0)
-        continue;
+  return row;
+}
 
-      const CFileItemPtr prevItem(m_gridIndex[channel][block - 1].item);
-      const CFileItemPtr currItem(m_gridIndex[channel][block].item);
+GridItem *CGUIEPGGridContainerModel::FindGridItem(int iChannel, int iBlock) const
+{
+  GridRow &row = GetGridRow(iChannel);
 
-      if (block == m_blocks - 1 || prevItem != currItem)
-      {
-        // special handling for last block.
-        int blockDelta = -1;
-        int sizeDelta = 0;
-        if (block == m_blocks - 1 && prevItem == currItem)
-        {
-          itemSize++;
-          blockDelta = 0;
-          sizeDelta = 1;
-        }
-
-        if (prevItem)
-        {
-          m_gridIndex[channel][savedBlock].item->SetProperty("GenreType", prevItem->GetEPGInfoTag()->GenreType());
-        }
-        else
-        {
-          CPVREpgInfoTagPtr gapTag(CPVREpgInfoTag::CreateDefaultTag());
-          gapTag->SetChannel(m_channelItems[channel]->GetPVRChannelInfoTag());
-          CFileItemPtr gapItem(new CFileItem(gapTag));
-          for (int i = block + blockDelta; i >= block - itemSize + sizeDelta; --i)
-          {
-            m_gridIndex[channel][i].item = gapItem;
-          }
-        }
-
-        float fItemWidth = itemSize * fBlockSize;
-        m_gridIndex[channel][savedBlock].originWidth = fItemWidth;
-        m_gridIndex[channel][savedBlock].width = fItemWidth;
-
-        itemSize = 1;
-        savedBlock = block;
-
-        // special handling for last block.
-        if (block == m_blocks - 1 && prevItem != currItem)
-        {
-          if (currItem)
-          {
-            m_gridIndex[channel][savedBlock].item->SetProperty("GenreType", currItem->GetEPGInfoTag()->GenreType());
-          }
-          else
-          {
-            CPVREpgInfoTagPtr gapTag(CPVREpgInfoTag::CreateDefaultTag());
-            gapTag->SetChannel(m_channelItems[channel]->GetPVRChannelInfoTag());
-            CFileItemPtr gapItem(new CFileItem(gapTag));
-            m_gridIndex[channel][block].item = gapItem;
-          }
-
-          m_gridIndex[channel][savedBlock].originWidth = fBlockSize; // size always 1 block here
-          m_gridIndex[channel][savedBlock].width = fBlockSize;
-        }
-      }
-      else
-      {
-        itemSize++;
-      }
-    }
-  }
+  const auto it = std::upper_bound(row.startBlocks.begin(), row.startBlocks.end(), iBlock);
+  if (it == row.startBlocks.begin())
+    return nullptr;
+
+  return &row.items[std::distance(row.startBlocks.begin(), it) - 1];
 }
 
-void CGUIEPGGridContainerModel::FindChannelAndBlockIndex(int channelUid, unsigned int broadcastUid, int eventOffset, int &newChannelIndex, int &newBlockIndex) const
+CFileItemPtr CGUIEPGGridContainerModel::GetGridItem(int iChannel, int iBlock) const
 {
-  const CDateTimeSpan blockDuration(0, 0, MINSPERBLOCK, 0);
+  const GridItem *gridItem = FindGridItem(iChannel, iBlock);
+  return gridItem ? gridItem->item : CFileItemPtr();
+}
 
+float CGUIEPGGridContainerModel::GetGridItemWidth(int iChannel, int iBlock) const
+{
+  const GridItem *gridItem = FindGridItem(iChannel, iBlock);
+  return gridItem ? gridItem->width : 0.0f;
+}
+
+float CGUIEPGGridContainerModel::GetGridItemOriginWidth(int iChannel, int iBlock) const
+{
+  const GridItem *gridItem = FindGridItem(iChannel, iBlock);
+  return gridItem ? gridItem->originWidth : 0.0f;
+}
+
+int CGUIEPGGridContainerModel::GetGridItemIndex(int iChannel, int iBlock) const
+{
+  const GridItem *gridItem = FindGridItem(iChannel, iBlock);
+  return gridItem ? gridItem->progIndex : INVALID_INDEX;
+}
+
+void CGUIEPGGridContainerModel::SetGridItemWidth(int iChannel, int iBlock, float fWidth)
+{
+  GridItem *gridItem = FindGridItem(iChannel, iBlock);
+  if (gridItem)
+    gridItem->width = fWidth;
+}
+
+void CGUIEPGGridContainerModel::FindChannelAndBlockIndex(int channelUid, unsigned int broadcastUid, int eventOffset, int &newChannelIndex, int &newBlockIndex) const
+{
   newChannelIndex = INVALID_INDEX;
   newBlockIndex = INVALID_INDEX;
 
@@ -292,35 +321,18 @@ void CGUIEPGGridContainerModel::FindChannelAndBlockIndex(int channelUid, unsigne
     iCurrentChannel++;
   }
 
-  if (newChannelIndex != INVALID_INDEX)
+  if (newChannelIndex != INVALID_INDEX && broadcastUid > 0)
   {
     // find the block
-    CDateTime gridCursor(m_gridStart); //reset cursor for new channel
-    unsigned long progIdx = m_epgItemsPtr[newChannelIndex].start;
-    unsigned long lastIdx = m_epgItemsPtr[newChannelIndex].stop;
-    int iEpgId = m_programmeItems[progIdx]->GetEPGInfoTag()->EpgID();
-    CPVREpgInfoTagPtr tag;
-    for (int block = 0; block < m_blocks; ++block)
+    const GridRow &row = GetGridRow(newChannelIndex);
+    for (size_t i = 0; i < row.items.size(); ++i)
     {
-      while (progIdx <= lastIdx)
+      if (row.items[i].progIndex != INVALID_INDEX &&
+          row.items[i].item->GetEPGInfoTag()->UniqueBroadcastID() == broadcastUid)
       {
-        tag = m_programmeItems[progIdx]->GetEPGInfoTag();
-
-        if (tag->EpgID() != iEpgId || gridCursor < tag->StartAsUTC() || m_gridEnd <= tag->StartAsUTC())
-          break; // next block
-
-        if (gridCursor < tag->EndAsUTC())
-        {
-          if (broadcastUid > 0 && tag->UniqueBroadcastID() == broadcastUid)
-          {
-            newBlockIndex = block + eventOffset;
-            return; // done.
-          }
-          break; // next block
-        }
-        progIdx++;
+        newBlockIndex = row.startBlocks[i] + eventOffset;
+        return; // done.
       }
-      gridCursor += blockDuration;
     }
   }
 }
@@ -357,39 +369,16 @@ void CGUIEPGGridContainerModel::FreeProgrammeMemory(int channel, int keepStart,
 {
   if (keepStart < keepEnd)
   {
-    // remove before keepStart and after keepEnd
-    if (keepStart > 0 && keepStart < m_blocks)
+    // remove items that lie completely before keepStart or after keepEnd
+    const GridRow &row = GetGridRow(channel);
+    for (size_t i = 0; i < row.items.size(); ++i)
     {
-      // if item exist and block is not part of visible item
-      CGUIListItemPtr last(m_gridIndex[channel][keepStart].item);
-      for (int i = keepStart - 1; i > 0; --i)
-      {
-        if (m_gridIndex[channel][i].item && m_gridIndex[channel][i].item != last)
-        {
-          m_gridIndex[channel][i].item->FreeMemory();
-          // FreeMemory() is smart enough to not cause any problems when called multiple times on same item
-          // but we can make use of condition needed to not call FreeMemory() on item that is partially visible
-          // to avoid calling FreeMemory() multiple times on item that occupy few blocks in a row
-          last = m_gridIndex[channel][i].item;
-        }
-      }
-    }
+      const int iFirstBlock = row.startBlocks[i];
+      const int iLastBlock = (i + 1 < row.items.size()) ? row.startBlocks[i + 1] - 1 : m_blocks - 1;
 
-    if (keepEnd > 0 && keepEnd < m_blocks)
-    {
-      CGUIListItemPtr last(m_gridIndex[channel][keepEnd].item);
-      for (int i = keepEnd + 1; i < m_blocks; ++i)
-      {
-        // if item exist and block is not part of visible item
-        if (m_gridIndex[channel][i].item && m_gridIndex[channel][i].item != last)
-        {
-          m_gridIndex[channel][i].item->FreeMemory();
-          // FreeMemory() is smart enough to not cause any problems when called multiple times on same item
-          // but we can make use of condition needed to not call FreeMemory() on item that is partially visible
-          // to avoid calling FreeMemory() multiple times on item that occupy few blocks in a row
-          last = m_gridIndex[channel][i].item;
-        }
-      }
+      if ((keepStart > 0 && keepStart < m_blocks && iLastBlock < keepStart) ||
+          (keepEnd > 0 && keepEnd < m_blocks && iFirstBlock > keepEnd))
+        row.items[i].item->FreeMemory();
     }
   }
 }
@@ -49,7 +49,7 @@ namespace PVR
     static const int MINSPERBLOCK = 5; // minutes
     static const int MAXBLOCKS = 33 * 24 * 60 / MINSPERBLOCK; //! 33 days of 5 minute blocks (31 days for upcoming data + 1 day for past data + 1 day for fillers)
 
-    CGUIEPGGridContainerModel() : m_blocks(0) {}
+    CGUIEPGGridContainerModel() : m_blocks(0), m_fBlockSize(0.0f) {}
     virtual ~CGUIEPGGridContainerModel() { Reset(); }
 
     void Refresh(const std::unique_ptr<CFileItemList> &items, const CDateTime &gridStart, const CDateTime &gridEnd, int iRulerUnit, int iBlocksPerPage, float fBlockSize);
@@ -75,12 +75,12 @@ namespace PVR
 
     int GetBlockCount() const { return m_blocks; }
     bool HasGridItems() const { return !m_gridIndex.empty(); }
-    GridItem *GetGridItemPtr(int iChannel, int iBlock) { return &m_gridIndex[iChannel][iBlock]; }
-    CFileItemPtr GetGridItem(int iChannel, int iBlock) const { return m_gridIndex[iChannel][iBlock].item; }
-    float GetGridItemWidth(int iChannel, int iBlock) const { return m_gridIndex[iChannel][iBlock].width; }
-    float GetGridItemOriginWidth(int iChannel, int iBlock) const { return m_gridIndex[iChannel][iBlock].originWidth; }
-    int GetGridItemIndex(int iChannel, int iBlock) const { return m_gridIndex[iChannel][iBlock].progIndex; }
-    void SetGridItemWidth(int iChannel, int iBlock, float fWidth) { m_gridIndex[iChannel][iBlock].width = fWidth; }
+    GridItem *GetGridItemPtr(int iChannel, int iBlock) { return FindGridItem(iChannel, iBlock); }
+    CFileItemPtr GetGridItem(int iChannel, int iBlock) const;
+    float GetGridItemWidth(int iChannel, int iBlock) const;
+    float GetGridItemOriginWidth(int iChannel, int iBlock) const;
+    int GetGridItemIndex(int iChannel, int iBlock) const;
+    void SetGridItemWidth(int iChannel, int iBlock, float fWidth);
 
     bool IsZeroGridDuration() const { return (m_gridEnd - m_gridStart) == CDateTimeSpan(0, 0, 0, 0); }
     const CDateTime &GetGridStart() const { return m_gridStart; }
@@ -95,9 +95,26 @@ namespace PVR
     int GetLastEventBlock(const CPVREpgInfoTagPtr event) const;
 
   private:
+    /*!
+     \brief The programmes of one channel, stored as one GridItem per run of
+     blocks instead of one per block. Rows are built on first access, so only
+     channels that are actually shown ever get laid out.
+     */
+    struct GridRow
+    {
+      bool valid = false;
+      std::vector<int> startBlocks; //! first block of the item at the same index
+      std::vector<GridItem> items;
+    };
+
     void FreeItemsMemory();
     void Reset();
 
+    GridItem *FindGridItem(int iChannel, int iBlock) const;
+    GridRow &GetGridRow(int iChannel) const;
+    void BuildGridRow(int iChannel, GridRow &row) const;
+    int GetFirstBlockFrom(const CDateTime &datetime) const;
+
     struct ItemsPtr
     {
       long start;
@@ -111,8 +128,9 @@ namespace PVR
     std::vector<CFileItemPtr> m_channelItems;
     std::vector<CFileItemPtr> m_rulerItems;
     std::vector<ItemsPtr> m_epgItemsPtr;
-    std::vector<std::vector<GridItem> > m_gridIndex;
+    mutable std::vector<GridRow> m_gridIndex;
 
     int m_blocks;
+    float m_fBlockSize;
   };
 }
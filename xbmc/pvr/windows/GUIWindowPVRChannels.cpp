@@ -195,6 +195,7 @@ bool CGUIWindowPVRChannelsBase::OnMessage(CGUIMessage& message)
         case ObservableMessageEpgActiveItem:
         case ObservableMessageCurrentItem:
         case ObservableMessageRecordings:
+        case ObservableMessageRecordingsReset:
         {
           SetInvalid();
           break;
@@ -308,11 +308,12 @@ bool CGUIWindowPVRRecordingsBase::OnMessage(CGUIMessage &message)
         case ObservableMessageEpgContainer:
         case ObservableMessageEpgActiveItem:
         case ObservableMessageCurrentItem:
+        case ObservableMessageRecordings:
         {
           SetInvalid();
           break;
         }
-        case ObservableMessageRecordings:
+        case ObservableMessageRecordingsReset:
         case ObservableMessageTimersReset:
         {
           Refresh(true);
@@ -41,6 +41,7 @@
 #include "utils/log.h"
 #include "utils/StringUtils.h"
 #include "utils/SystemInfo.h"
+#include "utils/Trace.h"
 #include "utils/URIUtils.h"
 #include "utils/Variant.h"
 #include "utils/XMLUtils.h"
@@ -82,6 +83,11 @@ void CAdvancedSettings::OnSettingsLoaded()
 
   m_extraLogEnabled = CServiceBroker::GetSettings().GetBool(CSettings::SETTING_DEBUG_EXTRALOGGING);
   setExtraLogLevel(CServiceBroker::GetSettings().GetList(CSettings::SETTING_DEBUG_SETEXTRALOGLEVEL));
+
+  // setup binary tracing
+  if (m_traceComponents != 0)
+    CTrace::Init(CSpecialProtocol::TranslatePath("special://logpath"), static_cast<size_t>(m_traceSize) * 1024 * 1024);
+  CTrace::SetComponents(m_traceComponents);
 }
 
 void CAdvancedSettings::OnSettingsUnloaded()
@@ -353,6 +359,9 @@ void CAdvancedSettings::Initialize()
   m_bPVRChannelIconsAutoScan       = true;
   m_bPVRAutoScanIconsUserSet       = false;
   m_iPVRNumericChannelSwitchTimeout = 2000;
+  m_iPVRTimeshiftMemorySize        = 0;
+  m_iPVRTimeshiftDiskSize          = 512;
+  m_iPVRZapAdjacentChannels        = 0;
 
   m_cacheMemSize = 1024 * 1024 * 20;
   m_cacheBufferMode = CACHE_BUFFER_MODE_INTERNET; // Default (buffer all internet streams/filesystems)
@@ -365,6 +374,9 @@ void CAdvancedSettings::Initialize()
   m_jsonOutputCompact = true;
   m_jsonTcpPort = 9090;
 
+  m_webserverResponseCacheSize = 16;
+  m_webserverTransformedImagesSize = 256;
+
   m_enableMultimediaKeys = false;
 
   m_canWindowed = true;
@@ -398,6 +410,8 @@ void CAdvancedSettings::Initialize()
   m_logLevelHint = m_logLevel = LOG_LEVEL_NORMAL;
   m_extraLogEnabled = false;
   m_extraLogLevels = 0;
+  m_traceComponents = 0;
+  m_traceSize = 16;
 
   m_userAgent = g_sysinfo.GetUserAgent();
 
@@ -802,6 +816,13 @@ void CAdvancedSettings::ParseSettingsFile(const std::string &file)
     XMLUtils::GetUInt(pElement, "tcpport", m_jsonTcpPort);
   }
 
+  pElement = pRootElement->FirstChildElement("webserver");
+  if (pElement)
+  {
+    XMLUtils::GetUInt(pElement, "responsecachesize", m_webserverResponseCacheSize, 0, 1024);
+    XMLUtils::GetUInt(pElement, "transformedimagessize", m_webserverTransformedImagesSize, 1, 65536);
+  }
+
   pElement = pRootElement->FirstChildElement("samba");
   if (pElement)
   {
@@ -1052,6 +1073,23 @@ void CAdvancedSettings::ParseSettingsFile(const std::string &file)
     }
   }
 
+  TiXmlElement* pTrace = pRootElement->FirstChildElement("trace");
+  if (pTrace)
+  {
+    XMLUtils::GetInt(pTrace, "size", m_traceSize, 1, 1024);
+    m_traceComponents = 0;
+    for (TiXmlElement* element = pTrace->FirstChildElement("component"); element; element = element->NextSiblingElement("component"))
+    {
+      if (element->NoChildren())
+        continue;
+
+      int component = CTrace::GetComponentByName(element->FirstChild()->ValueStr());
+      if (component == 0)
+        CLog::Log(LOGWARNING, "%s - unknown trace component %s", __FUNCTION__, element->FirstChild()->Value());
+      m_traceComponents |= component;
+    }
+  }
+
   XMLUtils::GetString(pRootElement, "cputempcommand", m_cpuTempCmd);
   XMLUtils::GetString(pRootElement, "gputempcommand", m_gpuTempCmd);
 
@@ -1065,6 +1103,9 @@ void CAdvancedSettings::ParseSettingsFile(const std::string &file)
     XMLUtils::GetBoolean(pPVR, "channeliconsautoscan", m_bPVRChannelIconsAutoScan);
     XMLUtils::GetBoolean(pPVR, "autoscaniconsuserset", m_bPVRAutoScanIconsUserSet);
     XMLUtils::GetInt(pPVR, "numericchannelswitchtimeout", m_iPVRNumericChannelSwitchTimeout, 50, 60000);
+    XMLUtils::GetInt(pPVR, "timeshiftmemorysize", m_iPVRTimeshiftMemorySize, 0, 1024);
+    XMLUtils::GetInt(pPVR, "timeshiftdisksize", m_iPVRTimeshiftDiskSize, 0, 65536);
+    XMLUtils::GetInt(pPVR, "zapadjacentchannels", m_iPVRZapAdjacentChannels, 0, 2);
   }
 
   TiXmlElement* pDatabase = pRootElement->FirstChildElement("videodatabase");
@@ -204,6 +204,8 @@ class CAdvancedSettings : public ISettingCallback, public ISettingsHandler
     int m_logLevelHint;
     bool m_extraLogEnabled;
     int m_extraLogLevels;
+    int m_traceComponents; /*!< @brief components to write to the binary trace file, see CTrace. defaults to none. */
+    int m_traceSize; /*!< @brief size in MB of the binary trace file. defaults to 16. */
     std::string m_cddbAddress;
 
     //airtunes + airplay
@@ -330,6 +332,9 @@ class CAdvancedSettings : public ISettingCallback, public ISettingsHandler
     bool m_bPVRChannelIconsAutoScan; /*!< @brief automatically scan user defined folder for channel icons when loading internal channel groups */
     bool m_bPVRAutoScanIconsUserSet; /*!< @brief mark channel icons populated by auto scan as "user set" */
     int m_iPVRNumericChannelSwitchTimeout; /*!< @brief time in ms before the numeric dialog auto closes when confirmchannelswitch is disabled */
+    int m_iPVRTimeshiftMemorySize; /*!< @brief size in MB of the local timeshift buffer in memory for live tv. 0 disables local timeshift. defaults to 0. */
+    int m_iPVRTimeshiftDiskSize; /*!< @brief maximum size in MB of the local timeshift buffer spilled to disk. defaults to 512. */
+    int m_iPVRZapAdjacentChannels; /*!< @brief number of channels adjacent to the playing one (0-2, next first) to keep opened for fast channel switching. 0 disables it. defaults to 0. */
 
     DatabaseSettings m_databaseMusic; // advanced music database setup
     DatabaseSettings m_databaseVideo; // advanced video database setup
@@ -350,6 +355,9 @@ class CAdvancedSettings : public ISettingCallback, public ISettingsHandler
     bool m_jsonOutputCompact;
     unsigned int m_jsonTcpPort;
 
+    unsigned int m_webserverResponseCacheSize; /*!< @brief size in MB of the response cache of the web server, 0 disables it. defaults to 16. */
+    unsigned int m_webserverTransformedImagesSize; /*!< @brief size in MB the transformed images of the web server may take on disk. defaults to 256. */
+
     bool m_enableMultimediaKeys;
     std::vector<std::string> m_settingsFiles;
     void ParseSettingsFile(const std::string &file);
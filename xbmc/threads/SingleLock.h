@@ -53,6 +53,7 @@ class CSingleTryLock : public CSingleLock
 {
 public:
   inline explicit CSingleTryLock(CCriticalSection& cs) : CSingleLock(cs,true) {}
+  inline explicit CSingleTryLock(const CCriticalSection& cs) : CSingleLock((CCriticalSection&)cs,true) {}
 
   inline bool IsOwner() const { return owns_lock(); }
 };
@@ -21,6 +21,8 @@
 #include "EGLUtils.h"
 #include "log.h"
 
+#include <EGL/eglext.h>
+
 std::set<std::string> CEGLUtils::GetClientExtensions()
 {
   const char* extensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
@@ -33,6 +35,35 @@ std::set<std::string> CEGLUtils::GetClientExtensions()
   return result;
 }
 
+std::set<std::string> CEGLUtils::GetExtensions(EGLDisplay eglDisplay)
+{
+  std::set<std::string> result;
+  const char* extensions = eglQueryString(eglDisplay, EGL_EXTENSIONS);
+  if (extensions)
+    StringUtils::SplitTo(std::inserter(result, result.begin()), extensions, " ");
+  return result;
+}
+
+bool CEGLUtils::HasExtension(EGLDisplay eglDisplay, const std::string& name)
+{
+  std::set<std::string> extensions = GetExtensions(eglDisplay);
+  return extensions.find(name) != extensions.end();
+}
+
+int CEGLUtils::GetBufferAge(EGLDisplay eglDisplay, EGLSurface eglSurface)
+{
+#if defined(EGL_EXT_buffer_age)
+  if (eglDisplay != EGL_NO_DISPLAY && eglSurface != EGL_NO_SURFACE)
+  {
+    EGLint age = 0;
+    if (eglQuerySurface(eglDisplay, eglSurface, EGL_BUFFER_AGE_EXT, &age) == EGL_TRUE)
+      return age;
+  }
+#endif
+
+  return -1;
+}
+
 void CEGLUtils::LogError(const std::string& what)
 {
   CLog::Log(LOGERROR, "%s (EGL error %d)", what.c_str(), eglGetError());
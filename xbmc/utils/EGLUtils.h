@@ -31,6 +31,15 @@ class CEGLUtils
 {
 public:
   static std::set<std::string> GetClientExtensions();
+  static std::set<std::string> GetExtensions(EGLDisplay eglDisplay);
+  static bool HasExtension(EGLDisplay eglDisplay, std::string const & name);
+  /**
+   * Get the age of the back buffer of a surface (EGL_EXT_buffer_age)
+   *
+   * \return number of frames since the buffer was last presented, 0 if its
+   * content is undefined, or -1 if the age is unknown
+   */
+  static int GetBufferAge(EGLDisplay eglDisplay, EGLSurface eglSurface);
   static void LogError(std::string const & what);
   template<typename T>
   static T GetRequiredProcAddress(const char * procname)
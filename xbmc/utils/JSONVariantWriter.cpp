@@ -20,12 +20,64 @@
 
 #include "JSONVariantWriter.h"
 
+#include <algorithm>
+#include <vector>
+
 #include <rapidjson/prettywriter.h>
-#include <rapidjson/stringbuffer.h>
 #include <rapidjson/writer.h>
 
 #include "utils/Variant.h"
 
+namespace
+{
+
+/*!
+ \brief rapidjson output stream appending straight to a std::string, which
+ saves copying the whole document out of an intermediate StringBuffer.
+
+ Like rapidjson's StringBuffer the string is grown geometrically by Reserve()
+ and written through PutUnsafe(), the writer reserves the space of every value
+ up front. Flush() trims the string to the written length.
+ */
+class CJSONStringOutputStream
+{
+public:
+  typedef char Ch;
+
+  explicit CJSONStringOutputStream(std::string &output) : m_output(output), m_length(output.size()) { }
+
+  void Put(Ch c)
+  {
+    Reserve(1);
+    PutUnsafe(c);
+  }
+  void PutUnsafe(Ch c) { m_output[m_length++] = c; }
+  void Reserve(size_t count)
+  {
+    if (m_output.size() - m_length < count)
+      m_output.resize(std::max(m_length + count, m_output.size() * 2));
+  }
+  void Flush() { m_output.resize(m_length); }
+
+  size_t GetLength() const { return m_length; }
+  void Clear()
+  {
+    m_output.clear();
+    m_length = 0;
+  }
+
+private:
+  std::string &m_output;
+  size_t m_length;
+};
+
+// found by argument dependent lookup in rapidjson's writers instead of the
+// generic versions which write one character at a time through Put()
+inline void PutReserve(CJSONStringOutputStream &stream, size_t count) { stream.Reserve(count); }
+inline void PutUnsafe(CJSONStringOutputStream &stream, char c) { stream.PutUnsafe(c); }
+
+}
+
 template<class TWriter>
 bool InternalWrite(TWriter& writer, const CVariant &value)
 {
@@ -82,23 +134,165 @@ bool InternalWrite(TWriter& writer, const CVariant &value)
 
 bool CJSONVariantWriter::Write(const CVariant &value, std::string& output, bool compact)
 {
-  rapidjson::StringBuffer stringBuffer;
+  // only hand the result over on success so that output is left untouched on failure
+  std::string buffer;
+  CJSONStringOutputStream stream(buffer);
   if (compact)
   {
-    rapidjson::Writer<rapidjson::StringBuffer> writer(stringBuffer);
+    rapidjson::Writer<CJSONStringOutputStream> writer(stream);
 
     if (!InternalWrite(writer, value) || !writer.IsComplete())
       return false;
   }
   else
   {
-    rapidjson::PrettyWriter<rapidjson::StringBuffer> writer(stringBuffer);
+    rapidjson::PrettyWriter<CJSONStringOutputStream> writer(stream);
     writer.SetIndent('\t', 1);
 
     if (!InternalWrite(writer, value) || !writer.IsComplete())
       return false;
   }
 
-  output = stringBuffer.GetString();
+  stream.Flush();
+  output.swap(buffer);
   return true;
 }
+
+class CJSONVariantChunkedWriter::IState
+{
+public:
+  virtual ~IState() = default;
+
+  virtual bool Write(size_t chunkSize, std::string &chunk) = 0;
+  virtual bool IsComplete() const = 0;
+};
+
+namespace
+{
+
+inline void SetupWriter(rapidjson::Writer<CJSONStringOutputStream> &writer) { }
+inline void SetupWriter(rapidjson::PrettyWriter<CJSONStringOutputStream> &writer) { writer.SetIndent('\t', 1); }
+
+/*!
+ \brief Walks the value with an explicit stack instead of recursing like
+ InternalWrite() so that writing can stop after every chunk and resume later.
+ */
+template<class TWriter>
+class CChunkedState : public CJSONVariantChunkedWriter::IState
+{
+public:
+  explicit CChunkedState(const CVariant &value)
+    : m_stream(m_buffer),
+      m_writer(m_stream)
+  {
+    SetupWriter(m_writer);
+    m_frames.push_back(CFrame(value));
+  }
+
+  bool Write(size_t chunkSize, std::string &chunk) override
+  {
+    while (!m_frames.empty() && m_stream.GetLength() < chunkSize)
+    {
+      if (!WriteNext())
+        return false;
+    }
+
+    // hand the written data over and reuse the buffer of the previous chunk
+    m_stream.Flush();
+    chunk.swap(m_buffer);
+    m_stream.Clear();
+    return true;
+  }
+
+  bool IsComplete() const override { return m_frames.empty(); }
+
+private:
+  struct CFrame
+  {
+    explicit CFrame(const CVariant &value_) : value(&value_), started(false) { }
+
+    const CVariant *value;
+    CVariant::const_iterator_array array;
+    CVariant::const_iterator_map map;
+    bool started;
+  };
+
+  bool WriteNext()
+  {
+    CFrame &frame = m_frames.back();
+    const CVariant &value = *frame.value;
+
+    if (value.isArray())
+    {
+      if (!frame.started)
+      {
+        frame.started = true;
+        frame.array = value.begin_array();
+        return m_writer.StartArray();
+      }
+
+      if (frame.array != value.end_array())
+      {
+        const CVariant &item = *frame.array++;
+        m_frames.push_back(CFrame(item));
+        return true;
+      }
+
+      m_frames.pop_back();
+      return m_writer.EndArray(value.size());
+    }
+
+    if (value.isObject())
+    {
+      if (!frame.started)
+      {
+        frame.started = true;
+        frame.map = value.begin_map();
+        return m_writer.StartObject();
+      }
+
+      if (frame.map != value.end_map())
+      {
+        const std::pair<const std::string, CVariant> &member = *frame.map++;
+        if (!m_writer.Key(member.first.c_str()))
+          return false;
+        m_frames.push_back(CFrame(member.second));
+        return true;
+      }
+
+      m_frames.pop_back();
+      return m_writer.EndObject(value.size());
+    }
+
+    m_frames.pop_back();
+    return InternalWrite(m_writer, value);
+  }
+
+  std::string m_buffer;
+  CJSONStringOutputStream m_stream;
+  TWriter m_writer;
+  std::vector<CFrame> m_frames;
+};
+
+}
+
+CJSONVariantChunkedWriter::CJSONVariantChunkedWriter(const CVariant &value, bool compact, size_t chunkSize /* = 65536 */)
+  : m_chunkSize(chunkSize)
+{
+  if (compact)
+    m_state.reset(new CChunkedState<rapidjson::Writer<CJSONStringOutputStream>>(value));
+  else
+    m_state.reset(new CChunkedState<rapidjson::PrettyWriter<CJSONStringOutputStream>>(value));
+}
+
+CJSONVariantChunkedWriter::~CJSONVariantChunkedWriter() = default;
+
+bool CJSONVariantChunkedWriter::Next(std::string &chunk)
+{
+  return m_state->Write(m_chunkSize, chunk);
+}
+
+bool CJSONVariantChunkedWriter::IsComplete() const
+{
+  return m_state->IsComplete();
+}
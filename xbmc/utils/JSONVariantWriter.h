@@ -19,6 +19,7 @@
  *
  */
 
+#include <memory>
 #include <string>
 
 class CVariant;
@@ -30,3 +31,38 @@ public:
 
   static bool Write(const CVariant &value, std::string& output, bool compact);
 };
+
+/*!
+ \brief Writes a CVariant as JSON in chunks of about the given size.
+
+ The output is the same as the one of CJSONVariantWriter::Write() but it can
+ be sent while the rest is still being written, so only one chunk of a large
+ document has to be held in memory. The value must neither be destroyed nor
+ modified before the writer is complete.
+ */
+class CJSONVariantChunkedWriter
+{
+public:
+  CJSONVariantChunkedWriter(const CVariant &value, bool compact, size_t chunkSize = 65536);
+  ~CJSONVariantChunkedWriter();
+
+  /*!
+   \brief Writes the next chunk, replacing the content of the given string.
+
+   The chunk is at least as big as the chunk size unless it is the last one,
+   once the writer is complete the chunk is empty.
+   \return false if the value can't be written as JSON
+   */
+  bool Next(std::string &chunk);
+
+  /*!
+   \brief Whether the whole value was written.
+   */
+  bool IsComplete() const;
+
+  class IState;
+
+private:
+  std::unique_ptr<IState> m_state;
+  size_t m_chunkSize;
+};
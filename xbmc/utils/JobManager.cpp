@@ -40,7 +40,20 @@ bool CJob::ShouldCancel(unsigned int progress, unsigned int total) const
 CJobWorker::CJobWorker(CJobManager *manager) : CThread("JobWorker")
 {
   m_jobManager = manager;
-  Create(true); // start work immediately, and kill ourselves when we're done
+
+  size_t thread_stacksize = 0;
+#if defined(TARGET_DARWIN_TVOS)
+  void *stack_addr;
+  pthread_attr_t attr;
+  pthread_attr_init(&attr);
+  pthread_attr_getstack(&attr, &stack_addr, &thread_stacksize);
+  pthread_attr_destroy(&attr);
+  // JSON-RPC method calls are executed as jobs, and under tvos they need
+  // the doubled stack the JSON-RPC server thread gets (Kodi json -> play video),
+  // see CTCPServer::StartServer
+  thread_stacksize *= 2;
+#endif
+  Create(true, thread_stacksize); // start work immediately, and kill ourselves when we're done
 }
 
 CJobWorker::~CJobWorker()
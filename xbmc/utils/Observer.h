@@ -41,6 +41,7 @@ typedef enum
   ObservableMessageTimers,
   ObservableMessageTimersReset,
   ObservableMessageRecordings,
+  ObservableMessageRecordingsReset,
   ObservableMessagePeripheralsChanged,
   ObservableMessageChannelGroupsLoaded,
   ObservableMessageManagerStopped,
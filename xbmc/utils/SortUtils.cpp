@@ -23,12 +23,16 @@
 #include "URL.h"
 #include "Util.h"
 #include "XBDateTime.h"
+#include "threads/Thread.h"
 #include "utils/CharsetConverter.h"
+#include "utils/CPUInfo.h"
 #include "utils/StringUtils.h"
 #include "utils/Variant.h"
 #include "utils/log.h"
 
 #include <algorithm>
+#include <locale>
+#include <unordered_map>
 
 std::string ArrayToString(SortAttribute attributes, const CVariant &variant, const std::string &separator = " / ")
 {
@@ -433,130 +437,300 @@ std::string ByLastUsed(SortAttribute attributes, const SortItem &values)
   return values.at(FieldLastUsed).asString();
 }
 
-bool preliminarySort(const SortItem &left, const SortItem &right, bool handleFolder, bool &result, std::wstring &labelLeft, std::wstring &labelRight)
+namespace
 {
-  // make sure both items have the necessary data to do the sorting
-  SortItem::const_iterator itLeftSort, itRightSort;
-  if ((itLeftSort = left.find(FieldSort)) == left.end())
+
+// lists below this size aren't worth spreading over several threads
+const size_t PARALLEL_SORT_MIN_ITEMS = 10000;
+const int PARALLEL_SORT_MAX_THREADS = 4;
+
+const uint64_t TOKEN_NUMBER = UINT64_C(1) << 63;
+const uint64_t TOKEN_NUMBER_MASK = (UINT64_C(1) << 50) - 1;
+const int TOKEN_DIGIT_SHIFT = 50;
+
+/*!
+ \brief Precomputed sort keys of a list of prepared sort items.
+
+ Every sort label is split once into tokens that hold either a run of digits
+ or the collation weight of a single character. Comparing two items then only
+ walks integer arrays instead of converting variants and asking the locale
+ about every character, while giving the same order as
+ StringUtils::AlphaNumericCompare.
+ */
+class CSortKeys
+{
+public:
+  explicit CSortKeys(size_t size) : m_keys(size) { }
+
+  void Add(size_t index, const SortItem &item)
   {
-    result = false;
-    return true;
+    SortKey &key = m_keys[index];
+
+    SortItem::const_iterator it = item.find(FieldSort);
+    if (it == item.end())
+      return;
+    key.label = &it->second;
+
+    if ((it = item.find(FieldSortSpecial)) != item.end() && it->second.asInteger() <= (int64_t)SortSpecialOnBottom)
+      key.special = (SortSpecial)it->second.asInteger();
+    if ((it = item.find(FieldFolder)) != item.end())
+      key.folder = it->second.asBoolean() ? 1 : 0;
   }
-  if ((itRightSort = right.find(FieldSort)) == right.end())
+
+  void Tokenize()
   {
-    result = true;
-    return true;
+    std::vector<std::wstring> labels(m_keys.size());
+    std::vector<wchar_t> characters;
+    for (size_t i = 0; i < m_keys.size(); i++)
+    {
+      if (!m_keys[i].label)
+        continue;
+      labels[i] = m_keys[i].label->asWideString();
+      for (const wchar_t *c = labels[i].c_str(); *c; c++)
+        characters.push_back(ToLower(*c));
+    }
+    for (wchar_t c = L'0'; c <= L'9'; c++)
+      characters.push_back(c);
+
+    std::sort(characters.begin(), characters.end());
+    characters.erase(std::unique(characters.begin(), characters.end()), characters.end());
+
+    // characters the locale considers equal share a weight
+    const std::collate<wchar_t>& coll = std::use_facet<std::collate<wchar_t> >(g_langInfo.GetSystemLocale());
+    std::stable_sort(characters.begin(), characters.end(), [&coll](const wchar_t &left, const wchar_t &right)
+    {
+      return coll.compare(&left, &left + 1, &right, &right + 1) < 0;
+    });
+    uint32_t weight = 0;
+    for (size_t i = 0; i < characters.size(); i++)
+    {
+      if (i > 0 && coll.compare(&characters[i - 1], &characters[i - 1] + 1, &characters[i], &characters[i] + 1) != 0)
+        weight++;
+      m_weights[characters[i]] = weight;
+    }
+    for (int digit = 0; digit < 10; digit++)
+      m_digitWeights[digit] = m_weights[L'0' + digit];
+
+    for (size_t i = 0; i < m_keys.size(); i++)
+    {
+      m_keys[i].tokenStart = m_tokens.size();
+      const wchar_t *c = labels[i].c_str();
+      while (*c)
+      {
+        if (*c >= L'0' && *c <= L'9')
+        { // compare only up to 15 digits
+          const wchar_t *start = c;
+          uint64_t number = 0;
+          while (*c >= L'0' && *c <= L'9' && c < start + 15)
+            number = number * 10 + (*c++ - L'0');
+          m_tokens.push_back(TOKEN_NUMBER | ((uint64_t)(*start - L'0') << TOKEN_DIGIT_SHIFT) | number);
+        }
+        else
+          m_tokens.push_back(m_weights[ToLower(*c++)]);
+      }
+      m_keys[i].tokenEnd = m_tokens.size();
+    }
   }
 
-  // look at special sorting behaviour
-  SortItem::const_iterator itLeft, itRight;
-  SortSpecial leftSortSpecial = SortSpecialNone;
-  SortSpecial rightSortSpecial = SortSpecialNone;
-  if ((itLeft = left.find(FieldSortSpecial)) != left.end() && itLeft->second.asInteger() <= (int64_t)SortSpecialOnBottom)
-    leftSortSpecial = (SortSpecial)itLeft->second.asInteger();
-  if ((itRight = right.find(FieldSortSpecial)) != right.end() && itRight->second.asInteger() <= (int64_t)SortSpecialOnBottom)
-    rightSortSpecial = (SortSpecial)itRight->second.asInteger();
-  
-  // one has a special sort
-  if (leftSortSpecial != rightSortSpecial)
+  bool Less(uint32_t left, uint32_t right, bool handleFolder, bool descending) const
   {
-    // left should be sorted on top
-    // or right should be sorted on bottom
-    // => left is sorted above right
-    if (leftSortSpecial == SortSpecialOnTop ||
-        rightSortSpecial == SortSpecialOnBottom)
-    {
-      result = true;
+    const SortKey &leftKey = m_keys[left];
+    const SortKey &rightKey = m_keys[right];
+
+    // make sure both items have the necessary data to do the sorting
+    if (!leftKey.label)
+      return false;
+    if (!rightKey.label)
       return true;
-    }
-    
-    // otherwise right is sorted above left
-    result = false;
-    return true;
+
+    // one has a special sort, left is sorted above right if it belongs on top
+    // or right belongs on the bottom
+    if (leftKey.special != rightKey.special)
+      return leftKey.special == SortSpecialOnTop || rightKey.special == SortSpecialOnBottom;
+    // both have either sort on top or sort on bottom -> leave as-is
+    if (leftKey.special != SortSpecialNone)
+      return false;
+
+    if (handleFolder && leftKey.folder >= 0 && rightKey.folder >= 0 && leftKey.folder != rightKey.folder)
+      return leftKey.folder == 1;
+
+    int result = Compare(leftKey, rightKey);
+    return descending ? result > 0 : result < 0;
   }
-  // both have either sort on top or sort on bottom -> leave as-is
-  else if (leftSortSpecial != SortSpecialNone && leftSortSpecial == rightSortSpecial)
+
+private:
+  struct SortKey
+  {
+    const CVariant *label = nullptr;
+    SortSpecial special = SortSpecialNone;
+    int folder = -1;
+    size_t tokenStart = 0;
+    size_t tokenEnd = 0;
+  };
+
+  static wchar_t ToLower(wchar_t c)
+  {
+    if (c >= L'A' && c <= L'Z')
+      c += L'a' - L'A';
+    return c;
+  }
+
+  uint32_t Weight(uint64_t token) const
   {
-    result = false;
-    return true;
+    if (token & TOKEN_NUMBER)
+      return m_digitWeights[(token & ~TOKEN_NUMBER) >> TOKEN_DIGIT_SHIFT];
+    return (uint32_t)token;
   }
 
-  if (handleFolder)
+  int Compare(const SortKey &left, const SortKey &right) const
   {
-    itLeft = left.find(FieldFolder);
-    itRight = right.find(FieldFolder);
-    if (itLeft != left.end() && itRight != right.end() &&
-        itLeft->second.asBoolean() != itRight->second.asBoolean())
+    const uint64_t *l = m_tokens.data() + left.tokenStart;
+    const uint64_t *lEnd = m_tokens.data() + left.tokenEnd;
+    const uint64_t *r = m_tokens.data() + right.tokenStart;
+    const uint64_t *rEnd = m_tokens.data() + right.tokenEnd;
+    for (; l != lEnd && r != rEnd; ++l, ++r)
     {
-      result = itLeft->second.asBoolean();
-      return true;
+      if ((*l & TOKEN_NUMBER) && (*r & TOKEN_NUMBER))
+      {
+        uint64_t lNumber = *l & TOKEN_NUMBER_MASK;
+        uint64_t rNumber = *r & TOKEN_NUMBER_MASK;
+        if (lNumber != rNumber)
+          return lNumber < rNumber ? -1 : 1;
+        continue;
+      }
+
+      uint32_t lWeight = Weight(*l);
+      uint32_t rWeight = Weight(*r);
+      if (lWeight != rWeight)
+        return lWeight < rWeight ? -1 : 1;
+
+      // a digit the locale considers equal to another character is only
+      // handled correctly by walking the labels character by character
+      if ((*l & TOKEN_NUMBER) != (*r & TOKEN_NUMBER))
+      {
+        int64_t result = StringUtils::AlphaNumericCompare(left.label->asWideString().c_str(), right.label->asWideString().c_str());
+        return result < 0 ? -1 : (result > 0 ? 1 : 0);
+      }
     }
-  }
 
-  labelLeft = itLeftSort->second.asWideString();
-  labelRight = itRightSort->second.asWideString();
+    if (r != rEnd)
+      return -1;
+    if (l != lEnd)
+      return 1;
+    return 0;
+  }
 
-  return false;
-}
+  std::vector<SortKey> m_keys;
+  std::vector<uint64_t> m_tokens;
+  std::unordered_map<wchar_t, uint32_t> m_weights;
+  uint32_t m_digitWeights[10];
+};
 
-bool SorterAscending(const SortItem &left, const SortItem &right)
+class CSortKeyComparator
 {
-  bool result;
-  std::wstring labelLeft, labelRight;
-  if (preliminarySort(left, right, true, result, labelLeft, labelRight))
-    return result;
+public:
+  CSortKeyComparator(const CSortKeys &keys, bool handleFolder, bool descending)
+    : m_keys(keys), m_handleFolder(handleFolder), m_descending(descending)
+  { }
 
-  return StringUtils::AlphaNumericCompare(labelLeft.c_str(), labelRight.c_str()) < 0;
-}
+  bool operator()(uint32_t left, uint32_t right) const
+  {
+    return m_keys.Less(left, right, m_handleFolder, m_descending);
+  }
 
-bool SorterDescending(const SortItem &left, const SortItem &right)
-{
-  bool result;
-  std::wstring labelLeft, labelRight;
-  if (preliminarySort(left, right, true, result, labelLeft, labelRight))
-    return result;
+private:
+  const CSortKeys &m_keys;
+  bool m_handleFolder;
+  bool m_descending;
+};
 
-  return StringUtils::AlphaNumericCompare(labelLeft.c_str(), labelRight.c_str()) > 0;
-}
+typedef std::vector<uint32_t> SortOrderList;
 
-bool SorterIgnoreFoldersAscending(const SortItem &left, const SortItem &right)
+class CSortRunnable : public IRunnable
 {
-  bool result;
-  std::wstring labelLeft, labelRight;
-  if (preliminarySort(left, right, false, result, labelLeft, labelRight))
-    return result;
+public:
+  CSortRunnable(SortOrderList::iterator begin, SortOrderList::iterator end, const CSortKeyComparator &comparator)
+    : m_begin(begin), m_end(end), m_comparator(comparator)
+  { }
 
-  return StringUtils::AlphaNumericCompare(labelLeft.c_str(), labelRight.c_str()) < 0;
-}
+  void Run() override
+  {
+    std::stable_sort(m_begin, m_end, m_comparator);
+  }
 
-bool SorterIgnoreFoldersDescending(const SortItem &left, const SortItem &right)
+private:
+  SortOrderList::iterator m_begin;
+  SortOrderList::iterator m_end;
+  const CSortKeyComparator &m_comparator;
+};
+
+void StableSort(SortOrderList &order, const CSortKeyComparator &comparator)
 {
-  bool result;
-  std::wstring labelLeft, labelRight;
-  if (preliminarySort(left, right, false, result, labelLeft, labelRight))
-    return result;
+  int threadCount = std::min(g_cpuInfo.getCPUCount(), PARALLEL_SORT_MAX_THREADS);
+  if (threadCount < 2 || order.size() < PARALLEL_SORT_MIN_ITEMS)
+  {
+    std::stable_sort(order.begin(), order.end(), comparator);
+    return;
+  }
+
+  size_t chunks = threadCount;
 
-  return StringUtils::AlphaNumericCompare(labelLeft.c_str(), labelRight.c_str()) > 0;
+  std::vector<SortOrderList::iterator> bounds;
+  for (size_t i = 0; i <= chunks; i++)
+    bounds.push_back(order.begin() + order.size() * i / chunks);
+
+  // sort the chunks concurrently, the first one on the calling thread
+  std::vector<std::unique_ptr<CSortRunnable>> runnables;
+  std::vector<std::unique_ptr<CThread>> threads;
+  for (size_t i = 1; i < chunks; i++)
+  {
+    runnables.emplace_back(new CSortRunnable(bounds[i], bounds[i + 1], comparator));
+    threads.emplace_back(new CThread(runnables.back().get(), "SortUtils"));
+    threads.back()->Create();
+  }
+  std::stable_sort(bounds[0], bounds[1], comparator);
+  for (auto &thread : threads)
+    thread->StopThread(true);
+
+  // merging neighbouring chunks keeps equal items in their original order
+  for (size_t width = 1; width < chunks; width *= 2)
+  {
+    for (size_t i = 0; i + width < chunks; i += 2 * width)
+      std::inplace_merge(bounds[i], bounds[i + width], bounds[std::min(i + 2 * width, chunks)], comparator);
+  }
 }
 
-bool SorterIndirectAscending(const SortItemPtr &left, const SortItemPtr &right)
+const SortItem& GetSortItem(const SortItem &item)
 {
-  return SorterAscending(*left, *right);
+  return item;
 }
 
-bool SorterIndirectDescending(const SortItemPtr &left, const SortItemPtr &right)
+const SortItem& GetSortItem(const SortItemPtr &item)
 {
-  return SorterDescending(*left, *right);
+  return *item;
 }
 
-bool SorterIndirectIgnoreFoldersAscending(const SortItemPtr &left, const SortItemPtr &right)
+template<typename T>
+void SortPreparedItems(std::vector<T> &items, SortOrder sortOrder, SortAttribute attributes)
 {
-  return SorterIgnoreFoldersAscending(*left, *right);
+  CSortKeys keys(items.size());
+  for (size_t i = 0; i < items.size(); i++)
+    keys.Add(i, GetSortItem(items[i]));
+  keys.Tokenize();
+
+  SortOrderList order(items.size());
+  for (size_t i = 0; i < order.size(); i++)
+    order[i] = static_cast<uint32_t>(i);
+
+  StableSort(order, CSortKeyComparator(keys, !(attributes & SortAttributeIgnoreFolders), sortOrder == SortOrderDescending));
+
+  std::vector<T> sortedItems;
+  sortedItems.reserve(items.size());
+  for (SortOrderList::const_iterator it = order.begin(); it != order.end(); ++it)
+    sortedItems.push_back(std::move(items[*it]));
+  items.swap(sortedItems);
 }
 
-bool SorterIndirectIgnoreFoldersDescending(const SortItemPtr &left, const SortItemPtr &right)
-{
-  return SorterIgnoreFoldersDescending(*left, *right);
 }
 
 std::map<SortBy, SortUtils::SortPreparator> fillPreparators()
@@ -746,7 +920,7 @@ void SortUtils::Sort(SortBy sortBy, SortOrder sortOrder, SortAttribute attribute
       }
 
       // Do the sorting
-      std::stable_sort(items.begin(), items.end(), getSorter(sortOrder, attributes));
+      SortPreparedItems(items, sortOrder, attributes);
     }
   }
 
@@ -796,7 +970,7 @@ void SortUtils::Sort(SortBy sortBy, SortOrder sortOrder, SortAttribute attribute
       }
 
       // Do the sorting
-      std::stable_sort(items.begin(), items.end(), getSorterIndirect(sortOrder, attributes));
+      SortPreparedItems(items, sortOrder, attributes);
     }
   }
 
@@ -849,22 +1023,6 @@ const SortUtils::SortPreparator& SortUtils::getPreparator(SortBy sortBy)
   return m_preparators[SortByNone];
 }
 
-SortUtils::Sorter SortUtils::getSorter(SortOrder sortOrder, SortAttribute attributes)
-{
-  if (attributes & SortAttributeIgnoreFolders)
-    return sortOrder == SortOrderDescending ? SorterIgnoreFoldersDescending : SorterIgnoreFoldersAscending;
-
-  return sortOrder == SortOrderDescending ? SorterDescending : SorterAscending;
-}
-
-SortUtils::SorterIndirect SortUtils::getSorterIndirect(SortOrder sortOrder, SortAttribute attributes)
-{
-  if (attributes & SortAttributeIgnoreFolders)
-    return sortOrder == SortOrderDescending ? SorterIndirectIgnoreFoldersDescending : SorterIndirectIgnoreFoldersAscending;
-
-  return sortOrder == SortOrderDescending ? SorterIndirectDescending : SorterIndirectAscending;
-}
-
 const Fields& SortUtils::GetFieldsForSorting(SortBy sortBy)
 {
   std::map<SortBy, Fields>::const_iterator it = m_sortingFields.find(sortBy);
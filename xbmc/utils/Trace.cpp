@@ -0,0 +1,191 @@
+/*
+ *      Copyright (C) 2017 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "Trace.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+
+#if defined(TARGET_WINDOWS)
+#include <windows.h>
+#include "platform/win32/CharsetConverter.h"
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#include "CompileInfo.h"
+#include "threads/CriticalSection.h"
+#include "threads/SingleLock.h"
+#include "threads/Thread.h"
+#include "utils/StringUtils.h"
+#include "utils/log.h"
+
+std::atomic<int> CTrace::s_components(0);
+
+namespace
+{
+  const size_t MIN_TRACE_SIZE = 64 * 1024;
+
+  CCriticalSection traceSection;
+  uint8_t* traceData = nullptr; // the ring buffer, never unmapped once created
+  uint64_t traceCapacity = 0;
+  std::atomic<uint64_t> tracePosition(0);
+  int requestedComponents = 0;
+
+  uint64_t GetMonotonicTime()
+  {
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+  }
+
+  uint8_t* MapFile(const std::string& file, size_t size)
+  {
+#if defined(TARGET_WINDOWS)
+    HANDLE handle = CreateFileW(KODI::PLATFORM::WINDOWS::ToW(file).c_str(), GENERIC_READ | GENERIC_WRITE,
+                                FILE_SHARE_READ, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (handle == INVALID_HANDLE_VALUE)
+      return nullptr;
+
+    const uint64_t size64 = size;
+    HANDLE mapping = CreateFileMappingW(handle, nullptr, PAGE_READWRITE, static_cast<DWORD>(size64 >> 32),
+                                        static_cast<DWORD>(size64 & 0xFFFFFFFF), nullptr);
+    CloseHandle(handle);
+    if (!mapping)
+      return nullptr;
+
+    void* data = MapViewOfFile(mapping, FILE_MAP_WRITE, 0, 0, size);
+    CloseHandle(mapping);
+    return static_cast<uint8_t*>(data);
+#else
+    int fd = open(file.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+      return nullptr;
+
+    void* data = MAP_FAILED;
+    if (ftruncate(fd, size) == 0)
+      data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    return data != MAP_FAILED ? static_cast<uint8_t*>(data) : nullptr;
+#endif
+  }
+}
+
+bool CTrace::Init(const std::string& path, size_t size)
+{
+  CSingleLock lock(traceSection);
+  if (traceData)
+    return true;
+
+  size = std::max(size, MIN_TRACE_SIZE) & ~static_cast<size_t>(7);
+
+  std::string appName = CCompileInfo::GetAppName();
+  StringUtils::ToLower(appName);
+  const std::string file = path + appName + ".trace";
+  const std::string oldFile = path + appName + ".old.trace";
+  (void)remove(oldFile.c_str());
+  (void)rename(file.c_str(), oldFile.c_str());
+
+  uint8_t* data = MapFile(file, TRACE_FILE_HEADER_SIZE + size);
+  if (!data)
+  {
+    CLog::Log(LOGERROR, "CTrace::%s - failed to create trace file %s", __FUNCTION__, file.c_str());
+    return false;
+  }
+
+  TraceFileHeader header = {};
+  memcpy(header.magic, TRACE_FILE_MAGIC, sizeof(header.magic));
+  header.version = TRACE_FILE_VERSION;
+  header.capacity = size;
+  header.startTime = GetMonotonicTime();
+  header.startWallTime = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+  memcpy(data, &header, sizeof(header));
+
+  traceCapacity = size;
+  traceData = data + TRACE_FILE_HEADER_SIZE;
+  s_components.store(requestedComponents, std::memory_order_relaxed);
+
+  CLog::Log(LOGNOTICE, "CTrace::%s - tracing to %s, %u kB", __FUNCTION__, file.c_str(), static_cast<unsigned int>(size / 1024));
+  return true;
+}
+
+void CTrace::SetComponents(int components)
+{
+  CSingleLock lock(traceSection);
+  requestedComponents = components;
+  if (traceData)
+    s_components.store(components, std::memory_order_relaxed);
+}
+
+int CTrace::GetComponentByName(const std::string& name)
+{
+#define KODI_TRACE_COMPONENT_BY_NAME(value, componentName) if (StringUtils::EqualsNoCase(name, componentName)) return value;
+  KODI_TRACE_COMPONENTS(KODI_TRACE_COMPONENT_BY_NAME)
+#undef KODI_TRACE_COMPONENT_BY_NAME
+  return 0;
+}
+
+void CTrace::AppendString(uint8_t* data, size_t& size, const char* value, size_t length)
+{
+  length = std::min<size_t>(length, 255);
+  if (size + 2 + length > TRACE_MAX_ARGUMENTS_SIZE)
+    return;
+
+  data[size++] = TRACE_ARGUMENT_STRING;
+  data[size++] = static_cast<uint8_t>(length);
+  memcpy(data + size, value, length);
+  size += length;
+}
+
+void CTrace::WriteRecord(int component, TraceEvent event, const uint8_t* data, size_t size)
+{
+  // s_components is only set once traceData is valid
+  TraceRecordHeader header = {};
+  header.time = GetMonotonicTime();
+  header.thread = (uint64_t)CThread::GetCurrentThreadId();
+  header.component = static_cast<uint32_t>(component);
+  header.event = static_cast<uint16_t>(event);
+  header.size = static_cast<uint16_t>((sizeof(header) + size + 7) & ~static_cast<size_t>(7));
+
+  // reserve the space, skipping the end of the ring buffer if the record does not fit
+  uint64_t position = tracePosition.load(std::memory_order_relaxed);
+  uint64_t start;
+  do
+  {
+    start = position;
+    const uint64_t offset = start % traceCapacity;
+    if (offset + header.size > traceCapacity)
+      start += traceCapacity - offset;
+  } while (!tracePosition.compare_exchange_weak(position, start + header.size, std::memory_order_relaxed));
+
+  uint8_t* record = traceData + start % traceCapacity;
+  const uint64_t invalidPosition = UINT64_MAX;
+  memcpy(record, &invalidPosition, sizeof(invalidPosition));
+  std::atomic_thread_fence(std::memory_order_release);
+  memcpy(record + sizeof(header.position), reinterpret_cast<const uint8_t*>(&header) + sizeof(header.position),
+         sizeof(header) - sizeof(header.position));
+  memcpy(record + sizeof(header), data, size);
+  memset(record + sizeof(header) + size, 0, header.size - sizeof(header) - size);
+
+  // the position marks the record as complete, write it last
+  std::atomic_thread_fence(std::memory_order_release);
+  memcpy(record, &start, sizeof(start));
+}
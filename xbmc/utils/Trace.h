@@ -0,0 +1,144 @@
+#pragma once
+
+/*
+ *      Copyright (C) 2017 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <atomic>
+#include <cstring>
+#include <string>
+#include <type_traits>
+
+#include "utils/TraceFormat.h"
+
+/*!
+ \brief Trace an event if its component is enabled.
+
+ The arguments are only evaluated if the component is enabled, a disabled
+ trace point costs a single load and branch.
+ Example: KODI_TRACE(LOGAVTIMING, TraceEvent::ClockDiscontinuity, clock, absolute);
+ */
+#define KODI_TRACE(component, event, ...) \
+  do \
+  { \
+    if (CTrace::IsEnabled(component)) \
+      CTrace::Write((component), (event), ##__VA_ARGS__); \
+  } while (0)
+
+/*!
+ \brief Binary trace of timing critical decisions.
+
+ Unlike the log, trace events are not formatted at runtime. Every event is a
+ compile time id (see KODI_TRACE_EVENTS in TraceFormat.h), the component,
+ thread, monotonic timestamp and its typed arguments, copied into a memory
+ mapped ring buffer file. Tracing is cheap enough for hot paths like the
+ VideoPlayer clock, and the file survives a crash of the process. It is
+ decoded offline by tools/depends/native/TraceDecoder.
+
+ Tracing is configured in advancedsettings.xml:
+ \code
+ <trace>
+   <size>16</size> <!-- size of the trace file in MB -->
+   <component>avtiming</component>
+ </trace>
+ \endcode
+ */
+class CTrace
+{
+public:
+  /*!
+   \brief Create the trace file, the one of the previous run is kept as <appname>.old.trace.
+   \param path The folder of the trace file.
+   \param size The size of the ring buffer in bytes.
+   \return true if the file is mapped, also if it was opened before.
+   */
+  static bool Init(const std::string& path, size_t size);
+
+  /*!
+   \brief Set the components to trace, a combination of the LOGxxx component flags.
+   Tracing stays disabled until Init succeeded.
+   */
+  static void SetComponents(int components);
+
+  static inline bool IsEnabled(int component)
+  {
+    return (s_components.load(std::memory_order_relaxed) & component) != 0;
+  }
+
+  /*!
+   \brief Get the component flag for a name of KODI_TRACE_COMPONENTS.
+   \return the flag or 0 if the name is unknown.
+   */
+  static int GetComponentByName(const std::string& name);
+
+  /*!
+   \brief Write an event, use KODI_TRACE instead to skip disabled components.
+   Arguments can be integers, enums, floating point numbers and strings.
+   Arguments that exceed TRACE_MAX_ARGUMENTS_SIZE are dropped.
+   */
+  template<typename... Args>
+  static void Write(int component, TraceEvent event, const Args&... args)
+  {
+    uint8_t data[TRACE_MAX_ARGUMENTS_SIZE];
+    size_t size = 0;
+    int dummy[] = { 0, (Append(data, size, args), 0)... };
+    (void)dummy;
+    WriteRecord(component, event, data, size);
+  }
+
+private:
+  template<typename T>
+  static typename std::enable_if<std::is_integral<T>::value || std::is_enum<T>::value>::type
+  Append(uint8_t* data, size_t& size, const T& value)
+  {
+    AppendValue(data, size, TRACE_ARGUMENT_INT, static_cast<int64_t>(value));
+  }
+
+  template<typename T>
+  static typename std::enable_if<std::is_floating_point<T>::value>::type
+  Append(uint8_t* data, size_t& size, const T& value)
+  {
+    AppendValue(data, size, TRACE_ARGUMENT_DOUBLE, static_cast<double>(value));
+  }
+
+  static void Append(uint8_t* data, size_t& size, const char* value)
+  {
+    AppendString(data, size, value, strlen(value));
+  }
+
+  static void Append(uint8_t* data, size_t& size, const std::string& value)
+  {
+    AppendString(data, size, value.c_str(), value.size());
+  }
+
+  template<typename T>
+  static void AppendValue(uint8_t* data, size_t& size, TraceArgumentType type, const T& value)
+  {
+    if (size + 1 + sizeof(value) > TRACE_MAX_ARGUMENTS_SIZE)
+      return;
+    data[size++] = type;
+    memcpy(data + size, &value, sizeof(value));
+    size += sizeof(value);
+  }
+
+  static void AppendString(uint8_t* data, size_t& size, const char* value, size_t length);
+  static void WriteRecord(int component, TraceEvent event, const uint8_t* data, size_t size);
+
+  static std::atomic<int> s_components;
+};
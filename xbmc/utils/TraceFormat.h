@@ -0,0 +1,144 @@
+#pragma once
+
+/*
+ *      Copyright (C) 2017 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/*
+ * Layout of the binary trace file written by CTrace. This header has no
+ * dependencies besides commons/ilog.h, so that the offline decoder in
+ * tools/depends/native/TraceDecoder can share it.
+ *
+ * The file is a header followed by a ring buffer of records. Records are
+ * 8 byte aligned and never wrap, the end of the ring buffer is skipped if a
+ * record does not fit. Every record starts with its absolute position in
+ * the trace stream, which is written last. A decoder finds the records by
+ * looking for headers whose position matches their offset in the ring buffer.
+ * All values are stored in host byte order, the file is read on the same
+ * machine or one with the same byte order.
+ */
+
+#include <stdint.h>
+
+#include "commons/ilog.h"
+
+/*!
+ * Events that can be traced: X(id, name, argument names)
+ * Append new events at the end, the ids are stored in the trace file.
+ */
+#define KODI_TRACE_EVENTS(X) \
+  X(ClockDiscontinuity, "clock discontinuity", "clock absolute") \
+  X(ClockErrorAdjust, "clock error adjust", "error adjustment reason") \
+  X(ClockSpeedAdjust, "clock speed adjust", "adjust") \
+  X(RenderPrepare, "render prepare", "frameonscreen renderpts nextframepts forcenext") \
+  X(VideoOutput, "video output", "pts clock timetodisplay") \
+  X(VideoOutputDropped, "video output dropped", "pts clock reason")
+
+/*!
+ * Components that can be traced: X(component, name)
+ */
+#define KODI_TRACE_COMPONENTS(X) \
+  X(LOGSAMBA, "samba") \
+  X(LOGCURL, "curl") \
+  X(LOGFFMPEG, "ffmpeg") \
+  X(LOGDBUS, "dbus") \
+  X(LOGJSONRPC, "jsonrpc") \
+  X(LOGAUDIO, "audio") \
+  X(LOGAIRTUNES, "airtunes") \
+  X(LOGUPNP, "upnp") \
+  X(LOGCEC, "cec") \
+  X(LOGVIDEO, "video") \
+  X(LOGWEBSERVER, "webserver") \
+  X(LOGDATABASE, "database") \
+  X(LOGAVTIMING, "avtiming")
+
+enum class TraceEvent : uint16_t
+{
+  None = 0, // never written, an unused part of the file reads as zeros
+#define KODI_TRACE_EVENT_ID(id, name, arguments) id,
+  KODI_TRACE_EVENTS(KODI_TRACE_EVENT_ID)
+#undef KODI_TRACE_EVENT_ID
+  Count
+};
+
+enum TraceArgumentType : uint8_t
+{
+  TRACE_ARGUMENT_INT = 1,    // followed by an int64_t
+  TRACE_ARGUMENT_DOUBLE = 2, // followed by a double
+  TRACE_ARGUMENT_STRING = 3  // followed by a uint8_t length and the characters
+};
+
+static const char TRACE_FILE_MAGIC[4] = { 'K', 'T', 'R', 'C' };
+static const uint32_t TRACE_FILE_VERSION = 1;
+static const uint32_t TRACE_FILE_HEADER_SIZE = 64; // offset of the ring buffer in the file
+static const uint32_t TRACE_MAX_ARGUMENTS_SIZE = 512;
+
+struct TraceFileHeader
+{
+  char magic[4];
+  uint32_t version;
+  uint64_t capacity;  // size of the ring buffer in bytes
+  uint64_t startTime; // monotonic time in us when the file was created
+  int64_t startWallTime; // time since the epoch in us at startTime
+};
+
+struct TraceRecordHeader
+{
+  uint64_t position;  // absolute position of the record, written last
+  uint64_t time;      // monotonic time in us
+  uint64_t thread;
+  uint32_t component;
+  uint16_t event;
+  uint16_t size;      // size of the record including the arguments, multiple of 8
+};
+
+static_assert(sizeof(TraceFileHeader) <= TRACE_FILE_HEADER_SIZE, "trace file header too large");
+static_assert(sizeof(TraceRecordHeader) == 32, "unexpected trace record header size");
+
+inline const char* GetTraceEventName(uint16_t event)
+{
+  static const char* const names[] =
+  {
+    "none",
+#define KODI_TRACE_EVENT_NAME(id, name, arguments) name,
+    KODI_TRACE_EVENTS(KODI_TRACE_EVENT_NAME)
+#undef KODI_TRACE_EVENT_NAME
+  };
+  return event < static_cast<uint16_t>(TraceEvent::Count) ? names[event] : "unknown";
+}
+
+inline const char* GetTraceEventArguments(uint16_t event)
+{
+  static const char* const arguments[] =
+  {
+    "",
+#define KODI_TRACE_EVENT_ARGUMENTS(id, name, arguments) arguments,
+    KODI_TRACE_EVENTS(KODI_TRACE_EVENT_ARGUMENTS)
+#undef KODI_TRACE_EVENT_ARGUMENTS
+  };
+  return event < static_cast<uint16_t>(TraceEvent::Count) ? arguments[event] : "";
+}
+
+inline const char* GetTraceComponentName(uint32_t component)
+{
+#define KODI_TRACE_COMPONENT_NAME(value, name) if (component == static_cast<uint32_t>(value)) return name;
+  KODI_TRACE_COMPONENTS(KODI_TRACE_COMPONENT_NAME)
+#undef KODI_TRACE_COMPONENT_NAME
+  return "unknown";
+}
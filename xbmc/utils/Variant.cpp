@@ -157,7 +157,7 @@ CVariant::CVariant(VariantType type)
       m_data.dvalue = 0.0;
       break;
     case VariantTypeString:
-      m_data.string = new std::string();
+      setString("", 0);
       break;
     case VariantTypeWideString:
       m_data.wstring = new std::wstring();
@@ -221,25 +221,25 @@ CVariant::CVariant(bool boolean)
 CVariant::CVariant(const char *str)
 {
   m_type = VariantTypeString;
-  m_data.string = new std::string(str);
+  setString(str, strlen(str));
 }
 
 CVariant::CVariant(const char *str, unsigned int length)
 {
   m_type = VariantTypeString;
-  m_data.string = new std::string(str, length);
+  setString(str, length);
 }
 
 CVariant::CVariant(const std::string &str)
 {
   m_type = VariantTypeString;
-  m_data.string = new std::string(str);
+  setString(str.c_str(), str.size());
 }
 
 CVariant::CVariant(std::string &&str)
 {
   m_type = VariantTypeString;
-  m_data.string = new std::string(std::move(str));
+  setString(std::move(str));
 }
 
 CVariant::CVariant(const wchar_t *str)
@@ -295,7 +295,7 @@ CVariant::CVariant(const CVariant &variant)
   *this = variant;
 }
 
-CVariant::CVariant(CVariant&& rhs)
+CVariant::CVariant(CVariant&& rhs) noexcept
 {
   //Set this so that operator= don't try and run cleanup
   //when we're not initialized.
@@ -314,8 +314,10 @@ void CVariant::cleanup()
   switch (m_type)
   {
   case VariantTypeString:
-    delete m_data.string;
+    if (!m_shortString)
+      delete m_data.string;
     m_data.string = nullptr;
+    m_shortString = false;
     break;
 
   case VariantTypeWideString:
@@ -338,6 +340,46 @@ void CVariant::cleanup()
   m_type = VariantTypeNull;
 }
 
+void CVariant::setString(const char *str, size_t length)
+{
+  if (length <= SHORT_STRING_LENGTH)
+  {
+    m_shortString = true;
+    memcpy(m_data.shortstring, str, length);
+    m_data.shortstring[length] = '\0';
+    m_data.shortstring[SHORT_STRING_LENGTH] = static_cast<char>(SHORT_STRING_LENGTH - length);
+  }
+  else
+  {
+    m_shortString = false;
+    m_data.string = new std::string(str, length);
+  }
+}
+
+void CVariant::setString(std::string &&str)
+{
+  // a long string already owns a heap buffer, so take it over instead of copying
+  if (str.size() <= SHORT_STRING_LENGTH)
+    setString(str.c_str(), str.size());
+  else
+  {
+    m_shortString = false;
+    m_data.string = new std::string(std::move(str));
+  }
+}
+
+const char *CVariant::stringData() const
+{
+  return m_shortString ? m_data.shortstring : m_data.string->c_str();
+}
+
+size_t CVariant::stringLength() const
+{
+  if (m_shortString)
+    return SHORT_STRING_LENGTH - static_cast<unsigned char>(m_data.shortstring[SHORT_STRING_LENGTH]);
+  return m_data.string->size();
+}
+
 bool CVariant::isInteger() const
 {
   return isSignedInteger() || isUnsignedInteger();
@@ -404,7 +446,7 @@ int64_t CVariant::asInteger(int64_t fallback) const
     case VariantTypeDouble:
       return (int64_t)m_data.dvalue;
     case VariantTypeString:
-      return str2int64(*m_data.string, fallback);
+      return str2int64(asString(), fallback);
     case VariantTypeWideString:
       return str2int64(*m_data.wstring, fallback);
     default:
@@ -425,7 +467,7 @@ uint64_t CVariant::asUnsignedInteger(uint64_t fallback) const
     case VariantTypeDouble:
       return (uint64_t)m_data.dvalue;
     case VariantTypeString:
-      return str2uint64(*m_data.string, fallback);
+      return str2uint64(asString(), fallback);
     case VariantTypeWideString:
       return str2uint64(*m_data.wstring, fallback);
     default:
@@ -446,7 +488,7 @@ double CVariant::asDouble(double fallback) const
     case VariantTypeUnsignedInteger:
       return (double)m_data.unsignedinteger;
     case VariantTypeString:
-      return str2double(*m_data.string, fallback);
+      return str2double(asString(), fallback);
     case VariantTypeWideString:
       return str2double(*m_data.wstring, fallback);
     default:
@@ -467,7 +509,7 @@ float CVariant::asFloat(float fallback) const
     case VariantTypeUnsignedInteger:
       return (float)m_data.unsignedinteger;
     case VariantTypeString:
-      return (float)str2double(*m_data.string, fallback);
+      return (float)str2double(asString(), fallback);
     case VariantTypeWideString:
       return (float)str2double(*m_data.wstring, fallback);
     default:
@@ -490,7 +532,7 @@ bool CVariant::asBoolean(bool fallback) const
     case VariantTypeDouble:
       return (m_data.dvalue != 0);
     case VariantTypeString:
-      if (m_data.string->empty() || m_data.string->compare("0") == 0 || m_data.string->compare("false") == 0)
+      if (stringLength() == 0 || strcmp(stringData(), "0") == 0 || strcmp(stringData(), "false") == 0)
         return false;
       return true;
     case VariantTypeWideString:
@@ -509,7 +551,7 @@ std::string CVariant::asString(const std::string &fallback /* = "" */) const
   switch (m_type)
   {
     case VariantTypeString:
-      return *m_data.string;
+      return std::string(stringData(), stringLength());
     case VariantTypeBoolean:
       return m_data.boolean ? "true" : "false";
     case VariantTypeInteger:
@@ -604,6 +646,14 @@ CVariant &CVariant::operator=(const CVariant &rhs)
   if (m_type == VariantTypeConstNull || this == &rhs)
     return *this;
 
+  // reuse an existing heap string buffer where it is large enough
+  if (m_type == VariantTypeString && !m_shortString &&
+      rhs.m_type == VariantTypeString && !rhs.m_shortString)
+  {
+    *m_data.string = *rhs.m_data.string;
+    return *this;
+  }
+
   cleanup();
 
   m_type = rhs.m_type;
@@ -623,7 +673,13 @@ CVariant &CVariant::operator=(const CVariant &rhs)
     m_data.dvalue = rhs.m_data.dvalue;
     break;
   case VariantTypeString:
-    m_data.string = new std::string(*rhs.m_data.string);
+    if (rhs.m_shortString)
+    {
+      m_shortString = true;
+      memcpy(m_data.shortstring, rhs.m_data.shortstring, sizeof(m_data.shortstring));
+    }
+    else
+      m_data.string = new std::string(*rhs.m_data.string);
     break;
   case VariantTypeWideString:
     m_data.wstring = new std::wstring(*rhs.m_data.wstring);
@@ -641,7 +697,7 @@ CVariant &CVariant::operator=(const CVariant &rhs)
   return *this;
 }
 
-CVariant& CVariant::operator=(CVariant&& rhs)
+CVariant& CVariant::operator=(CVariant&& rhs) noexcept
 {
   if (m_type == VariantTypeConstNull || this == &rhs)
     return *this;
@@ -651,6 +707,7 @@ CVariant& CVariant::operator=(CVariant&& rhs)
     cleanup();
 
   m_type = rhs.m_type;
+  m_shortString = rhs.m_shortString;
   m_data = std::move(rhs.m_data);
 
   //Should be enough to just set m_type here
@@ -665,6 +722,7 @@ CVariant& CVariant::operator=(CVariant&& rhs)
     rhs.m_data.map = nullptr;
 
   rhs.m_type = VariantTypeNull;
+  rhs.m_shortString = false;
 
   return *this;
 }
@@ -684,7 +742,8 @@ bool CVariant::operator==(const CVariant &rhs) const
     case VariantTypeDouble:
       return m_data.dvalue == rhs.m_data.dvalue;
     case VariantTypeString:
-      return *m_data.string == *rhs.m_data.string;
+      return stringLength() == rhs.stringLength() &&
+             memcmp(stringData(), rhs.stringData(), stringLength()) == 0;
     case VariantTypeWideString:
       return *m_data.wstring == *rhs.m_data.wstring;
     case VariantTypeArray:
@@ -736,7 +795,7 @@ void CVariant::append(CVariant&& variant)
 const char *CVariant::c_str() const
 {
   if (m_type == VariantTypeString)
-    return m_data.string->c_str();
+    return stringData();
   else
     return NULL;
 }
@@ -744,12 +803,15 @@ const char *CVariant::c_str() const
 void CVariant::swap(CVariant &rhs)
 {
   VariantType  temp_type = m_type;
+  bool         temp_short = m_shortString;
   VariantUnion temp_data = m_data;
 
   m_type = rhs.m_type;
+  m_shortString = rhs.m_shortString;
   m_data = rhs.m_data;
 
   rhs.m_type = temp_type;
+  rhs.m_shortString = temp_short;
   rhs.m_data = temp_data;
 }
 
@@ -824,7 +886,7 @@ unsigned int CVariant::size() const
   else if (m_type == VariantTypeArray)
     return m_data.array->size();
   else if (m_type == VariantTypeString)
-    return m_data.string->size();
+    return stringLength();
   else if (m_type == VariantTypeWideString)
     return m_data.wstring->size();
   else
@@ -838,7 +900,7 @@ bool CVariant::empty() const
   else if (m_type == VariantTypeArray)
     return m_data.array->empty();
   else if (m_type == VariantTypeString)
-    return m_data.string->empty();
+    return stringLength() == 0;
   else if (m_type == VariantTypeWideString)
     return m_data.wstring->empty();
   else if (m_type == VariantTypeNull)
@@ -854,7 +916,12 @@ void CVariant::clear()
   else if (m_type == VariantTypeArray)
     m_data.array->clear();
   else if (m_type == VariantTypeString)
-    m_data.string->clear();
+  {
+    if (m_shortString)
+      setString("", 0);
+    else
+      m_data.string->clear();
+  }
   else if (m_type == VariantTypeWideString)
     m_data.wstring->clear();
 }
@@ -74,7 +74,7 @@ public:
   CVariant(const std::map<std::string, std::string> &strMap);
   CVariant(const std::map<std::string, CVariant> &variantMap);
   CVariant(const CVariant &variant);
-  CVariant(CVariant &&rhs);
+  CVariant(CVariant &&rhs) noexcept;
   ~CVariant();
 
 
@@ -106,7 +106,7 @@ public:
   const CVariant &operator[](unsigned int position) const;
 
   CVariant &operator=(const CVariant &rhs);
-  CVariant &operator=(CVariant &&rhs);
+  CVariant &operator=(CVariant &&rhs) noexcept;
   bool operator==(const CVariant &rhs) const;
   bool operator!=(const CVariant &rhs) const { return !(*this == rhs); }
 
@@ -151,7 +151,15 @@ public:
   static CVariant ConstNullVariant;
 
 private:
+  /*! \brief Longest narrow string that is stored inline instead of on the heap */
+  static const size_t SHORT_STRING_LENGTH = 15;
+
   void cleanup();
+  void setString(const char *str, size_t length);
+  void setString(std::string &&str);
+  const char *stringData() const;
+  size_t stringLength() const;
+
   union VariantUnion
   {
     int64_t integer;
@@ -162,9 +170,13 @@ private:
     std::wstring *wstring;
     VariantArray *array;
     VariantMap *map;
+    /*! NUL terminated inline string. The last byte holds the number of unused
+        characters so that a string of the maximum length is terminated by it. */
+    char shortstring[SHORT_STRING_LENGTH + 1];
   };
 
   VariantType m_type;
+  bool m_shortString = false;
   VariantUnion m_data;
 
   static VariantArray EMPTY_ARRAY;
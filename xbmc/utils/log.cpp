@@ -26,6 +26,14 @@
 #include "utils/StringUtils.h"
 #include "CompileInfo.h"
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+#include <thread>
+
 static const char* const levelNames[] =
 {"DEBUG", "INFO", "NOTICE", "WARNING", "ERROR", "SEVERE", "FATAL", "NONE"};
 
@@ -33,20 +41,348 @@ static const char* const levelNames[] =
 static const char* const logLevelNames[] =
 { "LOG_LEVEL_NONE" /*-1*/, "LOG_LEVEL_NORMAL" /*0*/, "LOG_LEVEL_DEBUG" /*1*/, "LOG_LEVEL_DEBUG_FREEMEM" /*2*/ };
 
+// number of messages the queue can hold, must be a power of two
+static const size_t queueSize = 8192;
+// time in ms the writer thread sleeps when nothing is logged
+static const unsigned int writerIdleTimeout = 100;
+static const int64_t msPerDay = 24 * 60 * 60 * 1000;
+// time in ms after which the local time is taken again, so that clock and DST changes show up in the log
+static const int64_t localTimeAnchorInterval = 60 * 1000;
+
 // s_globals is used as static global with CLog global variables
 #define s_globals XBMC_GLOBAL_USE(CLog).m_globalInstance
 
+/*!
+ \brief Writes log messages on a background thread.
+
+ Logging threads only format the message and put it into a bounded lock-free
+ queue (multi-producer ring buffer, every slot carries a sequence number telling
+ whether it is free or filled). Collapsing repeated lines, adding the prefix,
+ and writing to the log file happen on the writer thread, so a slow disk does
+ not stall the logging threads and they don't contend on a lock.
+ If the queue is full, the logging thread waits until the writer made space,
+ messages are never dropped.
+ */
+class CLog::CLogWriter
+{
+public:
+  CLogWriter();
+  ~CLogWriter();
+
+  void Start();
+  /*!
+   \brief Write all queued messages and stop the writer thread.
+   */
+  void Stop();
+  /*!
+   \brief Queue a message for the writer thread.
+   \return false if the writer is not running, the caller has to write the message itself then.
+   */
+  bool Push(int logLevel, std::string&& logString);
+  bool Flush(unsigned int timeout);
+#if defined(TARGET_POSIX)
+  void WriteQueuedOnCrash();
+#endif
+
+private:
+  struct Record
+  {
+    std::atomic<size_t> sequence;
+    int logLevel;
+    uint64_t threadId;
+    int64_t time;
+    std::string logString;
+  };
+
+  void Process();
+  void WriteQueued();
+  void ReleaseWritten();
+  bool HasQueued() const;
+  void Wakeup();
+
+  std::unique_ptr<Record[]> m_records;
+  std::atomic<size_t> m_pushPosition;
+  std::atomic<size_t> m_writtenPosition;
+  size_t m_popPosition; // only used by the writer thread
+  int64_t m_lastTime;   // only used by the writer thread
+  std::atomic<bool> m_bRunning;
+  std::atomic<bool> m_bWriterIdle;
+  std::thread m_thread;
+  std::mutex m_mutex;
+  std::condition_variable m_wakeupCondition;
+  bool m_bWakeup; // protected by m_mutex
+  bool m_bStop;   // protected by m_mutex
+};
+
+CLog::CLogWriter::CLogWriter()
+  : m_records(new Record[queueSize]),
+    m_pushPosition(0),
+    m_writtenPosition(0),
+    m_popPosition(0),
+    m_lastTime(0),
+    m_bRunning(false),
+    m_bWriterIdle(false),
+    m_bWakeup(false),
+    m_bStop(false)
+{
+  for (size_t i = 0; i < queueSize; ++i)
+    m_records[i].sequence.store(i, std::memory_order_relaxed);
+}
+
+CLog::CLogWriter::~CLogWriter()
+{
+  Stop();
+}
+
+void CLog::CLogWriter::Start()
+{
+  if (m_thread.joinable())
+    return;
+
+  m_bStop = false;
+  m_bRunning.store(true, std::memory_order_release);
+  m_thread = std::thread(&CLogWriter::Process, this);
+}
+
+void CLog::CLogWriter::Stop()
+{
+  if (!m_thread.joinable())
+    return;
+
+  // new messages are written synchronously from here on
+  m_bRunning.store(false, std::memory_order_release);
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_bStop = true;
+    m_bWakeup = true;
+  }
+  m_wakeupCondition.notify_one();
+  m_thread.join();
+}
+
+bool CLog::CLogWriter::Push(int logLevel, std::string&& logString)
+{
+  const int64_t time = CLog::GetMonotonicTime();
+
+  Record* record;
+  size_t position = m_pushPosition.load(std::memory_order_relaxed);
+  while (true)
+  {
+    if (!m_bRunning.load(std::memory_order_acquire))
+      return false;
+
+    record = &m_records[position & (queueSize - 1)];
+    const size_t sequence = record->sequence.load(std::memory_order_acquire);
+    const intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+    if (diff == 0)
+    {
+      if (m_pushPosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+        break;
+    }
+    else if (diff < 0)
+    {
+      // queue is full, wait for the writer to catch up
+      Wakeup();
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      position = m_pushPosition.load(std::memory_order_relaxed);
+    }
+    else
+      position = m_pushPosition.load(std::memory_order_relaxed);
+  }
+
+  record->logLevel = logLevel;
+  record->threadId = (uint64_t)CThread::GetCurrentThreadId();
+  record->time = time;
+  record->logString = std::move(logString);
+  record->sequence.store(position + 1, std::memory_order_release);
+
+  // only the first message after the writer went idle pays for waking it up
+  if (m_bWriterIdle.load(std::memory_order_relaxed) && m_bWriterIdle.exchange(false, std::memory_order_acq_rel))
+    Wakeup();
+
+  return true;
+}
+
+bool CLog::CLogWriter::Flush(unsigned int timeout)
+{
+  if (!m_bRunning.load(std::memory_order_acquire))
+    return true;
+
+  const size_t position = m_pushPosition.load(std::memory_order_acquire);
+  const auto endTime = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout);
+
+  Wakeup();
+  while (m_writtenPosition.load(std::memory_order_acquire) < position)
+  {
+    if (std::chrono::steady_clock::now() >= endTime)
+      return false;
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  return true;
+}
+
+#if defined(TARGET_POSIX)
+void CLog::CLogWriter::WriteQueuedOnCrash()
+{
+  static const char header[] = "Log messages queued at the time of the crash:\n";
+
+  // a record is filled and not yet written by the writer thread if its sequence
+  // is its position + 1, the strings were formatted by the logging threads
+  const size_t end = m_pushPosition.load(std::memory_order_acquire);
+  bool headerWritten = false;
+  for (size_t position = m_writtenPosition.load(std::memory_order_acquire); position != end; ++position)
+  {
+    const Record& record = m_records[position & (queueSize - 1)];
+    if (record.sequence.load(std::memory_order_acquire) != position + 1)
+      continue;
+
+    if (!headerWritten)
+    {
+      s_globals.m_platform.WriteToLogOnCrash(header, sizeof(header) - 1);
+      headerWritten = true;
+    }
+
+    // one write per line, so that it isn't mixed up with what the writer thread writes
+    // at the same time. the buffer is static, the stack may be what crashed
+    static char line[4096];
+    const char* levelName = levelNames[std::min(std::max(record.logLevel, 0), LOGNONE)];
+    size_t size = std::min(strlen(levelName), sizeof(line) - 3);
+    memcpy(line, levelName, size);
+    line[size++] = ':';
+    line[size++] = ' ';
+    const size_t length = std::min(record.logString.size(), sizeof(line) - 1 - size);
+    memcpy(line + size, record.logString.data(), length);
+    size += length;
+    line[size++] = '\n';
+    s_globals.m_platform.WriteToLogOnCrash(line, size);
+  }
+}
+#endif
+
+void CLog::CLogWriter::Process()
+{
+  while (true)
+  {
+    WriteQueued();
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if (m_bStop)
+      break;
+
+    m_bWriterIdle.store(true, std::memory_order_release);
+    // a message may have been queued before the idle flag was visible
+    if (!m_bWakeup && !HasQueued())
+      m_wakeupCondition.wait_for(lock, std::chrono::milliseconds(writerIdleTimeout), [this]() { return m_bWakeup; });
+    m_bWakeup = false;
+    m_bWriterIdle.store(false, std::memory_order_relaxed);
+  }
+
+  // messages queued while stopping
+  WriteQueued();
+}
+
+bool CLog::CLogWriter::HasQueued() const
+{
+  const Record& record = m_records[m_popPosition & (queueSize - 1)];
+  return record.sequence.load(std::memory_order_acquire) == m_popPosition + 1;
+}
+
+void CLog::CLogWriter::WriteQueued()
+{
+  if (!HasQueued())
+    return;
+
+  std::string output;
+  CSingleLock waitLock(s_globals.critSec);
+  while (HasQueued())
+  {
+    const Record& record = m_records[m_popPosition & (queueSize - 1)];
+    // messages may be queued in a different order than their time was taken
+    m_lastTime = std::max(m_lastTime, record.time);
+    CLog::FormatLogString(output, record.logLevel, record.threadId, m_lastTime, record.logString);
+    ++m_popPosition;
+
+    // write in chunks, so neither the output grows unbounded nor the file is hit for every line
+    if (output.size() >= 64 * 1024)
+    {
+      s_globals.m_platform.WriteStringToLog(output);
+      output.clear();
+      ReleaseWritten();
+    }
+  }
+
+  if (!output.empty())
+    s_globals.m_platform.WriteStringToLog(output);
+  ReleaseWritten();
+}
+
+void CLog::CLogWriter::ReleaseWritten()
+{
+  // records are only given back once they are in the file, until then
+  // WriteQueuedOnCrash still finds them
+  for (size_t position = m_writtenPosition.load(std::memory_order_relaxed); position != m_popPosition; ++position)
+  {
+    Record& record = m_records[position & (queueSize - 1)];
+    record.logString.clear();
+    record.sequence.store(position + queueSize, std::memory_order_release);
+  }
+
+  m_writtenPosition.store(m_popPosition, std::memory_order_release);
+}
+
+void CLog::CLogWriter::Wakeup()
+{
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_bWakeup = true;
+  }
+  m_wakeupCondition.notify_one();
+}
+
+CLog::CLogGlobals::CLogGlobals(void)
+  : m_repeatCount(0),
+    m_repeatLogLevel(-1),
+    m_logLevel(LOG_LEVEL_DEBUG),
+    m_extraLogLevels(0),
+    m_timeAnchor(0),
+    m_localTimeAnchor(0),
+    m_writer(new CLogWriter)
+{
+  AnchorLocalTime();
+}
+
+CLog::CLogGlobals::~CLogGlobals()
+{
+  m_writer->Stop();
+}
+
 CLog::CLog() = default;
 
 CLog::~CLog() = default;
 
 void CLog::Close()
 {
+  // write what is still queued, later messages are written synchronously until the next Init
+  s_globals.m_writer->Stop();
+
   CSingleLock waitLock(s_globals.critSec);
   s_globals.m_platform.CloseLogFile();
   s_globals.m_repeatLine.clear();
 }
 
+bool CLog::Flush(unsigned int timeout)
+{
+  return s_globals.m_writer->Flush(timeout);
+}
+
+#if defined(TARGET_POSIX)
+void CLog::WriteQueuedOnCrash()
+{
+  s_globals.m_writer->WriteQueuedOnCrash();
+}
+#endif
+
 void CLog::Log(int loglevel, PRINTF_FORMAT_STRING const char *format, ...)
 {
   if (IsLogLevelLogged(loglevel))
@@ -101,9 +437,25 @@ void CLog::LogFunction(int loglevel, const char* functionName, int component, co
   }
 }
 
-void CLog::LogString(int logLevel, const std::string& logString)
+void CLog::LogString(int logLevel, std::string&& logString)
 {
+  if (s_globals.m_writer->Push(logLevel, std::move(logString)))
+  {
+    // severe and fatal errors often precede a crash, make sure they are in the file
+    if (logLevel >= LOGSEVERE)
+      s_globals.m_writer->Flush(1000);
+    return;
+  }
+
+  std::string output;
   CSingleLock waitLock(s_globals.critSec);
+  FormatLogString(output, logLevel, (uint64_t)CThread::GetCurrentThreadId(), GetMonotonicTime(), logString);
+  if (!output.empty())
+    s_globals.m_platform.WriteStringToLog(output);
+}
+
+void CLog::FormatLogString(std::string& output, int logLevel, uint64_t threadId, int64_t time, const std::string& logString)
+{
   std::string strData(logString);
   StringUtils::TrimRight(strData);
   if (!strData.empty())
@@ -118,16 +470,15 @@ void CLog::LogString(int logLevel, const std::string& logString)
       std::string strData2 = StringUtils::Format("Previous line repeats %d times.",
                                                 s_globals.m_repeatCount);
       PrintDebugString(strData2);
-      WriteLogString(s_globals.m_repeatLogLevel, strData2);
+      FormatLogLine(output, s_globals.m_repeatLogLevel, threadId, time, strData2);
       s_globals.m_repeatCount = 0;
     }
 
-    s_globals.m_repeatLine = strData;
-    s_globals.m_repeatLogLevel = logLevel;
-
     PrintDebugString(strData);
+    FormatLogLine(output, logLevel, threadId, time, strData);
 
-    WriteLogString(logLevel, strData);
+    s_globals.m_repeatLine = std::move(strData);
+    s_globals.m_repeatLogLevel = logLevel;
   }
 }
 
@@ -140,7 +491,12 @@ bool CLog::Init(const std::string& path)
 
   std::string appName = CCompileInfo::GetAppName();
   StringUtils::ToLower(appName);
-  return s_globals.m_platform.OpenLogFile(path + appName + ".log", path + appName + ".old.log");
+  if (!s_globals.m_platform.OpenLogFile(path + appName + ".log", path + appName + ".old.log"))
+    return false;
+
+  s_globals.AnchorLocalTime();
+  s_globals.m_writer->Start();
+  return true;
 }
 
 void CLog::MemDump(char *pData, int length)
@@ -176,11 +532,13 @@ void CLog::MemDump(char *pData, int length)
 
 void CLog::SetLogLevel(int level)
 {
-  CSingleLock waitLock(s_globals.critSec);
   if (level >= LOG_LEVEL_NONE && level <= LOG_LEVEL_MAX)
   {
-    s_globals.m_logLevel = level;
-    CLog::Log(LOGNOTICE, "Log level changed to \"%s\"", logLevelNames[s_globals.m_logLevel + 1]);
+    {
+      CSingleLock waitLock(s_globals.critSec);
+      s_globals.m_logLevel = level;
+    }
+    CLog::Log(LOGNOTICE, "Log level changed to \"%s\"", logLevelNames[level + 1]);
   }
   else
     CLog::Log(LOGERROR, "%s: Invalid log level requested: %d", __FUNCTION__, level);
@@ -220,25 +578,47 @@ void CLog::PrintDebugString(const std::string& line)
 #endif // defined(_DEBUG) || defined(PROFILE)
 }
 
-bool CLog::WriteLogString(int logLevel, const std::string& logString)
+void CLog::FormatLogLine(std::string& output, int logLevel, uint64_t threadId, int64_t time, const std::string& line)
 {
   static const char* prefixFormat = "%02d:%02d:%02d.%03d T:%" PRIu64" %7s: ";
 
-  std::string strData(logString);
+  std::string strData(line);
   /* fixup newline alignment, number of spaces should equal prefix length */
   StringUtils::Replace(strData, "\n", "\n                                            ");
 
+  if (time - s_globals.m_timeAnchor >= localTimeAnchorInterval)
+    s_globals.AnchorLocalTime();
+
+  int64_t localTime = (s_globals.m_localTimeAnchor + time - s_globals.m_timeAnchor) % msPerDay;
+  if (localTime < 0)
+    localTime += msPerDay;
+
+  if (!output.empty())
+    output += '\n';
+  output += StringUtils::Format(prefixFormat,
+                                static_cast<int>(localTime / 3600000),
+                                static_cast<int>(localTime / 60000 % 60),
+                                static_cast<int>(localTime / 1000 % 60),
+                                static_cast<int>(localTime % 1000),
+                                threadId,
+                                levelNames[logLevel]);
+  output += strData;
+}
+
+int64_t CLog::GetMonotonicTime()
+{
+  return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void CLog::CLogGlobals::AnchorLocalTime()
+{
+  // timestamps are derived from a monotonic clock, so reading the local time
+  // for every line is avoided. it is taken again when the log is opened and
+  // once a minute while formatting, which happens under the log lock
   int hour, minute, second;
   double millisecond;
-  s_globals.m_platform.GetCurrentLocalTime(hour, minute, second, millisecond);
-
-  strData = StringUtils::Format(prefixFormat,
-                                  hour,
-                                  minute,
-                                  second,
-                                  static_cast<int>(millisecond),
-                                  (uint64_t)CThread::GetCurrentThreadId(),
-                                  levelNames[logLevel]) + strData;
+  m_platform.GetCurrentLocalTime(hour, minute, second, millisecond);
 
-  return s_globals.m_platform.WriteStringToLog(strData);
+  m_timeAnchor = GetMonotonicTime();
+  m_localTimeAnchor = ((hour * 60 + minute) * 60 + second) * 1000 + static_cast<int64_t>(millisecond);
 }
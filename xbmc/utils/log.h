@@ -20,6 +20,8 @@
  *
  */
 
+#include <memory>
+#include <stdint.h>
 #include <string>
 
 #if defined(TARGET_POSIX)
@@ -42,6 +44,23 @@ public:
   CLog();
   ~CLog(void);
   static void Close();
+  /*!
+   \brief Wait until all queued log messages are written to the log file.
+   \param timeout The time in ms to wait at most.
+   \return true if all messages were written, false on timeout.
+   */
+  static bool Flush(unsigned int timeout = 5000);
+#if defined(TARGET_POSIX)
+  /*!
+   \brief Write the messages the writer thread didn't take yet, for fatal signal handlers.
+
+   Only async-signal-safe functions are used, so the messages are written as
+   they were logged, with their level but without time and thread, and
+   repeated lines are not collapsed. As the writer thread keeps running, some
+   messages may end up twice in the log file.
+   */
+  static void WriteQueuedOnCrash();
+#endif
   static void Log(int loglevel, PRINTF_FORMAT_STRING const char *format, ...);
   static void Log(int loglevel, int component, PRINTF_FORMAT_STRING const char *format, ...);
   static void LogFunction(int loglevel, IN_OPT_STRING const char* functionName, PRINTF_FORMAT_STRING const char* format, ...) PARAM3_PRINTF_FORMAT;
@@ -56,22 +75,30 @@ public:
   static bool IsLogLevelLogged(int loglevel);
 
 protected:
+  class CLogWriter;
+
   class CLogGlobals
   {
   public:
-    CLogGlobals(void) : m_repeatCount(0), m_repeatLogLevel(-1), m_logLevel(LOG_LEVEL_DEBUG), m_extraLogLevels(0) {}
-    ~CLogGlobals() = default;
+    CLogGlobals(void);
+    ~CLogGlobals();
+    void AnchorLocalTime();
     PlatformInterfaceForCLog m_platform;
     int         m_repeatCount;
     int         m_repeatLogLevel;
     std::string m_repeatLine;
     int         m_logLevel;
     int         m_extraLogLevels;
-    CCriticalSection critSec;
+    int64_t     m_timeAnchor;      // monotonic time in ms at m_localTimeAnchor
+    int64_t     m_localTimeAnchor; // local time of day in ms
+    CCriticalSection critSec;      // never hold it while logging, the writer thread needs it
+    std::unique_ptr<CLogWriter> m_writer;
   };
   class CLogGlobals m_globalInstance; // used as static global variable
-  static void LogString(int logLevel, const std::string& logString);
-  static bool WriteLogString(int logLevel, const std::string& logString);
+  static void LogString(int logLevel, std::string&& logString);
+  static void FormatLogString(std::string& output, int logLevel, uint64_t threadId, int64_t time, const std::string& logString);
+  static void FormatLogLine(std::string& output, int logLevel, uint64_t threadId, int64_t time, const std::string& line);
+  static int64_t GetMonotonicTime();
 };
 
 
@@ -21,6 +21,7 @@
 #include "PosixInterfaceForCLog.h"
 #include <stdio.h>
 #include <time.h>
+#include <unistd.h>
 #include <sys/time.h>
 
 #if defined(TARGET_DARWIN)
@@ -34,7 +35,8 @@ struct FILEWRAP : public FILE
 
 
 CPosixInterfaceForCLog::CPosixInterfaceForCLog() :
-  m_file(NULL)
+  m_file(NULL),
+  m_fd(-1)
 { }
 
 CPosixInterfaceForCLog::~CPosixInterfaceForCLog()
@@ -58,6 +60,8 @@ bool CPosixInterfaceForCLog::OpenLogFile(const std::string &logFilename, const s
 
   static const unsigned char BOM[3] = { 0xEF, 0xBB, 0xBF };
   (void)fwrite(BOM, sizeof(BOM), 1, m_file); // write BOM, ignore possible errors
+  (void)fflush(m_file);
+  m_fd = fileno(m_file);
 
   return true;
 }
@@ -66,6 +70,7 @@ void CPosixInterfaceForCLog::CloseLogFile()
 {
   if (m_file)
   {
+    m_fd = -1;
     fclose(m_file);
     m_file = NULL;
   }
@@ -83,6 +88,20 @@ bool CPosixInterfaceForCLog::WriteStringToLog(const std::string &logString)
   return ret;
 }
 
+void CPosixInterfaceForCLog::WriteToLogOnCrash(const char* data, size_t size)
+{
+  // every write is followed by fflush, so nothing of the file's own buffer gets lost
+  const int fd = m_fd;
+  while (fd >= 0 && size > 0)
+  {
+    const ssize_t written = write(fd, data, size);
+    if (written <= 0)
+      return;
+    data += written;
+    size -= written;
+  }
+}
+
 void CPosixInterfaceForCLog::PrintDebugString(const std::string &debugString)
 {
 #ifdef _DEBUG
@@ -31,8 +31,13 @@ public:
   bool OpenLogFile(const std::string& logFilename, const std::string& backupOldLogToFilename);
   void CloseLogFile(void);
   bool WriteStringToLog(const std::string& logString);
+  /*!
+   \brief Write to the log file with write(2) only, for fatal signal handlers.
+   */
+  void WriteToLogOnCrash(const char* data, size_t size);
   void PrintDebugString(const std::string& debugString);
   static void GetCurrentLocalTime(int& hour, int& minute, int& second, double& millisecond);
 private:
   FILEWRAP* m_file;
+  volatile int m_fd; // descriptor of m_file, read by fatal signal handlers
 };
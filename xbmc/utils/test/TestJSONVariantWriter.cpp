@@ -21,6 +21,9 @@
 #include "utils/JSONVariantWriter.h"
 #include "utils/Variant.h"
 
+#include <string>
+#include <vector>
+
 #include "gtest/gtest.h"
 
 TEST(TestJSONVariantWriter, CanWriteNull)
@@ -161,3 +164,104 @@ TEST(TestJSONVariantWriter, CanWriteArray)
   ASSERT_TRUE(CJSONVariantWriter::Write(variant, str, false));
   ASSERT_STREQ("[\n\t{\n\t\t\"foo\": \"bar\"\n\t}\n]", str.c_str());
 }
+
+static CVariant CreateLibrary(unsigned int items)
+{
+  CVariant library(CVariant::VariantTypeObject);
+  CVariant &movies = library["movies"];
+  movies = CVariant(CVariant::VariantTypeArray);
+  for (unsigned int i = 0; i < items; i++)
+  {
+    CVariant movie(CVariant::VariantTypeObject);
+    movie["movieid"] = i;
+    movie["label"] = "Movie " + std::to_string(i);
+    movie["rating"] = 7.5;
+    movie["genre"].push_back("Drama");
+    movie["genre"].push_back("Comedy");
+    movie["art"] = CVariant(CVariant::VariantTypeObject);
+    movie["cast"] = CVariant(CVariant::VariantTypeArray);
+    movies.push_back(movie);
+  }
+  library["limits"]["total"] = items;
+  return library;
+}
+
+static bool WriteChunked(const CVariant &value, bool compact, size_t chunkSize, std::string &output, std::vector<size_t> &chunkSizes)
+{
+  CJSONVariantChunkedWriter writer(value, compact, chunkSize);
+  std::string chunk;
+  while (!writer.IsComplete())
+  {
+    if (!writer.Next(chunk))
+      return false;
+    output += chunk;
+    chunkSizes.push_back(chunk.size());
+  }
+
+  return true;
+}
+
+TEST(TestJSONVariantWriter, ChunkedWriterWritesTheSameAsWrite)
+{
+  const CVariant library = CreateLibrary(100);
+
+  for (bool compact : { true, false })
+  {
+    std::string expected;
+    ASSERT_TRUE(CJSONVariantWriter::Write(library, expected, compact));
+
+    for (size_t chunkSize : { 1, 100, 4096, 1048576 })
+    {
+      std::string output;
+      std::vector<size_t> chunkSizes;
+      ASSERT_TRUE(WriteChunked(library, compact, chunkSize, output, chunkSizes));
+      EXPECT_EQ(expected, output);
+    }
+  }
+}
+
+TEST(TestJSONVariantWriter, ChunkedWriterWritesChunksOfTheChunkSize)
+{
+  const CVariant library = CreateLibrary(1000);
+
+  std::string output;
+  std::vector<size_t> chunkSizes;
+  ASSERT_TRUE(WriteChunked(library, true, 4096, output, chunkSizes));
+  ASSERT_GT(chunkSizes.size(), 2U);
+
+  // a chunk is only exceeded by the last value written into it
+  for (size_t i = 0; i + 1 < chunkSizes.size(); i++)
+  {
+    EXPECT_GE(chunkSizes[i], 4096U);
+    EXPECT_LT(chunkSizes[i], 4096U + 64U);
+  }
+  EXPECT_LE(chunkSizes.back(), 4096U + 64U);
+}
+
+TEST(TestJSONVariantWriter, ChunkedWriterWritesScalarsAndEmptyContainers)
+{
+  std::vector<CVariant> values;
+  values.push_back(CVariant());
+  values.push_back(CVariant("foo"));
+  values.push_back(CVariant(-1));
+  values.push_back(CVariant(CVariant::VariantTypeArray));
+  values.push_back(CVariant(CVariant::VariantTypeObject));
+
+  for (const CVariant &value : values)
+  {
+    std::string expected;
+    ASSERT_TRUE(CJSONVariantWriter::Write(value, expected, false));
+
+    CJSONVariantChunkedWriter writer(value, false);
+    ASSERT_FALSE(writer.IsComplete());
+
+    std::string chunk;
+    ASSERT_TRUE(writer.Next(chunk));
+    EXPECT_EQ(expected, chunk);
+    ASSERT_TRUE(writer.IsComplete());
+
+    // nothing is left once the writer is complete
+    ASSERT_TRUE(writer.Next(chunk));
+    EXPECT_TRUE(chunk.empty());
+  }
+}
@@ -19,8 +19,11 @@
  */
 
 #include "utils/SortUtils.h"
+#include "utils/StringUtils.h"
 #include "utils/Variant.h"
 
+#include <string>
+
 #include "gtest/gtest.h"
 
 TEST(TestSortUtils, Sort_SortBy)
@@ -115,6 +118,87 @@ TEST(TestSortUtils, Sort_SortDescription)
   EXPECT_STREQ("R Artist", (*items.at(6))[FieldArtist].asString().c_str());
 }
 
+TEST(TestSortUtils, Sort_NaturalOrder)
+{
+  const char *labels[] = { "Episode 10", "episode 2", "Episode 1", "Episode 02b", "Episode", "Episode 100" };
+  SortItems items;
+  for (const char *label : labels)
+  {
+    SortItemPtr item(new SortItem());
+    (*item)[FieldLabel] = label;
+    items.push_back(item);
+  }
+
+  SortUtils::Sort(SortByLabel, SortOrderAscending, SortAttributeNone, items);
+
+  EXPECT_STREQ("Episode", (*items.at(0))[FieldLabel].asString().c_str());
+  EXPECT_STREQ("Episode 1", (*items.at(1))[FieldLabel].asString().c_str());
+  EXPECT_STREQ("episode 2", (*items.at(2))[FieldLabel].asString().c_str());
+  EXPECT_STREQ("Episode 02b", (*items.at(3))[FieldLabel].asString().c_str());
+  EXPECT_STREQ("Episode 10", (*items.at(4))[FieldLabel].asString().c_str());
+  EXPECT_STREQ("Episode 100", (*items.at(5))[FieldLabel].asString().c_str());
+}
+
+TEST(TestSortUtils, Sort_SpecialAndFolders)
+{
+  SortItems items;
+  for (int i = 0; i < 6; i++)
+  {
+    SortItemPtr item(new SortItem());
+    (*item)[FieldLabel] = std::string(1, 'f' - i);
+    (*item)[FieldFolder] = i % 2 == 0;
+    items.push_back(item);
+  }
+  (*items[1])[FieldSortSpecial] = SortSpecialOnBottom;
+  (*items[4])[FieldSortSpecial] = SortSpecialOnTop;
+
+  SortUtils::Sort(SortByLabel, SortOrderDescending, SortAttributeNone, items);
+
+  // b is on top, e on the bottom and the folders f and d come before the files c and a
+  EXPECT_STREQ("b", (*items.at(0))[FieldLabel].asString().c_str());
+  EXPECT_STREQ("f", (*items.at(1))[FieldLabel].asString().c_str());
+  EXPECT_STREQ("d", (*items.at(2))[FieldLabel].asString().c_str());
+  EXPECT_STREQ("c", (*items.at(3))[FieldLabel].asString().c_str());
+  EXPECT_STREQ("a", (*items.at(4))[FieldLabel].asString().c_str());
+  EXPECT_STREQ("e", (*items.at(5))[FieldLabel].asString().c_str());
+}
+
+TEST(TestSortUtils, Sort_LargeLibrary)
+{
+  // large enough to be sorted in parallel
+  const char *words[] = { "The", "Movie", "movie", "Part", "Zed", "007", "Return of the", "A" };
+  SortItems items;
+  for (int i = 0; i < 40000; i++)
+  {
+    std::string title = StringUtils::Format("%s %d %s %d", words[(i * 7) % 8], (i * 31) % 997, words[(i * 3) % 8], i % 13);
+    SortItemPtr item(new SortItem());
+    (*item)[FieldLabel] = title;
+    (*item)[FieldFolder] = i % 5 == 0;
+    (*item)[FieldId] = i;
+    items.push_back(item);
+  }
+
+  SortUtils::Sort(SortByLabel, SortOrderAscending, SortAttributeNone, items);
+
+  ASSERT_EQ(40000u, items.size());
+  for (size_t i = 1; i < items.size(); i++)
+  {
+    const SortItem &previous = *items[i - 1];
+    const SortItem &current = *items[i];
+    if (previous.at(FieldFolder).asBoolean() != current.at(FieldFolder).asBoolean())
+    {
+      EXPECT_TRUE(previous.at(FieldFolder).asBoolean());
+      continue;
+    }
+    int64_t result = StringUtils::AlphaNumericCompare(previous.at(FieldSort).asWideString().c_str(),
+                                                      current.at(FieldSort).asWideString().c_str());
+    EXPECT_LE(result, 0);
+    // equal items keep their original order
+    if (result == 0)
+      EXPECT_LT(previous.at(FieldId).asInteger(), current.at(FieldId).asInteger());
+  }
+}
+
 TEST(TestSortUtils, GetFieldsForSorting)
 {
   Fields fields;
@@ -0,0 +1,100 @@
+/*
+ *      Copyright (C) 2017 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "utils/Trace.h"
+#include "filesystem/File.h"
+#include "filesystem/SpecialProtocol.h"
+#include "utils/StringUtils.h"
+#include "CompileInfo.h"
+
+#include <cstring>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+TEST(TestTrace, Write)
+{
+  // the trace file stays mapped once created, so there is a single test writing it
+  const std::string path = CSpecialProtocol::TranslatePath("special://temp/");
+  std::string appName = CCompileInfo::GetAppName();
+  StringUtils::ToLower(appName);
+
+  CTrace::SetComponents(LOGAVTIMING);
+  EXPECT_FALSE(CTrace::IsEnabled(LOGAVTIMING)); // not before the file is created
+  ASSERT_TRUE(CTrace::Init(path, 64 * 1024));
+  EXPECT_TRUE(CTrace::IsEnabled(LOGAVTIMING));
+  EXPECT_FALSE(CTrace::IsEnabled(LOGAUDIO));
+
+  bool evaluated = false;
+  KODI_TRACE(LOGAUDIO, TraceEvent::ClockSpeedAdjust, (evaluated = true));
+  EXPECT_FALSE(evaluated);
+
+  KODI_TRACE(LOGAVTIMING, TraceEvent::ClockErrorAdjust, 1.5, -2, "audio");
+  // overwrites the first record several times
+  for (int i = 0; i < 5000; i++)
+    KODI_TRACE(LOGAVTIMING, TraceEvent::VideoOutput, 10.0 * i, 20.0 * i, i);
+  KODI_TRACE(LOGAVTIMING, TraceEvent::ClockDiscontinuity, 3.0, 4.0);
+
+  XFILE::CFile file;
+  std::vector<uint8_t> data;
+  ASSERT_TRUE(file.Open(path + appName + ".trace"));
+  data.resize(static_cast<size_t>(file.GetLength()));
+  ASSERT_EQ(static_cast<ssize_t>(data.size()), file.Read(data.data(), data.size()));
+  file.Close();
+
+  TraceFileHeader header;
+  memcpy(&header, data.data(), sizeof(header));
+  EXPECT_EQ(0, memcmp(header.magic, TRACE_FILE_MAGIC, sizeof(header.magic)));
+  EXPECT_EQ(TRACE_FILE_VERSION, header.version);
+  EXPECT_EQ(64u * 1024, header.capacity);
+  ASSERT_EQ(TRACE_FILE_HEADER_SIZE + header.capacity, data.size());
+
+  // video output records are 32 + 3 * 9 bytes padded to 64, the last record is shorter
+  const uint8_t* ring = data.data() + TRACE_FILE_HEADER_SIZE;
+  int videoOutputs = 0;
+  bool discontinuity = false;
+  for (uint64_t offset = 0; offset < header.capacity; offset += 64)
+  {
+    TraceRecordHeader record;
+    memcpy(&record, ring + offset, sizeof(record));
+    EXPECT_EQ(offset, record.position % header.capacity);
+    EXPECT_EQ(static_cast<uint32_t>(LOGAVTIMING), record.component);
+    EXPECT_NE(static_cast<uint16_t>(TraceEvent::ClockErrorAdjust), record.event);
+    if (record.event == static_cast<uint16_t>(TraceEvent::VideoOutput))
+    {
+      const uint8_t* arguments = ring + offset + sizeof(record);
+      int64_t value;
+      EXPECT_EQ(64, record.size);
+      EXPECT_EQ(TRACE_ARGUMENT_DOUBLE, arguments[0]);
+      EXPECT_EQ(TRACE_ARGUMENT_DOUBLE, arguments[9]);
+      EXPECT_EQ(TRACE_ARGUMENT_INT, arguments[18]);
+      memcpy(&value, arguments + 19, sizeof(value));
+      EXPECT_LT(value, 5000);
+      videoOutputs++;
+    }
+    else if (record.event == static_cast<uint16_t>(TraceEvent::ClockDiscontinuity))
+    {
+      EXPECT_EQ(56, record.size);
+      discontinuity = true;
+    }
+  }
+  EXPECT_EQ(1023, videoOutputs);
+  EXPECT_TRUE(discontinuity);
+}
@@ -22,6 +22,8 @@
 
 #include "gtest/gtest.h"
 
+#include <type_traits>
+
 TEST(TestVariant, VariantTypeInteger)
 {
   CVariant a((int)0), b((int64_t)1);
@@ -75,6 +77,73 @@ TEST(TestVariant, VariantTypeString)
   EXPECT_STREQ("VariantTypeString3", c.asString().c_str());
 }
 
+TEST(TestVariant, VariantTypeStringLength)
+{
+  // strings around the inline storage limit
+  const std::string shortStr(15, 'a');
+  const std::string longStr(16, 'b');
+  const std::string embedded("a\0b", 3);
+  CVariant a(shortStr), b(longStr), c(embedded), d("");
+
+  EXPECT_EQ(15u, a.size());
+  EXPECT_EQ(shortStr, a.asString());
+  EXPECT_STREQ(shortStr.c_str(), a.c_str());
+  EXPECT_EQ(16u, b.size());
+  EXPECT_EQ(longStr, b.asString());
+  EXPECT_STREQ(longStr.c_str(), b.c_str());
+  EXPECT_EQ(3u, c.size());
+  EXPECT_EQ(embedded, c.asString());
+  EXPECT_TRUE(d.empty());
+  EXPECT_FALSE(d.asBoolean());
+
+  EXPECT_EQ((int64_t)42, CVariant("42").asInteger());
+  EXPECT_EQ((int64_t)42, CVariant("000000000000000042").asInteger());
+  EXPECT_FALSE(CVariant("false").asBoolean());
+  EXPECT_TRUE(CVariant("true").asBoolean());
+}
+
+TEST(TestVariant, VariantTypeStringCopyMove)
+{
+  CVariant a(std::string(15, 'a')), b(std::string(40, 'b'));
+
+  CVariant c(a), d(b);
+  EXPECT_EQ(a, c);
+  EXPECT_EQ(b, d);
+  EXPECT_NE(a, b);
+
+  // assignment between short and long strings in both directions
+  c = b;
+  EXPECT_EQ(b, c);
+  d = a;
+  EXPECT_EQ(a, d);
+  c = CVariant(std::string(20, 'c'));
+  EXPECT_EQ(std::string(20, 'c'), c.asString());
+
+  CVariant e(std::move(a)), f(std::move(b));
+  EXPECT_EQ(std::string(15, 'a'), e.asString());
+  EXPECT_EQ(std::string(40, 'b'), f.asString());
+  EXPECT_TRUE(a.isNull());
+  EXPECT_TRUE(b.isNull());
+
+  e.swap(f);
+  EXPECT_EQ(std::string(40, 'b'), e.asString());
+  EXPECT_EQ(std::string(15, 'a'), f.asString());
+
+  e.clear();
+  f.clear();
+  EXPECT_TRUE(e.empty());
+  EXPECT_TRUE(f.empty());
+  EXPECT_EQ(e, f);
+}
+
+TEST(TestVariant, NothrowMove)
+{
+  // std::vector only moves its elements on reallocation if this holds,
+  // otherwise large arrays are deep copied every time they grow
+  EXPECT_TRUE(std::is_nothrow_move_constructible<CVariant>::value);
+  EXPECT_TRUE(std::is_nothrow_move_assignable<CVariant>::value);
+}
+
 TEST(TestVariant, VariantTypeWideString)
 {
   CVariant a(L"VariantTypeWideString");
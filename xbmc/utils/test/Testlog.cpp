@@ -19,6 +19,13 @@
  */
 
 #include <stdlib.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <sstream>
+#include <thread>
+#include <vector>
 #include "utils/log.h"
 #include "utils/RegExp.h"
 #include "filesystem/File.h"
@@ -151,3 +158,104 @@ TEST_F(Testlog, SetLogLevel)
   CLog::Close();
   EXPECT_TRUE(XFILE::CFile::Delete(logfile));
 }
+
+TEST_F(Testlog, MultipleThreads)
+{
+  const int threadCount = 8;
+  const int messageCount = 2000;
+  std::string logfile, logstring;
+  char buf[4096];
+  unsigned int bytesread;
+  XFILE::CFile file;
+
+  std::string appName = CCompileInfo::GetAppName();
+  StringUtils::ToLower(appName);
+  logfile = CSpecialProtocol::TranslatePath("special://temp/") + appName + ".log";
+  EXPECT_TRUE(CLog::Init(CSpecialProtocol::TranslatePath("special://temp/").c_str()));
+
+  std::vector<std::thread> threads;
+  for (int i = 0; i < threadCount; i++)
+  {
+    threads.emplace_back([i]() {
+      for (int j = 0; j < messageCount; j++)
+        CLog::Log(LOGDEBUG, "thread %d message %d", i, j);
+    });
+  }
+  for (auto& thread : threads)
+    thread.join();
+
+  EXPECT_TRUE(CLog::Flush());
+  CLog::Close();
+
+  EXPECT_TRUE(file.Open(logfile));
+  while ((bytesread = file.Read(buf, sizeof(buf) - 1)) > 0)
+  {
+    buf[bytesread] = '\0';
+    logstring.append(buf);
+  }
+  file.Close();
+
+  // every message is written once, in the order it was logged by its thread,
+  // and the timestamps never go back (unless the day changes)
+  std::vector<int> nextMessage(threadCount, 0);
+  int lastTime = 0;
+  std::istringstream lines(logstring.substr(3));
+  std::string line;
+  while (std::getline(lines, line))
+  {
+    int hour, minute, second, millisecond, thread, message;
+    ASSERT_EQ(4, sscanf(line.c_str(), "%d:%d:%d.%d", &hour, &minute, &second, &millisecond)) << line;
+    int time = ((hour * 60 + minute) * 60 + second) * 1000 + millisecond;
+    EXPECT_TRUE(time >= lastTime || lastTime - time > 12 * 60 * 60 * 1000) << line;
+    lastTime = time;
+
+    size_t pos = line.find("thread ");
+    if (pos == std::string::npos)
+      continue;
+    ASSERT_EQ(2, sscanf(line.c_str() + pos, "thread %d message %d", &thread, &message)) << line;
+    ASSERT_TRUE(thread >= 0 && thread < threadCount) << line;
+    EXPECT_EQ(nextMessage[thread], message) << line;
+    nextMessage[thread] = message + 1;
+  }
+
+  for (int i = 0; i < threadCount; i++)
+    EXPECT_EQ(messageCount, nextMessage[i]) << "thread " << i;
+
+  EXPECT_TRUE(XFILE::CFile::Delete(logfile));
+}
+
+TEST_F(Testlog, DISABLED_ContentionBenchmark)
+{
+  const int threadCount = std::max(4, static_cast<int>(std::thread::hardware_concurrency()));
+  const int messageCount = 20000;
+  std::string logfile;
+
+  std::string appName = CCompileInfo::GetAppName();
+  StringUtils::ToLower(appName);
+  logfile = CSpecialProtocol::TranslatePath("special://temp/") + appName + ".log";
+  EXPECT_TRUE(CLog::Init(CSpecialProtocol::TranslatePath("special://temp/").c_str()));
+
+  auto start = std::chrono::steady_clock::now();
+  std::vector<std::thread> threads;
+  for (int i = 0; i < threadCount; i++)
+  {
+    threads.emplace_back([i]() {
+      for (int j = 0; j < messageCount; j++)
+        CLog::Log(LOGDEBUG, "benchmark thread %d message %d", i, j);
+    });
+  }
+  for (auto& thread : threads)
+    thread.join();
+  auto logged = std::chrono::steady_clock::now();
+
+  EXPECT_TRUE(CLog::Flush(30000));
+  auto written = std::chrono::steady_clock::now();
+  CLog::Close();
+
+  const double calls = static_cast<double>(threadCount) * messageCount;
+  std::cout << threadCount << " threads: " <<
+    static_cast<int64_t>(calls / std::chrono::duration<double>(logged - start).count()) << " log calls/s, " <<
+    static_cast<int64_t>(calls / std::chrono::duration<double>(written - start).count()) << " lines written/s" << std::endl;
+
+  EXPECT_TRUE(XFILE::CFile::Delete(logfile));
+}
@@ -88,6 +88,13 @@ public:
   virtual bool UseLimitedColor();
   //the number of presentation buffers
   virtual int NoOfBuffers();
+  /**
+   * Get the age of the back buffer that the next frame is rendered into
+   *
+   * \return number of frames since the buffer was last presented, 0 if its
+   * content is undefined, or a negative value if the age is unknown
+   */
+  virtual int GetBufferAge() { return -1; }
   /**
    * Get average display latency
    *
@@ -29,6 +29,7 @@
 #include <GL/glext.h>
 
 #include "GLContextEGL.h"
+#include "utils/EGLUtils.h"
 #include "utils/log.h"
 
 #define EGL_NO_CONFIG (EGLConfig)0
@@ -40,6 +41,7 @@ CGLContextEGL::CGLContextEGL(Display *dpy) : CGLContext(dpy)
   m_eglSurface = EGL_NO_SURFACE;
   m_eglContext = EGL_NO_CONTEXT;
   m_eglConfig = EGL_NO_CONFIG;
+  m_bufferAgeSupported = false;
 }
 
 CGLContextEGL::~CGLContextEGL()
@@ -360,6 +362,15 @@ void CGLContextEGL::QueryExtensions()
 {
   std::string extensions = eglQueryString(m_eglDisplay, EGL_EXTENSIONS);
   m_extensions = std::string(" ") + extensions + " ";
+  m_bufferAgeSupported = IsExtSupported("EGL_EXT_buffer_age");
 
   CLog::Log(LOGDEBUG, "EGL_EXTENSIONS:%s", m_extensions.c_str());
 }
+
+int CGLContextEGL::GetBufferAge()
+{
+  if (!m_bufferAgeSupported)
+    return -1;
+
+  return CEGLUtils::GetBufferAge(m_eglDisplay, m_eglSurface);
+}
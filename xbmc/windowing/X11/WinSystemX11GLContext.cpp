@@ -82,6 +82,14 @@ bool CWinSystemX11GLContext::IsExtSupported(const char* extension)
   return m_pGLContext->IsExtSupported(extension);
 }
 
+int CWinSystemX11GLContext::GetBufferAge()
+{
+  if (!m_pGLContext)
+    return -1;
+
+  return m_pGLContext->GetBufferAge();
+}
+
 #ifdef HAS_GLX
 GLXWindow CWinSystemX11GLContext::GetWindow() const
 {
@@ -44,6 +44,7 @@ public:
   bool DestroyWindow() override;
 
   bool IsExtSupported(const char* extension) override;
+  int GetBufferAge() override;
 
   // videosync
   std::unique_ptr<CVideoSync> GetVideoSync(void *clock) override;
@@ -22,6 +22,7 @@
 
 #include "guilib/IDirtyRegionSolver.h"
 #include "settings/AdvancedSettings.h"
+#include "utils/EGLUtils.h"
 #include "utils/log.h"
 
 #include <EGL/eglext.h>
@@ -31,7 +32,8 @@ CGLContextEGL::CGLContextEGL() :
   m_eglDisplay(EGL_NO_DISPLAY),
   m_eglSurface(EGL_NO_SURFACE),
   m_eglContext(EGL_NO_CONTEXT),
-  m_eglConfig(0)
+  m_eglConfig(0),
+  m_bufferAgeSupported(false)
 {
 }
 
@@ -47,27 +49,6 @@ bool CGLContextEGL::CreateDisplay(EGLDisplay display,
   EGLint neglconfigs = 0;
   int major, minor;
 
-  EGLint surface_type = EGL_WINDOW_BIT;
-  // for the non-trivial dirty region modes, we need the EGL buffer to be preserved across updates
-  if (g_advancedSettings.m_guiAlgorithmDirtyRegions == DIRTYREGION_SOLVER_COST_REDUCTION ||
-      g_advancedSettings.m_guiAlgorithmDirtyRegions == DIRTYREGION_SOLVER_UNION)
-    surface_type |= EGL_SWAP_BEHAVIOR_PRESERVED_BIT;
-
-  EGLint attribs[] =
-  {
-    EGL_RED_SIZE,        8,
-    EGL_GREEN_SIZE,      8,
-    EGL_BLUE_SIZE,       8,
-    EGL_ALPHA_SIZE,      8,
-    EGL_DEPTH_SIZE,     16,
-    EGL_STENCIL_SIZE,    0,
-    EGL_SAMPLE_BUFFERS,  0,
-    EGL_SAMPLES,         0,
-    EGL_SURFACE_TYPE,    surface_type,
-    EGL_RENDERABLE_TYPE, renderable_type,
-    EGL_NONE
-  };
-
   const char *client_extensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
   CLog::Log(LOGNOTICE, "EGL_EXTENSIONS = %s", client_extensions);
 
@@ -104,6 +85,35 @@ bool CGLContextEGL::CreateDisplay(EGLDisplay display,
 
   eglBindAPI(rendering_api);
 
+  const char *display_extensions = eglQueryString(m_eglDisplay, EGL_EXTENSIONS);
+  CLog::Log(LOGNOTICE, "EGL_EXTENSIONS = %s", display_extensions);
+
+  m_bufferAgeSupported = CEGLUtils::HasExtension(m_eglDisplay, "EGL_EXT_buffer_age");
+
+  EGLint surface_type = EGL_WINDOW_BIT;
+  // for the non-trivial dirty region modes, we need the EGL buffer to be preserved across updates.
+  // partial redraw can do without as long as the driver tells us how old the back buffer is.
+  if (g_advancedSettings.m_guiAlgorithmDirtyRegions == DIRTYREGION_SOLVER_COST_REDUCTION ||
+      g_advancedSettings.m_guiAlgorithmDirtyRegions == DIRTYREGION_SOLVER_UNION ||
+      (g_advancedSettings.m_guiAlgorithmDirtyRegions == DIRTYREGION_SOLVER_PARTIAL_REDRAW &&
+       !m_bufferAgeSupported))
+    surface_type |= EGL_SWAP_BEHAVIOR_PRESERVED_BIT;
+
+  EGLint attribs[] =
+  {
+    EGL_RED_SIZE,        8,
+    EGL_GREEN_SIZE,      8,
+    EGL_BLUE_SIZE,       8,
+    EGL_ALPHA_SIZE,      8,
+    EGL_DEPTH_SIZE,     16,
+    EGL_STENCIL_SIZE,    0,
+    EGL_SAMPLE_BUFFERS,  0,
+    EGL_SAMPLES,         0,
+    EGL_SURFACE_TYPE,    surface_type,
+    EGL_RENDERABLE_TYPE, renderable_type,
+    EGL_NONE
+  };
+
   if (!eglChooseConfig(m_eglDisplay, attribs,
                        &m_eglConfig, 1, &neglconfigs))
   {
@@ -117,9 +127,6 @@ bool CGLContextEGL::CreateDisplay(EGLDisplay display,
     return false;
   }
 
-  const char *display_extensions = eglQueryString(m_eglDisplay, EGL_EXTENSIONS);
-  CLog::Log(LOGNOTICE, "EGL_EXTENSIONS = %s", display_extensions);
-
   return true;
 }
 
@@ -161,9 +168,12 @@ bool CGLContextEGL::BindContext()
 
 bool CGLContextEGL::SurfaceAttrib()
 {
-  // for the non-trivial dirty region modes, we need the EGL buffer to be preserved across updates
+  // for the non-trivial dirty region modes, we need the EGL buffer to be preserved across updates.
+  // partial redraw can do without as long as the driver tells us how old the back buffer is.
   if (g_advancedSettings.m_guiAlgorithmDirtyRegions == DIRTYREGION_SOLVER_COST_REDUCTION ||
-      g_advancedSettings.m_guiAlgorithmDirtyRegions == DIRTYREGION_SOLVER_UNION)
+      g_advancedSettings.m_guiAlgorithmDirtyRegions == DIRTYREGION_SOLVER_UNION ||
+      (g_advancedSettings.m_guiAlgorithmDirtyRegions == DIRTYREGION_SOLVER_PARTIAL_REDRAW &&
+       !m_bufferAgeSupported))
   {
     if ((m_eglDisplay == EGL_NO_DISPLAY) || (m_eglSurface == EGL_NO_SURFACE))
     {
@@ -250,3 +260,11 @@ void CGLContextEGL::SwapBuffers()
 
   eglSwapBuffers(m_eglDisplay, m_eglSurface);
 }
+
+int CGLContextEGL::GetBufferAge()
+{
+  if (!m_bufferAgeSupported)
+    return -1;
+
+  return CEGLUtils::GetBufferAge(m_eglDisplay, m_eglSurface);
+}
@@ -40,9 +40,11 @@ public:
   void Detach();
   bool SetVSync(bool enable);
   void SwapBuffers();
+  int GetBufferAge();
 
   EGLDisplay m_eglDisplay;
   EGLSurface m_eglSurface;
   EGLContext m_eglContext;
   EGLConfig m_eglConfig;
+  bool m_bufferAgeSupported;
 };
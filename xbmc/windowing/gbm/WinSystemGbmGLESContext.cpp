@@ -143,6 +143,11 @@ void CWinSystemGbmGLESContext::PresentRenderImpl(bool rendered)
   }
 }
 
+int CWinSystemGbmGLESContext::GetBufferAge()
+{
+  return m_pGLContext.GetBufferAge();
+}
+
 EGLDisplay CWinSystemGbmGLESContext::GetEGLDisplay() const
 {
   return m_pGLContext.m_eglDisplay;
@@ -94,6 +94,8 @@ bool CGLContextEGL::CreateDisplay(wayland::display_t& display,
     return false;
   }
 
+  m_bufferAgeSupported = CEGLUtils::HasExtension(m_eglDisplay, "EGL_EXT_buffer_age");
+
   if (eglChooseConfig(m_eglDisplay, attribs, &m_eglConfig, 1, &neglconfigs) != EGL_TRUE)
   {
     CEGLUtils::LogError("Failed to query number of EGL configs");
@@ -209,3 +211,11 @@ void CGLContextEGL::SwapBuffers()
     throw std::runtime_error("eglSwapBuffers failed");
   }
 }
+
+int CGLContextEGL::GetBufferAge()
+{
+  if (!m_bufferAgeSupported)
+    return -1;
+
+  return CEGLUtils::GetBufferAge(m_eglDisplay, m_eglSurface);
+}
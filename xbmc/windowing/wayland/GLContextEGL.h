@@ -53,6 +53,7 @@ public:
   void Destroy();
   void SetVSync(bool enable);
   void SwapBuffers();
+  int GetBufferAge();
 
   EGLDisplay GetEGLDisplay() const
   {
@@ -68,6 +69,7 @@ private:
   EGLSurface m_eglSurface{EGL_NO_SURFACE};
   EGLContext m_eglContext{EGL_NO_CONTEXT};
   EGLConfig m_eglConfig{};
+  bool m_bufferAgeSupported{false};
 
   std::set<std::string> m_clientExtensions;
 
@@ -134,6 +134,11 @@ void CWinSystemWaylandEGLContext::PresentFrame(bool rendered)
   FinishFramePresentation();
 }
 
+int CWinSystemWaylandEGLContext::GetBufferAge()
+{
+  return m_eglContext.GetBufferAge();
+}
+
 EGLDisplay CWinSystemWaylandEGLContext::GetEGLDisplay() const
 {
   return m_eglContext.GetEGLDisplay();
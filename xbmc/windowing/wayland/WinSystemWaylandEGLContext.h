@@ -40,6 +40,7 @@ public:
                        RESOLUTION_INFO& res) override;
   bool DestroyWindow() override;
   bool DestroyWindowSystem() override;
+  int GetBufferAge() override;
 
   EGLDisplay GetEGLDisplay() const;
 